@@ -309,6 +309,9 @@ COMPILE_ASSERT(sizeof(ssize_t) == sizeof(int64_t));
 #define ENABLE_PROFILER
 #define ENABLE_MESHOPTIMIZER
 #define ENABLE_THREAD_PERFORMANCE_STATS
+// Per resource directory and per archive read statistics, see fsGetIoStats.
+// Times every stream read, including memory streams, so it is off by default
+// #define ENABLE_FS_IO_STATS
 // #define ENABLE_VMA_LOG // Very verbose, prints for each allocation
 
 // ENABLE_FORGE_ANDROID_SHADERC can be disabled if all shaders are compiled offline.
@@ -40,6 +40,7 @@
 #include "../../Game/Interfaces/IScripting.h"
 #include "../../OS/Interfaces/IOperatingSystem.h"
 #include "../../Utilities/Interfaces/IFileSystem.h"
+#include "../../Resources/ResourceLoader/Interfaces/IResourceLoader.h"
 
 #include "../../Utilities/Math/Algorithms.h"
 
@@ -3266,10 +3267,110 @@ void ProfileFlipCpu()
         S.nActiveBars = nNewActiveBars;
 }
 
+#if defined(ENABLE_FS_IO_STATS)
+enum ProfileIoCounter
+{
+    PROFILE_IO_COUNTER_OPENS,
+    PROFILE_IO_COUNTER_READS,
+    PROFILE_IO_COUNTER_BYTES_READ,
+    PROFILE_IO_COUNTER_READ_TIME_US,
+    PROFILE_IO_COUNTER_COUNT,
+};
+
+static const char* gProfileIoCounterNames[PROFILE_IO_COUNTER_COUNT] = { "opens", "reads", "bytes read", "read time us" };
+
+// Last slot is memory streams. Tokens are created for used directories only, counters are limited.
+static ProfileToken gProfileIoCounterTokens[RD_COUNT + 1][PROFILE_IO_COUNTER_COUNT];
+static bool         gProfileIoCountersCreated[RD_COUNT + 1];
+
+// Publishes totals of fsGetIoStats as counters "FileSystem/<directory>/<counter>"
+static void profileUpdateIoCounters()
+{
+    for (uint32_t i = 0; i <= RD_COUNT; ++i)
+    {
+        FsIoStats stats;
+        if (!(i < RD_COUNT ? fsGetIoStats((ResourceDirectory)i, &stats) : fsGetMemoryStreamIoStats(&stats)) || !stats.openCount)
+            continue;
+
+        ProfileToken* tokens = gProfileIoCounterTokens[i];
+        if (!gProfileIoCountersCreated[i])
+        {
+            for (uint32_t c = 0; c < PROFILE_IO_COUNTER_COUNT; ++c)
+            {
+                char name[64];
+                if (i < RD_COUNT)
+                    snprintf(name, sizeof name, "FileSystem/rd%u/%s", i, gProfileIoCounterNames[c]);
+                else
+                    snprintf(name, sizeof name, "FileSystem/memory/%s", gProfileIoCounterNames[c]);
+                tokens[c] = ProfileGetCounterToken(name);
+                if (c == PROFILE_IO_COUNTER_BYTES_READ)
+                    ProfileCounterConfig(name, PROFILE_COUNTER_FORMAT_BYTES, 0, 0);
+            }
+            gProfileIoCountersCreated[i] = true;
+        }
+
+        ProfileCounterSet(tokens[PROFILE_IO_COUNTER_OPENS], (int64_t)stats.openCount);
+        ProfileCounterSet(tokens[PROFILE_IO_COUNTER_READS], (int64_t)stats.readCount);
+        ProfileCounterSet(tokens[PROFILE_IO_COUNTER_BYTES_READ], (int64_t)stats.bytesRead);
+        ProfileCounterSet(tokens[PROFILE_IO_COUNTER_READ_TIME_US], (int64_t)stats.readTimeUsec);
+    }
+}
+#endif
+
+enum ProfileLoaderCounter
+{
+    PROFILE_LOADER_COUNTER_FRAME_UPLOAD_SIZE,
+    PROFILE_LOADER_COUNTER_FRAME_REQUESTS,
+    PROFILE_LOADER_COUNTER_QUEUED_REQUESTS,
+    PROFILE_LOADER_COUNTER_AVERAGE_LATENCY_US,
+    PROFILE_LOADER_COUNTER_STAGING_STALLS,
+    PROFILE_LOADER_COUNTER_BUDGET_LIMITED_FRAMES,
+    PROFILE_LOADER_COUNTER_COUNT,
+};
+
+static const char* gProfileLoaderCounterNames[PROFILE_LOADER_COUNTER_COUNT] = {
+    "ResourceLoader/bytes uploaded per frame", "ResourceLoader/requests per frame", "ResourceLoader/queued requests",
+    "ResourceLoader/average latency us",       "ResourceLoader/staging stalls",     "ResourceLoader/budget limited frames",
+};
+
+static ProfileToken gProfileLoaderCounterTokens[PROFILE_LOADER_COUNTER_COUNT];
+static bool         gProfileLoaderCountersCreated;
+
+// Publishes getResourceLoaderStats as counters "ResourceLoader/<counter>"
+static void profileUpdateResourceLoaderCounters()
+{
+    ResourceLoaderStats stats;
+    if (!getResourceLoaderStats(&stats))
+        return;
+
+    ProfileToken* tokens = gProfileLoaderCounterTokens;
+    if (!gProfileLoaderCountersCreated)
+    {
+        for (uint32_t c = 0; c < PROFILE_LOADER_COUNTER_COUNT; ++c)
+        {
+            tokens[c] = ProfileGetCounterToken(gProfileLoaderCounterNames[c]);
+        }
+        ProfileCounterConfig(gProfileLoaderCounterNames[PROFILE_LOADER_COUNTER_FRAME_UPLOAD_SIZE], PROFILE_COUNTER_FORMAT_BYTES, 0, 0);
+        gProfileLoaderCountersCreated = true;
+    }
+
+    ProfileCounterSet(tokens[PROFILE_LOADER_COUNTER_FRAME_UPLOAD_SIZE], (int64_t)stats.mFrameUploadSize);
+    ProfileCounterSet(tokens[PROFILE_LOADER_COUNTER_FRAME_REQUESTS], (int64_t)stats.mFrameRequestCount);
+    ProfileCounterSet(tokens[PROFILE_LOADER_COUNTER_QUEUED_REQUESTS], (int64_t)stats.mQueuedRequestCount);
+    ProfileCounterSet(tokens[PROFILE_LOADER_COUNTER_AVERAGE_LATENCY_US], (int64_t)stats.mAverageLatencyUs);
+    ProfileCounterSet(tokens[PROFILE_LOADER_COUNTER_STAGING_STALLS], (int64_t)stats.mStagingStallCount);
+    ProfileCounterSet(tokens[PROFILE_LOADER_COUNTER_BUDGET_LIMITED_FRAMES], (int64_t)stats.mBudgetLimitedFrameCount);
+}
+
 void flipProfiler()
 {
     PROFILER_SET_CPU_SCOPE("Profile", "ProfileFlip", 0x3355ee);
 
+#if defined(ENABLE_FS_IO_STATS)
+    profileUpdateIoCounters();
+#endif
+    profileUpdateResourceLoaderCounters();
+
     ProfileFlipCpu();
 }
 
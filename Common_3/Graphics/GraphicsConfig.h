@@ -47,7 +47,10 @@
 // ------------------------------- renderer configuration ------------------------------- //
 
 // Comment/uncomment includes to disable/enable rendering APIs
-#if defined(_WINDOWS)
+#if defined(FORGE_EXPLICIT_RENDERER_API_NULL)
+// Headless renderer, available on every platform
+#include "Null/NullConfig.h"
+#elif defined(_WINDOWS)
 #if defined(FORGE_EXPLICIT_RENDERER_API)
 #if defined(FORGE_EXPLICIT_RENDERER_API_DIRECT3D11)
 #include "Direct3D11/Direct3D11Config.h"
@@ -129,7 +132,8 @@ enum
 #define ENABLE_GRAPHICS_DEBUG_ANNOTATION
 #endif
 
-#if (defined(DIRECT3D12) + defined(DIRECT3D11) + defined(VULKAN) + defined(METAL) + defined(ORBIS) + defined(PROSPERO) + defined(NX64)) == 0
+#if (defined(DIRECT3D12) + defined(DIRECT3D11) + defined(VULKAN) + defined(METAL) + defined(ORBIS) + defined(PROSPERO) + defined(NX64) + \
+     defined(NULL_RENDERER)) == 0
 #error "No rendering API defined"
 #endif
 
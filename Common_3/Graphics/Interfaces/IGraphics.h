@@ -100,6 +100,9 @@ typedef enum RendererApi
 #endif
 #if defined(PROSPERO)
     RENDERER_API_PROSPERO,
+#endif
+#if defined(NULL_RENDERER)
+    RENDERER_API_NULL,
 #endif
     RENDERER_API_COUNT
 } RendererApi;
@@ -888,6 +891,12 @@ typedef struct DEFINE_ALIGNED(ResourceHeap, 64)
 #if defined(PROSPERO)
         ProsperoResourceHeap mStruct;
 #endif
+#if defined(NULL_RENDERER)
+        struct
+        {
+            void* pCpuData;
+        } mNull;
+#endif
 #if defined(USE_MULTIPLE_RENDER_APIS)
     };
 #endif
@@ -1025,6 +1034,14 @@ typedef struct DEFINE_ALIGNED(Buffer, 64)
 #if defined(PROSPERO)
         ProsperoBuffer mStruct;
 #endif
+#if defined(NULL_RENDERER)
+        struct
+        {
+            /// CPU memory standing in for the GPU allocation, pCpuMappedAddress points to it while the buffer is mapped
+            void*    pCpuData;
+            uint32_t mOwnsMemory : 1;
+        } mNull;
+#endif
 #if defined(USE_MULTIPLE_RENDER_APIS)
     };
 #endif
@@ -1150,6 +1167,13 @@ typedef struct DEFINE_ALIGNED(Texture, 64)
 #if defined(PROSPERO)
         ProsperoTexture mStruct;
 #endif
+#if defined(NULL_RENDERER)
+        struct
+        {
+            /// Tightly packed subresources, array layer major. NULL for render targets and swapchain images
+            void* pCpuData;
+        } mNull;
+#endif
 #if defined(USE_MULTIPLE_RENDER_APIS)
     };
 #endif
@@ -1541,6 +1565,13 @@ typedef struct DEFINE_ALIGNED(RootSignature, 64)
 #if defined(PROSPERO)
         ProsperoRootSignature mStruct;
 #endif
+#if defined(NULL_RENDERER)
+        struct
+        {
+            // No backend data, pads the common members to the size asserted below
+            uint64_t mPadding[13];
+        } mNull;
+#endif
 #if defined(USE_MULTIPLE_RENDER_APIS)
     };
 #endif
@@ -1930,6 +1961,12 @@ typedef struct Fence
 #if defined(PROSPERO)
         ProsperoFence mStruct;
 #endif
+#if defined(NULL_RENDERER)
+        struct
+        {
+            uint32_t mSubmitted : 1;
+        } mNull;
+#endif
 #if defined(USE_MULTIPLE_RENDER_APIS)
     };
 #endif
@@ -2655,6 +2692,12 @@ typedef struct SwapChain
             RenderTarget**              ppFragmentDensityMasks;
         } mVR;
 #endif
+#if defined(NULL_RENDERER)
+        struct
+        {
+            uint32_t mImageIndex;
+        } mNull;
+#endif
 #if defined(USE_MULTIPLE_RENDER_APIS)
     };
 #endif
@@ -0,0 +1,1335 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+/* Headless null renderer.
+ * Implements the graphics interface without a GPU so CPU side code (resource loading, batching, UI, profiler)
+ * can run and be benchmarked on machines without one.
+ * Buffers and textures are backed by CPU memory and copies are executed at record time, so uploaded data
+ * can be read back. Every other command is ignored and all submitted work is complete immediately.
+ */
+#include "../GraphicsConfig.h"
+
+#ifdef NULL_RENDERER
+#define RENDERER_IMPLEMENTATION
+
+#include "../../Resources/ResourceLoader/ThirdParty/OpenSource/tinyimageformat/tinyimageformat_apis.h"
+#include "../../Resources/ResourceLoader/ThirdParty/OpenSource/tinyimageformat/tinyimageformat_base.h"
+#include "../../Resources/ResourceLoader/ThirdParty/OpenSource/tinyimageformat/tinyimageformat_query.h"
+
+#include "../../Utilities/Interfaces/ILog.h"
+#include "../Interfaces/IGraphics.h"
+
+#include "../../Utilities/Math/MathTypes.h"
+#include "../../Utilities/Threading/Atomics.h"
+
+#include "../../Utilities/Interfaces/IMemory.h"
+
+//-V:SAFE_FREE:779
+#define SAFE_FREE(p_var) \
+    if (p_var)           \
+    {                    \
+        tf_free(p_var);  \
+        p_var = NULL;    \
+    }
+
+// Alignment of CPU allocations backing buffers, textures and heaps
+#define NULL_RESOURCE_ALIGNMENT 256
+
+// clang-format off
+void getBufferSizeAlign(Renderer* pRenderer, const BufferDesc* pDesc, ResourceSizeAlign* pOut);
+void getTextureSizeAlign(Renderer* pRenderer, const TextureDesc* pDesc, ResourceSizeAlign* pOut);
+void addBuffer(Renderer* pRenderer, const BufferDesc* pDesc, Buffer** pp_buffer);
+void removeBuffer(Renderer* pRenderer, Buffer* pBuffer);
+void mapBuffer(Renderer* pRenderer, Buffer* pBuffer, ReadRange* pRange);
+void unmapBuffer(Renderer* pRenderer, Buffer* pBuffer);
+void cmdUpdateBuffer(Cmd* pCmd, Buffer* pBuffer, uint64_t dstOffset, Buffer* pSrcBuffer, uint64_t srcOffset, uint64_t size);
+void cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pSrcBuffer, const struct SubresourceDataDesc* pSubresourceDesc);
+void cmdCopySubresource(Cmd* pCmd, Buffer* pDstBuffer, Texture* pTexture, const struct SubresourceDataDesc* pSubresourceDesc);
+void addTexture(Renderer* pRenderer, const TextureDesc* pDesc, Texture** ppTexture);
+void removeTexture(Renderer* pRenderer, Texture* pTexture);
+// clang-format on
+
+struct SubresourceDataDesc
+{
+    uint64_t mSrcOffset;
+    uint32_t mMipLevel;
+    uint32_t mArrayLayer;
+    uint32_t mRowPitch;
+    uint32_t mSlicePitch;
+};
+
+// CPU memory allocated for resources, reported by calculateMemoryUse
+static tfrg_atomic64_t gNullAllocatedMemory = 0;
+
+static void* null_alloc_memory(uint64_t size)
+{
+    void* pData = tf_calloc_memalign(1, NULL_RESOURCE_ALIGNMENT, (size_t)size);
+    ASSERT(pData);
+    tfrg_atomic64_add_relaxed(&gNullAllocatedMemory, size);
+    return pData;
+}
+
+static void null_free_memory(void* pData, uint64_t size)
+{
+    tfrg_atomic64_add_relaxed(&gNullAllocatedMemory, (uint64_t)-(int64_t)size);
+    tf_free(pData);
+}
+
+/************************************************************************/
+// Texture Layout
+/************************************************************************/
+// Textures store their subresources tightly packed, array layer major, mip minor
+static uint64_t util_get_subresource_size(TinyImageFormat fmt, uint32_t width, uint32_t height, uint32_t depth, uint32_t mipLevel)
+{
+    width = max(1u, width >> mipLevel);
+    height = max(1u, height >> mipLevel);
+    depth = max(1u, depth >> mipLevel);
+
+    if (!TinyImageFormat_IsSinglePlane(fmt))
+    {
+        uint64_t size = 0;
+        for (uint32_t i = 0; i < TinyImageFormat_NumOfPlanes(fmt); ++i)
+        {
+            size += (uint64_t)TinyImageFormat_PlaneWidth(fmt, i, width) * TinyImageFormat_PlaneHeight(fmt, i, height) *
+                    TinyImageFormat_PlaneSizeOfBlock(fmt, i);
+        }
+        return size * depth;
+    }
+
+    const uint64_t blocksWide = (width + TinyImageFormat_WidthOfBlock(fmt) - 1) / TinyImageFormat_WidthOfBlock(fmt);
+    const uint64_t blocksHigh = (height + TinyImageFormat_HeightOfBlock(fmt) - 1) / TinyImageFormat_HeightOfBlock(fmt);
+    return blocksWide * blocksHigh * depth * (TinyImageFormat_BitSizeOfBlock(fmt) / 8);
+}
+
+static uint64_t util_get_texture_size(const TextureDesc* pDesc)
+{
+    const uint32_t mipLevels = max(1u, pDesc->mMipLevels);
+    uint64_t       layerSize = 0;
+    for (uint32_t mip = 0; mip < mipLevels; ++mip)
+    {
+        layerSize += util_get_subresource_size(pDesc->mFormat, pDesc->mWidth, pDesc->mHeight, pDesc->mDepth, mip);
+    }
+    return layerSize * max(1u, pDesc->mArraySize);
+}
+
+static uint64_t util_get_subresource_offset(const Texture* pTexture, uint32_t mipLevel, uint32_t arrayLayer)
+{
+    const TinyImageFormat fmt = (TinyImageFormat)pTexture->mFormat;
+    uint64_t              layerSize = 0;
+    uint64_t              mipOffset = 0;
+    for (uint32_t mip = 0; mip < pTexture->mMipLevels; ++mip)
+    {
+        if (mip == mipLevel)
+        {
+            mipOffset = layerSize;
+        }
+        layerSize += util_get_subresource_size(fmt, pTexture->mWidth, pTexture->mHeight, pTexture->mDepth, mip);
+    }
+    return layerSize * arrayLayer + mipOffset;
+}
+
+// Copies one subresource between a buffer with the given pitches and the packed texture memory.
+// Textures without memory (render targets) read as zero.
+static void util_copy_subresource(Texture* pTexture, uint8_t* pBufferData, const SubresourceDataDesc* pSubresourceDesc, bool toTexture)
+{
+    const TinyImageFormat fmt = (TinyImageFormat)pTexture->mFormat;
+    uint8_t*              pTextureData = (uint8_t*)pTexture->mNull.pCpuData;
+    if (pTextureData)
+    {
+        pTextureData += util_get_subresource_offset(pTexture, pSubresourceDesc->mMipLevel, pSubresourceDesc->mArrayLayer);
+    }
+    else if (toTexture)
+    {
+        return;
+    }
+    pBufferData += pSubresourceDesc->mSrcOffset;
+
+    if (!TinyImageFormat_IsSinglePlane(fmt))
+    {
+        // Planes are packed the same way in the buffer
+        const uint64_t size =
+            util_get_subresource_size(fmt, pTexture->mWidth, pTexture->mHeight, pTexture->mDepth, pSubresourceDesc->mMipLevel);
+        if (toTexture)
+            memcpy(pTextureData, pBufferData, size);
+        else if (pTextureData)
+            memcpy(pBufferData, pTextureData, size);
+        else
+            memset(pBufferData, 0, size);
+        return;
+    }
+
+    const uint32_t width = max(1u, (uint32_t)pTexture->mWidth >> pSubresourceDesc->mMipLevel);
+    const uint32_t height = max(1u, (uint32_t)pTexture->mHeight >> pSubresourceDesc->mMipLevel);
+    const uint32_t depth = max(1u, (uint32_t)pTexture->mDepth >> pSubresourceDesc->mMipLevel);
+    const uint32_t rowBytes =
+        (width + TinyImageFormat_WidthOfBlock(fmt) - 1) / TinyImageFormat_WidthOfBlock(fmt) * (TinyImageFormat_BitSizeOfBlock(fmt) / 8);
+    const uint32_t numRows = (height + TinyImageFormat_HeightOfBlock(fmt) - 1) / TinyImageFormat_HeightOfBlock(fmt);
+    const uint32_t rowPitch = pSubresourceDesc->mRowPitch ? pSubresourceDesc->mRowPitch : rowBytes;
+    const uint32_t slicePitch = pSubresourceDesc->mSlicePitch ? pSubresourceDesc->mSlicePitch : rowPitch * numRows;
+
+    for (uint32_t z = 0; z < depth; ++z)
+    {
+        for (uint32_t row = 0; row < numRows; ++row)
+        {
+            uint8_t* pBufferRow = pBufferData + (uint64_t)z * slicePitch + (uint64_t)row * rowPitch;
+            if (!pTextureData)
+            {
+                memset(pBufferRow, 0, rowBytes);
+                continue;
+            }
+
+            uint8_t* pTextureRow = pTextureData + ((uint64_t)z * numRows + row) * rowBytes;
+            if (toTexture)
+                memcpy(pTextureRow, pBufferRow, rowBytes);
+            else
+                memcpy(pBufferRow, pTextureRow, rowBytes);
+        }
+    }
+}
+/************************************************************************/
+// Renderer Init Remove
+/************************************************************************/
+void initRendererContext(const char* appName, const RendererContextDesc* pDesc, RendererContext** ppContext)
+{
+    UNREF_PARAM(appName);
+    UNREF_PARAM(pDesc);
+    ASSERT(ppContext);
+
+    RendererContext* pContext = (RendererContext*)tf_calloc_memalign(1, alignof(RendererContext), sizeof(RendererContext));
+    ASSERT(pContext);
+
+    // One GPU with fixed properties. gpu.cfg rules are not applied so results do not depend on the machine
+    GpuDesc* gpu = &pContext->mGpus[0];
+    setDefaultGPUProperties(gpu);
+    for (uint32_t i = 0; i < TinyImageFormat_Count; ++i)
+    {
+        gpu->mFormatCaps[i] = FORMAT_CAP_LINEAR_FILTER | FORMAT_CAP_READ | FORMAT_CAP_WRITE | FORMAT_CAP_READ_WRITE |
+                              FORMAT_CAP_RENDER_TARGET;
+    }
+    gpu->mVRAM = 4ull * TF_GB;
+    gpu->mUniformBufferAlignment = 256;
+    gpu->mUploadBufferAlignment = 1;
+    gpu->mUploadBufferTextureAlignment = 1;
+    gpu->mUploadBufferTextureRowAlignment = 1;
+    gpu->mMaxVertexInputBindings = MAX_VERTEX_BINDINGS;
+    gpu->mMaxBoundTextures = 1000000;
+    gpu->mWaveLaneCount = 32;
+    gpu->mMaxTotalComputeThreads = 1024;
+    gpu->mMaxComputeThreads[0] = 1024;
+    gpu->mMaxComputeThreads[1] = 1024;
+    gpu->mMaxComputeThreads[2] = 64;
+    gpu->mMultiDrawIndirect = true;
+    gpu->mMultiDrawIndirectCount = true;
+    gpu->mRootConstant = true;
+    gpu->mIndirectRootConstant = true;
+    gpu->mBuiltinDrawID = true;
+    gpu->mTessellationSupported = true;
+    gpu->mGeometryShaderSupported = true;
+    gpu->mPrimitiveIdSupported = true;
+    gpu->mPrimitiveIdPsSupported = true;
+    gpu->mSamplerAnisotropySupported = true;
+    gpu->mGraphicsQueueSupported = true;
+    // Uploads go through staging buffers and copies like on a discrete GPU, that is the path this backend measures
+    gpu->mUnifiedMemorySupported = false;
+    gpu->mGpuVendorPreset.mPresetLevel = GPU_PRESET_HIGH;
+    strncpy(gpu->mGpuVendorPreset.mVendorName, "Null", MAX_GPU_VENDOR_STRING_LENGTH);
+    strncpy(gpu->mGpuVendorPreset.mGpuName, "Null Renderer", MAX_GPU_VENDOR_STRING_LENGTH);
+    strncpy(gpu->mGpuVendorPreset.mGpuDriverVersion, "0", MAX_GPU_VENDOR_STRING_LENGTH);
+    pContext->mGpuCount = 1;
+
+    LOGF(LogLevel::eINFO, "GPU[0] detected. Null renderer, Preset: %s", presetLevelToString(gpu->mGpuVendorPreset.mPresetLevel));
+
+    *ppContext = pContext;
+}
+
+void exitRendererContext(RendererContext* pContext)
+{
+    ASSERT(pContext);
+    SAFE_FREE(pContext);
+}
+
+void initRenderer(const char* appName, const RendererDesc* pDesc, Renderer** ppRenderer)
+{
+    ASSERT(ppRenderer);
+    ASSERT(pDesc);
+
+    Renderer* pRenderer = (Renderer*)tf_calloc_memalign(1, alignof(Renderer), sizeof(Renderer));
+    ASSERT(pRenderer);
+
+    pRenderer->mRendererApi = RENDERER_API_NULL;
+    pRenderer->mGpuMode = GPU_MODE_SINGLE;
+    pRenderer->mShaderTarget = pDesc->mShaderTarget;
+    pRenderer->mLinkedNodeCount = 1;
+    pRenderer->pName = appName;
+
+    if (pDesc->pContext)
+    {
+        pRenderer->pContext = pDesc->pContext;
+        pRenderer->mOwnsContext = false;
+    }
+    else
+    {
+        RendererContextDesc contextDesc = {};
+        contextDesc.mEnableGpuBasedValidation = pDesc->mEnableGpuBasedValidation;
+        initRendererContext(appName, &contextDesc, &pRenderer->pContext);
+        pRenderer->mOwnsContext = true;
+    }
+
+    pRenderer->pGpu = &pRenderer->pContext->mGpus[0];
+
+    *ppRenderer = pRenderer;
+}
+
+void exitRenderer(Renderer* pRenderer)
+{
+    ASSERT(pRenderer);
+
+    if (pRenderer->mOwnsContext)
+    {
+        exitRendererContext(pRenderer->pContext);
+    }
+
+    SAFE_FREE(pRenderer);
+}
+/************************************************************************/
+// Queue Fence Semaphore Functions
+/************************************************************************/
+void initFence(Renderer* pRenderer, Fence** ppFence)
+{
+    ASSERT(pRenderer);
+    ASSERT(ppFence);
+
+    Fence* pFence = (Fence*)tf_calloc(1, sizeof(Fence));
+    ASSERT(pFence);
+
+    *ppFence = pFence;
+}
+
+void exitFence(Renderer* pRenderer, Fence* pFence)
+{
+    ASSERT(pRenderer);
+    ASSERT(pFence);
+
+    SAFE_FREE(pFence);
+}
+
+void initSemaphore(Renderer* pRenderer, Semaphore** ppSemaphore)
+{
+    ASSERT(pRenderer);
+    ASSERT(ppSemaphore);
+
+    Semaphore* pSemaphore = (Semaphore*)tf_calloc(1, sizeof(Semaphore));
+    ASSERT(pSemaphore);
+
+    *ppSemaphore = pSemaphore;
+}
+
+void exitSemaphore(Renderer* pRenderer, Semaphore* pSemaphore)
+{
+    ASSERT(pRenderer);
+    ASSERT(pSemaphore);
+
+    SAFE_FREE(pSemaphore);
+}
+
+void initQueue(Renderer* pRenderer, QueueDesc* pDesc, Queue** ppQueue)
+{
+    ASSERT(pRenderer);
+    ASSERT(pDesc);
+    ASSERT(ppQueue);
+
+    Queue* pQueue = (Queue*)tf_calloc(1, sizeof(Queue));
+    ASSERT(pQueue);
+
+    pQueue->mType = pDesc->mType;
+    pQueue->mNodeIndex = pDesc->mNodeIndex;
+
+    *ppQueue = pQueue;
+}
+
+void exitQueue(Renderer* pRenderer, Queue* pQueue)
+{
+    ASSERT(pRenderer);
+    ASSERT(pQueue);
+
+    SAFE_FREE(pQueue);
+}
+
+void acquireNextImage(Renderer* pRenderer, SwapChain* pSwapChain, Semaphore* pSignalSemaphore, Fence* pFence, uint32_t* pImageIndex)
+{
+    UNREF_PARAM(pRenderer);
+    UNREF_PARAM(pSignalSemaphore);
+    ASSERT(pSwapChain);
+    ASSERT(pImageIndex);
+
+    if (pFence)
+    {
+        pFence->mNull.mSubmitted = true;
+    }
+
+    *pImageIndex = pSwapChain->mNull.mImageIndex;
+    pSwapChain->mNull.mImageIndex = (pSwapChain->mNull.mImageIndex + 1) % pSwapChain->mImageCount;
+}
+
+void queueSubmit(Queue* pQueue, const QueueSubmitDesc* pDesc)
+{
+    UNREF_PARAM(pQueue);
+    ASSERT(pDesc);
+
+    // Commands were executed when they were recorded
+    if (pDesc->pSignalFence)
+    {
+        pDesc->pSignalFence->mNull.mSubmitted = true;
+    }
+}
+
+void queuePresent(Queue* pQueue, const QueuePresentDesc* pDesc)
+{
+    UNREF_PARAM(pQueue);
+    UNREF_PARAM(pDesc);
+}
+
+void waitQueueIdle(Queue* pQueue) { UNREF_PARAM(pQueue); }
+
+void getFenceStatus(Renderer* pRenderer, Fence* pFence, FenceStatus* pFenceStatus)
+{
+    UNREF_PARAM(pRenderer);
+    ASSERT(pFence);
+    ASSERT(pFenceStatus);
+
+    if (pFence->mNull.mSubmitted)
+    {
+        pFence->mNull.mSubmitted = false;
+        *pFenceStatus = FENCE_STATUS_COMPLETE;
+    }
+    else
+    {
+        *pFenceStatus = FENCE_STATUS_NOTSUBMITTED;
+    }
+}
+
+void waitForFences(Renderer* pRenderer, uint32_t fenceCount, Fence** ppFences)
+{
+    UNREF_PARAM(pRenderer);
+
+    for (uint32_t i = 0; i < fenceCount; ++i)
+    {
+        ppFences[i]->mNull.mSubmitted = false;
+    }
+}
+
+void toggleVSync(Renderer* pRenderer, SwapChain** ppSwapChain)
+{
+    UNREF_PARAM(pRenderer);
+    ASSERT(ppSwapChain && *ppSwapChain);
+
+    (*ppSwapChain)->mEnableVsync = !(*ppSwapChain)->mEnableVsync;
+}
+
+TinyImageFormat getSupportedSwapchainFormat(Renderer* pRenderer, const SwapChainDesc* pDesc, ColorSpace colorSpace)
+{
+    UNREF_PARAM(pRenderer);
+    UNREF_PARAM(pDesc);
+
+    if (COLOR_SPACE_SDR_SRGB == colorSpace)
+        return TinyImageFormat_B8G8R8A8_SRGB;
+    return TinyImageFormat_B8G8R8A8_UNORM;
+}
+
+uint32_t getRecommendedSwapchainImageCount(Renderer* pRenderer, const WindowHandle* hwnd)
+{
+    UNREF_PARAM(pRenderer);
+    UNREF_PARAM(hwnd);
+    return 2;
+}
+/************************************************************************/
+// Swapchain Functions
+/************************************************************************/
+void addSwapChain(Renderer* pRenderer, const SwapChainDesc* pDesc, SwapChain** ppSwapChain)
+{
+    ASSERT(pRenderer);
+    ASSERT(pDesc);
+    ASSERT(ppSwapChain);
+    ASSERT(pDesc->mImageCount);
+
+    LOGF(LogLevel::eINFO, "Adding null swapchain @ %ux%u", pDesc->mWidth, pDesc->mHeight);
+
+    SwapChain* pSwapChain = (SwapChain*)tf_calloc(1, sizeof(SwapChain) + pDesc->mImageCount * sizeof(RenderTarget*));
+    ASSERT(pSwapChain);
+    pSwapChain->ppRenderTargets = (RenderTarget**)(pSwapChain + 1);
+
+    RenderTargetDesc descColor = {};
+    descColor.mWidth = pDesc->mWidth;
+    descColor.mHeight = pDesc->mHeight;
+    descColor.mDepth = 1;
+    descColor.mArraySize = 1;
+    descColor.mFormat = pDesc->mColorFormat;
+    descColor.mClearValue = pDesc->mColorClearValue;
+    descColor.mSampleCount = SAMPLE_COUNT_1;
+    descColor.mStartState = RESOURCE_STATE_PRESENT;
+    descColor.mFlags = TEXTURE_CREATION_FLAG_ALLOW_DISPLAY_TARGET;
+
+    for (uint32_t i = 0; i < pDesc->mImageCount; ++i)
+    {
+        addRenderTarget(pRenderer, &descColor, &pSwapChain->ppRenderTargets[i]);
+    }
+
+    pSwapChain->mImageCount = pDesc->mImageCount;
+    pSwapChain->mEnableVsync = pDesc->mEnableVsync;
+    pSwapChain->mColorSpace = pDesc->mColorSpace;
+    pSwapChain->mFormat = pDesc->mColorFormat;
+
+    *ppSwapChain = pSwapChain;
+}
+
+void removeSwapChain(Renderer* pRenderer, SwapChain* pSwapChain)
+{
+    ASSERT(pRenderer);
+    ASSERT(pSwapChain);
+
+    for (uint32_t i = 0; i < pSwapChain->mImageCount; ++i)
+    {
+        removeRenderTarget(pRenderer, pSwapChain->ppRenderTargets[i]);
+    }
+
+    SAFE_FREE(pSwapChain);
+}
+/************************************************************************/
+// Command Pool Functions
+/************************************************************************/
+void initCmdPool(Renderer* pRenderer, const CmdPoolDesc* pDesc, CmdPool** ppCmdPool)
+{
+    ASSERT(pRenderer);
+    ASSERT(pDesc);
+    ASSERT(ppCmdPool);
+
+    CmdPool* pCmdPool = (CmdPool*)tf_calloc(1, sizeof(CmdPool));
+    ASSERT(pCmdPool);
+
+    pCmdPool->pQueue = pDesc->pQueue;
+
+    *ppCmdPool = pCmdPool;
+}
+
+void exitCmdPool(Renderer* pRenderer, CmdPool* pCmdPool)
+{
+    ASSERT(pRenderer);
+    ASSERT(pCmdPool);
+
+    SAFE_FREE(pCmdPool);
+}
+
+void initCmd(Renderer* pRenderer, const CmdDesc* pDesc, Cmd** ppCmd)
+{
+    ASSERT(pRenderer);
+    ASSERT(pDesc);
+    ASSERT(ppCmd);
+
+    Cmd* pCmd = (Cmd*)tf_calloc_memalign(1, alignof(Cmd), sizeof(Cmd));
+    ASSERT(pCmd);
+
+    pCmd->pRenderer = pRenderer;
+    pCmd->pQueue = pDesc->pPool->pQueue;
+
+    *ppCmd = pCmd;
+}
+
+void exitCmd(Renderer* pRenderer, Cmd* pCmd)
+{
+    ASSERT(pRenderer);
+    ASSERT(pCmd);
+
+    SAFE_FREE(pCmd);
+}
+
+void initCmd_n(Renderer* pRenderer, const CmdDesc* pDesc, uint32_t cmdCount, Cmd*** pppCmds)
+{
+    ASSERT(pRenderer);
+    ASSERT(pDesc);
+    ASSERT(cmdCount);
+    ASSERT(pppCmds);
+
+    Cmd** ppCmds = (Cmd**)tf_calloc(cmdCount, sizeof(Cmd*));
+    ASSERT(ppCmds);
+
+    for (uint32_t i = 0; i < cmdCount; ++i)
+    {
+        initCmd(pRenderer, pDesc, &ppCmds[i]);
+    }
+
+    *pppCmds = ppCmds;
+}
+
+void exitCmd_n(Renderer* pRenderer, uint32_t cmdCount, Cmd** ppCmds)
+{
+    ASSERT(ppCmds);
+
+    for (uint32_t i = 0; i < cmdCount; ++i)
+    {
+        exitCmd(pRenderer, ppCmds[i]);
+    }
+
+    SAFE_FREE(ppCmds);
+}
+
+void resetCmdPool(Renderer* pRenderer, CmdPool* pCmdPool)
+{
+    UNREF_PARAM(pRenderer);
+    UNREF_PARAM(pCmdPool);
+}
+/************************************************************************/
+// Memory Functions
+/************************************************************************/
+void addResourceHeap(Renderer* pRenderer, const ResourceHeapDesc* pDesc, ResourceHeap** ppHeap)
+{
+    ASSERT(pRenderer);
+    ASSERT(pDesc);
+    ASSERT(ppHeap);
+
+    ResourceHeap* pHeap = (ResourceHeap*)tf_calloc_memalign(1, alignof(ResourceHeap), sizeof(ResourceHeap));
+    ASSERT(pHeap);
+
+    pHeap->mNull.pCpuData = null_alloc_memory(pDesc->mSize);
+    pHeap->mSize = pDesc->mSize;
+
+    *ppHeap = pHeap;
+}
+
+void removeResourceHeap(Renderer* pRenderer, ResourceHeap* pHeap)
+{
+    ASSERT(pRenderer);
+    ASSERT(pHeap);
+
+    null_free_memory(pHeap->mNull.pCpuData, pHeap->mSize);
+    SAFE_FREE(pHeap);
+}
+
+void getBufferSizeAlign(Renderer* pRenderer, const BufferDesc* pDesc, ResourceSizeAlign* pOut)
+{
+    ASSERT(pRenderer);
+    ASSERT(pDesc);
+    ASSERT(pOut);
+
+    pOut->mSize = pDesc->mSize;
+    if (pDesc->mDescriptors & DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+    {
+        pOut->mSize = round_up_64(pOut->mSize, pRenderer->pGpu->mUniformBufferAlignment);
+    }
+    pOut->mAlignment = NULL_RESOURCE_ALIGNMENT;
+}
+
+void getTextureSizeAlign(Renderer* pRenderer, const TextureDesc* pDesc, ResourceSizeAlign* pOut)
+{
+    UNREF_PARAM(pRenderer);
+    ASSERT(pDesc);
+    ASSERT(pOut);
+
+    pOut->mSize = util_get_texture_size(pDesc);
+    pOut->mAlignment = NULL_RESOURCE_ALIGNMENT;
+}
+
+void addBuffer(Renderer* pRenderer, const BufferDesc* pDesc, Buffer** ppBuffer)
+{
+    ASSERT(pRenderer);
+    ASSERT(pDesc);
+    ASSERT(pDesc->mSize > 0);
+    ASSERT(ppBuffer);
+
+    Buffer* pBuffer = (Buffer*)tf_calloc_memalign(1, alignof(Buffer), sizeof(Buffer));
+    ASSERT(pBuffer);
+
+    ResourceSizeAlign sizeAlign = {};
+    getBufferSizeAlign(pRenderer, pDesc, &sizeAlign);
+
+    if (pDesc->pPlacement)
+    {
+        ASSERT(pDesc->pPlacement->mOffset + sizeAlign.mSize <= pDesc->pPlacement->pHeap->mSize);
+        pBuffer->mNull.pCpuData = (uint8_t*)pDesc->pPlacement->pHeap->mNull.pCpuData + pDesc->pPlacement->mOffset;
+    }
+    else
+    {
+        pBuffer->mNull.pCpuData = null_alloc_memory(sizeAlign.mSize);
+        pBuffer->mNull.mOwnsMemory = true;
+    }
+
+    if (pDesc->mFlags & BUFFER_CREATION_FLAG_PERSISTENT_MAP_BIT)
+    {
+        pBuffer->pCpuMappedAddress = pBuffer->mNull.pCpuData;
+    }
+
+    pBuffer->mSize = (uint32_t)pDesc->mSize;
+    pBuffer->mMemoryUsage = pDesc->mMemoryUsage;
+    pBuffer->mNodeIndex = pDesc->mNodeIndex;
+    pBuffer->mDescriptors = pDesc->mDescriptors;
+
+    *ppBuffer = pBuffer;
+}
+
+void removeBuffer(Renderer* pRenderer, Buffer* pBuffer)
+{
+    ASSERT(pRenderer);
+    ASSERT(pBuffer);
+
+    if (pBuffer->mNull.mOwnsMemory)
+    {
+        ResourceSizeAlign sizeAlign = {};
+        BufferDesc        desc = {};
+        desc.mSize = pBuffer->mSize;
+        desc.mDescriptors = (DescriptorType)pBuffer->mDescriptors;
+        getBufferSizeAlign(pRenderer, &desc, &sizeAlign);
+        null_free_memory(pBuffer->mNull.pCpuData, sizeAlign.mSize);
+    }
+
+    SAFE_FREE(pBuffer);
+}
+
+void mapBuffer(Renderer* pRenderer, Buffer* pBuffer, ReadRange* pRange)
+{
+    UNREF_PARAM(pRenderer);
+    ASSERT(pBuffer);
+    ASSERT(pBuffer->mMemoryUsage != RESOURCE_MEMORY_USAGE_GPU_ONLY && "Trying to map non-cpu accessible resource");
+
+    pBuffer->pCpuMappedAddress = (uint8_t*)pBuffer->mNull.pCpuData + (pRange ? pRange->mOffset : 0);
+}
+
+void unmapBuffer(Renderer* pRenderer, Buffer* pBuffer)
+{
+    UNREF_PARAM(pRenderer);
+    ASSERT(pBuffer);
+
+    pBuffer->pCpuMappedAddress = NULL;
+}
+
+void addTexture(Renderer* pRenderer, const TextureDesc* pDesc, Texture** ppTexture)
+{
+    ASSERT(pRenderer);
+    ASSERT(pDesc && pDesc->mWidth && pDesc->mHeight && (pDesc->mDepth || pDesc->mArraySize));
+    ASSERT(ppTexture);
+
+    Texture* pTexture = (Texture*)tf_calloc_memalign(1, alignof(Texture), sizeof(Texture));
+    ASSERT(pTexture);
+
+    pTexture->mWidth = pDesc->mWidth;
+    pTexture->mHeight = pDesc->mHeight;
+    pTexture->mDepth = max(1u, pDesc->mDepth);
+    pTexture->mMipLevels = max(1u, pDesc->mMipLevels);
+    pTexture->mArraySizeMinusOne = max(1u, pDesc->mArraySize) - 1;
+    pTexture->mFormat = pDesc->mFormat;
+    pTexture->mSampleCount = pDesc->mSampleCount;
+    pTexture->mNodeIndex = pDesc->mNodeIndex;
+    pTexture->mUav = (pDesc->mDescriptors & DESCRIPTOR_TYPE_RW_TEXTURE) ? 1 : 0;
+    pTexture->mOwnsImage = !pDesc->pNativeHandle && !pDesc->pPlacement;
+
+    // Render targets are never read back on the CPU, only textures get memory
+    if (pDesc->pPlacement)
+    {
+        pTexture->mNull.pCpuData = (uint8_t*)pDesc->pPlacement->pHeap->mNull.pCpuData + pDesc->pPlacement->mOffset;
+    }
+    else if (pTexture->mOwnsImage && !(pDesc->mStartState & (RESOURCE_STATE_RENDER_TARGET | RESOURCE_STATE_DEPTH_WRITE)) &&
+             !(pDesc->mFlags & TEXTURE_CREATION_FLAG_ALLOW_DISPLAY_TARGET))
+    {
+        pTexture->mNull.pCpuData = null_alloc_memory(util_get_texture_size(pDesc));
+    }
+    else
+    {
+        pTexture->mOwnsImage = false;
+    }
+
+    *ppTexture = pTexture;
+}
+
+void removeTexture(Renderer* pRenderer, Texture* pTexture)
+{
+    ASSERT(pRenderer);
+    ASSERT(pTexture);
+
+    if (pTexture->mOwnsImage)
+    {
+        TextureDesc desc = {};
+        desc.mWidth = pTexture->mWidth;
+        desc.mHeight = pTexture->mHeight;
+        desc.mDepth = pTexture->mDepth;
+        desc.mMipLevels = pTexture->mMipLevels;
+        desc.mArraySize = pTexture->mArraySizeMinusOne + 1;
+        desc.mFormat = (TinyImageFormat)pTexture->mFormat;
+        null_free_memory(pTexture->mNull.pCpuData, util_get_texture_size(&desc));
+    }
+
+    SAFE_FREE(pTexture);
+}
+
+void addRenderTarget(Renderer* pRenderer, const RenderTargetDesc* pDesc, RenderTarget** ppRenderTarget)
+{
+    ASSERT(pRenderer);
+    ASSERT(pDesc);
+    ASSERT(ppRenderTarget);
+
+    RenderTarget* pRenderTarget = (RenderTarget*)tf_calloc_memalign(1, alignof(RenderTarget), sizeof(RenderTarget));
+    ASSERT(pRenderTarget);
+
+    const bool isDepth = TinyImageFormat_HasDepth(pDesc->mFormat);
+
+    TextureDesc textureDesc = {};
+    textureDesc.mArraySize = pDesc->mArraySize;
+    textureDesc.mClearValue = pDesc->mClearValue;
+    textureDesc.mDepth = pDesc->mDepth;
+    textureDesc.mFlags = pDesc->mFlags;
+    textureDesc.mFormat = pDesc->mFormat;
+    textureDesc.mWidth = pDesc->mWidth;
+    textureDesc.mHeight = pDesc->mHeight;
+    textureDesc.mMipLevels = max(1u, pDesc->mMipLevels);
+    textureDesc.mSampleCount = pDesc->mSampleCount;
+    textureDesc.mSampleQuality = pDesc->mSampleQuality;
+    textureDesc.mStartState = isDepth ? RESOURCE_STATE_DEPTH_WRITE : RESOURCE_STATE_RENDER_TARGET;
+    textureDesc.pNativeHandle = pDesc->pNativeHandle;
+    textureDesc.pName = pDesc->pName;
+    textureDesc.mNodeIndex = pDesc->mNodeIndex;
+    textureDesc.mDescriptors = pDesc->mDescriptors;
+    addTexture(pRenderer, &textureDesc, &pRenderTarget->pTexture);
+
+    pRenderTarget->mWidth = pDesc->mWidth;
+    pRenderTarget->mHeight = pDesc->mHeight;
+    pRenderTarget->mArraySize = pDesc->mArraySize;
+    pRenderTarget->mDepth = pDesc->mDepth;
+    pRenderTarget->mMipLevels = textureDesc.mMipLevels;
+    pRenderTarget->mSampleCount = pDesc->mSampleCount;
+    pRenderTarget->mSampleQuality = pDesc->mSampleQuality;
+    pRenderTarget->mFormat = pDesc->mFormat;
+    pRenderTarget->mClearValue = pDesc->mClearValue;
+    pRenderTarget->mDescriptors = pDesc->mDescriptors;
+
+    *ppRenderTarget = pRenderTarget;
+}
+
+void removeRenderTarget(Renderer* pRenderer, RenderTarget* pRenderTarget)
+{
+    ASSERT(pRenderTarget);
+
+    removeTexture(pRenderer, pRenderTarget->pTexture);
+    SAFE_FREE(pRenderTarget);
+}
+
+void addSampler(Renderer* pRenderer, const SamplerDesc* pDesc, Sampler** ppSampler)
+{
+    ASSERT(pRenderer);
+    ASSERT(pDesc);
+    ASSERT(ppSampler);
+
+    Sampler* pSampler = (Sampler*)tf_calloc_memalign(1, alignof(Sampler), sizeof(Sampler));
+    ASSERT(pSampler);
+
+    *ppSampler = pSampler;
+}
+
+void removeSampler(Renderer* pRenderer, Sampler* pSampler)
+{
+    ASSERT(pRenderer);
+    ASSERT(pSampler);
+
+    SAFE_FREE(pSampler);
+}
+/************************************************************************/
+// Shader Functions
+/************************************************************************/
+void addShaderBinary(Renderer* pRenderer, const BinaryShaderDesc* pDesc, Shader** ppShaderProgram)
+{
+    ASSERT(pRenderer);
+    ASSERT(pDesc);
+    ASSERT(ppShaderProgram);
+
+    // Bytecode is not used and there is no reflection, root signatures have no descriptors
+    Shader* pShaderProgram = (Shader*)tf_calloc(1, sizeof(Shader));
+    ASSERT(pShaderProgram);
+
+    pShaderProgram->mStages = pDesc->mStages;
+
+    *ppShaderProgram = pShaderProgram;
+}
+
+void removeShader(Renderer* pRenderer, Shader* pShaderProgram)
+{
+    ASSERT(pRenderer);
+    ASSERT(pShaderProgram);
+
+    SAFE_FREE(pShaderProgram);
+}
+
+void addRootSignature(Renderer* pRenderer, const RootSignatureDesc* pDesc, RootSignature** ppRootSignature)
+{
+    ASSERT(pRenderer);
+    ASSERT(pDesc);
+    ASSERT(ppRootSignature);
+
+    RootSignature* pRootSignature = (RootSignature*)tf_calloc_memalign(1, alignof(RootSignature), sizeof(RootSignature));
+    ASSERT(pRootSignature);
+
+    pRootSignature->mPipelineType = PIPELINE_TYPE_GRAPHICS;
+    for (uint32_t i = 0; i < pDesc->mShaderCount; ++i)
+    {
+        if (pDesc->ppShaders[i]->mStages & SHADER_STAGE_COMP)
+        {
+            pRootSignature->mPipelineType = PIPELINE_TYPE_COMPUTE;
+        }
+    }
+
+    *ppRootSignature = pRootSignature;
+}
+
+void removeRootSignature(Renderer* pRenderer, RootSignature* pRootSignature)
+{
+    ASSERT(pRenderer);
+    ASSERT(pRootSignature);
+
+    SAFE_FREE(pRootSignature);
+}
+
+uint32_t getDescriptorIndexFromName(const RootSignature* pRootSignature, const char* pName)
+{
+    UNREF_PARAM(pRootSignature);
+    UNREF_PARAM(pName);
+    return UINT32_MAX;
+}
+/************************************************************************/
+// Pipeline Functions
+/************************************************************************/
+void addPipeline(Renderer* pRenderer, const PipelineDesc* pDesc, Pipeline** ppPipeline)
+{
+    ASSERT(pRenderer);
+    ASSERT(pDesc);
+    ASSERT(ppPipeline);
+
+    Pipeline* pPipeline = (Pipeline*)tf_calloc_memalign(1, alignof(Pipeline), sizeof(Pipeline));
+    ASSERT(pPipeline);
+
+    *ppPipeline = pPipeline;
+}
+
+void removePipeline(Renderer* pRenderer, Pipeline* pPipeline)
+{
+    ASSERT(pRenderer);
+    ASSERT(pPipeline);
+
+    SAFE_FREE(pPipeline);
+}
+
+void addPipelineCache(Renderer* pRenderer, const PipelineCacheDesc* pDesc, PipelineCache** ppPipelineCache)
+{
+    ASSERT(pRenderer);
+    ASSERT(pDesc);
+    ASSERT(ppPipelineCache);
+
+    PipelineCache* pPipelineCache = (PipelineCache*)tf_calloc(1, sizeof(PipelineCache));
+    ASSERT(pPipelineCache);
+
+    *ppPipelineCache = pPipelineCache;
+}
+
+void removePipelineCache(Renderer* pRenderer, PipelineCache* pPipelineCache)
+{
+    ASSERT(pRenderer);
+    ASSERT(pPipelineCache);
+
+    SAFE_FREE(pPipelineCache);
+}
+
+void getPipelineCacheData(Renderer* pRenderer, PipelineCache* pPipelineCache, size_t* pSize, void* pData)
+{
+    UNREF_PARAM(pRenderer);
+    UNREF_PARAM(pPipelineCache);
+    UNREF_PARAM(pData);
+    ASSERT(pSize);
+
+    *pSize = 0;
+}
+/************************************************************************/
+// Descriptor Set Functions
+/************************************************************************/
+void addDescriptorSet(Renderer* pRenderer, const DescriptorSetDesc* pDesc, DescriptorSet** ppDescriptorSet)
+{
+    ASSERT(pRenderer);
+    ASSERT(pDesc);
+    ASSERT(ppDescriptorSet);
+
+    DescriptorSet* pDescriptorSet = (DescriptorSet*)tf_calloc_memalign(1, alignof(DescriptorSet), sizeof(DescriptorSet));
+    ASSERT(pDescriptorSet);
+
+    *ppDescriptorSet = pDescriptorSet;
+}
+
+void removeDescriptorSet(Renderer* pRenderer, DescriptorSet* pDescriptorSet)
+{
+    ASSERT(pRenderer);
+    ASSERT(pDescriptorSet);
+
+    SAFE_FREE(pDescriptorSet);
+}
+
+void updateDescriptorSet(Renderer* pRenderer, uint32_t index, DescriptorSet* pDescriptorSet, uint32_t count, const DescriptorData* pParams)
+{
+    UNREF_PARAM(pRenderer);
+    UNREF_PARAM(index);
+    UNREF_PARAM(count);
+    UNREF_PARAM(pParams);
+    ASSERT(pDescriptorSet);
+}
+/************************************************************************/
+// Command buffer Functions
+/************************************************************************/
+void beginCmd(Cmd* pCmd) { ASSERT(pCmd); }
+
+void endCmd(Cmd* pCmd) { ASSERT(pCmd); }
+
+void cmdBindRenderTargets(Cmd* pCmd, const BindRenderTargetsDesc* pDesc)
+{
+    UNREF_PARAM(pCmd);
+    UNREF_PARAM(pDesc);
+}
+
+void cmdSetViewport(Cmd* pCmd, float x, float y, float width, float height, float minDepth, float maxDepth)
+{
+    UNREF_PARAM(pCmd);
+    UNREF_PARAM(x);
+    UNREF_PARAM(y);
+    UNREF_PARAM(width);
+    UNREF_PARAM(height);
+    UNREF_PARAM(minDepth);
+    UNREF_PARAM(maxDepth);
+}
+
+void cmdSetScissor(Cmd* pCmd, uint32_t x, uint32_t y, uint32_t width, uint32_t height)
+{
+    UNREF_PARAM(pCmd);
+    UNREF_PARAM(x);
+    UNREF_PARAM(y);
+    UNREF_PARAM(width);
+    UNREF_PARAM(height);
+}
+
+void cmdSetStencilReferenceValue(Cmd* pCmd, uint32_t val)
+{
+    UNREF_PARAM(pCmd);
+    UNREF_PARAM(val);
+}
+
+void cmdBindPipeline(Cmd* pCmd, Pipeline* pPipeline)
+{
+    UNREF_PARAM(pCmd);
+    UNREF_PARAM(pPipeline);
+}
+
+void cmdBindDescriptorSet(Cmd* pCmd, uint32_t index, DescriptorSet* pDescriptorSet)
+{
+    UNREF_PARAM(pCmd);
+    UNREF_PARAM(index);
+    UNREF_PARAM(pDescriptorSet);
+}
+
+void cmdBindPushConstants(Cmd* pCmd, RootSignature* pRootSignature, uint32_t paramIndex, const void* pConstants)
+{
+    UNREF_PARAM(pCmd);
+    UNREF_PARAM(pRootSignature);
+    UNREF_PARAM(paramIndex);
+    UNREF_PARAM(pConstants);
+}
+
+void cmdBindDescriptorSetWithRootCbvs(Cmd* pCmd, uint32_t index, DescriptorSet* pDescriptorSet, uint32_t count,
+                                      const DescriptorData* pParams)
+{
+    UNREF_PARAM(pCmd);
+    UNREF_PARAM(index);
+    UNREF_PARAM(pDescriptorSet);
+    UNREF_PARAM(count);
+    UNREF_PARAM(pParams);
+}
+
+void cmdBindIndexBuffer(Cmd* pCmd, Buffer* pBuffer, uint32_t indexType, uint64_t offset)
+{
+    UNREF_PARAM(pCmd);
+    UNREF_PARAM(pBuffer);
+    UNREF_PARAM(indexType);
+    UNREF_PARAM(offset);
+}
+
+void cmdBindVertexBuffer(Cmd* pCmd, uint32_t bufferCount, Buffer** ppBuffers, const uint32_t* pStrides, const uint64_t* pOffsets)
+{
+    UNREF_PARAM(pCmd);
+    UNREF_PARAM(bufferCount);
+    UNREF_PARAM(ppBuffers);
+    UNREF_PARAM(pStrides);
+    UNREF_PARAM(pOffsets);
+}
+
+void cmdDraw(Cmd* pCmd, uint32_t vertexCount, uint32_t firstVertex)
+{
+    UNREF_PARAM(pCmd);
+    UNREF_PARAM(vertexCount);
+    UNREF_PARAM(firstVertex);
+}
+
+void cmdDrawInstanced(Cmd* pCmd, uint32_t vertexCount, uint32_t firstVertex, uint32_t instanceCount, uint32_t firstInstance)
+{
+    UNREF_PARAM(pCmd);
+    UNREF_PARAM(vertexCount);
+    UNREF_PARAM(firstVertex);
+    UNREF_PARAM(instanceCount);
+    UNREF_PARAM(firstInstance);
+}
+
+void cmdDrawIndexed(Cmd* pCmd, uint32_t indexCount, uint32_t firstIndex, uint32_t firstVertex)
+{
+    UNREF_PARAM(pCmd);
+    UNREF_PARAM(indexCount);
+    UNREF_PARAM(firstIndex);
+    UNREF_PARAM(firstVertex);
+}
+
+void cmdDrawIndexedInstanced(Cmd* pCmd, uint32_t indexCount, uint32_t firstIndex, uint32_t instanceCount, uint32_t firstVertex,
+                             uint32_t firstInstance)
+{
+    UNREF_PARAM(pCmd);
+    UNREF_PARAM(indexCount);
+    UNREF_PARAM(firstIndex);
+    UNREF_PARAM(instanceCount);
+    UNREF_PARAM(firstVertex);
+    UNREF_PARAM(firstInstance);
+}
+
+void cmdDispatch(Cmd* pCmd, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+    UNREF_PARAM(pCmd);
+    UNREF_PARAM(groupCountX);
+    UNREF_PARAM(groupCountY);
+    UNREF_PARAM(groupCountZ);
+}
+
+void cmdExecuteIndirect(Cmd* pCmd, IndirectArgumentType type, unsigned int maxCommandCount, Buffer* pIndirectBuffer, uint64_t bufferOffset,
+                        Buffer* pCounterBuffer, uint64_t counterBufferOffset)
+{
+    UNREF_PARAM(pCmd);
+    UNREF_PARAM(type);
+    UNREF_PARAM(maxCommandCount);
+    UNREF_PARAM(pIndirectBuffer);
+    UNREF_PARAM(bufferOffset);
+    UNREF_PARAM(pCounterBuffer);
+    UNREF_PARAM(counterBufferOffset);
+}
+
+void cmdResourceBarrier(Cmd* pCmd, uint32_t bufferBarrierCount, BufferBarrier* pBufferBarriers, uint32_t textureBarrierCount,
+                        TextureBarrier* pTextureBarriers, uint32_t rtBarrierCount, RenderTargetBarrier* pRtBarriers)
+{
+    UNREF_PARAM(pCmd);
+    UNREF_PARAM(bufferBarrierCount);
+    UNREF_PARAM(pBufferBarriers);
+    UNREF_PARAM(textureBarrierCount);
+    UNREF_PARAM(pTextureBarriers);
+    UNREF_PARAM(rtBarrierCount);
+    UNREF_PARAM(pRtBarriers);
+}
+
+void cmdUpdateBuffer(Cmd* pCmd, Buffer* pBuffer, uint64_t dstOffset, Buffer* pSrcBuffer, uint64_t srcOffset, uint64_t size)
+{
+    UNREF_PARAM(pCmd);
+    ASSERT(pBuffer);
+    ASSERT(pSrcBuffer);
+    ASSERT(srcOffset + size <= pSrcBuffer->mSize);
+    ASSERT(dstOffset + size <= pBuffer->mSize);
+
+    memcpy((uint8_t*)pBuffer->mNull.pCpuData + dstOffset, (uint8_t*)pSrcBuffer->mNull.pCpuData + srcOffset, (size_t)size);
+}
+
+void cmdUpdateSubresource(Cmd* pCmd, Texture* pTexture, Buffer* pSrcBuffer, const SubresourceDataDesc* pSubresourceDesc)
+{
+    UNREF_PARAM(pCmd);
+    ASSERT(pTexture);
+    ASSERT(pSrcBuffer);
+    ASSERT(pSubresourceDesc);
+
+    util_copy_subresource(pTexture, (uint8_t*)pSrcBuffer->mNull.pCpuData, pSubresourceDesc, true);
+}
+
+void cmdCopySubresource(Cmd* pCmd, Buffer* pDstBuffer, Texture* pTexture, const SubresourceDataDesc* pSubresourceDesc)
+{
+    UNREF_PARAM(pCmd);
+    ASSERT(pDstBuffer);
+    ASSERT(pTexture);
+    ASSERT(pSubresourceDesc);
+
+    // Render targets have no memory, zeroes are written for their content
+    util_copy_subresource(pTexture, (uint8_t*)pDstBuffer->mNull.pCpuData, pSubresourceDesc, false);
+}
+/************************************************************************/
+// GPU Query Implementation
+/************************************************************************/
+void getTimestampFrequency(Queue* pQueue, double* pFrequency)
+{
+    UNREF_PARAM(pQueue);
+    ASSERT(pFrequency);
+
+    *pFrequency = 1000000000.0;
+}
+
+void initQueryPool(Renderer* pRenderer, const QueryPoolDesc* pDesc, QueryPool** ppQueryPool)
+{
+    ASSERT(pRenderer);
+    ASSERT(pDesc);
+    ASSERT(ppQueryPool);
+
+    QueryPool* pQueryPool = (QueryPool*)tf_calloc(1, sizeof(QueryPool));
+    ASSERT(pQueryPool);
+
+    pQueryPool->mCount = pDesc->mQueryCount;
+    pQueryPool->mStride = 1;
+
+    *ppQueryPool = pQueryPool;
+}
+
+void exitQueryPool(Renderer* pRenderer, QueryPool* pQueryPool)
+{
+    ASSERT(pRenderer);
+    ASSERT(pQueryPool);
+
+    SAFE_FREE(pQueryPool);
+}
+
+void cmdBeginQuery(Cmd* pCmd, QueryPool* pQueryPool, QueryDesc* pQuery)
+{
+    UNREF_PARAM(pCmd);
+    UNREF_PARAM(pQueryPool);
+    UNREF_PARAM(pQuery);
+}
+
+void cmdEndQuery(Cmd* pCmd, QueryPool* pQueryPool, QueryDesc* pQuery)
+{
+    UNREF_PARAM(pCmd);
+    UNREF_PARAM(pQueryPool);
+    UNREF_PARAM(pQuery);
+}
+
+void cmdResolveQuery(Cmd* pCmd, QueryPool* pQueryPool, uint32_t startQuery, uint32_t queryCount)
+{
+    UNREF_PARAM(pCmd);
+    UNREF_PARAM(pQueryPool);
+    UNREF_PARAM(startQuery);
+    UNREF_PARAM(queryCount);
+}
+
+void cmdResetQuery(Cmd* pCmd, QueryPool* pQueryPool, uint32_t startQuery, uint32_t queryCount)
+{
+    UNREF_PARAM(pCmd);
+    UNREF_PARAM(pQueryPool);
+    UNREF_PARAM(startQuery);
+    UNREF_PARAM(queryCount);
+}
+
+void getQueryData(Renderer* pRenderer, QueryPool* pQueryPool, uint32_t queryIndex, QueryData* pOutData)
+{
+    UNREF_PARAM(pRenderer);
+    UNREF_PARAM(pQueryPool);
+    UNREF_PARAM(queryIndex);
+    ASSERT(pOutData);
+
+    // Queries complete immediately with zero results
+    *pOutData = {};
+    pOutData->mValid = true;
+}
+/************************************************************************/
+// Memory Stats Implementation
+/************************************************************************/
+void logMemoryStats(Renderer* pRenderer)
+{
+    UNREF_PARAM(pRenderer);
+    LOGF(LogLevel::eINFO, "Null renderer resource memory: %llu bytes",
+         (unsigned long long)tfrg_atomic64_load_relaxed(&gNullAllocatedMemory));
+}
+
+void calculateMemoryUse(Renderer* pRenderer, uint64_t* usedBytes, uint64_t* totalAllocatedBytes)
+{
+    UNREF_PARAM(pRenderer);
+    *usedBytes = tfrg_atomic64_load_relaxed(&gNullAllocatedMemory);
+    *totalAllocatedBytes = *usedBytes;
+}
+/************************************************************************/
+// Debug Marker Implementation
+/************************************************************************/
+void cmdBeginDebugMarker(Cmd* pCmd, float r, float g, float b, const char* pName)
+{
+    UNREF_PARAM(pCmd);
+    UNREF_PARAM(r);
+    UNREF_PARAM(g);
+    UNREF_PARAM(b);
+    UNREF_PARAM(pName);
+}
+
+void cmdEndDebugMarker(Cmd* pCmd) { UNREF_PARAM(pCmd); }
+
+void cmdAddDebugMarker(Cmd* pCmd, float r, float g, float b, const char* pName)
+{
+    UNREF_PARAM(pCmd);
+    UNREF_PARAM(r);
+    UNREF_PARAM(g);
+    UNREF_PARAM(b);
+    UNREF_PARAM(pName);
+}
+
+void cmdWriteMarker(Cmd* pCmd, const MarkerDesc* pDesc)
+{
+    UNREF_PARAM(pCmd);
+    ASSERT(pDesc && pDesc->pBuffer);
+
+    // Markers are written in order, all previous work is complete
+    *(uint32_t*)((uint8_t*)pDesc->pBuffer->mNull.pCpuData + pDesc->mOffset) = pDesc->mValue;
+}
+/************************************************************************/
+// Resource Debug Naming Interface
+/************************************************************************/
+void setBufferName(Renderer* pRenderer, Buffer* pBuffer, const char* pName)
+{
+    UNREF_PARAM(pRenderer);
+    UNREF_PARAM(pBuffer);
+    UNREF_PARAM(pName);
+}
+
+void setTextureName(Renderer* pRenderer, Texture* pTexture, const char* pName)
+{
+    UNREF_PARAM(pRenderer);
+    UNREF_PARAM(pTexture);
+    UNREF_PARAM(pName);
+}
+
+void setRenderTargetName(Renderer* pRenderer, RenderTarget* pRenderTarget, const char* pName)
+{
+    UNREF_PARAM(pRenderer);
+    UNREF_PARAM(pRenderTarget);
+    UNREF_PARAM(pName);
+}
+
+void setPipelineName(Renderer* pRenderer, Pipeline* pPipeline, const char* pName)
+{
+    UNREF_PARAM(pRenderer);
+    UNREF_PARAM(pPipeline);
+    UNREF_PARAM(pName);
+}
+
+#endif
@@ -38,6 +38,8 @@
 extern "C"
 {
     void                         parse_path_statement(char* PathStatment, size_t size);
+    bool                         unixFsInitAsyncReads(void);
+    void                         unixFsExitAsyncReads(void);
     extern ResourceDirectoryInfo gResourceDirectories[RD_COUNT];
 }
 
@@ -167,6 +169,7 @@ static IFileSystem gBundledFileIO = {
     NULL,
     NULL,
     NULL,
+    NULL,
 };
 
 IFileSystem* pSystemFileIO = &gBundledFileIO;
@@ -220,8 +223,15 @@ bool initFileSystem(FileSystemInitDesc* pDesc)
     mkdir(gResourceDirectories[RD_SCREENSHOTS].mPath, 0700);
 #endif
 
+    if (!unixFsInitAsyncReads())
+        return false;
+
     gInitialized = true;
     return true;
 }
 
-void exitFileSystem() { gInitialized = false; }
+void exitFileSystem()
+{
+    unixFsExitAsyncReads();
+    gInitialized = false;
+}
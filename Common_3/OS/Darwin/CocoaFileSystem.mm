@@ -37,6 +37,8 @@ static bool gInitialized = false;
 extern "C"
 {
     void                         parse_path_statement(char* PathStatment, size_t size);
+    bool                         unixFsInitAsyncReads(void);
+    void                         unixFsExitAsyncReads(void);
     extern ResourceDirectoryInfo gResourceDirectories[RD_COUNT];
 }
 
@@ -133,8 +135,15 @@ bool initFileSystem(FileSystemInitDesc* pDesc)
 #endif
     }
 
+    if (!unixFsInitAsyncReads())
+        return false;
+
     gInitialized = true;
     return true;
 }
 
-void exitFileSystem() { gInitialized = false; }
+void exitFileSystem()
+{
+    unixFsExitAsyncReads();
+    gInitialized = false;
+}
@@ -38,6 +38,8 @@ static bool gInitialized = false;
 
 extern ResourceDirectoryInfo gResourceDirectories[RD_COUNT];
 void                         parse_path_statement(char* PathStatment, size_t size);
+bool                         unixFsInitAsyncReads(void);
+void                         unixFsExitAsyncReads(void);
 
 bool initFileSystem(FileSystemInitDesc* pDesc)
 {
@@ -73,8 +75,15 @@ bool initFileSystem(FileSystemInitDesc* pDesc)
         tf_free(buffer);
     }
 
+    if (!unixFsInitAsyncReads())
+        return false;
+
     gInitialized = true;
     return true;
 }
 
-void exitFileSystem(void) { gInitialized = false; }
+void exitFileSystem(void)
+{
+    unixFsExitAsyncReads();
+    gInitialized = false;
+}
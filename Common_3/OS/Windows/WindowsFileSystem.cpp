@@ -106,7 +106,11 @@ struct WindowsFileStream
     HANDLE handle;
     HANDLE fileMapping;
     LPVOID mapView;
+    // Overlapped handle for ReadAt, created on first use.
+    // ReadFile on 'handle' would move the file pointer under the CRT buffer.
+    HANDLE readAtHandle;
 };
+COMPILE_ASSERT(sizeof(WindowsFileStream) <= sizeof(FileStreamUserData));
 
 #define WSD(name, fs) struct WindowsFileStream* name = (struct WindowsFileStream*)(fs)->mUser.data
 
@@ -140,7 +144,7 @@ public:
 
 static inline FORGE_CONSTEXPR const char* fsFileModeToString(FileMode mode)
 {
-    mode = (FileMode)(mode & ~FM_ALLOW_READ);
+    mode = (FileMode)(mode & ~(FM_ALLOW_READ | FM_UNBUFFERED));
     switch (mode)
     {
     case FM_READ:
@@ -160,7 +164,7 @@ static inline FORGE_CONSTEXPR const char* fsFileModeToString(FileMode mode)
 
 static inline FORGE_CONSTEXPR const char* fsOverwriteFileModeToString(FileMode mode)
 {
-    switch (mode)
+    switch (mode & ~FM_UNBUFFERED)
     {
     case FM_READ_WRITE:
         return "wb+";
@@ -228,6 +232,11 @@ bool PlatformOpenFile(ResourceDirectory resourceDir, const char* fileName, FileM
         WSD(stream, pOut);
         stream->file = fp;
 
+        if (mode & FM_UNBUFFERED)
+        {
+            setvbuf(fp, NULL, _IONBF, 0);
+        }
+
         stream->handle = (HANDLE)_get_osfhandle(_fileno(fp));
         if (stream->handle == INVALID_HANDLE_VALUE)
         {
@@ -315,6 +324,12 @@ static bool ioWindowsFsClose(FileStream* fs)
         stream->fileMapping = INVALID_HANDLE_VALUE;
     }
 
+    if (stream->readAtHandle)
+    {
+        CloseHandle(stream->readAtHandle);
+        stream->readAtHandle = NULL;
+    }
+
     if (fclose(stream->file) == EOF)
     {
         LOGF(LogLevel::eERROR, "Error closing system FileStream: %s (%x)", strerror(errno), errno);
@@ -335,6 +350,83 @@ static size_t ioWindowsFsRead(FileStream* fs, void* dst, size_t size)
     return read;
 }
 
+static HANDLE getReadAtHandle(WindowsFileStream* stream)
+{
+    HANDLE handle = (HANDLE)InterlockedCompareExchangePointer(&stream->readAtHandle, NULL, NULL);
+    if (handle)
+        return handle;
+
+    handle = ReOpenFile(stream->handle, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, FILE_FLAG_OVERLAPPED);
+    if (handle == INVALID_HANDLE_VALUE)
+    {
+        LOGF(LogLevel::eERROR, "Failed to reopen file for positional reads: %s", WindowsErrorString().c_str());
+        return NULL;
+    }
+
+    // Several threads might reopen at once, first one wins
+    HANDLE previous = (HANDLE)InterlockedCompareExchangePointer(&stream->readAtHandle, handle, NULL);
+    if (previous)
+    {
+        CloseHandle(handle);
+        return previous;
+    }
+    return handle;
+}
+
+static size_t ioWindowsFsReadAt(FileStream* fs, void* dst, size_t size, uint64_t offset)
+{
+    WSD(stream, fs);
+
+    HANDLE handle = getReadAtHandle(stream);
+    if (!handle)
+        return 0;
+
+    // Event per call, reads of the same handle from several threads must not wait on the handle itself
+    HANDLE readEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (!readEvent)
+    {
+        LOGF(LogLevel::eERROR, "Failed to create read event: %s", WindowsErrorString().c_str());
+        return 0;
+    }
+
+    // Overlapped handle has no file pointer, reads from several threads don't interfere
+    // and the CRT stream position stays intact.
+    size_t readBytes = 0;
+    while (readBytes < size)
+    {
+        const uint64_t position = offset + readBytes;
+        const size_t   remaining = size - readBytes;
+
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = (DWORD)position;
+        overlapped.OffsetHigh = (DWORD)(position >> 32);
+        overlapped.hEvent = readEvent;
+
+        DWORD read = 0;
+        BOOL  success =
+            ReadFile(handle, (uint8_t*)dst + readBytes, remaining > UINT32_MAX ? UINT32_MAX : (DWORD)remaining, NULL, &overlapped);
+        if (success || GetLastError() == ERROR_IO_PENDING)
+        {
+            success = GetOverlappedResult(handle, &overlapped, &read, TRUE);
+        }
+        if (!success)
+        {
+            if (GetLastError() != ERROR_HANDLE_EOF)
+            {
+                LOGF(LogLevel::eERROR, "Error reading %s bytes at offset %llu from file: %s", humanReadableSize(size).str,
+                     (unsigned long long)offset, WindowsErrorString().c_str());
+            }
+            break;
+        }
+        if (read == 0)
+            break;
+        readBytes += read;
+    }
+
+    CloseHandle(readEvent);
+    return readBytes;
+}
+
 static size_t ioWindowsFsWrite(FileStream* fs, const void* src, size_t size)
 {
     if ((fs->mMode & (FM_WRITE | FM_APPEND)) == 0)
@@ -426,7 +518,63 @@ static IFileSystem gWindowsFileIO = {
     NULL,
     ioWindowsFsMemoryMap,
     ioWindowsGetSystemHandle,
+    ioWindowsFsReadAt,
     NULL,
 };
 
 IFileSystem* pSystemFileIO = &gWindowsFileIO;
+
+/************************************************************************/
+// MARK: - Asynchronous reads
+/************************************************************************/
+
+// Reads are done on submission, CRT streams keep their own buffer and position
+struct FileAsyncReadBatch
+{
+    uint32_t count;
+    bool     success;
+};
+
+bool fsReadAsync(uint32_t count, FileAsyncRead* pReads, FileAsyncReadBatch** ppOutBatch)
+{
+    ASSERT(ppOutBatch);
+    ASSERT(pReads || !count);
+
+    FileAsyncReadBatch* batch = (FileAsyncReadBatch*)tf_calloc(1, sizeof(FileAsyncReadBatch));
+    batch->count = count;
+    batch->success = true;
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        FileAsyncRead* pRead = &pReads[i];
+        pRead->mBytesRead = 0;
+        pRead->mError = 0;
+        if (!pRead->mSize)
+            continue;
+
+        FileStream* fs = pRead->pStream;
+        ssize_t     position = fsGetStreamSeekPosition(fs);
+        if (position >= 0 && fsSeekStream(fs, SBO_START_OF_FILE, (ssize_t)pRead->mOffset))
+        {
+            pRead->mBytesRead = fsReadFromStream(fs, pRead->pDst, (size_t)pRead->mSize);
+            fsSeekStream(fs, SBO_START_OF_FILE, position);
+        }
+        if (pRead->mBytesRead != pRead->mSize)
+        {
+            pRead->mError = EIO;
+            batch->success = false;
+        }
+    }
+
+    *ppOutBatch = batch;
+    return true;
+}
+
+uint32_t fsPollAsyncReads(FileAsyncReadBatch* pBatch) { return pBatch->count; }
+
+bool fsWaitAsyncReads(FileAsyncReadBatch* pBatch)
+{
+    bool success = pBatch->success;
+    tf_free(pBatch);
+    return success;
+}
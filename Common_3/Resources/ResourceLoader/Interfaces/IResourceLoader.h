@@ -67,6 +67,28 @@ typedef enum RegisterMaterialResult
 
 // MARK: - Resource Loading
 
+typedef uint64_t SyncToken;
+
+// Load requests are executed from highest priority, in queue order within one priority.
+// Requests of different priorities can execute in any order, dependent requests should use the same priority.
+typedef enum ResourceLoadPriority
+{
+    RESOURCE_LOAD_PRIORITY_LOW = -1,
+    RESOURCE_LOAD_PRIORITY_NORMAL = 0,
+    RESOURCE_LOAD_PRIORITY_HIGH = 1,
+} ResourceLoadPriority;
+
+typedef enum ResourceLoadStatus
+{
+    RESOURCE_LOAD_STATUS_COMPLETED = 0,
+    RESOURCE_LOAD_STATUS_FAILED,
+    RESOURCE_LOAD_STATUS_CANCELLED,
+} ResourceLoadStatus;
+
+/// Called once a load is completed on the GPU, failed or cancelled.
+/// Loads which have nothing to upload complete in addResource, with token 0.
+typedef void (*ResourceLoadCallback)(void* pUserData, SyncToken token, ResourceLoadStatus status);
+
 typedef struct BufferLoadDesc
 {
     Buffer**    ppBuffer;
@@ -80,6 +102,13 @@ typedef struct BufferLoadDesc
     // Optional (if user provides staging buffer memory)
     Buffer*  pSrcBuffer;
     uint64_t mSrcOffset;
+
+    ResourceLoadPriority mPriority;
+    /// Optional, queued for drainCompletedResourceLoads unless mCallbackOnLoaderThread is set
+    ResourceLoadCallback pCallback;
+    void*                pCallbackUserData;
+    /// Call pCallback on the resource loader thread as soon as the load completes, it must be short and thread safe
+    bool                 mCallbackOnLoaderThread;
 } BufferLoadDesc;
 
 typedef struct TextureLoadDesc
@@ -105,24 +134,126 @@ typedef struct TextureLoadDesc
     TextureCreationFlags mCreationFlag;
     /// The texture file format (dds/ktx/...)
     TextureContainerType mContainer;
+    ResourceLoadPriority mPriority;
+    /// Optional, queued for drainCompletedResourceLoads unless mCallbackOnLoaderThread is set
+    ResourceLoadCallback pCallback;
+    void*                pCallbackUserData;
+    /// Call pCallback on the resource loader thread as soon as the load completes, it must be short and thread safe
+    bool                 mCallbackOnLoaderThread;
 } TextureLoadDesc;
 
+/// Texture loaded from a DDS or KTX file whose finest mips are streamed in and out, see updateTextureStreaming.
+/// Mip counts are counted from the smallest mip, e.g. 1 means the smallest mip alone.
+typedef struct StreamedTexture
+{
+    /// Texture made of the resident mips, NULL until the smallest mips are loaded.
+    /// Replaced by updateTextureStreaming when mips are streamed in or evicted, descriptors using it must be updated then.
+    Texture* pTexture;
+    /// Mip levels in the file
+    uint32_t mMipLevels;
+    /// Resident mips never go below this count, it is the smallest mip chain which can be a texture on its own
+    uint32_t mMinMipCount;
+    /// Last count passed to requestStreamedTextureMips
+    uint32_t mRequestedMipCount;
+    /// Mip levels of pTexture
+    uint32_t mResidentMipCount;
+    /// GPU memory of pTexture
+    uint64_t mResidentSize;
+} StreamedTexture;
+
+typedef struct StreamedTextureLoadDesc
+{
+    StreamedTexture**    ppTexture;
+    /// Filename without extension. Extension will be determined based on mContainer. Only DDS and KTX files can be streamed
+    const char*          pFileName;
+    /// The index of the GPU in SLI/Cross-Fire that owns this texture, or the Renderer index in unlinked mode.
+    uint32_t             mNodeIndex;
+    TextureCreationFlags mCreationFlag;
+    /// The texture file format (dds/ktx/...)
+    TextureContainerType mContainer;
+} StreamedTextureLoadDesc;
+
+typedef struct TextureStreamingStats
+{
+    uint64_t mBudget;
+    /// GPU memory of resident mips of all streamed textures
+    uint64_t mResidentSize;
+    /// GPU memory all streamed textures would take with their requested mips
+    uint64_t mRequestedSize;
+    uint32_t mTextureCount;
+    /// Textures waiting for a load of more or less mips
+    uint32_t mPendingLoadCount;
+    /// Loads which dropped finest mips to stay within the budget, since the resource loader was initialized
+    uint64_t mEvictionCount;
+} TextureStreamingStats;
+
+typedef struct ResourceLoaderStats
+{
+    /// Staging memory allocated and requests executed in the last finished frame, see advanceResourceLoaderFrame
+    uint64_t mFrameUploadSize;
+    uint32_t mFrameRequestCount;
+    /// Requests waiting for the loader thread
+    uint32_t mQueuedRequestCount;
+    /// Moving average of time from adding a request to completion of its token
+    uint64_t mAverageLatencyUs;
+    /// Totals since the resource loader was initialized
+    uint64_t mTotalUploadSize;
+    uint64_t mTotalRequestCount;
+    /// Staging buffer overflows which submitted copies early and waited for an older staging buffer
+    uint64_t mStagingStallCount;
+    /// Frames which left requests in the queue because of the upload budget
+    uint64_t mBudgetLimitedFrameCount;
+} ResourceLoaderStats;
+
 typedef struct BufferChunk
 {
     uint32_t mOffset;
     uint32_t mSize;
 } BufferChunk;
 
+typedef struct BufferChunkNode
+{
+    BufferChunk mChunk;
+    /// Neighbouring chunks in the buffer, UINT32_MAX at the ends
+    uint32_t    mPrev;
+    uint32_t    mNext;
+    /// Free list of the chunk size class while the chunk is free, list of unused nodes while the node is unused
+    uint32_t    mPrevFree;
+    uint32_t    mNextFree;
+    bool        mFree;
+} BufferChunkNode;
+
 // Structure used to sub-allocate chunks on a buffer, keeps track of free memory to handle new requests.
+// Free chunks are kept in free lists segregated by size (two level segregated fit), which makes allocation and release
+// constant time. Released chunks are merged with free neighbours.
 // Interface to add/remove this allocator is currently private, could be made public if needed.
 typedef struct BufferChunkAllocator
 {
-    Buffer*      pBuffer;
-    uint32_t     mUsedChunkCount;
-    uint32_t     mSize;
-    BufferChunk* mUnusedChunks;
+    Buffer*          pBuffer;
+    uint32_t         mUsedChunkCount;
+    uint32_t         mSize;
+    /// stb_ds array of used and free chunks, in offset order starting at mFirstNode
+    BufferChunkNode* pNodes;
+    uint32_t         mFirstNode;
+    uint32_t         mFirstUnusedNode;
+    uint32_t         mFreeChunkCount;
+    uint32_t         mFreeSize;
+    /// Free lists and lookup of used chunks by offset
+    struct BufferChunkAllocatorInternal* pInternal;
 } BufferChunkAllocator;
 
+typedef struct BufferChunkAllocatorStats
+{
+    uint32_t mSize;
+    uint32_t mUsedChunkCount;
+    uint32_t mUsedSize;
+    uint32_t mFreeChunkCount;
+    uint32_t mFreeSize;
+    uint32_t mLargestFreeChunkSize;
+    /// 1 - mLargestFreeChunkSize / mFreeSize, 0 when all free memory is one chunk
+    float    mFragmentation;
+} BufferChunkAllocatorStats;
+
 // Stores huge buffers that are then used to sub-allocate memory for each of the loaded meshes.
 // GeometryBuffer can be provided to GeometryLoadDesc::pGeometryBuffer when loading a mesh, sub-chunks will be allocated
 // by mIndex and mVertex allocators and return the BufferChunk(s) that where used in Geometry::mIndexBufferChunk and
@@ -134,6 +265,33 @@ typedef struct GeometryBuffer
 } GeometryBuffer;
 
 FORGE_CONSTEXPR const char GEOMETRY_FILE_MAGIC_STR[] = { 'G', 'e', 'o', 'm', 'e', 't', 'r', 'y', 'T', 'F' };
+FORGE_CONSTEXPR const uint32_t GEOMETRY_FILE_VERSION = 2;
+
+typedef enum GeometryFileSection
+{
+    /// Geometry followed by draw arguments
+    GEOMETRY_FILE_SECTION_GEOMETRY = 0,
+    /// Meshlets, meshlet data, meshlet vertices and meshlet triangles
+    GEOMETRY_FILE_SECTION_MESHLETS,
+    /// GeometryData followed by inverse bind poses, joint remaps and user data
+    GEOMETRY_FILE_SECTION_GEOMETRY_DATA,
+    /// GeometryData::ShadowData followed by indices and vertex attributes
+    GEOMETRY_FILE_SECTION_SHADOW,
+    GEOMETRY_FILE_SECTION_COUNT,
+} GeometryFileSection;
+
+/// Start of geometry files since version 2, sections follow in GeometryFileSection order.
+/// Version 1 files have no header, they store size of the Geometry section after the magic, which is at least 352.
+typedef struct GeometryFileHeader
+{
+    char     mMagic[sizeof(GEOMETRY_FILE_MAGIC_STR)];
+    /// GEOMETRY_FILE_VERSION, not aligned
+    uint8_t  mVersion[sizeof(uint32_t)];
+    uint8_t  mPad[2];
+    /// Offsets from the start of the file, multiples of 16
+    uint64_t mSectionOffsets[GEOMETRY_FILE_SECTION_COUNT];
+    uint64_t mSectionSizes[GEOMETRY_FILE_SECTION_COUNT];
+} GeometryFileHeader;
 
 typedef struct Meshlet
 {
@@ -334,6 +492,13 @@ typedef struct GeometryLoadDesc
 
     /// Used to convert data to desired state inside GeometryBuffer.
     GeometryBufferLayoutDesc* pGeometryBufferLayoutDesc;
+
+    ResourceLoadPriority mPriority;
+    /// Optional, queued for drainCompletedResourceLoads unless mCallbackOnLoaderThread is set
+    ResourceLoadCallback pCallback;
+    void*                pCallbackUserData;
+    /// Call pCallback on the resource loader thread as soon as the load completes, it must be short and thread safe
+    bool                 mCallbackOnLoaderThread;
 } GeometryLoadDesc;
 
 typedef struct BufferUpdateDesc
@@ -468,7 +633,55 @@ typedef struct PipelineCacheSaveDesc
     const char* pFileName;
 } PipelineCacheSaveDesc;
 
-typedef uint64_t SyncToken;
+typedef struct PipelineWarmUpProgress
+{
+    /// Shaders and pipelines finished so far, including failed ones
+    uint32_t    mShadersCompleted;
+    uint32_t    mShaderCount;
+    uint32_t    mPipelinesCompleted;
+    uint32_t    mPipelineCount;
+    /// Pipeline which just finished, UINT32_MAX when a shader finished
+    uint32_t    mPipelineIndex;
+    const char* pPipelineName;
+    /// Time addPipeline took for this pipeline
+    int64_t     mPipelineTimeUs;
+    bool        mFailed;
+} PipelineWarmUpProgress;
+
+/// Called once per finished shader and pipeline from worker threads, calls are serialized
+typedef void (*PipelineWarmUpCallback)(const PipelineWarmUpProgress* pProgress, void* pUserData);
+
+typedef struct PipelineWarmUpDesc
+{
+    /// Shaders to load, ppShaders[i] receives the shader of pShaderDescs[i] or NULL if it failed to load
+    const ShaderLoadDesc*    pShaderDescs;
+    Shader**                 ppShaders;
+    uint32_t                 mShaderCount;
+    /// Optional. Root signature created from all shaders above once they are loaded, ppShaders and mShaderCount are ignored.
+    /// Used by pipelines without a root signature in their description.
+    /// If any shader fails, the root signature is not created and all pipelines which would use it are skipped,
+    /// including the ones whose own shaders loaded
+    const RootSignatureDesc* pRootSignatureDesc;
+    RootSignature**          ppRootSignature;
+    /// Pipelines to create, ppPipelines[i] receives the pipeline of pPipelineDescs[i] or NULL if it failed.
+    /// If pPipelineShaderIndices is set, compute and graphics pipelines without a shader program in their description
+    /// use ppShaders[pPipelineShaderIndices[i]]
+    const PipelineDesc*      pPipelineDescs;
+    const uint32_t*          pPipelineShaderIndices;
+    Pipeline**               ppPipelines;
+    uint32_t                 mPipelineCount;
+    /// Optional. Replaces PipelineDesc::pCache of all pipelines, e.g. cache from loadPipelineCache, saved afterwards with savePipelineCache.
+    PipelineCache*           pCache;
+    /// Flags pCache was created with. With PIPELINE_CACHE_FLAG_EXTERNALLY_SYNCHRONIZED pipelines are created on the calling thread,
+    /// shaders still load on worker threads
+    PipelineCacheFlags       mCacheFlags;
+    /// Optional. Receives time addPipeline took for each pipeline
+    int64_t*                 pPipelineTimesUs;
+    /// Worker threads, limited to getNumCPUCores(). The calling thread helps them. If 0, everything runs on the calling thread
+    uint32_t                 mThreadCount;
+    PipelineWarmUpCallback   pCallback;
+    void*                    pUserData;
+} PipelineWarmUpDesc;
 
 struct Material;
 
@@ -477,6 +690,19 @@ typedef struct ResourceLoaderDesc
     uint64_t mBufferSize;
     uint32_t mBufferCount;
     bool     mSingleThreaded;
+    // Threads reading and parsing texture and geometry files ahead of the thread recording copy commands.
+    // If 0, files are read by the thread recording copy commands. Ignored if mSingleThreaded is set.
+    uint32_t mIoThreadCount;
+    // Limit of file data read ahead and not yet copied to staging memory. If 0, there is no limit
+    uint64_t mIoReadAheadSize;
+    // GPU memory of all streamed textures, finest mips of least recently requested textures are evicted above it.
+    // If 0, there is no limit. See updateTextureStreaming
+    uint64_t mTextureStreamingBudget;
+    // Per frame limits of staging memory allocated and of requests executed by the loader thread, the rest stays in the queue
+    // for the next frames. A request larger than mUploadBudgetSize runs alone. If 0, there is no limit.
+    // Ignored if mSingleThreaded is set. See advanceResourceLoaderFrame
+    uint64_t mUploadBudgetSize;
+    uint32_t mUploadBudgetRequestCount;
 #ifdef ENABLE_FORGE_MATERIALS
     bool mUseMaterials;
 #endif
@@ -545,6 +771,8 @@ FORGE_RENDERER_API void addGeometryBufferPart(BufferChunkAllocator* buffer, uint
 /// Buffer must be the one passed to claimGeometryBufferPart for this chunk.
 FORGE_RENDERER_API void removeGeometryBufferPart(BufferChunkAllocator* buffer, BufferChunk* chunk);
 
+FORGE_RENDERER_API void getGeometryBufferPartStats(const BufferChunkAllocator* buffer, BufferChunkAllocatorStats* pOutStats);
+
 typedef struct FlushResourceUpdateDesc
 {
     uint32_t    mNodeIndex;
@@ -601,6 +829,43 @@ FORGE_RENDERER_API SyncToken getLastTokenSubmitted();
 FORGE_RENDERER_API bool      isTokenSubmitted(const SyncToken* token);
 FORGE_RENDERER_API void      waitForTokenSubmitted(const SyncToken* token);
 
+/// Removes a buffer, texture or geometry load which is not executed yet from the queue.
+/// Token must be the one addResource returned for this load alone. Cancelled token completes like an executed one.
+/// Output texture or geometry is not created, buffer created by addResource stays and must be removed by the caller.
+/// Returns false if the load is already executing or executed, or an io thread is reading its file right now.
+/// Data the load description borrows from the caller, like the file name, must stay valid until the token completes then.
+FORGE_RENDERER_API bool cancelResourceLoad(SyncToken token);
+/// Moves a load which is not executed yet to another priority, e.g. when the asset becomes visible.
+/// Token must be the one addResource returned for this load alone. Returns false if the load is already executing or executed.
+FORGE_RENDERER_API bool setResourceLoadPriority(SyncToken token, ResourceLoadPriority priority);
+
+/// Calls queued completion callbacks of loads, see BufferLoadDesc::pCallback, on the calling thread in completion order.
+/// Callbacks may add new loads. Calls at most maxCount callbacks, all if 0. Returns number of callbacks called.
+FORGE_RENDERER_API uint32_t drainCompletedResourceLoads(uint32_t maxCount);
+
+/// Texture streaming. These functions must be called from one thread, the one which renders with the streamed textures.
+/// Reads the file header and queues a load of the smallest mips. Returns false if the file cannot be read or cannot be streamed.
+FORGE_RENDERER_API bool addStreamedTexture(const StreamedTextureLoadDesc* pDesc);
+/// GPU must not use the texture anymore
+FORGE_RENDERER_API void removeStreamedTexture(StreamedTexture* pTexture);
+/// Marks the texture as used and sets how many mips, counted from the smallest, it needs.
+/// Textures which were not requested for the longest time are the first to lose their finest mips when over budget.
+FORGE_RENDERER_API void requestStreamedTextureMips(StreamedTexture* pTexture, uint32_t mipCount);
+/// Call once per frame. Replaces textures whose mip loads completed, removes replaced textures three calls later,
+/// when GPU no longer uses them, and queues loads of more or less mips to fit requests into the budget.
+/// Returns number of textures whose StreamedTexture::pTexture changed.
+FORGE_RENDERER_API uint32_t updateTextureStreaming();
+FORGE_RENDERER_API void     setTextureStreamingBudget(uint64_t budget);
+FORGE_RENDERER_API void     getTextureStreamingStats(TextureStreamingStats* pOutStats);
+
+/// Starts a new frame of the upload budget and of the frame counters of getResourceLoaderStats, call once per frame.
+/// Until it is called for the first time, every pass of the loader thread is a frame.
+/// The budget does not apply while some thread is blocked in waitForToken or waitForAllResourceLoads.
+FORGE_RENDERER_API void advanceResourceLoaderFrame();
+FORGE_RENDERER_API void setResourceLoaderUploadBudget(uint64_t size, uint32_t requestCount);
+/// Returns false if the resource loader is not initialized
+FORGE_RENDERER_API bool getResourceLoaderStats(ResourceLoaderStats* pOutStats);
+
 /// Return the semaphore for the last copy operation of a specific GPU.
 /// Could be NULL if no operations have been executed.
 FORGE_RENDERER_API Semaphore* getLastSemaphoreSubmitted(uint32_t nodeIndex);
@@ -612,6 +877,10 @@ FORGE_RENDERER_API void addShader(Renderer* pRenderer, const ShaderLoadDesc* pDe
 FORGE_RENDERER_API void loadPipelineCache(Renderer* pRenderer, const PipelineCacheLoadDesc* pDesc, PipelineCache** ppPipelineCache);
 FORGE_RENDERER_API void savePipelineCache(Renderer* pRenderer, PipelineCache* pPipelineCache, PipelineCacheSaveDesc* pDesc);
 
+/// Loads shaders and then creates pipelines of a manifest on worker threads, to avoid first use hitches and to shorten startup.
+/// Blocks until all of them are finished. Returns false if any shader, the root signature or any pipeline failed.
+FORGE_RENDERER_API bool warmUpPipelines(Renderer* pRenderer, const PipelineWarmUpDesc* pDesc);
+
 /// Determines whether we are using Uniform Memory Architecture or not.
 /// Do not assume this variable will be the same, if code was compiled with multiple APIs result of this function might change per API.
 FORGE_RENDERER_API bool isUma();
@@ -41,6 +41,8 @@
 #include "../../Utilities/Interfaces/IFileSystem.h"
 #include "../../Utilities/Interfaces/ILog.h"
 #include "../../Utilities/Interfaces/IThread.h"
+#include "../../Utilities/Interfaces/ITime.h"
+#include "../../Utilities/Threading/ThreadSystem.h"
 #include "Interfaces/IResourceLoader.h"
 
 #include "../../Utilities/Math/ShaderUtilities.h" // Packing functions
@@ -75,12 +77,16 @@
 
 #define MAX_FRAMES 3U
 
+#define MAX_IO_THREADS 16U
+
+#define RESOURCE_LOAD_PRIORITY_COUNT 3U
+
 struct SubresourceDataDesc
 {
     uint64_t mSrcOffset;
     uint32_t mMipLevel;
     uint32_t mArrayLayer;
-#if defined(DIRECT3D11) || defined(METAL) || defined(VULKAN)
+#if defined(DIRECT3D11) || defined(METAL) || defined(VULKAN) || defined(NULL_RENDERER)
     uint32_t mRowPitch;
     uint32_t mSlicePitch;
 #endif
@@ -255,6 +261,9 @@ typedef struct Material
     LoadedMaterial* pLoaded;
 
     MaterialDesc* pDesc;
+
+    // Binary materials point to strings and indexes in the file, which is read to pFileData
+    void* pFileData;
 } Material;
 
 // Global storage for resources used by Materials
@@ -288,6 +297,63 @@ struct MaterialLibrary
 
 static MaterialLibrary* pMaterialLibrary = NULL;
 
+// Binary material format written by forge_material_compiler.py, which documents the layout.
+// Little endian, sections are 4 byte aligned, offsets are from the start of the file.
+#define MATERIAL_BINARY_MAGIC   ":FMB"
+#define MATERIAL_BINARY_VERSION 1
+// Upper bound of MaterialBinaryHeader::mMaxShaderSetBindings and mMaxTextureSetTextures, far above what a shader can bind
+#define MATERIAL_BINARY_MAX_SET_ENTRIES 1024
+
+typedef struct MaterialBinaryHeader
+{
+    char     mMagic[4];
+    uint32_t mVersion;
+    uint32_t mShaderSetCount;
+    uint32_t mTextureSetCount;
+    uint32_t mMaterialSetCount;
+    uint32_t mShaderCount;
+    uint32_t mTextureCount;
+    uint32_t mBindingCount;
+    uint32_t mTextureIdxCount;
+    uint32_t mMaxShaderSetBindings;
+    uint32_t mMaxTextureSetTextures;
+    uint32_t mStringsSize;
+    uint32_t mShaderSetsOffset;
+    uint32_t mTextureSetsOffset;
+    uint32_t mMaterialSetsOffset;
+    uint32_t mTextureIdxsOffset;
+    uint32_t mTextureIdsOffset;
+    uint32_t mTextureNamesOffset;
+    uint32_t mShaderNamesOffset;
+    uint32_t mBindingNamesOffset;
+    uint32_t mTextureFlagsOffset;
+    uint32_t mStringsOffset;
+} MaterialBinaryHeader;
+
+typedef struct MaterialBinaryShaderSet
+{
+    uint32_t mId;
+    // Same order as MaterialDesc::ShaderSet
+    uint32_t mShaderIdxs[6];
+    // Range of binding names
+    uint32_t mFirstBinding;
+    uint32_t mBindingCount;
+} MaterialBinaryShaderSet;
+
+typedef struct MaterialBinaryTextureSet
+{
+    // Range of texture indexes
+    uint32_t mFirstTextureIdx;
+    uint32_t mTextureCount;
+} MaterialBinaryTextureSet;
+
+typedef struct MaterialBinaryMaterialSet
+{
+    uint32_t mNameOffset;
+    uint32_t mShaderSetIdx;
+    uint32_t mTextureSetIdx;
+} MaterialBinaryMaterialSet;
+
 static uint32_t materialNextFileLine(const char* pFile, uint64_t fileSize, uint64_t currOffset, uint64_t* pNextNewline)
 {
     uint64_t    newLineOffset = currOffset;
@@ -459,7 +525,7 @@ static inline bool IssueExplicitInitialStateBarrier()
 #endif
 }
 
-ResourceLoaderDesc          gDefaultResourceLoaderDesc = { 8ull * TF_MB, 2, false };
+ResourceLoaderDesc          gDefaultResourceLoaderDesc = { 8ull * TF_MB, 2, false, 4, 64ull * TF_MB, 0, 0, 0 };
 /************************************************************************/
 // Surface Utils
 /************************************************************************/
@@ -542,6 +608,8 @@ struct TextureLoadDescInternal
             TextureCreationFlags mFlags;
             TextureContainerType mContainer;
             uint32_t             mNodeIndex;
+            // Finest mips which are not loaded, used by texture streaming
+            uint32_t             mSkipMipCount;
         };
         struct
         {
@@ -619,6 +687,11 @@ typedef struct CopyEngine
 
     bool isRecording;
     bool flushOnOverflow;
+
+    /// Staging memory allocated since the copy engine was set up, including temporary buffers
+    uint64_t allocatedStagingSize;
+    /// Flushes in the middle of a batch because staging buffer was full
+    uint64_t overflowFlushCount;
 } CopyEngine;
 
 typedef enum UpdateRequestType
@@ -638,16 +711,78 @@ typedef enum UploadFunctionResult
     UPLOAD_FUNCTION_RESULT_INVALID_REQUEST
 } UploadFunctionResult;
 
+// Priority and completion callback of a load, from its load description
+typedef struct ResourceLoadOptions
+{
+    ResourceLoadPriority mPriority;
+    ResourceLoadCallback pCallback;
+    void*                pCallbackUserData;
+    bool                 mCallbackOnLoaderThread;
+} ResourceLoadOptions;
+
+template<typename T>
+static ResourceLoadOptions getLoadOptions(const T* pDesc)
+{
+    return { pDesc->mPriority, pDesc->pCallback, pDesc->pCallbackUserData, pDesc->mCallbackOnLoaderThread };
+}
+
+typedef struct ResourceLoadCallbackEntry
+{
+    ResourceLoadCallback pCallback;
+    void*                pUserData;
+    SyncToken            mToken;
+    ResourceLoadStatus   mStatus;
+    bool                 mOnLoaderThread;
+} ResourceLoadCallbackEntry;
+
+typedef enum ResourcePrepareState
+{
+    RESOURCE_PREPARE_PENDING,
+    RESOURCE_PREPARE_RUNNING,
+    RESOURCE_PREPARE_DONE,
+} ResourcePrepareState;
+
+// File read and parse of a texture or geometry load request.
+// Done by io threads ahead of the streamer thread, or by the streamer thread itself if it gets to the request first.
+typedef struct ResourcePrepareJob
+{
+    UpdateRequestType    mType;
+    // Protected by ResourceLoader::mPrepareMutex
+    ResourcePrepareState mState;
+    // File data held in memory until the request is executed, counted against mIoReadAheadSize
+    uint64_t             mSize;
+    uint32_t             mPriority;
+    bool                 mSuccess;
+
+    union
+    {
+        TextureLoadDescInternal mTexLoadDesc;
+        GeometryLoadDesc        mGeomLoadDesc;
+    };
+
+    // UPDATE_REQUEST_LOAD_TEXTURE
+    TextureDesc               mTextureDesc;
+    TextureUpdateDescInternal mTextureUpdateDesc;
+
+    // UPDATE_REQUEST_LOAD_GEOMETRY
+    Geometry*     pGeom;
+    GeometryData* pGeomData;
+} ResourcePrepareJob;
+
 struct UpdateRequest
 {
+    UpdateRequest() {}
     UpdateRequest(const BufferLoadDescInternal& buffer): mType(UPDATE_REQUEST_LOAD_BUFFER), bufLoadDesc(buffer) {}
     UpdateRequest(const TextureLoadDescInternal& texture): mType(UPDATE_REQUEST_LOAD_TEXTURE), texLoadDesc(texture) {}
     UpdateRequest(const GeometryLoadDesc& geom): mType(UPDATE_REQUEST_LOAD_GEOMETRY), geomLoadDesc(geom) {}
     UpdateRequest(const TextureBarrier& barrier): mType(UPDATE_REQUEST_TEXTURE_BARRIER), textureBarrier(barrier) {}
     UpdateRequest(const TextureCopyDesc& texture): mType(UPDATE_REQUEST_COPY_TEXTURE), texCopyDesc(texture) {}
 
-    UpdateRequestType mType = UPDATE_REQUEST_INVALID;
-    uint64_t          mWaitIndex = 0;
+    UpdateRequestType   mType = UPDATE_REQUEST_INVALID;
+    uint64_t            mWaitIndex = 0;
+    ResourcePrepareJob* pPrepareJob = NULL;
+    // getUSec when the request was queued
+    int64_t             mQueueTime = 0;
     union
     {
         BufferLoadDescInternal  bufLoadDesc;
@@ -658,6 +793,39 @@ struct UpdateRequest
     };
 };
 
+struct StreamedTextureInternal
+{
+    StreamedTexture mPublic;
+    // Least recently requested list, most recent first
+    StreamedTextureInternal* pPrev;
+    StreamedTextureInternal* pNext;
+    TextureDesc              mDesc;
+    const char*              pFileName;
+    TextureCreationFlags     mFlags;
+    TextureContainerType     mContainer;
+    // Written by the loader thread, read once mPendingToken completes
+    Texture*                 pPendingTexture;
+    SyncToken                mPendingToken;
+    uint32_t                 mPendingMipCount;
+    bool                     mLoadPending;
+    bool                     mFailed;
+    // GPU memory per mip count, from mMinMipCount
+    uint64_t*                pSizes;
+};
+
+// Executed request waiting for its token to complete, for request latency
+typedef struct ExecutedRequestTime
+{
+    SyncToken mToken;
+    int64_t   mQueueTime;
+} ExecutedRequestTime;
+
+typedef struct RetiredTexture
+{
+    Texture* pTexture;
+    uint64_t mFrame;
+} RetiredTexture;
+
 struct ResourceLoader
 {
     Renderer* ppRenderers[MAX_MULTIPLE_GPUS];
@@ -672,8 +840,10 @@ struct ResourceLoader
     ConditionVariable mQueueCond;
     Mutex             mTokenMutex;
     ConditionVariable mTokenCond;
-    // array of stb_ds arrays
-    UpdateRequest*    mRequestQueue[MAX_MULTIPLE_GPUS];
+    // stb_ds arrays per node and priority, from lowest priority. Protected by mQueueMutex
+    UpdateRequest*    mRequestQueue[MAX_MULTIPLE_GPUS][RESOURCE_LOAD_PRIORITY_COUNT];
+    // Requests before this index were taken by the streamer thread
+    ptrdiff_t         mRequestQueueHead[MAX_MULTIPLE_GPUS][RESOURCE_LOAD_PRIORITY_COUNT];
 
     tfrg_atomic64_t mTokenCompleted;
     tfrg_atomic64_t mTokenSubmitted;
@@ -682,11 +852,53 @@ struct ResourceLoader
     Mutex mSemaphoreMutex;
 
     SyncToken mCurrentTokenState[MAX_FRAMES];
-    SyncToken mMaxToken;
+    // Protected by mQueueMutex, see markTokenExecuted
+    SyncToken  mMaxToken;
+    // stb_ds sorted array of tokens executed or cancelled before some lower token
+    SyncToken* mExecutedTokens;
+
+    // stb_ds array of callbacks of loads not completed yet, in token order. Protected by mQueueMutex
+    ResourceLoadCallbackEntry* mPendingCallbacks;
+    // stb_ds array used by streamer thread only, callbacks taken from mPendingCallbacks once their loads complete
+    ResourceLoadCallbackEntry* mCompletedCallbacks;
+    Mutex                      mCallbackMutex;
+    // stb_ds array of callbacks waiting for drainCompletedResourceLoads. Protected by mCallbackMutex
+    ResourceLoadCallbackEntry* mReadyCallbacks;
 
     CopyEngine pCopyEngines[MAX_MULTIPLE_GPUS];
     CopyEngine pUploadEngines[MAX_MULTIPLE_GPUS];
     Mutex      mUploadEngineMutex;
+
+    uint32_t     mIoThreadCount;
+    ThreadHandle mIoThreads[MAX_IO_THREADS];
+
+    Mutex                mPrepareMutex;
+    // Io threads wait for jobs and for read ahead memory to be consumed
+    ConditionVariable    mPrepareCond;
+    // Streamer thread waits for jobs run by io threads
+    ConditionVariable    mPrepareDoneCond;
+    // stb_ds arrays of jobs not taken by any thread yet per priority, in queue order
+    ResourcePrepareJob** mPrepareQueue[RESOURCE_LOAD_PRIORITY_COUNT];
+    uint64_t             mPreparedSize;
+
+    // Texture streaming, used by the thread calling texture streaming functions only
+    StreamedTextureInternal* pStreamedTexturesHead;
+    StreamedTextureInternal* pStreamedTexturesTail;
+    // stb_ds array of replaced textures GPU may still use
+    RetiredTexture*          mRetiredTextures;
+    uint64_t                 mStreamingFrame;
+    uint64_t                 mStreamingEvictionCount;
+
+    // Upload budget and statistics, protected by mQueueMutex. mFrameIndex is 0 until advanceResourceLoaderFrame is called
+    uint64_t            mFrameIndex;
+    uint64_t            mFrameUploadSize;
+    uint32_t            mFrameRequestCount;
+    bool                mFrameBudgetLimited;
+    // Threads blocked waiting for tokens, budget does not apply while there are any
+    uint32_t            mTokenWaiterCount;
+    ResourceLoaderStats mStats;
+    // stb_ds array of executed requests whose tokens did not complete yet. Protected by mQueueMutex
+    ExecutedRequestTime* mExecutedRequestTimes;
 };
 
 static ResourceLoader* pResourceLoader = NULL;
@@ -831,6 +1043,8 @@ static void setupCopyEngine(Renderer* pRenderer, CopyEngineDesc* pDesc, CopyEngi
     pCopyEngine->bufferCount = pDesc->mBufferCount;
     pCopyEngine->nodeIndex = pDesc->mNodeIndex;
     pCopyEngine->isRecording = false;
+    pCopyEngine->allocatedStagingSize = 0;
+    pCopyEngine->overflowFlushCount = 0;
     pCopyEngine->pLastSubmittedSemaphore = NULL;
 }
 
@@ -1014,6 +1228,7 @@ static MappedMemoryRange allocateStagingMemory(CopyEngine* pCopyEngine, uint64_t
             "Allocating temporary staging buffer. Required allocation size of %llu is larger than the staging buffer capacity of %llu",
             memoryRequirement, size);
         arrpush(pResourceSet->mTempBuffers, range.pBuffer);
+        pCopyEngine->allocatedStagingSize += memoryRequirement;
         return range;
     }
 
@@ -1025,6 +1240,7 @@ static MappedMemoryRange allocateStagingMemory(CopyEngine* pCopyEngine, uint64_t
         ASSERT(buffer->pCpuMappedAddress);
         uint8_t* pDstData = (uint8_t*)buffer->pCpuMappedAddress + offset;
         pCopyEngine->resourceSets[pCopyEngine->activeSet].mAllocatedSpace = offset + memoryRequirement;
+        pCopyEngine->allocatedStagingSize += memoryRequirement;
         return { pDstData, buffer, offset, memoryRequirement };
     }
     else
@@ -1032,6 +1248,7 @@ static MappedMemoryRange allocateStagingMemory(CopyEngine* pCopyEngine, uint64_t
         if (pCopyEngine->flushOnOverflow)
         {
             ASSERT(pCopyEngine->pFnFlush);
+            ++pCopyEngine->overflowFlushCount;
             pCopyEngine->pFnFlush(pCopyEngine);
             return allocateStagingMemory(pCopyEngine, memoryRequirement, alignment, nodeIndex);
         }
@@ -1259,7 +1476,7 @@ static UploadFunctionResult updateTexture(Renderer* pRenderer, CopyEngine* pCopy
                 subresourceDesc.mArrayLayer = layer;
                 subresourceDesc.mMipLevel = mip;
                 subresourceDesc.mSrcOffset = upload.mOffset + offset;
-#if defined(DIRECT3D11) || defined(METAL) || defined(VULKAN)
+#if defined(DIRECT3D11) || defined(METAL) || defined(VULKAN) || defined(NULL_RENDERER)
                 subresourceDesc.mRowPitch = subRowPitch;
                 subresourceDesc.mSlicePitch = subSlicePitch;
 #endif
@@ -1283,6 +1500,192 @@ static UploadFunctionResult updateTexture(Renderer* pRenderer, CopyEngine* pCopy
     return UPLOAD_FUNCTION_RESULT_COMPLETED;
 }
 
+static TextureContainerType resolveTextureContainer(TextureContainerType container)
+{
+    if (TEXTURE_CONTAINER_DEFAULT == container)
+    {
+#if defined(TARGET_IOS) || defined(__ANDROID__) || defined(NX64)
+        container = TEXTURE_CONTAINER_KTX;
+#elif defined(_WINDOWS) || defined(XBOX) || defined(__APPLE__) || defined(__linux__)
+        container = TEXTURE_CONTAINER_DDS;
+#elif defined(ORBIS) || defined(PROSPERO)
+        container = TEXTURE_CONTAINER_GNF;
+#endif
+    }
+
+    return container;
+}
+
+// Containers loaded through readTextureFile, others are loaded by platform code which creates the texture itself
+static bool canReadTextureFileAhead(TextureContainerType container)
+{
+#if defined(XBOX)
+    return container == TEXTURE_CONTAINER_KTX;
+#else
+    return container == TEXTURE_CONTAINER_DDS || container == TEXTURE_CONTAINER_KTX;
+#endif
+}
+
+// Replaces file stream by memory stream with the rest of the file
+static bool readStreamAhead(FileStream* pStream, uint64_t* pOutSize)
+{
+    ssize_t fileSize = fsGetStreamFileSize(pStream);
+    ssize_t position = fsGetStreamSeekPosition(pStream);
+    if (fileSize < 0 || position < 0 || position > fileSize)
+    {
+        return false;
+    }
+
+    size_t remainingBytes = (size_t)(fileSize - position);
+    void*  data = tf_malloc(max<size_t>(remainingBytes, 1));
+    if ((size_t)fsReadFromStream(pStream, data, remainingBytes) != remainingBytes)
+    {
+        tf_free(data);
+        return false;
+    }
+
+    fsCloseStream(pStream);
+    if (!fsOpenStreamFromMemory(data, remainingBytes, FM_READ, true, pStream))
+    {
+        tf_free(data);
+        return false;
+    }
+
+    *pOutSize = remainingBytes;
+    return true;
+}
+
+// Replaces file stream by memory stream with mips from skipMipCount on, in the order updateTexture reads them.
+// Texture description is changed to describe the texture made of these mips.
+static bool readTextureMips(FileStream* pStream, TextureDesc* pTextureDesc, bool mipsAfterSlice, uint32_t skipMipCount, uint64_t* pOutSize)
+{
+    if (skipMipCount >= pTextureDesc->mMipLevels)
+    {
+        return false;
+    }
+
+    // Size of skipped and loaded mips of one layer for DDS, of all layers for KTX which also stores mip size before every mip
+    uint64_t skipSize = 0;
+    uint64_t loadSize = 0;
+    for (uint32_t mip = 0; mip < pTextureDesc->mMipLevels; ++mip)
+    {
+        uint32_t numBytes = 0;
+        uint32_t rowBytes = 0;
+        uint32_t numRows = 0;
+        if (!util_get_surface_info(MIP_REDUCE(pTextureDesc->mWidth, mip), MIP_REDUCE(pTextureDesc->mHeight, mip), pTextureDesc->mFormat,
+                                   &numBytes, &rowBytes, &numRows))
+        {
+            return false;
+        }
+
+        uint64_t mipSize = (uint64_t)rowBytes * numRows * MIP_REDUCE(pTextureDesc->mDepth, mip);
+        if (mipsAfterSlice)
+        {
+            mipSize = sizeof(uint32_t) + mipSize * pTextureDesc->mArraySize;
+        }
+        if (mip < skipMipCount)
+        {
+            skipSize += mipSize;
+        }
+        else
+        {
+            loadSize += mipSize;
+        }
+    }
+
+    const ssize_t  dataStart = fsGetStreamSeekPosition(pStream);
+    const uint32_t chunkCount = mipsAfterSlice ? 1 : pTextureDesc->mArraySize;
+    const uint64_t dataSize = loadSize * chunkCount;
+    if (dataStart < 0)
+    {
+        return false;
+    }
+
+    uint8_t* data = (uint8_t*)tf_malloc(max<size_t>((size_t)dataSize, 1));
+    for (uint32_t i = 0; i < chunkCount; ++i)
+    {
+        const ssize_t offset = dataStart + (ssize_t)(i * (skipSize + loadSize) + skipSize);
+        if (!fsSeekStream(pStream, SBO_START_OF_FILE, offset) ||
+            (uint64_t)fsReadFromStream(pStream, data + i * loadSize, (size_t)loadSize) != loadSize)
+        {
+            tf_free(data);
+            return false;
+        }
+    }
+
+    fsCloseStream(pStream);
+    if (!fsOpenStreamFromMemory(data, (size_t)dataSize, FM_READ, true, pStream))
+    {
+        tf_free(data);
+        return false;
+    }
+
+    pTextureDesc->mWidth = MIP_REDUCE(pTextureDesc->mWidth, skipMipCount);
+    pTextureDesc->mHeight = MIP_REDUCE(pTextureDesc->mHeight, skipMipCount);
+    pTextureDesc->mDepth = MIP_REDUCE(pTextureDesc->mDepth, skipMipCount);
+    pTextureDesc->mMipLevels -= skipMipCount;
+    if (pOutSize)
+    {
+        *pOutSize = dataSize;
+    }
+    return true;
+}
+
+// Opens texture file and reads texture description.
+// If readAhead is set, texture data is read to memory, so copying it to staging memory later does not wait for the file.
+static bool readTextureFile(const TextureLoadDescInternal* pTextureDesc, TextureContainerType container, bool readAhead,
+                            TextureDesc* pOutTextureDesc, TextureUpdateDescInternal* pOutUpdateDesc, uint64_t* pOutSize)
+{
+    pOutTextureDesc->pName = pTextureDesc->pFileName;
+    pOutTextureDesc->mFlags |= pTextureDesc->mFlags;
+
+    FileStream stream = {};
+    if (!fsOpenStreamFromPath(RD_TEXTURES, pTextureDesc->pFileName, FM_READ, &stream))
+    {
+        return false;
+    }
+
+    bool success = false;
+    switch (container)
+    {
+    case TEXTURE_CONTAINER_DDS:
+        success = loadDDSTextureDesc(&stream, pOutTextureDesc);
+        break;
+    case TEXTURE_CONTAINER_KTX:
+        success = loadKTXTextureDesc(&stream, pOutTextureDesc);
+        pOutUpdateDesc->mMipsAfterSlice = true;
+        // KTX stores mip size before the mip data
+        // This function gets called to skip the mip size so we read the mip data
+        pOutUpdateDesc->pPreMipFunc = [](FileStream* pStream, uint32_t)
+        {
+            uint32_t mipSize = 0;
+            fsReadFromStream(pStream, &mipSize, sizeof(mipSize));
+        };
+        break;
+    default:
+        break;
+    }
+
+    if (success && pTextureDesc->mSkipMipCount)
+    {
+        // Always read to memory, skipped mips are interleaved with loaded ones
+        success = readTextureMips(&stream, pOutTextureDesc, pOutUpdateDesc->mMipsAfterSlice, pTextureDesc->mSkipMipCount, pOutSize);
+    }
+    else if (success && readAhead)
+    {
+        success = readStreamAhead(&stream, pOutSize);
+    }
+
+    if (!success)
+    {
+        fsCloseStream(&stream);
+        return false;
+    }
+
+    pOutUpdateDesc->mStream = stream;
+    return true;
+}
+
 static UploadFunctionResult loadTexture(Renderer* pRenderer, CopyEngine* pCopyEngine, const UpdateRequest& pTextureUpdate)
 {
     const TextureLoadDescInternal* pTextureDesc = &pTextureUpdate.texLoadDesc;
@@ -1331,22 +1734,10 @@ static UploadFunctionResult loadTexture(Renderer* pRenderer, CopyEngine* pCopyEn
 
     if (pTextureDesc->pFileName)
     {
-        FileStream stream = {};
-        bool       success = false;
+        bool success = false;
 
         TextureUpdateDescInternal updateDesc = {};
-        TextureContainerType      container = pTextureDesc->mContainer;
-
-        if (TEXTURE_CONTAINER_DEFAULT == container)
-        {
-#if defined(TARGET_IOS) || defined(__ANDROID__) || defined(NX64)
-            container = TEXTURE_CONTAINER_KTX;
-#elif defined(_WINDOWS) || defined(XBOX) || defined(__APPLE__) || defined(__linux__)
-            container = TEXTURE_CONTAINER_DDS;
-#elif defined(ORBIS) || defined(PROSPERO)
-            container = TEXTURE_CONTAINER_GNF;
-#endif
-        }
+        TextureContainerType      container = resolveTextureContainer(pTextureDesc->mContainer);
 
         TextureDesc textureDesc = {};
         textureDesc.pName = pTextureDesc->pFileName;
@@ -1359,71 +1750,66 @@ static UploadFunctionResult loadTexture(Renderer* pRenderer, CopyEngine* pCopyEn
             return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
         }
 
-        switch (container)
+        const ResourcePrepareJob* pJob = pTextureUpdate.pPrepareJob;
+        if (pJob)
         {
-        case TEXTURE_CONTAINER_DDS:
+            success = pJob->mSuccess;
+            textureDesc = pJob->mTextureDesc;
+            updateDesc = pJob->mTextureUpdateDesc;
+        }
+        else
         {
-#if defined(XBOX)
-            success = fsOpenStreamFromPath(RD_TEXTURES, pTextureDesc->pFileName, FM_READ, &stream);
-            uint32_t res = 1;
-            if (success)
+            switch (container)
             {
-                extern uint32_t loadXDDSTexture(Renderer * pRenderer, FileStream * stream, const char* name, TextureCreationFlags flags,
-                                                Texture** ppTexture);
-                res = loadXDDSTexture(pRenderer, &stream, pTextureDesc->pFileName, pTextureDesc->mFlags, pTextureDesc->ppTexture);
-                fsCloseStream(&stream);
-            }
-
-            if (!res)
+            case TEXTURE_CONTAINER_DDS:
             {
-                return UPLOAD_FUNCTION_RESULT_COMPLETED;
-            }
+#if defined(XBOX)
+                FileStream stream = {};
+                success = fsOpenStreamFromPath(RD_TEXTURES, pTextureDesc->pFileName, FM_READ, &stream);
+                uint32_t res = 1;
+                if (success)
+                {
+                    extern uint32_t loadXDDSTexture(Renderer * pRenderer, FileStream * stream, const char* name, TextureCreationFlags flags,
+                                                    Texture** ppTexture);
+                    res = loadXDDSTexture(pRenderer, &stream, pTextureDesc->pFileName, pTextureDesc->mFlags, pTextureDesc->ppTexture);
+                    fsCloseStream(&stream);
+                }
 
-            LOGF(eINFO, "XDDS: Could not find XDDS texture %s. Trying to load Desktop version", pTextureDesc->pFileName);
-#else
-            success = fsOpenStreamFromPath(RD_TEXTURES, pTextureDesc->pFileName, FM_READ, &stream);
-            if (success)
-            {
-                success = loadDDSTextureDesc(&stream, &textureDesc);
-            }
-#endif
-            break;
-        }
-        case TEXTURE_CONTAINER_KTX:
-        {
-            success = fsOpenStreamFromPath(RD_TEXTURES, pTextureDesc->pFileName, FM_READ, &stream);
-            if (success)
-            {
-                success = loadKTXTextureDesc(&stream, &textureDesc);
-                updateDesc.mMipsAfterSlice = true;
-                // KTX stores mip size before the mip data
-                // This function gets called to skip the mip size so we read the mip data
-                updateDesc.pPreMipFunc = [](FileStream* pStream, uint32_t)
+                if (!res)
                 {
-                    uint32_t mipSize = 0;
-                    fsReadFromStream(pStream, &mipSize, sizeof(mipSize));
-                };
+                    return UPLOAD_FUNCTION_RESULT_COMPLETED;
+                }
+
+                LOGF(eINFO, "XDDS: Could not find XDDS texture %s. Trying to load Desktop version", pTextureDesc->pFileName);
+#endif
+                success = readTextureFile(pTextureDesc, container, false, &textureDesc, &updateDesc, NULL);
+                break;
             }
-            break;
-        }
-        case TEXTURE_CONTAINER_GNF:
-        {
-#if defined(ORBIS) || defined(PROSPERO)
-            success = fsOpenStreamFromPath(RD_TEXTURES, pTextureDesc->pFileName, FM_READ, &stream);
-            uint32_t res = 1;
-            if (success)
+            case TEXTURE_CONTAINER_KTX:
             {
-                extern uint32_t loadGnfTexture(Renderer * pRenderer, FileStream * stream, const char* name, TextureCreationFlags flags,
-                                               Texture** ppTexture);
-                res = loadGnfTexture(pRenderer, &stream, pTextureDesc->pFileName, pTextureDesc->mFlags, pTextureDesc->ppTexture);
-                fsCloseStream(&stream);
+                success = readTextureFile(pTextureDesc, container, false, &textureDesc, &updateDesc, NULL);
+                break;
             }
+            case TEXTURE_CONTAINER_GNF:
+            {
+#if defined(ORBIS) || defined(PROSPERO)
+                FileStream stream = {};
+                success = fsOpenStreamFromPath(RD_TEXTURES, pTextureDesc->pFileName, FM_READ, &stream);
+                uint32_t res = 1;
+                if (success)
+                {
+                    extern uint32_t loadGnfTexture(Renderer * pRenderer, FileStream * stream, const char* name, TextureCreationFlags flags,
+                                                   Texture** ppTexture);
+                    res = loadGnfTexture(pRenderer, &stream, pTextureDesc->pFileName, pTextureDesc->mFlags, pTextureDesc->ppTexture);
+                    fsCloseStream(&stream);
+                }
 
-            return res ? UPLOAD_FUNCTION_RESULT_INVALID_REQUEST : UPLOAD_FUNCTION_RESULT_COMPLETED;
+                return res ? UPLOAD_FUNCTION_RESULT_INVALID_REQUEST : UPLOAD_FUNCTION_RESULT_COMPLETED;
 #endif
-        }
-        default:
-            break;
+            }
+            default:
+                break;
+            }
         }
 
         if (success)
@@ -1439,7 +1825,6 @@ static UploadFunctionResult loadTexture(Renderer* pRenderer, CopyEngine* pCopyEn
 #endif
             addTexture(pRenderer, &textureDesc, pTextureDesc->ppTexture);
 
-            updateDesc.mStream = stream;
             updateDesc.pTexture = *pTextureDesc->ppTexture;
             updateDesc.mBaseMipLevel = 0;
             updateDesc.mMipLevels = textureDesc.mMipLevels;
@@ -1515,16 +1900,12 @@ static void fillGeometryUpdateDesc(Renderer* pRenderer, CopyEngine* pCopyEngine,
     indexUpdateDesc->mSize = geom->mIndexCount * *indexStride;
 
     // We need to check for pCpuMappedAddress because when we allocate a custom ResourceHeap with GPU_ONLY memory we don't get any CPU
-    // mapped address and we need staging memory
+    // mapped address and we need staging memory, it is allocated below for all buffers at once
     if (gUma && indexUpdateDesc->pBuffer->pCpuMappedAddress)
     {
         indexUpdateDesc->mInternal.mMappedRange = { (uint8_t*)indexUpdateDesc->pBuffer->pCpuMappedAddress + indexUpdateDesc->mDstOffset };
+        indexUpdateDesc->pMappedData = indexUpdateDesc->mInternal.mMappedRange.pData;
     }
-    else
-    {
-        indexUpdateDesc->mInternal.mMappedRange.pData = (uint8_t*)tf_calloc_memalign(1, 4, indexUpdateDesc->mSize);
-    }
-    indexUpdateDesc->pMappedData = indexUpdateDesc->mInternal.mMappedRange.pData;
 
     // Vertex buffers
     uint32_t bufferCounter = 0;
@@ -1572,139 +1953,296 @@ static void fillGeometryUpdateDesc(Renderer* pRenderer, CopyEngine* pCopyEngine,
         {
             vertexUpdateDesc[i].mInternal.mMappedRange = { (uint8_t*)vertexUpdateDesc[i].pBuffer->pCpuMappedAddress +
                                                            vertexUpdateDesc[i].mDstOffset };
+            vertexUpdateDesc[i].pMappedData = vertexUpdateDesc[i].mInternal.mMappedRange.pData;
         }
-        else
-        {
-            vertexUpdateDesc[i].mInternal.mMappedRange.pData = (uint8_t*)tf_calloc_memalign(1, 4, vertexUpdateDesc[i].mSize);
-        }
-        vertexUpdateDesc[i].pMappedData = vertexUpdateDesc[i].mInternal.mMappedRange.pData;
         ++bufferCounter;
     }
 
     geom->mVertexBufferCount = bufferCounter;
-}
 
-static UploadFunctionResult loadGeometryCustomMeshFormat(Renderer* pRenderer, CopyEngine* pCopyEngine, GeometryLoadDesc* pDesc,
-                                                         BufferUpdateDesc vertexUpdateDesc[MAX_VERTEX_BINDINGS],
-                                                         BufferUpdateDesc indexUpdateDesc[1])
-{
-    FileStream file = {};
-    if (!fsOpenStreamFromPath(RD_MESHES, pDesc->pFileName, FM_READ, &file))
+    // One staging allocation for all buffers, data is written to it directly instead of being copied from temporary memory
+    BufferUpdateDesc* stagingUpdates[MAX_VERTEX_BINDINGS + 1] = {};
+    uint32_t          stagingUpdateCount = 0;
+    if (!indexUpdateDesc->pMappedData)
     {
-        LOGF(eERROR, "Failed to open bin file %s", pDesc->pFileName);
-        ASSERT(false);
-        return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+        stagingUpdates[stagingUpdateCount++] = indexUpdateDesc;
     }
-
-    char magic[TF_ARRAY_COUNT(GEOMETRY_FILE_MAGIC_STR)] = { 0 };
-    COMPILE_ASSERT(sizeof(magic) == sizeof(GEOMETRY_FILE_MAGIC_STR));
-    fsReadFromStream(&file, magic, sizeof(magic));
-
-    if (strncmp(magic, GEOMETRY_FILE_MAGIC_STR, TF_ARRAY_COUNT(magic)) != 0)
+    for (uint32_t i = 0; i < MAX_VERTEX_BINDINGS; ++i)
     {
-        LOGF(eERROR, "File '%s' is not a Geometry file.", pDesc->pFileName);
-        return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+        if (vertexUpdateDesc[i].pBuffer && !vertexUpdateDesc[i].pMappedData)
+        {
+            stagingUpdates[stagingUpdateCount++] = &vertexUpdateDesc[i];
+        }
     }
 
-    uint32_t geomSize = 0;
-    fsReadFromStream(&file, &geomSize, sizeof(uint32_t));
-    if (!VERIFYMSG(geomSize >= 352, "File '%s': Geometry object must have a size >= 352.", pDesc->pFileName))
+    if (stagingUpdateCount)
     {
-        return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+        const uint64_t alignment = max(4u, pRenderer->pGpu->mUploadBufferAlignment);
+        uint64_t       stagingSize = 0;
+        for (uint32_t i = 0; i < stagingUpdateCount; ++i)
+        {
+            stagingSize += round_up_64(stagingUpdates[i]->mSize, alignment);
+        }
+
+        MappedMemoryRange range = allocateStagingMemory(pCopyEngine, stagingSize, (uint32_t)alignment, pDesc->mNodeIndex);
+        ASSERT(range.pData);
+        if (range.mFlags & MAPPED_RANGE_FLAG_TEMP_BUFFER)
+        {
+            setBufferName(pRenderer, range.pBuffer, pDesc->pFileName);
+        }
+
+        uint64_t offset = 0;
+        for (uint32_t i = 0; i < stagingUpdateCount; ++i)
+        {
+            const uint64_t size = round_up_64(stagingUpdates[i]->mSize, alignment);
+            stagingUpdates[i]->mInternal.mMappedRange = { range.pData + offset, range.pBuffer, range.mOffset + offset, size, range.mFlags };
+            stagingUpdates[i]->pMappedData = stagingUpdates[i]->mInternal.mMappedRange.pData;
+            offset += size;
+        }
     }
+}
 
-    Geometry* geom = (Geometry*)tf_calloc(1, geomSize);
+static uint64_t getGeometryMeshletsSize(const GeometryMeshlets* pMeshlets)
+{
+    return pMeshlets->mMeshletCount * (sizeof(*pMeshlets->mMeshlets) + sizeof(*pMeshlets->mMeshletsData)) +
+           pMeshlets->mVertexCount * sizeof(*pMeshlets->mVertices) + pMeshlets->mTriangleCount * sizeof(*pMeshlets->mTriangles);
+}
+
+static void setGeometryMeshletPointers(GeometryMeshlets* pMeshlets, void* pMem)
+{
+    pMeshlets->mMeshlets = (Meshlet*)pMem;
+    pMeshlets->mMeshletsData = (MeshletData*)(pMeshlets->mMeshlets + pMeshlets->mMeshletCount);
+    pMeshlets->mVertices = (uint32_t*)(pMeshlets->mMeshletsData + pMeshlets->mMeshletCount);
+    pMeshlets->mTriangles = (uint8_t*)(pMeshlets->mVertices + pMeshlets->mVertexCount);
+}
 
-    if (!VERIFYMSG(geom, "File '%s': Geometry object is a nullptr.", pDesc->pFileName))
+// Pointers are stored in the file as they were at export time, clear them before anything can free or follow them
+static void clearGeometryDataPointers(GeometryData* pGeomData)
+{
+    pGeomData->pShadow = NULL;
+    pGeomData->pInverseBindPoses = NULL;
+    pGeomData->pJointRemaps = NULL;
+    pGeomData->meshlets = NULL;
+    pGeomData->pUserData = NULL;
+}
+
+// Version 1 stores size before every section and meshlets at the end of the file
+static bool readGeometryFileV1(FileStream* pFile, const char* pFileName, uint32_t geomSize, Geometry** ppGeom, GeometryData** ppGeomData)
+{
+    if (!VERIFYMSG(geomSize >= 352, "File '%s': Geometry object must have a size >= 352.", pFileName))
     {
-        return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+        return false;
     }
 
-    fsReadFromStream(&file, geom, geomSize);
+    Geometry* geom = (Geometry*)tf_calloc(1, geomSize);
+    *ppGeom = geom;
+    if (fsReadFromStream(pFile, geom, geomSize) != geomSize)
+    {
+        return false;
+    }
 
     uint32_t geomDataSize = 0;
-    fsReadFromStream(&file, &geomDataSize, sizeof(uint32_t));
-    if (!VERIFYMSG(geomDataSize > 0, "File '%s': Geometry object must have a size greater than 0.", pDesc->pFileName))
+    fsReadFromStream(pFile, &geomDataSize, sizeof(uint32_t));
+    if (!VERIFYMSG(geomDataSize >= sizeof(GeometryData), "File '%s': GeometryData object must have a size >= %u.", pFileName,
+                   (uint32_t)sizeof(GeometryData)))
     {
-        return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+        return false;
     }
 
     GeometryData* geomData = (GeometryData*)tf_calloc(1, geomDataSize);
-    if (!VERIFYMSG(geomData, "File '%s': Geometry object is a nullptr.", pDesc->pFileName))
+    *ppGeomData = geomData;
+    const bool geomDataRead = fsReadFromStream(pFile, geomData, geomDataSize) == geomDataSize;
+    clearGeometryDataPointers(geomData);
+    if (!geomDataRead)
     {
-        return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+        return false;
     }
 
-    fsReadFromStream(&file, geomData, geomDataSize);
-
     uint32_t shadowSize = 0;
-    fsReadFromStream(&file, &shadowSize, sizeof(uint32_t));
-    ASSERT(shadowSize > 0);
+    fsReadFromStream(pFile, &shadowSize, sizeof(uint32_t));
     if (shadowSize < sizeof(*geomData->pShadow))
     {
-        LOGF(eERROR, "File '%s': Geometry object has shadow with size less than %x, got %x", pDesc->pFileName,
-             (int)sizeof(*geomData->pShadow), (int)shadowSize);
-        return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+        LOGF(eERROR, "File '%s': Geometry object has shadow with size less than %x, got %x", pFileName, (int)sizeof(*geomData->pShadow),
+             (int)shadowSize);
+        return false;
     }
 
     geomData->pShadow = (GeometryData::ShadowData*)tf_malloc(shadowSize);
-    if (!geomData->pShadow)
-    {
-        return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
-    }
-
-    if (!VERIFYMSG(fsReadFromStream(&file, geomData->pShadow, shadowSize) == shadowSize,
-                   "File '%s': Failed to read Geometry object's shadow.", pDesc->pFileName))
+    if (!VERIFYMSG(fsReadFromStream(pFile, geomData->pShadow, shadowSize) == shadowSize,
+                   "File '%s': Failed to read Geometry object's shadow.", pFileName))
     {
-        return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+        return false;
     }
 
     if (geom->meshlets.mMeshletCount)
     {
-        uint64_t meshlets_size = geom->meshlets.mMeshletCount * sizeof *geom->meshlets.mMeshlets;
-        uint64_t meshlets_data_size = geom->meshlets.mMeshletCount * sizeof *geom->meshlets.mMeshletsData;
-        uint64_t vertices_size = geom->meshlets.mVertexCount * sizeof *geom->meshlets.mVertices;
-        uint64_t triangles_size = geom->meshlets.mTriangleCount * sizeof *geom->meshlets.mTriangles;
-
-        uint64_t alloc_size = meshlets_size + meshlets_data_size + vertices_size + triangles_size;
-
-        void* mem = tf_malloc(alloc_size);
-
-        geom->meshlets.mMeshlets = (Meshlet*)mem;
-        geom->meshlets.mMeshletsData = (MeshletData*)(geom->meshlets.mMeshlets + geom->meshlets.mMeshletCount);
-        geom->meshlets.mVertices = (uint32_t*)(geom->meshlets.mMeshletsData + geom->meshlets.mMeshletCount);
-        geom->meshlets.mTriangles = (uint8_t*)(geom->meshlets.mVertices + geom->meshlets.mVertexCount);
+        // Meshlets are kept in the Geometry allocation, the same way version 2 files are read
+        const uint64_t meshletsOffset = round_up_64(geomSize, 16);
+        const uint64_t meshletsSize = getGeometryMeshletsSize(&geom->meshlets);
+        geom = (Geometry*)tf_realloc(geom, (size_t)(meshletsOffset + meshletsSize));
+        *ppGeom = geom;
 
-        size_t read = fsReadFromStream(&file, mem, alloc_size);
-        if (alloc_size != read)
+        void* mem = (uint8_t*)geom + meshletsOffset;
+        setGeometryMeshletPointers(&geom->meshlets, mem);
+        if (fsReadFromStream(pFile, mem, (size_t)meshletsSize) != meshletsSize)
         {
-            return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+            return false;
         }
     }
 
-    fsCloseStream(&file);
+    return true;
+}
 
-    geom->pDrawArgs = (IndirectDrawIndexArguments*)(geom + 1); //-V1027
+static bool readGeometryFileSection(FileStream* pFile, const GeometryFileHeader* pHeader, GeometryFileSection section, uint64_t size,
+                                    void* pOut)
+{
+    return fsSeekStream(pFile, SBO_START_OF_FILE, (ssize_t)pHeader->mSectionOffsets[section]) &&
+           (uint64_t)fsReadFromStream(pFile, pOut, (size_t)size) == size;
+}
 
-    if (geomData->mJointCount > 0)
+// Version 2 is read with one read per allocation, Geometry and meshlets are adjacent in the file and share one allocation
+static bool readGeometryFileV2(FileStream* pFile, const char* pFileName, GeometryFileHeader* pHeader, Geometry** ppGeom,
+                               GeometryData** ppGeomData)
+{
+    const size_t prefixSize = offsetof(GeometryFileHeader, mPad);
+    const size_t headerSize = sizeof(*pHeader) - prefixSize;
+    if (fsReadFromStream(pFile, (uint8_t*)pHeader + prefixSize, headerSize) != headerSize)
     {
-        geomData->pInverseBindPoses = (mat4*)(geomData + 1); //-V1027
-        geomData->pJointRemaps =
-            (uint32_t*)((uint8_t*)geomData->pInverseBindPoses + round_up(geomData->mJointCount * sizeof(*geomData->pInverseBindPoses), 16));
+        LOGF(eERROR, "File '%s': Failed to read geometry file header.", pFileName);
+        return false;
     }
 
-    uint8_t* pUserData = geomData->mJointCount > 0
-                             ? ((uint8_t*)geomData->pJointRemaps + round_up(geomData->mJointCount * sizeof(uint32_t), 16))
-                             : (uint8_t*)(geomData + 1);
-    if (geomData->mUserDataSize > 0)
+    const uint64_t  fileSize = (uint64_t)max<ssize_t>(fsGetStreamFileSize(pFile), 0);
+    const uint64_t* offsets = pHeader->mSectionOffsets;
+    const uint64_t* sizes = pHeader->mSectionSizes;
+    for (uint32_t i = 0; i < GEOMETRY_FILE_SECTION_COUNT; ++i)
     {
-        geomData->pUserData = pUserData;
+        if (offsets[i] % 16 || offsets[i] > fileSize || sizes[i] > fileSize - offsets[i])
+        {
+            LOGF(eERROR, "File '%s': Geometry file section %u is out of the file.", pFileName, i);
+            return false;
+        }
     }
 
-    // Determine index stride
-    const uint32_t indexStride = geom->mVertexCount > UINT16_MAX ? sizeof(uint32_t) : sizeof(uint16_t);
+    const uint64_t geomOffset = offsets[GEOMETRY_FILE_SECTION_GEOMETRY];
+    const uint64_t meshletsOffset = offsets[GEOMETRY_FILE_SECTION_MESHLETS];
+    const uint64_t meshletsSize = sizes[GEOMETRY_FILE_SECTION_MESHLETS];
+    if (sizes[GEOMETRY_FILE_SECTION_GEOMETRY] < sizeof(Geometry) || sizes[GEOMETRY_FILE_SECTION_GEOMETRY_DATA] < sizeof(GeometryData) ||
+        sizes[GEOMETRY_FILE_SECTION_SHADOW] < sizeof(GeometryData::ShadowData) ||
+        (meshletsSize && meshletsOffset < geomOffset + sizes[GEOMETRY_FILE_SECTION_GEOMETRY]))
+    {
+        LOGF(eERROR, "File '%s': Geometry file sections are invalid.", pFileName);
+        return false;
+    }
 
-    geomData->pShadow->pIndices = geomData->pShadow + 1;
+    const uint64_t geomAllocSize = meshletsSize ? meshletsOffset + meshletsSize - geomOffset : sizes[GEOMETRY_FILE_SECTION_GEOMETRY];
+    Geometry*      geom = (Geometry*)tf_malloc((size_t)geomAllocSize);
+    *ppGeom = geom;
+    if (!readGeometryFileSection(pFile, pHeader, GEOMETRY_FILE_SECTION_GEOMETRY, geomAllocSize, geom))
+    {
+        return false;
+    }
+
+    if (meshletsSize != (geom->meshlets.mMeshletCount ? getGeometryMeshletsSize(&geom->meshlets) : 0))
+    {
+        LOGF(eERROR, "File '%s': Geometry meshlets do not match their file section.", pFileName);
+        return false;
+    }
+    if (meshletsSize)
+    {
+        setGeometryMeshletPointers(&geom->meshlets, (uint8_t*)geom + (meshletsOffset - geomOffset));
+    }
+
+    GeometryData* geomData = (GeometryData*)tf_malloc((size_t)sizes[GEOMETRY_FILE_SECTION_GEOMETRY_DATA]);
+    *ppGeomData = geomData;
+    const bool geomDataRead =
+        readGeometryFileSection(pFile, pHeader, GEOMETRY_FILE_SECTION_GEOMETRY_DATA, sizes[GEOMETRY_FILE_SECTION_GEOMETRY_DATA], geomData);
+    clearGeometryDataPointers(geomData);
+    if (!geomDataRead)
+    {
+        return false;
+    }
+
+    geomData->pShadow = (GeometryData::ShadowData*)tf_malloc((size_t)sizes[GEOMETRY_FILE_SECTION_SHADOW]);
+    return readGeometryFileSection(pFile, pHeader, GEOMETRY_FILE_SECTION_SHADOW, sizes[GEOMETRY_FILE_SECTION_SHADOW], geomData->pShadow);
+}
+
+// Reads and sets up CPU side of the geometry, does not touch the renderer
+static bool readGeometryFile(const GeometryLoadDesc* pDesc, Geometry** ppGeom, GeometryData** ppGeomData, uint64_t* pOutSize)
+{
+    FileStream file = {};
+    if (!fsOpenStreamFromPath(RD_MESHES, pDesc->pFileName, FM_READ, &file))
+    {
+        LOGF(eERROR, "Failed to open bin file %s", pDesc->pFileName);
+        ASSERT(false);
+        return false;
+    }
+
+    // Version 1 stores size of Geometry where version 2 stores its version
+    GeometryFileHeader header = {};
+    const size_t       prefixSize = offsetof(GeometryFileHeader, mPad);
+    uint32_t           version = 0;
+    if (fsReadFromStream(&file, &header, prefixSize) != prefixSize ||
+        strncmp(header.mMagic, GEOMETRY_FILE_MAGIC_STR, TF_ARRAY_COUNT(header.mMagic)) != 0)
+    {
+        LOGF(eERROR, "File '%s' is not a Geometry file.", pDesc->pFileName);
+        fsCloseStream(&file);
+        return false;
+    }
+    memcpy(&version, header.mVersion, sizeof(version));
+
+    Geometry*     geom = NULL;
+    GeometryData* geomData = NULL;
+    bool          success = false;
+    if (version == GEOMETRY_FILE_VERSION)
+    {
+        success = readGeometryFileV2(&file, pDesc->pFileName, &header, &geom, &geomData);
+    }
+    else if (version >= 352)
+    {
+        success = readGeometryFileV1(&file, pDesc->pFileName, version, &geom, &geomData);
+    }
+    else
+    {
+        LOGF(eERROR, "File '%s': Geometry file version %u is not supported, expected %u.", pDesc->pFileName, version,
+             GEOMETRY_FILE_VERSION);
+    }
+
+    *pOutSize = (uint64_t)fsGetStreamFileSize(&file);
+    fsCloseStream(&file);
+
+    if (!success)
+    {
+        if (geomData)
+        {
+            tf_free(geomData->pShadow);
+        }
+        tf_free(geomData);
+        tf_free(geom);
+        return false;
+    }
+
+    geom->pDrawArgs = (IndirectDrawIndexArguments*)(geom + 1); //-V1027
+
+    if (geomData->mJointCount > 0)
+    {
+        geomData->pInverseBindPoses = (mat4*)(geomData + 1); //-V1027
+        geomData->pJointRemaps =
+            (uint32_t*)((uint8_t*)geomData->pInverseBindPoses + round_up(geomData->mJointCount * sizeof(*geomData->pInverseBindPoses), 16));
+    }
+
+    uint8_t* pUserData = geomData->mJointCount > 0
+                             ? ((uint8_t*)geomData->pJointRemaps + round_up(geomData->mJointCount * sizeof(uint32_t), 16))
+                             : (uint8_t*)(geomData + 1);
+    if (geomData->mUserDataSize > 0)
+    {
+        geomData->pUserData = pUserData;
+    }
+
+    // Determine index stride
+    const uint32_t indexStride = geom->mVertexCount > UINT16_MAX ? sizeof(uint32_t) : sizeof(uint16_t);
+
+    geomData->pShadow->pIndices = geomData->pShadow + 1;
 
     geomData->pShadow->pAttributes[SEMANTIC_POSITION] = (uint8_t*)geomData->pShadow->pIndices + (geom->mIndexCount * indexStride);
 
@@ -1718,6 +2256,18 @@ static UploadFunctionResult loadGeometryCustomMeshFormat(Renderer* pRenderer, Co
             geomData->pShadow->pAttributes[i] = nullptr;
     }
 
+    *ppGeom = geom;
+    *ppGeomData = geomData;
+    return true;
+}
+
+static UploadFunctionResult loadGeometryCustomMeshFormat(Renderer* pRenderer, CopyEngine* pCopyEngine, GeometryLoadDesc* pDesc, Geometry* geom,
+                                                         GeometryData* geomData, BufferUpdateDesc vertexUpdateDesc[MAX_VERTEX_BINDINGS],
+                                                         BufferUpdateDesc indexUpdateDesc[1])
+{
+    // Determine index stride
+    const uint32_t indexStride = geom->mVertexCount > UINT16_MAX ? sizeof(uint32_t) : sizeof(uint16_t);
+
     uint32_t vertexAttribCount[MAX_SEMANTICS] = {};
     uint32_t vertexOffsets[MAX_SEMANTICS] = {}; // offset in the GPU layout
     uint32_t vertexBindings[MAX_SEMANTICS] = {};
@@ -1843,10 +2393,28 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
 {
     GeometryLoadDesc* pDesc = &pGeometryLoad.geomLoadDesc;
 
+    Geometry*     geom = NULL;
+    GeometryData* geomData = NULL;
+    uint64_t      fileSize = 0;
+
+    const ResourcePrepareJob* pJob = pGeometryLoad.pPrepareJob;
+    bool                      success = pJob ? pJob->mSuccess : readGeometryFile(pDesc, &geom, &geomData, &fileSize);
+    if (pJob)
+    {
+        geom = pJob->pGeom;
+        geomData = pJob->pGeomData;
+    }
+
+    if (!success)
+    {
+        return UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+    }
+
     BufferUpdateDesc indexUpdateDesc = {};
     BufferUpdateDesc vertexUpdateDesc[MAX_VERTEX_BINDINGS] = {};
 
-    UploadFunctionResult res = loadGeometryCustomMeshFormat(pRenderer, pCopyEngine, pDesc, vertexUpdateDesc, &indexUpdateDesc);
+    UploadFunctionResult res =
+        loadGeometryCustomMeshFormat(pRenderer, pCopyEngine, pDesc, geom, geomData, vertexUpdateDesc, &indexUpdateDesc);
     if (res != UPLOAD_FUNCTION_RESULT_COMPLETED)
         return res;
 
@@ -1855,18 +2423,10 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
     BufferBarrier        barriers[MAX_VERTEX_BINDINGS + 1] = {};
     uint32_t             barrierCount = 0;
 
-    if (!gUma || (indexUpdateDesc.pMappedData && !indexUpdateDesc.pBuffer->pCpuMappedAddress))
+    // Staging memory was written by loadGeometryCustomMeshFormat, buffers mapped on UMA were written directly
+    if (!gUma || !indexUpdateDesc.pBuffer->pCpuMappedAddress)
     {
         indexUpdateDesc.mCurrentState = gUma ? indexUpdateDesc.mCurrentState : RESOURCE_STATE_COPY_DEST;
-        indexUpdateDesc.mInternal.mMappedRange = allocateStagingMemory(pCopyEngine, indexUpdateDesc.mSize, 1, pDesc->mNodeIndex);
-        ASSERT(indexUpdateDesc.pMappedData);
-        memcpy(indexUpdateDesc.mInternal.mMappedRange.pData, indexUpdateDesc.pMappedData, indexUpdateDesc.mSize);
-        tf_free(indexUpdateDesc.pMappedData);
-        if (indexUpdateDesc.mInternal.mMappedRange.mFlags & MAPPED_RANGE_FLAG_TEMP_BUFFER)
-        {
-            setBufferName(pRenderer, indexUpdateDesc.mInternal.mMappedRange.pBuffer, pDesc->pFileName);
-        }
-        indexUpdateDesc.pMappedData = indexUpdateDesc.mInternal.mMappedRange.pData;
         uploadResult = updateBuffer(pRenderer, pCopyEngine, indexUpdateDesc);
     }
 
@@ -1876,19 +2436,9 @@ static UploadFunctionResult loadGeometry(Renderer* pRenderer, CopyEngine* pCopyE
     {
         if (vertexUpdateDesc[i].pBuffer)
         {
-            if (!gUma || (vertexUpdateDesc[i].pMappedData && !vertexUpdateDesc[i].pBuffer->pCpuMappedAddress))
+            if (!gUma || !vertexUpdateDesc[i].pBuffer->pCpuMappedAddress)
             {
                 vertexUpdateDesc[i].mCurrentState = gUma ? vertexUpdateDesc[i].mCurrentState : RESOURCE_STATE_COPY_DEST;
-                vertexUpdateDesc[i].mInternal.mMappedRange =
-                    allocateStagingMemory(pCopyEngine, vertexUpdateDesc[i].mSize, 1, pDesc->mNodeIndex);
-                ASSERT(vertexUpdateDesc[i].pMappedData);
-                memcpy(vertexUpdateDesc[i].mInternal.mMappedRange.pData, vertexUpdateDesc[i].pMappedData, vertexUpdateDesc[i].mSize);
-                tf_free(vertexUpdateDesc[i].pMappedData);
-                if (vertexUpdateDesc[i].mInternal.mMappedRange.mFlags & MAPPED_RANGE_FLAG_TEMP_BUFFER)
-                {
-                    setBufferName(pRenderer, vertexUpdateDesc[i].mInternal.mMappedRange.pBuffer, pDesc->pFileName);
-                }
-                vertexUpdateDesc[i].pMappedData = vertexUpdateDesc[i].mInternal.mMappedRange.pData;
                 uploadResult = updateBuffer(pRenderer, pCopyEngine, vertexUpdateDesc[i]);
             }
             barriers[barrierCount++] = { vertexUpdateDesc[i].pBuffer, RESOURCE_STATE_COPY_DEST, gVertexBufferState };
@@ -1934,7 +2484,7 @@ static UploadFunctionResult copyTexture(Renderer* pRenderer, CopyEngine* pCopyEn
     subresourceDesc.mArrayLayer = pTextureCopy.mTextureArrayLayer;
     subresourceDesc.mMipLevel = pTextureCopy.mTextureMipLevel;
     subresourceDesc.mSrcOffset = pTextureCopy.mBufferOffset;
-#if defined(DIRECT3D11) || defined(METAL) || defined(VULKAN)
+#if defined(DIRECT3D11) || defined(METAL) || defined(VULKAN) || defined(NULL_RENDERER)
     const uint32_t sliceAlignment = util_get_texture_subresource_alignment(pRenderer, fmt);
     const uint32_t rowAlignment = util_get_texture_row_alignment(pRenderer);
     uint32_t       subRowPitch = round_up(rowBytes, rowAlignment);
@@ -1954,169 +2504,665 @@ static UploadFunctionResult copyTexture(Renderer* pRenderer, CopyEngine* pCopyEn
 /************************************************************************/
 // Internal Resource Loader Implementation
 /************************************************************************/
-static bool areTasksAvailable(ResourceLoader* pLoader)
+static void runPrepareJob(ResourcePrepareJob* pJob, bool readAhead)
+{
+    switch (pJob->mType)
+    {
+    case UPDATE_REQUEST_LOAD_TEXTURE:
+        pJob->mSuccess = readTextureFile(&pJob->mTexLoadDesc, resolveTextureContainer(pJob->mTexLoadDesc.mContainer), readAhead,
+                                         &pJob->mTextureDesc, &pJob->mTextureUpdateDesc, &pJob->mSize);
+        break;
+    case UPDATE_REQUEST_LOAD_GEOMETRY:
+        pJob->mSuccess = readGeometryFile(&pJob->mGeomLoadDesc, &pJob->pGeom, &pJob->pGeomData, &pJob->mSize);
+        break;
+    default:
+        ASSERT(false);
+        break;
+    }
+
+    // Only data read ahead is counted, streamer thread consumes its own reads right away
+    if (!readAhead || !pJob->mSuccess)
+    {
+        pJob->mSize = 0;
+    }
+}
+
+// Frees data read by a job whose request is not executed
+static void freePrepareJobData(ResourcePrepareJob* pJob)
+{
+    if (!pJob->mSuccess)
+    {
+        return;
+    }
+
+    if (pJob->mType == UPDATE_REQUEST_LOAD_TEXTURE)
+    {
+        fsCloseStream(&pJob->mTextureUpdateDesc.mStream);
+    }
+    else if (pJob->mType == UPDATE_REQUEST_LOAD_GEOMETRY)
+    {
+        tf_free(pJob->pGeom);
+        tf_free(pJob->pGeomData->pShadow);
+        tf_free(pJob->pGeomData);
+    }
+}
+
+static void removePendingPrepareJob(ResourceLoader* pLoader, ResourcePrepareJob* pJob)
 {
-    for (size_t i = 0; i < MAX_MULTIPLE_GPUS; ++i)
+    ResourcePrepareJob** pQueue = pLoader->mPrepareQueue[pJob->mPriority];
+    for (ptrdiff_t i = 0; i < arrlen(pQueue); ++i)
     {
-        if (arrlen(pLoader->mRequestQueue[i]))
+        if (pQueue[i] == pJob)
         {
-            return true;
+            arrdel(pLoader->mPrepareQueue[pJob->mPriority], i);
+            return;
         }
     }
+    ASSERT(false);
+}
 
-    return false;
+// Highest priority job not taken by any thread yet
+static ResourcePrepareJob* nextPendingPrepareJob(ResourceLoader* pLoader)
+{
+    for (int32_t p = RESOURCE_LOAD_PRIORITY_COUNT - 1; p >= 0; --p)
+    {
+        if (arrlen(pLoader->mPrepareQueue[p]))
+        {
+            return pLoader->mPrepareQueue[p][0];
+        }
+    }
+    return NULL;
 }
 
-static void streamerThreadFunc(void* pThreadData)
+static void ioThreadFunc(void* pThreadData)
 {
     ResourceLoader* pLoader = (ResourceLoader*)pThreadData;
     ASSERT(pLoader);
 
-    while (pLoader->mRun)
+    acquireMutex(&pLoader->mPrepareMutex);
+    for (;;)
     {
-        acquireMutex(&pLoader->mQueueMutex);
-
-        // Check for pending tokens
-        // Safe to use mTokenCounter as we are inside critical section
-        bool allTokensSignaled = (pLoader->mTokenCompleted == tfrg_atomic64_load_relaxed(&pLoader->mTokenCounter));
+        // Read ahead limit only holds back io threads, streamer thread reads requests it gets to itself
+        while (pLoader->mRun && (!nextPendingPrepareJob(pLoader) ||
+                                 (pLoader->mDesc.mIoReadAheadSize && pLoader->mPreparedSize >= pLoader->mDesc.mIoReadAheadSize)))
+        {
+            waitConditionVariable(&pLoader->mPrepareCond, &pLoader->mPrepareMutex, TIMEOUT_INFINITE);
+        }
 
-        while (!areTasksAvailable(pLoader) && allTokensSignaled && pLoader->mRun)
+        if (!pLoader->mRun)
         {
-            // No waiting if not running dedicated resource loader thread.
-            if (pLoader->mDesc.mSingleThreaded)
-            {
-                releaseMutex(&pLoader->mQueueMutex);
-                return;
-            }
-            // Sleep until someone adds an update request to the queue
-            waitConditionVariable(&pLoader->mQueueCond, &pLoader->mQueueMutex, TIMEOUT_INFINITE);
+            break;
         }
 
-        releaseMutex(&pLoader->mQueueMutex);
+        ResourcePrepareJob* pJob = nextPendingPrepareJob(pLoader);
+        arrdel(pLoader->mPrepareQueue[pJob->mPriority], 0);
+        pJob->mState = RESOURCE_PREPARE_RUNNING;
+        releaseMutex(&pLoader->mPrepareMutex);
 
-        for (uint32_t nodeIndex = 0; nodeIndex < pLoader->mGpuCount; ++nodeIndex)
+        runPrepareJob(pJob, true);
+
+        acquireMutex(&pLoader->mPrepareMutex);
+        pJob->mState = RESOURCE_PREPARE_DONE;
+        pLoader->mPreparedSize += pJob->mSize;
+        wakeAllConditionVariable(&pLoader->mPrepareDoneCond);
+    }
+    releaseMutex(&pLoader->mPrepareMutex);
+}
+
+// Creates job reading the file of the request on io threads, returns NULL if request is read by streamer thread
+static ResourcePrepareJob* queuePrepareJob(ResourceLoader* pLoader, const UpdateRequest* pRequest, uint32_t priority)
+{
+    if (!pLoader->mIoThreadCount)
+    {
+        return NULL;
+    }
+
+    switch (pRequest->mType)
+    {
+    case UPDATE_REQUEST_LOAD_TEXTURE:
+        if (!pRequest->texLoadDesc.pFileName || pRequest->texLoadDesc.mForceReset ||
+            !canReadTextureFileAhead(resolveTextureContainer(pRequest->texLoadDesc.mContainer)))
         {
-            CopyEngine* copyEngine = &pLoader->pCopyEngines[nodeIndex];
-            waitCopyEngineSet(pLoader->ppRenderers[nodeIndex], copyEngine);
-            resetCopyEngineSet(pLoader->ppRenderers[nodeIndex], copyEngine);
-            copyEngine->activeSet = (copyEngine->activeSet + 1) % pLoader->mDesc.mBufferCount;
+            return NULL;
         }
+        break;
+    case UPDATE_REQUEST_LOAD_GEOMETRY:
+        break;
+    default:
+        return NULL;
+    }
 
-        // Signal pending tokens from previous frames
-        acquireMutex(&pLoader->mTokenMutex);
-        tfrg_atomic64_store_release(&pLoader->mTokenCompleted, pLoader->mCurrentTokenState[pLoader->pCopyEngines[0].activeSet]);
-        releaseMutex(&pLoader->mTokenMutex);
-        wakeAllConditionVariable(&pLoader->mTokenCond);
+    ResourcePrepareJob* pJob = (ResourcePrepareJob*)tf_calloc(1, sizeof(ResourcePrepareJob));
+    pJob->mType = pRequest->mType;
+    pJob->mState = RESOURCE_PREPARE_PENDING;
+    pJob->mPriority = priority;
+    if (pRequest->mType == UPDATE_REQUEST_LOAD_TEXTURE)
+    {
+        pJob->mTexLoadDesc = pRequest->texLoadDesc;
+    }
+    else
+    {
+        pJob->mGeomLoadDesc = pRequest->geomLoadDesc;
+    }
 
-        uint64_t completionMask = 0;
+    acquireMutex(&pLoader->mPrepareMutex);
+    arrpush(pLoader->mPrepareQueue[priority], pJob);
+    releaseMutex(&pLoader->mPrepareMutex);
+    wakeOneConditionVariable(&pLoader->mPrepareCond);
 
-        for (uint32_t nodeIndex = 0; nodeIndex < pLoader->mGpuCount; ++nodeIndex)
-        {
-            acquireMutex(&pLoader->mQueueMutex);
+    return pJob;
+}
 
-            UpdateRequest** pRequestQueue = &pLoader->mRequestQueue[nodeIndex];
-            CopyEngine*     pCopyEngine = &pLoader->pCopyEngines[nodeIndex];
+// Waits until file of the request is read, reads it on this thread if no io thread took it yet
+static void finishPrepareJob(ResourceLoader* pLoader, ResourcePrepareJob* pJob)
+{
+    acquireMutex(&pLoader->mPrepareMutex);
 
-            if (!arrlen(*pRequestQueue))
-            {
-                releaseMutex(&pLoader->mQueueMutex);
-                continue;
-            }
+    if (pJob->mState == RESOURCE_PREPARE_PENDING)
+    {
+        removePendingPrepareJob(pLoader, pJob);
+        pJob->mState = RESOURCE_PREPARE_RUNNING;
+        releaseMutex(&pLoader->mPrepareMutex);
 
-            UpdateRequest* activeQueue = *pRequestQueue;
-            *pRequestQueue = NULL;
-            releaseMutex(&pLoader->mQueueMutex);
+        runPrepareJob(pJob, false);
 
-            Renderer* pRenderer = pLoader->ppRenderers[nodeIndex];
-            SyncToken maxNodeToken = {};
+        acquireMutex(&pLoader->mPrepareMutex);
+        pJob->mState = RESOURCE_PREPARE_DONE;
+    }
 
-            ASSERT(arrlen(activeQueue));
+    while (pJob->mState != RESOURCE_PREPARE_DONE)
+    {
+        waitConditionVariable(&pLoader->mPrepareDoneCond, &pLoader->mPrepareMutex, TIMEOUT_INFINITE);
+    }
 
-            for (ptrdiff_t j = 0; j < arrlen(activeQueue); ++j)
-            {
-                UpdateRequest updateState = activeQueue[j];
-                // #NOTE: acquireCmd also resets copy engine on first use
-                Cmd*          cmd = acquireCmd(pCopyEngine);
+    releaseMutex(&pLoader->mPrepareMutex);
+}
 
-                UploadFunctionResult result = UPLOAD_FUNCTION_RESULT_COMPLETED;
-                switch (updateState.mType)
-                {
-                case UPDATE_REQUEST_TEXTURE_BARRIER:
-                    cmdResourceBarrier(cmd, 0, NULL, 1, &updateState.textureBarrier, 0, NULL);
-                    result = UPLOAD_FUNCTION_RESULT_COMPLETED;
-                    break;
-                case UPDATE_REQUEST_LOAD_BUFFER:
-                    result = loadBuffer(pRenderer, pCopyEngine, updateState);
-                    break;
-                case UPDATE_REQUEST_LOAD_TEXTURE:
-                    result = loadTexture(pRenderer, pCopyEngine, updateState);
-                    break;
-                case UPDATE_REQUEST_LOAD_GEOMETRY:
-                    result = loadGeometry(pRenderer, pCopyEngine, updateState);
-                    break;
-                case UPDATE_REQUEST_COPY_TEXTURE:
-                    result = copyTexture(pRenderer, pCopyEngine, updateState.texCopyDesc);
-                    break;
-                case UPDATE_REQUEST_INVALID:
-                    break;
-                }
+static void releasePrepareJob(ResourceLoader* pLoader, ResourcePrepareJob* pJob)
+{
+    acquireMutex(&pLoader->mPrepareMutex);
+    ASSERT(pLoader->mPreparedSize >= pJob->mSize);
+    pLoader->mPreparedSize -= pJob->mSize;
+    releaseMutex(&pLoader->mPrepareMutex);
+    wakeAllConditionVariable(&pLoader->mPrepareCond);
 
-                bool completed = result == UPLOAD_FUNCTION_RESULT_COMPLETED || result == UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+    tf_free(pJob);
+}
 
-                completionMask |= (uint64_t)completed << nodeIndex;
+// Takes the job out of io threads reach. Returns false if a thread is reading its file right now,
+// the read uses file name and descriptors owned by the caller, so the request must stay queued.
+// Called inside mQueueMutex, the streamer thread cannot take the request meanwhile
+static bool cancelPrepareJob(ResourceLoader* pLoader, ResourcePrepareJob* pJob)
+{
+    acquireMutex(&pLoader->mPrepareMutex);
+    if (pJob->mState == RESOURCE_PREPARE_RUNNING)
+    {
+        releaseMutex(&pLoader->mPrepareMutex);
+        return false;
+    }
 
-                if (updateState.mWaitIndex && completed)
-                {
-                    ASSERT(maxNodeToken < updateState.mWaitIndex);
-                    maxNodeToken = updateState.mWaitIndex;
-                }
+    if (pJob->mState == RESOURCE_PREPARE_PENDING)
+    {
+        removePendingPrepareJob(pLoader, pJob);
+    }
+    releaseMutex(&pLoader->mPrepareMutex);
+    return true;
+}
 
-                ASSERT(result != UPLOAD_FUNCTION_RESULT_STAGING_BUFFER_FULL);
-            }
+static void setPrepareJobPriority(ResourceLoader* pLoader, ResourcePrepareJob* pJob, uint32_t priority)
+{
+    acquireMutex(&pLoader->mPrepareMutex);
+    if (pJob->mState == RESOURCE_PREPARE_PENDING && pJob->mPriority != priority)
+    {
+        removePendingPrepareJob(pLoader, pJob);
+        pJob->mPriority = priority;
+        arrpush(pLoader->mPrepareQueue[priority], pJob);
+    }
+    releaseMutex(&pLoader->mPrepareMutex);
+}
 
-            arrfree(activeQueue);
-            pLoader->mMaxToken = max(pLoader->mMaxToken, maxNodeToken);
-        }
+static uint32_t getLoadPriorityIndex(ResourceLoadPriority priority)
+{
+    int32_t index = (int32_t)priority - (int32_t)RESOURCE_LOAD_PRIORITY_LOW;
+    return (uint32_t)min(max(index, 0), (int32_t)RESOURCE_LOAD_PRIORITY_COUNT - 1);
+}
 
-        if (completionMask != 0)
+// Must be called inside mQueueMutex
+static ptrdiff_t getQueuedRequestCount(ResourceLoader* pLoader, uint32_t nodeIndex)
+{
+    ptrdiff_t count = 0;
+    for (uint32_t p = 0; p < RESOURCE_LOAD_PRIORITY_COUNT; ++p)
+    {
+        count += arrlen(pLoader->mRequestQueue[nodeIndex][p]) - pLoader->mRequestQueueHead[nodeIndex][p];
+    }
+    return count;
+}
+
+// Takes the next request to execute, highest priority first. Must be called inside mQueueMutex
+static bool popRequest(ResourceLoader* pLoader, uint32_t nodeIndex, UpdateRequest* pOut)
+{
+    for (int32_t p = RESOURCE_LOAD_PRIORITY_COUNT - 1; p >= 0; --p)
+    {
+        UpdateRequest** pQueue = &pLoader->mRequestQueue[nodeIndex][p];
+        ptrdiff_t*      pHead = &pLoader->mRequestQueueHead[nodeIndex][p];
+        if (*pHead == arrlen(*pQueue))
         {
-            for (uint32_t nodeIndex = 0; nodeIndex < pLoader->mGpuCount; ++nodeIndex)
-            {
-                if (completionMask & ((uint64_t)1 << nodeIndex))
-                {
-                    CopyEngine* copyEngine = &pLoader->pCopyEngines[nodeIndex];
-                    streamerFlush(copyEngine);
-                    acquireMutex(&pLoader->mSemaphoreMutex);
-                    copyEngine->pLastSubmittedSemaphore = copyEngine->resourceSets[copyEngine->activeSet].pSemaphore;
-                    releaseMutex(&pLoader->mSemaphoreMutex);
-                }
-            }
+            continue;
         }
 
-        SyncToken nextToken = max(pLoader->mMaxToken, getLastTokenCompleted());
-        pLoader->mCurrentTokenState[pLoader->pCopyEngines[0].activeSet] = nextToken;
-
-        // Signal submitted tokens
-        acquireMutex(&pLoader->mTokenMutex);
-        tfrg_atomic64_store_release(&pLoader->mTokenSubmitted, pLoader->mCurrentTokenState[pLoader->pCopyEngines[0].activeSet]);
-        releaseMutex(&pLoader->mTokenMutex);
-        wakeAllConditionVariable(&pLoader->mTokenCond);
+        *pOut = (*pQueue)[(*pHead)++];
 
-        if (pResourceLoader->mDesc.mSingleThreaded)
+        // Drop taken requests once they are the larger part of the array, so that queue which never gets empty does not grow
+        if (*pHead == arrlen(*pQueue))
         {
-            return;
+            arrsetlen(*pQueue, 0);
+            *pHead = 0;
         }
+        else if (*pHead > arrlen(*pQueue) / 2)
+        {
+            arrdeln(*pQueue, 0, *pHead);
+            *pHead = 0;
+        }
+        return true;
     }
+    return false;
+}
 
+// Finds request which is not executed yet. Must be called inside mQueueMutex
+static bool findQueuedRequest(ResourceLoader* pLoader, SyncToken token, uint32_t* pNodeIndex, uint32_t* pPriority, ptrdiff_t* pIndex)
+{
     for (uint32_t nodeIndex = 0; nodeIndex < pLoader->mGpuCount; ++nodeIndex)
     {
-        streamerFlush(&pLoader->pCopyEngines[nodeIndex]);
-#if defined(DIRECT3D11)
-        const bool wait = false;
-#else
-        const bool wait = true;
-#endif
-        if (wait)
+        for (uint32_t p = 0; p < RESOURCE_LOAD_PRIORITY_COUNT; ++p)
+        {
+            UpdateRequest* pQueue = pLoader->mRequestQueue[nodeIndex][p];
+            for (ptrdiff_t i = pLoader->mRequestQueueHead[nodeIndex][p]; i < arrlen(pQueue); ++i)
+            {
+                if (pQueue[i].mWaitIndex == token)
+                {
+                    *pNodeIndex = nodeIndex;
+                    *pPriority = p;
+                    *pIndex = i;
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
+// Tokens complete in order: mMaxToken is the highest token for which all lower tokens were executed or cancelled.
+// Must be called inside mQueueMutex
+static void markTokenExecuted(ResourceLoader* pLoader, SyncToken token)
+{
+    ASSERT(token > pLoader->mMaxToken);
+
+    if (token != pLoader->mMaxToken + 1)
+    {
+        // Keep sorted, requests executed ahead of lower tokens mostly come in increasing order
+        ptrdiff_t i = arrlen(pLoader->mExecutedTokens);
+        arrpush(pLoader->mExecutedTokens, token);
+        for (; i > 0 && pLoader->mExecutedTokens[i - 1] > token; --i)
+        {
+            pLoader->mExecutedTokens[i] = pLoader->mExecutedTokens[i - 1];
+        }
+        pLoader->mExecutedTokens[i] = token;
+        return;
+    }
+
+    pLoader->mMaxToken = token;
+
+    ptrdiff_t count = 0;
+    while (count < arrlen(pLoader->mExecutedTokens) && pLoader->mExecutedTokens[count] == pLoader->mMaxToken + 1)
+    {
+        ++pLoader->mMaxToken;
+        ++count;
+    }
+    if (count)
+    {
+        arrdeln(pLoader->mExecutedTokens, 0, count);
+    }
+}
+
+// Must be called inside mQueueMutex
+static void setLoadCallbackStatus(ResourceLoader* pLoader, SyncToken token, ResourceLoadStatus status)
+{
+    // Sorted by token
+    ptrdiff_t first = 0;
+    ptrdiff_t last = arrlen(pLoader->mPendingCallbacks);
+    while (first < last)
+    {
+        ptrdiff_t middle = first + (last - first) / 2;
+        if (pLoader->mPendingCallbacks[middle].mToken < token)
+        {
+            first = middle + 1;
+        }
+        else
+        {
+            last = middle;
+        }
+    }
+
+    if (first < arrlen(pLoader->mPendingCallbacks) && pLoader->mPendingCallbacks[first].mToken == token)
+    {
+        pLoader->mPendingCallbacks[first].mStatus = status;
+    }
+}
+
+// Calls callbacks which run on loader thread, queues others for drainCompletedResourceLoads
+static void dispatchLoadCallbacks(ResourceLoader* pLoader, const ResourceLoadCallbackEntry* pEntries, ptrdiff_t count)
+{
+    bool queued = false;
+    for (ptrdiff_t i = 0; i < count; ++i)
+    {
+        if (pEntries[i].mOnLoaderThread)
+        {
+            pEntries[i].pCallback(pEntries[i].pUserData, pEntries[i].mToken, pEntries[i].mStatus);
+        }
+        else
+        {
+            if (!queued)
+            {
+                acquireMutex(&pLoader->mCallbackMutex);
+                queued = true;
+            }
+            arrpush(pLoader->mReadyCallbacks, pEntries[i]);
+        }
+    }
+
+    if (queued)
+    {
+        releaseMutex(&pLoader->mCallbackMutex);
+    }
+}
+
+// Dispatches callbacks of loads with token <= completedToken
+static void dispatchCompletedLoadCallbacks(ResourceLoader* pLoader, SyncToken completedToken)
+{
+    arrsetlen(pLoader->mCompletedCallbacks, 0);
+
+    acquireMutex(&pLoader->mQueueMutex);
+    ptrdiff_t count = 0;
+    while (count < arrlen(pLoader->mPendingCallbacks) && pLoader->mPendingCallbacks[count].mToken <= completedToken)
+    {
+        arrpush(pLoader->mCompletedCallbacks, pLoader->mPendingCallbacks[count]);
+        ++count;
+    }
+    if (count)
+    {
+        arrdeln(pLoader->mPendingCallbacks, 0, count);
+    }
+    releaseMutex(&pLoader->mQueueMutex);
+
+    // Outside of locks, callbacks may queue new loads
+    dispatchLoadCallbacks(pLoader, pLoader->mCompletedCallbacks, arrlen(pLoader->mCompletedCallbacks));
+}
+
+// For loads which have nothing to upload
+static void completeLoadWithoutRequest(ResourceLoader* pLoader, const ResourceLoadOptions* pOptions)
+{
+    if (!pOptions->pCallback)
+    {
+        return;
+    }
+
+    ResourceLoadCallbackEntry entry = { pOptions->pCallback, pOptions->pCallbackUserData, 0, RESOURCE_LOAD_STATUS_COMPLETED,
+                                        pOptions->mCallbackOnLoaderThread };
+    dispatchLoadCallbacks(pLoader, &entry, 1);
+}
+
+static SyncToken getMaxExecutedToken(ResourceLoader* pLoader)
+{
+    acquireMutex(&pLoader->mQueueMutex);
+    SyncToken token = pLoader->mMaxToken;
+    releaseMutex(&pLoader->mQueueMutex);
+    return token;
+}
+
+static bool areTasksAvailable(ResourceLoader* pLoader)
+{
+    for (uint32_t i = 0; i < MAX_MULTIPLE_GPUS; ++i)
+    {
+        if (getQueuedRequestCount(pLoader, i))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// Must be called inside mQueueMutex
+static bool isUploadBudgetExhausted(ResourceLoader* pLoader)
+{
+    const ResourceLoaderDesc* pDesc = &pLoader->mDesc;
+    if (pDesc->mSingleThreaded || pLoader->mTokenWaiterCount)
+    {
+        return false;
+    }
+    return (pDesc->mUploadBudgetSize && pLoader->mFrameUploadSize >= pDesc->mUploadBudgetSize) ||
+           (pDesc->mUploadBudgetRequestCount && pLoader->mFrameRequestCount >= pDesc->mUploadBudgetRequestCount);
+}
+
+// Publishes counters of the finished frame. Must be called inside mQueueMutex
+static void beginUploadFrame(ResourceLoader* pLoader)
+{
+    pLoader->mStats.mFrameUploadSize = pLoader->mFrameUploadSize;
+    pLoader->mStats.mFrameRequestCount = pLoader->mFrameRequestCount;
+    pLoader->mStats.mBudgetLimitedFrameCount += pLoader->mFrameBudgetLimited ? 1 : 0;
+    pLoader->mFrameUploadSize = 0;
+    pLoader->mFrameRequestCount = 0;
+    pLoader->mFrameBudgetLimited = false;
+}
+
+// Latency of executed requests whose tokens are completed now
+static void updateRequestLatency(ResourceLoader* pLoader, SyncToken completedToken)
+{
+    const int64_t now = getUSec(false);
+    acquireMutex(&pLoader->mQueueMutex);
+    for (ptrdiff_t i = arrlen(pLoader->mExecutedRequestTimes) - 1; i >= 0; --i)
+    {
+        const ExecutedRequestTime* pTime = &pLoader->mExecutedRequestTimes[i];
+        if (pTime->mToken > completedToken)
+        {
+            continue;
+        }
+
+        const uint64_t latency = (uint64_t)max(now - pTime->mQueueTime, (int64_t)0);
+        uint64_t*      pAverage = &pLoader->mStats.mAverageLatencyUs;
+        *pAverage = *pAverage ? (*pAverage * 15 + latency) / 16 : latency;
+        arrdelswap(pLoader->mExecutedRequestTimes, i);
+    }
+    releaseMutex(&pLoader->mQueueMutex);
+}
+
+static void streamerThreadFunc(void* pThreadData)
+{
+    ResourceLoader* pLoader = (ResourceLoader*)pThreadData;
+    ASSERT(pLoader);
+
+    while (pLoader->mRun)
+    {
+        acquireMutex(&pLoader->mQueueMutex);
+
+        // Check for pending tokens
+        // Safe to use mTokenCounter as we are inside critical section
+        bool allTokensSignaled = (pLoader->mTokenCompleted == tfrg_atomic64_load_relaxed(&pLoader->mTokenCounter));
+
+        // Requests over the upload budget wait for the next frame, unless frames are not counted yet.
+        // Pending tokens don't keep the thread spinning then, advanceResourceLoaderFrame or a token waiter wakes it.
+        while (((!areTasksAvailable(pLoader) && allTokensSignaled) || (pLoader->mFrameIndex && isUploadBudgetExhausted(pLoader))) &&
+               pLoader->mRun)
+        {
+            // No waiting if not running dedicated resource loader thread.
+            if (pLoader->mDesc.mSingleThreaded)
+            {
+                releaseMutex(&pLoader->mQueueMutex);
+                return;
+            }
+            // Sleep until someone adds an update request to the queue
+            waitConditionVariable(&pLoader->mQueueCond, &pLoader->mQueueMutex, TIMEOUT_INFINITE);
+        }
+
+        if (!pLoader->mFrameIndex)
+        {
+            beginUploadFrame(pLoader);
+        }
+
+        releaseMutex(&pLoader->mQueueMutex);
+
+        for (uint32_t nodeIndex = 0; nodeIndex < pLoader->mGpuCount; ++nodeIndex)
+        {
+            CopyEngine* copyEngine = &pLoader->pCopyEngines[nodeIndex];
+            waitCopyEngineSet(pLoader->ppRenderers[nodeIndex], copyEngine);
+            resetCopyEngineSet(pLoader->ppRenderers[nodeIndex], copyEngine);
+            copyEngine->activeSet = (copyEngine->activeSet + 1) % pLoader->mDesc.mBufferCount;
+        }
+
+        // Signal pending tokens from previous frames
+        const SyncToken completedToken = pLoader->mCurrentTokenState[pLoader->pCopyEngines[0].activeSet];
+        acquireMutex(&pLoader->mTokenMutex);
+        tfrg_atomic64_store_release(&pLoader->mTokenCompleted, completedToken);
+        releaseMutex(&pLoader->mTokenMutex);
+        wakeAllConditionVariable(&pLoader->mTokenCond);
+
+        dispatchCompletedLoadCallbacks(pLoader, completedToken);
+        updateRequestLatency(pLoader, completedToken);
+
+        uint64_t completionMask = 0;
+
+        for (uint32_t nodeIndex = 0; nodeIndex < pLoader->mGpuCount; ++nodeIndex)
+        {
+            // Requests queued during this pass may be taken ahead of the ones counted here if their priority is higher,
+            // the rest is left for the next pass
+            acquireMutex(&pLoader->mQueueMutex);
+            const ptrdiff_t requestCount = getQueuedRequestCount(pLoader, nodeIndex);
+            releaseMutex(&pLoader->mQueueMutex);
+
+            CopyEngine* pCopyEngine = &pLoader->pCopyEngines[nodeIndex];
+            Renderer*   pRenderer = pLoader->ppRenderers[nodeIndex];
+
+            for (ptrdiff_t j = 0; j < requestCount; ++j)
+            {
+                acquireMutex(&pLoader->mQueueMutex);
+                UpdateRequest updateState;
+                const bool    budgetExhausted = isUploadBudgetExhausted(pLoader);
+                const bool    popped = !budgetExhausted && popRequest(pLoader, nodeIndex, &updateState);
+                pLoader->mFrameBudgetLimited |= budgetExhausted;
+                releaseMutex(&pLoader->mQueueMutex);
+
+                // Cancelled or left for the next frame
+                if (!popped)
+                {
+                    break;
+                }
+
+                const uint64_t stagingSize = pCopyEngine->allocatedStagingSize;
+                const uint64_t overflowFlushCount = pCopyEngine->overflowFlushCount;
+
+                // #NOTE: acquireCmd also resets copy engine on first use
+                Cmd* cmd = acquireCmd(pCopyEngine);
+
+                if (updateState.pPrepareJob)
+                {
+                    finishPrepareJob(pLoader, updateState.pPrepareJob);
+                }
+
+                UploadFunctionResult result = UPLOAD_FUNCTION_RESULT_COMPLETED;
+                switch (updateState.mType)
+                {
+                case UPDATE_REQUEST_TEXTURE_BARRIER:
+                    cmdResourceBarrier(cmd, 0, NULL, 1, &updateState.textureBarrier, 0, NULL);
+                    result = UPLOAD_FUNCTION_RESULT_COMPLETED;
+                    break;
+                case UPDATE_REQUEST_LOAD_BUFFER:
+                    result = loadBuffer(pRenderer, pCopyEngine, updateState);
+                    break;
+                case UPDATE_REQUEST_LOAD_TEXTURE:
+                    result = loadTexture(pRenderer, pCopyEngine, updateState);
+                    break;
+                case UPDATE_REQUEST_LOAD_GEOMETRY:
+                    result = loadGeometry(pRenderer, pCopyEngine, updateState);
+                    break;
+                case UPDATE_REQUEST_COPY_TEXTURE:
+                    result = copyTexture(pRenderer, pCopyEngine, updateState.texCopyDesc);
+                    break;
+                case UPDATE_REQUEST_INVALID:
+                    break;
+                }
+
+                if (updateState.pPrepareJob)
+                {
+                    releasePrepareJob(pLoader, updateState.pPrepareJob);
+                }
+
+                bool completed = result == UPLOAD_FUNCTION_RESULT_COMPLETED || result == UPLOAD_FUNCTION_RESULT_INVALID_REQUEST;
+
+                completionMask |= (uint64_t)completed << nodeIndex;
+
+                acquireMutex(&pLoader->mQueueMutex);
+                const uint64_t uploadSize = pCopyEngine->allocatedStagingSize - stagingSize;
+                pLoader->mFrameUploadSize += uploadSize;
+                ++pLoader->mFrameRequestCount;
+                pLoader->mStats.mTotalUploadSize += uploadSize;
+                ++pLoader->mStats.mTotalRequestCount;
+                pLoader->mStats.mStagingStallCount += pCopyEngine->overflowFlushCount - overflowFlushCount;
+                if (updateState.mWaitIndex && completed)
+                {
+                    if (result == UPLOAD_FUNCTION_RESULT_INVALID_REQUEST)
+                    {
+                        setLoadCallbackStatus(pLoader, updateState.mWaitIndex, RESOURCE_LOAD_STATUS_FAILED);
+                    }
+                    markTokenExecuted(pLoader, updateState.mWaitIndex);
+
+                    ExecutedRequestTime time = { updateState.mWaitIndex, updateState.mQueueTime };
+                    arrpush(pLoader->mExecutedRequestTimes, time);
+                }
+                releaseMutex(&pLoader->mQueueMutex);
+
+                ASSERT(result != UPLOAD_FUNCTION_RESULT_STAGING_BUFFER_FULL);
+            }
+        }
+
+        if (completionMask != 0)
+        {
+            for (uint32_t nodeIndex = 0; nodeIndex < pLoader->mGpuCount; ++nodeIndex)
+            {
+                if (completionMask & ((uint64_t)1 << nodeIndex))
+                {
+                    CopyEngine* copyEngine = &pLoader->pCopyEngines[nodeIndex];
+                    streamerFlush(copyEngine);
+                    acquireMutex(&pLoader->mSemaphoreMutex);
+                    copyEngine->pLastSubmittedSemaphore = copyEngine->resourceSets[copyEngine->activeSet].pSemaphore;
+                    releaseMutex(&pLoader->mSemaphoreMutex);
+                }
+            }
+        }
+
+        SyncToken nextToken = max(getMaxExecutedToken(pLoader), getLastTokenCompleted());
+        pLoader->mCurrentTokenState[pLoader->pCopyEngines[0].activeSet] = nextToken;
+
+        // Signal submitted tokens
+        acquireMutex(&pLoader->mTokenMutex);
+        tfrg_atomic64_store_release(&pLoader->mTokenSubmitted, pLoader->mCurrentTokenState[pLoader->pCopyEngines[0].activeSet]);
+        releaseMutex(&pLoader->mTokenMutex);
+        wakeAllConditionVariable(&pLoader->mTokenCond);
+
+        if (pResourceLoader->mDesc.mSingleThreaded)
+        {
+            return;
+        }
+    }
+
+    for (uint32_t nodeIndex = 0; nodeIndex < pLoader->mGpuCount; ++nodeIndex)
+    {
+        streamerFlush(&pLoader->pCopyEngines[nodeIndex]);
+#if defined(DIRECT3D11)
+        const bool wait = false;
+#else
+        const bool wait = true;
+#endif
+        if (wait)
         {
             waitQueueIdle(pLoader->pCopyEngines[nodeIndex].pQueue);
         }
@@ -2132,7 +3178,7 @@ static void CopyEngineFlush(CopyEngine* pCopyEngine)
     pCopyEngine->pLastSubmittedSemaphore = pCopyEngine->resourceSets[pCopyEngine->activeSet].pSemaphore;
     releaseMutex(&pResourceLoader->mSemaphoreMutex);
 
-    SyncToken nextToken = max(pResourceLoader->mMaxToken, getLastTokenCompleted());
+    SyncToken nextToken = max(getMaxExecutedToken(pResourceLoader), getLastTokenCompleted());
     pResourceLoader->mCurrentTokenState[pResourceLoader->pCopyEngines[0].activeSet] = nextToken;
 
     // Signal submitted tokens
@@ -2182,6 +3228,10 @@ static void initResourceLoader(Renderer** ppRenderers, uint32_t rendererCount, R
     initConditionVariable(&pLoader->mTokenCond);
     initMutex(&pLoader->mSemaphoreMutex);
     initMutex(&pLoader->mUploadEngineMutex);
+    initMutex(&pLoader->mPrepareMutex);
+    initConditionVariable(&pLoader->mPrepareCond);
+    initConditionVariable(&pLoader->mPrepareDoneCond);
+    initMutex(&pLoader->mCallbackMutex);
 
     pLoader->mTokenCounter = 0;
     pLoader->mTokenCompleted = 0;
@@ -2250,6 +3300,16 @@ static void initResourceLoader(Renderer** ppRenderers, uint32_t rendererCount, R
     if (!pLoader->mDesc.mSingleThreaded)
     {
         initThread(&threadDesc, &pLoader->mThread);
+
+        pLoader->mIoThreadCount = min(pLoader->mDesc.mIoThreadCount, MAX_IO_THREADS);
+        for (uint32_t i = 0; i < pLoader->mIoThreadCount; ++i)
+        {
+            ThreadDesc ioThreadDesc = {};
+            ioThreadDesc.pFunc = ioThreadFunc;
+            ioThreadDesc.pData = pLoader;
+            snprintf(ioThreadDesc.mThreadName, sizeof(ioThreadDesc.mThreadName), "ResourceLoaderIO%u", i);
+            initThread(&ioThreadDesc, &pLoader->mIoThreads[i]);
+        }
     }
 
     *ppLoader = pLoader;
@@ -2267,8 +3327,56 @@ static void exitResourceLoader(ResourceLoader* pLoader)
     {
         wakeOneConditionVariable(&pLoader->mQueueCond);
         joinThread(pLoader->mThread);
+
+        acquireMutex(&pLoader->mPrepareMutex);
+        wakeAllConditionVariable(&pLoader->mPrepareCond);
+        releaseMutex(&pLoader->mPrepareMutex);
+        for (uint32_t i = 0; i < pLoader->mIoThreadCount; ++i)
+        {
+            joinThread(pLoader->mIoThreads[i]);
+        }
     }
 
+    // Jobs of requests which were not executed
+    for (uint32_t nodeIndex = 0; nodeIndex < MAX_MULTIPLE_GPUS; ++nodeIndex)
+    {
+        for (uint32_t p = 0; p < RESOURCE_LOAD_PRIORITY_COUNT; ++p)
+        {
+            UpdateRequest* pQueue = pLoader->mRequestQueue[nodeIndex][p];
+            for (ptrdiff_t i = pLoader->mRequestQueueHead[nodeIndex][p]; i < arrlen(pQueue); ++i)
+            {
+                ResourcePrepareJob* pJob = pQueue[i].pPrepareJob;
+                if (pJob)
+                {
+                    if (pJob->mState == RESOURCE_PREPARE_DONE)
+                    {
+                        freePrepareJobData(pJob);
+                    }
+                    tf_free(pJob);
+                }
+            }
+            arrfree(pLoader->mRequestQueue[nodeIndex][p]);
+        }
+    }
+    for (uint32_t p = 0; p < RESOURCE_LOAD_PRIORITY_COUNT; ++p)
+    {
+        arrfree(pLoader->mPrepareQueue[p]);
+    }
+    arrfree(pLoader->mExecutedTokens);
+    // Callbacks of loads which were not completed or drained are dropped
+    arrfree(pLoader->mPendingCallbacks);
+    arrfree(pLoader->mCompletedCallbacks);
+    arrfree(pLoader->mReadyCallbacks);
+    arrfree(pLoader->mExecutedRequestTimes);
+
+    ASSERT(!pLoader->pStreamedTexturesHead && "Streamed textures must be removed before exiting the resource loader");
+    for (ptrdiff_t i = 0; i < arrlen(pLoader->mRetiredTextures); ++i)
+    {
+        Texture* pTexture = pLoader->mRetiredTextures[i].pTexture;
+        removeTexture(pLoader->ppRenderers[pTexture->mNodeIndex], pTexture);
+    }
+    arrfree(pLoader->mRetiredTextures);
+
     for (uint32_t nodeIndex = 0; nodeIndex < pLoader->mGpuCount; ++nodeIndex)
     {
 #if defined(DIRECT3D11)
@@ -2291,44 +3399,31 @@ static void exitResourceLoader(ResourceLoader* pLoader)
     exitMutex(&pLoader->mTokenMutex);
     exitMutex(&pLoader->mSemaphoreMutex);
     exitMutex(&pLoader->mUploadEngineMutex);
+    exitConditionVariable(&pLoader->mPrepareCond);
+    exitConditionVariable(&pLoader->mPrepareDoneCond);
+    exitMutex(&pLoader->mPrepareMutex);
+    exitMutex(&pLoader->mCallbackMutex);
 
     tf_delete(pLoader);
 }
 
-static void queueBufferLoad(ResourceLoader* pLoader, BufferLoadDescInternal* pBufferLoad, SyncToken* token)
+static void queueRequest(ResourceLoader* pLoader, uint32_t nodeIndex, const ResourceLoadOptions* pOptions, UpdateRequest* pRequest,
+                         SyncToken* token)
 {
-    uint32_t nodeIndex = pBufferLoad->pBuffer->mNodeIndex;
     acquireMutex(&pLoader->mQueueMutex);
 
     SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
 
-    arrpush(pLoader->mRequestQueue[nodeIndex], UpdateRequest(*pBufferLoad));
-    UpdateRequest* pLastRequest = arrback(pLoader->mRequestQueue[nodeIndex]);
-    if (pLastRequest)
-        pLastRequest->mWaitIndex = t;
+    pRequest->mWaitIndex = t;
+    pRequest->mQueueTime = getUSec(false);
+    arrpush(pLoader->mRequestQueue[nodeIndex][getLoadPriorityIndex(pOptions->mPriority)], *pRequest);
 
-    releaseMutex(&pLoader->mQueueMutex);
-    wakeOneConditionVariable(&pLoader->mQueueCond);
-    if (token)
-        *token = max(t, *token);
-
-    if (pResourceLoader->mDesc.mSingleThreaded)
+    if (pOptions->pCallback)
     {
-        streamerThreadFunc(pResourceLoader);
+        ResourceLoadCallbackEntry entry = { pOptions->pCallback, pOptions->pCallbackUserData, t, RESOURCE_LOAD_STATUS_COMPLETED,
+                                            pOptions->mCallbackOnLoaderThread };
+        arrpush(pLoader->mPendingCallbacks, entry);
     }
-}
-
-static void queueTextureLoad(ResourceLoader* pLoader, TextureLoadDescInternal* pTextureLoad, SyncToken* token)
-{
-    uint32_t nodeIndex = pTextureLoad->mNodeIndex;
-    acquireMutex(&pLoader->mQueueMutex);
-
-    SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
-
-    arrpush(pLoader->mRequestQueue[nodeIndex], UpdateRequest(*pTextureLoad));
-    UpdateRequest* pLastRequest = arrback(pLoader->mRequestQueue[nodeIndex]);
-    if (pLastRequest)
-        pLastRequest->mWaitIndex = t;
 
     releaseMutex(&pLoader->mQueueMutex);
     wakeOneConditionVariable(&pLoader->mQueueCond);
@@ -2341,73 +3436,56 @@ static void queueTextureLoad(ResourceLoader* pLoader, TextureLoadDescInternal* p
     }
 }
 
-static void queueGeometryLoad(ResourceLoader* pLoader, GeometryLoadDesc* pGeometryLoad, SyncToken* token)
+static void queueBufferLoad(ResourceLoader* pLoader, BufferLoadDescInternal* pBufferLoad, const ResourceLoadOptions* pOptions,
+                            SyncToken* token)
 {
-    uint32_t nodeIndex = pGeometryLoad->mNodeIndex;
-    acquireMutex(&pLoader->mQueueMutex);
-
-    SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
-
-    arrpush(pLoader->mRequestQueue[nodeIndex], UpdateRequest(*pGeometryLoad));
-    UpdateRequest* pLastRequest = arrback(pLoader->mRequestQueue[nodeIndex]);
-    if (pLastRequest)
-        pLastRequest->mWaitIndex = t;
-
-    releaseMutex(&pLoader->mQueueMutex);
-    wakeOneConditionVariable(&pLoader->mQueueCond);
-    if (token)
-        *token = max(t, *token);
-
-    if (pResourceLoader->mDesc.mSingleThreaded)
-    {
-        streamerThreadFunc(pResourceLoader);
-    }
+    UpdateRequest request(*pBufferLoad);
+    queueRequest(pLoader, pBufferLoad->pBuffer->mNodeIndex, pOptions, &request, token);
 }
 
-static void queueTextureBarrier(ResourceLoader* pLoader, Texture* pTexture, ResourceState state, SyncToken* token)
+static void queueTextureLoad(ResourceLoader* pLoader, TextureLoadDescInternal* pTextureLoad, const ResourceLoadOptions* pOptions,
+                             SyncToken* token)
 {
-    uint32_t nodeIndex = pTexture->mNodeIndex;
-    acquireMutex(&pLoader->mQueueMutex);
-
-    SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
-
-    arrpush(pLoader->mRequestQueue[nodeIndex], UpdateRequest(TextureBarrier{ pTexture, RESOURCE_STATE_UNDEFINED, state }));
-    UpdateRequest* pLastRequest = arrback(pLoader->mRequestQueue[nodeIndex]);
-    if (pLastRequest)
-        pLastRequest->mWaitIndex = t;
+    UpdateRequest request(*pTextureLoad);
+    request.pPrepareJob = queuePrepareJob(pLoader, &request, getLoadPriorityIndex(pOptions->mPriority));
+    queueRequest(pLoader, pTextureLoad->mNodeIndex, pOptions, &request, token);
+}
 
-    releaseMutex(&pLoader->mQueueMutex);
-    wakeOneConditionVariable(&pLoader->mQueueCond);
-    if (token)
-        *token = max(t, *token);
+static void queueGeometryLoad(ResourceLoader* pLoader, GeometryLoadDesc* pGeometryLoad, SyncToken* token)
+{
+    ResourceLoadOptions options = getLoadOptions(pGeometryLoad);
+    UpdateRequest       request(*pGeometryLoad);
+    request.pPrepareJob = queuePrepareJob(pLoader, &request, getLoadPriorityIndex(options.mPriority));
+    queueRequest(pLoader, pGeometryLoad->mNodeIndex, &options, &request, token);
+}
 
-    if (pResourceLoader->mDesc.mSingleThreaded)
-    {
-        streamerThreadFunc(pResourceLoader);
-    }
+static void queueTextureBarrier(ResourceLoader* pLoader, Texture* pTexture, ResourceState state, const ResourceLoadOptions* pOptions,
+                                SyncToken* token)
+{
+    UpdateRequest request(TextureBarrier{ pTexture, RESOURCE_STATE_UNDEFINED, state });
+    queueRequest(pLoader, pTexture->mNodeIndex, pOptions, &request, token);
 }
 
 static void queueTextureCopy(ResourceLoader* pLoader, TextureCopyDesc* pTextureCopy, SyncToken* token)
 {
     ASSERT(pTextureCopy->pTexture->mNodeIndex == pTextureCopy->pBuffer->mNodeIndex);
-    uint32_t nodeIndex = pTextureCopy->pTexture->mNodeIndex;
-    acquireMutex(&pLoader->mQueueMutex);
-
-    SyncToken t = tfrg_atomic64_add_relaxed(&pLoader->mTokenCounter, 1) + 1;
-
-    arrpush(pLoader->mRequestQueue[nodeIndex], UpdateRequest(*pTextureCopy));
-    UpdateRequest* pLastRequest = arrback(pLoader->mRequestQueue[nodeIndex]);
-    if (pLastRequest)
-        pLastRequest->mWaitIndex = t;
+    ResourceLoadOptions options = {};
+    UpdateRequest       request(*pTextureCopy);
+    queueRequest(pLoader, pTextureCopy->pTexture->mNodeIndex, &options, &request, token);
+}
 
+// Lifts the upload budget while a thread is blocked on a token, so that loads it waits for are not spread over frames
+static void setTokenWaiter(ResourceLoader* pLoader, bool waiting)
+{
+    acquireMutex(&pLoader->mQueueMutex);
+    if (waiting)
+        ++pLoader->mTokenWaiterCount;
+    else
+        --pLoader->mTokenWaiterCount;
     releaseMutex(&pLoader->mQueueMutex);
-    wakeOneConditionVariable(&pLoader->mQueueCond);
-    if (token)
-        *token = max(t, *token);
-
-    if (pResourceLoader->mDesc.mSingleThreaded)
+    if (waiting)
     {
-        streamerThreadFunc(pResourceLoader);
+        wakeOneConditionVariable(&pLoader->mQueueCond);
     }
 }
 
@@ -2417,12 +3495,14 @@ static void waitForToken(ResourceLoader* pLoader, const SyncToken* token)
     {
         return;
     }
+    setTokenWaiter(pLoader, true);
     acquireMutex(&pLoader->mTokenMutex);
     while (!isTokenCompleted(token))
     {
         waitConditionVariable(&pLoader->mTokenCond, &pLoader->mTokenMutex, TIMEOUT_INFINITE);
     }
     releaseMutex(&pLoader->mTokenMutex);
+    setTokenWaiter(pLoader, false);
 }
 
 static void waitForTokenSubmitted(ResourceLoader* pLoader, const SyncToken* token)
@@ -2431,12 +3511,14 @@ static void waitForTokenSubmitted(ResourceLoader* pLoader, const SyncToken* toke
     {
         return;
     }
+    setTokenWaiter(pLoader, true);
     acquireMutex(&pLoader->mTokenMutex);
     while (!isTokenSubmitted(token))
     {
         waitConditionVariable(&pLoader->mTokenCond, &pLoader->mTokenMutex, TIMEOUT_INFINITE);
     }
     releaseMutex(&pLoader->mTokenMutex);
+    setTokenWaiter(pLoader, false);
 }
 
 /************************************************************************/
@@ -2533,6 +3615,7 @@ void exitResourceLoaderInterface(Renderer* pRenderer)
 #endif
 
     exitResourceLoader(pResourceLoader);
+    pResourceLoader = NULL;
 
 #if defined(ENABLE_FORGE_RELOAD_SHADER)
     platformExitReloadClient();
@@ -2549,6 +3632,7 @@ void exitResourceLoaderInterface(Renderer** pRenderers, uint32_t rendererCount)
     UNREF_PARAM(pRenderers);
     UNREF_PARAM(rendererCount);
     exitResourceLoader(pResourceLoader);
+    pResourceLoader = NULL;
 }
 
 #ifdef ENABLE_FORGE_MATERIALS
@@ -2848,6 +3932,231 @@ static void parseMaterial(const char* pFileBuffer, uint64_t fileSize, Material**
     *pOut = pMaterial;
 }
 
+static bool materialBinarySectionValid(uint64_t fileSize, uint32_t offset, uint64_t count, uint64_t elementSize)
+{
+    return offset % 4 == 0 && offset <= fileSize && count * elementSize <= fileSize - offset;
+}
+
+static bool materialBinaryStringsValid(const uint32_t* pOffsets, uint32_t count, uint32_t stringsSize)
+{
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        if (pOffsets[i] >= stringsSize)
+            return false;
+    }
+    return true;
+}
+
+static void* materialTakeMemory(uint8_t** ppCursor, uint64_t size, uint64_t alignment)
+{
+    uint8_t* pMem = (uint8_t*)round_up_64((uint64_t)(uintptr_t)*ppCursor, alignment);
+    *ppCursor = pMem + size;
+    return pMem;
+}
+
+// Validates binary material and sets up MaterialDesc pointing to indexes and strings in pData, nothing is parsed or copied
+static bool parseMaterialBinary(const uint8_t* pData, uint64_t fileSize, const char* pFileName, Material** pOut)
+{
+    const MaterialBinaryHeader* pHeader = (const MaterialBinaryHeader*)pData;
+    if (fileSize < sizeof(MaterialBinaryHeader) || pHeader->mVersion != MATERIAL_BINARY_VERSION)
+    {
+        LOGF(eERROR, "Material '%s' has unsupported binary version", pFileName);
+        return false;
+    }
+
+    const MaterialBinaryHeader header = *pHeader;
+    if (!materialBinarySectionValid(fileSize, header.mShaderSetsOffset, header.mShaderSetCount, sizeof(MaterialBinaryShaderSet)) ||
+        !materialBinarySectionValid(fileSize, header.mTextureSetsOffset, header.mTextureSetCount, sizeof(MaterialBinaryTextureSet)) ||
+        !materialBinarySectionValid(fileSize, header.mMaterialSetsOffset, header.mMaterialSetCount, sizeof(MaterialBinaryMaterialSet)) ||
+        !materialBinarySectionValid(fileSize, header.mTextureIdxsOffset, header.mTextureIdxCount, sizeof(uint32_t)) ||
+        !materialBinarySectionValid(fileSize, header.mTextureIdsOffset, header.mTextureCount, sizeof(uint32_t)) ||
+        !materialBinarySectionValid(fileSize, header.mTextureNamesOffset, header.mTextureCount, sizeof(uint32_t)) ||
+        !materialBinarySectionValid(fileSize, header.mShaderNamesOffset, header.mShaderCount, sizeof(uint32_t)) ||
+        !materialBinarySectionValid(fileSize, header.mBindingNamesOffset, header.mBindingCount, sizeof(uint32_t)) ||
+        !materialBinarySectionValid(fileSize, header.mTextureFlagsOffset, header.mTextureCount, sizeof(uint8_t)) ||
+        !materialBinarySectionValid(fileSize, header.mStringsOffset, header.mStringsSize, sizeof(char)) ||
+        (header.mStringsSize && pData[header.mStringsOffset + header.mStringsSize - 1] != '\0'))
+    {
+        LOGF(eERROR, "Material '%s' is truncated or corrupted", pFileName);
+        return false;
+    }
+
+    const MaterialBinaryShaderSet*   pShaderSets = (const MaterialBinaryShaderSet*)(pData + header.mShaderSetsOffset);
+    const MaterialBinaryTextureSet*  pTextureSets = (const MaterialBinaryTextureSet*)(pData + header.mTextureSetsOffset);
+    const MaterialBinaryMaterialSet* pMaterialSets = (const MaterialBinaryMaterialSet*)(pData + header.mMaterialSetsOffset);
+    const uint32_t*                  pTextureIdxs = (const uint32_t*)(pData + header.mTextureIdxsOffset);
+    const uint32_t*                  pTextureNames = (const uint32_t*)(pData + header.mTextureNamesOffset);
+    const uint32_t*                  pShaderNames = (const uint32_t*)(pData + header.mShaderNamesOffset);
+    const uint32_t*                  pBindingNames = (const uint32_t*)(pData + header.mBindingNamesOffset);
+    const char*                      pStrings = (const char*)(pData + header.mStringsOffset);
+
+    // Indexes are used without checks at load time, so bad ones are rejected here
+    bool valid = materialBinaryStringsValid(pTextureNames, header.mTextureCount, header.mStringsSize) &&
+                 materialBinaryStringsValid(pShaderNames, header.mShaderCount, header.mStringsSize) &&
+                 materialBinaryStringsValid(pBindingNames, header.mBindingCount, header.mStringsSize);
+    for (uint32_t i = 0; valid && i < header.mShaderSetCount; ++i)
+    {
+        const MaterialBinaryShaderSet* pSet = &pShaderSets[i];
+        for (uint32_t stage = 0; stage < TF_ARRAY_COUNT(pSet->mShaderIdxs); ++stage)
+        {
+            valid &= pSet->mShaderIdxs[stage] == INVALID_MATERIAL_ID || pSet->mShaderIdxs[stage] < header.mShaderCount;
+        }
+        valid &= pSet->mBindingCount <= header.mMaxShaderSetBindings && pSet->mFirstBinding <= header.mBindingCount &&
+                 pSet->mBindingCount <= header.mBindingCount - pSet->mFirstBinding;
+    }
+    for (uint32_t i = 0; valid && i < header.mTextureSetCount; ++i)
+    {
+        const MaterialBinaryTextureSet* pSet = &pTextureSets[i];
+        valid &= pSet->mTextureCount <= header.mMaxTextureSetTextures && pSet->mFirstTextureIdx <= header.mTextureIdxCount &&
+                 pSet->mTextureCount <= header.mTextureIdxCount - pSet->mFirstTextureIdx;
+    }
+    for (uint32_t i = 0; valid && i < header.mTextureIdxCount; ++i)
+    {
+        valid &= pTextureIdxs[i] < header.mTextureCount;
+    }
+    // Texture indexes of material sets are allocated by the counts of their texture sets
+    uint64_t textureIndexCount = 0;
+    for (uint32_t i = 0; valid && i < header.mMaterialSetCount; ++i)
+    {
+        const MaterialBinaryMaterialSet* pSet = &pMaterialSets[i];
+        valid &= pSet->mNameOffset < header.mStringsSize && pSet->mShaderSetIdx < header.mShaderSetCount &&
+                 pSet->mTextureSetIdx < header.mTextureSetCount;
+        textureIndexCount += valid ? pTextureSets[pSet->mTextureSetIdx].mTextureCount : 0;
+    }
+    // Maximums are not backed by any section, so they are only trusted up to the tables they describe
+    valid &= header.mMaxShaderSetBindings <= MATERIAL_BINARY_MAX_SET_ENTRIES && header.mMaxShaderSetBindings <= header.mBindingCount &&
+             header.mMaxTextureSetTextures <= MATERIAL_BINARY_MAX_SET_ENTRIES &&
+             header.mMaxTextureSetTextures <= header.mTextureIdxCount;
+    if (!valid)
+    {
+        LOGF(eERROR, "Material '%s' has invalid indexes", pFileName);
+        return false;
+    }
+
+    // Counts are bounded by the file size and set sizes by MATERIAL_BINARY_MAX_SET_ENTRIES, 64 bit sums can't overflow
+    const uint32_t numMaterialSets = header.mMaterialSetCount;
+    const uint64_t nameCount = (uint64_t)numMaterialSets + header.mTextureCount + header.mShaderCount + header.mBindingCount;
+
+    uint64_t totalSize = sizeof(Material);
+    totalSize += sizeof(Material::LoadedMaterial) * numMaterialSets + alignof(Material::LoadedMaterial); // Material::pLoaded
+    totalSize += sizeof(uint32_t) * textureIndexCount + alignof(uint32_t);                                  // pTextureIndexes
+    totalSize += sizeof(MaterialDesc) + alignof(MaterialDesc);
+    totalSize += sizeof(MaterialDesc::ShaderSet) * header.mShaderSetCount + alignof(MaterialDesc::ShaderSet);
+    totalSize += sizeof(MaterialDesc::TextureSet) * header.mTextureSetCount + alignof(MaterialDesc::TextureSet);
+    totalSize += sizeof(MaterialDesc::MaterialSet) * numMaterialSets + alignof(MaterialDesc::MaterialSet);
+    totalSize += sizeof(const char*) * nameCount + alignof(const char*); // Set, texture, shader and binding names
+
+    Material* pMaterial = totalSize <= SIZE_MAX ? (Material*)tf_calloc(1, (size_t)totalSize) : NULL;
+    if (!pMaterial)
+    {
+        LOGF(eERROR, "Failed to allocate %llu bytes for material '%s'", (unsigned long long)totalSize, pFileName);
+        return false;
+    }
+
+    uint8_t* pCursor = (uint8_t*)(pMaterial + 1);
+    pMaterial->pLoaded = (Material::LoadedMaterial*)materialTakeMemory(&pCursor, sizeof(Material::LoadedMaterial) * numMaterialSets,
+                                                                        alignof(Material::LoadedMaterial));
+    uint32_t* pTextureIndexes = (uint32_t*)materialTakeMemory(&pCursor, sizeof(uint32_t) * textureIndexCount, alignof(uint32_t));
+    for (uint32_t i = 0; i < numMaterialSets; ++i)
+    {
+        pMaterial->pLoaded[i].pTextureIndexes = pTextureIndexes;
+        pTextureIndexes += pTextureSets[pMaterialSets[i].mTextureSetIdx].mTextureCount;
+    }
+
+    MaterialDesc* pMaterialDesc = (MaterialDesc*)materialTakeMemory(&pCursor, sizeof(MaterialDesc), alignof(MaterialDesc));
+    pMaterial->pDesc = pMaterialDesc;
+    pMaterialDesc->pShaderSets = (MaterialDesc::ShaderSet*)materialTakeMemory(
+        &pCursor, sizeof(MaterialDesc::ShaderSet) * header.mShaderSetCount, alignof(MaterialDesc::ShaderSet));
+    pMaterialDesc->pTextureSets = (MaterialDesc::TextureSet*)materialTakeMemory(
+        &pCursor, sizeof(MaterialDesc::TextureSet) * header.mTextureSetCount, alignof(MaterialDesc::TextureSet));
+    pMaterialDesc->pMaterialSets = (MaterialDesc::MaterialSet*)materialTakeMemory(
+        &pCursor, sizeof(MaterialDesc::MaterialSet) * numMaterialSets, alignof(MaterialDesc::MaterialSet));
+    const char** ppNames = (const char**)materialTakeMemory(&pCursor, sizeof(const char*) * nameCount, alignof(const char*));
+    ASSERT(pCursor <= (uint8_t*)pMaterial + totalSize);
+
+    pMaterialDesc->mShaderSetCount = header.mShaderSetCount;
+    pMaterialDesc->mTextureSetCount = header.mTextureSetCount;
+    pMaterialDesc->mMaterialCount = numMaterialSets;
+    pMaterialDesc->mTextureCount = header.mTextureCount;
+    pMaterialDesc->mShaderCount = header.mShaderCount;
+    pMaterialDesc->mMaxShaderSetBindings = header.mMaxShaderSetBindings;
+    pMaterialDesc->mMaxTextureSetTextures = header.mMaxTextureSetTextures;
+    // Indexes and flags are used in place
+    pMaterialDesc->pTextureIds = (uint32_t*)(pData + header.mTextureIdsOffset);
+    pMaterialDesc->pTextureFlags = (uint8_t*)(pData + header.mTextureFlagsOffset);
+
+    pMaterialDesc->pMaterialSetNames = ppNames;
+    pMaterialDesc->pTextureNames = pMaterialDesc->pMaterialSetNames + numMaterialSets;
+    pMaterialDesc->pShaderNames = pMaterialDesc->pTextureNames + header.mTextureCount;
+    const char** ppBindingNames = pMaterialDesc->pShaderNames + header.mShaderCount;
+    for (uint32_t i = 0; i < header.mTextureCount; ++i)
+    {
+        pMaterialDesc->pTextureNames[i] = pStrings + pTextureNames[i];
+    }
+    for (uint32_t i = 0; i < header.mShaderCount; ++i)
+    {
+        pMaterialDesc->pShaderNames[i] = pStrings + pShaderNames[i];
+    }
+    for (uint32_t i = 0; i < header.mBindingCount; ++i)
+    {
+        ppBindingNames[i] = pStrings + pBindingNames[i];
+    }
+
+    for (uint32_t i = 0; i < header.mShaderSetCount; ++i)
+    {
+        MaterialDesc::ShaderSet* pShaderSet = &pMaterialDesc->pShaderSets[i];
+        pShaderSet->mId = pShaderSets[i].mId;
+        pShaderSet->mVertIdx = pShaderSets[i].mShaderIdxs[0];
+        pShaderSet->mFragIdx = pShaderSets[i].mShaderIdxs[1];
+        pShaderSet->mHullIdx = pShaderSets[i].mShaderIdxs[2];
+        pShaderSet->mDomainIdx = pShaderSets[i].mShaderIdxs[3];
+        pShaderSet->mGeomIdx = pShaderSets[i].mShaderIdxs[4];
+        pShaderSet->mCompIdx = pShaderSets[i].mShaderIdxs[5];
+        pShaderSet->mTextureBindingCount = pShaderSets[i].mBindingCount;
+        pShaderSet->pTextureBindingNames = ppBindingNames + pShaderSets[i].mFirstBinding;
+    }
+    for (uint32_t i = 0; i < header.mTextureSetCount; ++i)
+    {
+        pMaterialDesc->pTextureSets[i].mTextureCount = pTextureSets[i].mTextureCount;
+        pMaterialDesc->pTextureSets[i].pTextureIdxs = (uint32_t*)(pTextureIdxs + pTextureSets[i].mFirstTextureIdx);
+    }
+    for (uint32_t i = 0; i < numMaterialSets; ++i)
+    {
+        pMaterialDesc->pMaterialSetNames[i] = pStrings + pMaterialSets[i].mNameOffset;
+        pMaterialDesc->pMaterialSets[i].mShaderSetIdx = pMaterialSets[i].mShaderSetIdx;
+        pMaterialDesc->pMaterialSets[i].mTextureSetIdx = pMaterialSets[i].mTextureSetIdx;
+    }
+
+    *pOut = pMaterial;
+    return true;
+}
+
+// Reads binary material file, the stream is closed before returning so loaded materials don't hold file handles
+static bool loadMaterialBinary(FileStream* pStream, const char* pFileName, Material** pOut)
+{
+    const ssize_t fileSize = fsGetStreamFileSize(pStream);
+    void*         pFileData = fileSize > 0 ? tf_malloc((size_t)fileSize) : NULL;
+
+    const bool read = pFileData && fsSeekStream(pStream, SBO_START_OF_FILE, 0) &&
+                      fsReadFromStream(pStream, pFileData, (size_t)fileSize) == (size_t)fileSize;
+    fsCloseStream(pStream);
+    if (!read)
+    {
+        LOGF(eERROR, "Failed to read material '%s'", pFileName);
+        tf_free(pFileData);
+        return false;
+    }
+
+    if (!parseMaterialBinary((const uint8_t*)pFileData, (uint64_t)fileSize, pFileName, pOut))
+    {
+        tf_free(pFileData);
+        return false;
+    }
+
+    (*pOut)->pFileData = pFileData;
+    return true;
+}
+
 uint32_t addMaterial(const char* pMaterialFileName, Material** pOutMaterial, SyncToken* pSyncToken)
 {
     MaterialLibrary* pLib = pMaterialLibrary;
@@ -2858,8 +4167,23 @@ uint32_t addMaterial(const char* pMaterialFileName, Material** pOutMaterial, Syn
     char*      materialFileBuffer = NULL;
     uint64_t   fileSize = 0;
     FileStream stream = {};
+    Material*  pMaterial = nullptr;
+
+    if (!fsOpenStreamFromPath(RD_COMPILED_MATERIALS, pMaterialFileName, FM_READ, &stream))
+    {
+        return REGISTER_MATERIAL_BADFILE;
+    }
 
-    if (fsOpenStreamFromPath(RD_COMPILED_MATERIALS, pMaterialFileName, FM_READ, &stream))
+    // Shipping builds use binary materials, text ones are still loaded for development
+    char magic[4] = {};
+    if (fsReadFromStream(&stream, magic, sizeof(magic)) == sizeof(magic) && memcmp(magic, MATERIAL_BINARY_MAGIC, sizeof(magic)) == 0)
+    {
+        if (!loadMaterialBinary(&stream, pMaterialFileName, &pMaterial))
+        {
+            return REGISTER_MATERIAL_BADFILE;
+        }
+    }
+    else if (fsSeekStream(&stream, SBO_START_OF_FILE, 0))
     {
         fileSize = fsGetStreamFileSize(&stream);
 
@@ -2873,20 +4197,20 @@ uint32_t addMaterial(const char* pMaterialFileName, Material** pOutMaterial, Syn
         materialFileBuffer[readSize] = '\0';
 
         fsCloseStream(&stream);
+
+        parseMaterial(materialFileBuffer, fileSize, &pMaterial);
+
+        if (materialFileBuffer != materialFileStackBuffer)
+            tf_free(materialFileBuffer);
+
+        materialFileBuffer = nullptr;
     }
     else
     {
+        fsCloseStream(&stream);
         return REGISTER_MATERIAL_BADFILE;
     }
 
-    Material* pMaterial = nullptr;
-    parseMaterial(materialFileBuffer, fileSize, &pMaterial);
-
-    if (materialFileBuffer != materialFileStackBuffer)
-        tf_free(materialFileBuffer);
-
-    materialFileBuffer = nullptr;
-
     ASSERT(pMaterial && pMaterial->pDesc);
     MaterialDesc* pMaterialDesc = pMaterial->pDesc;
 
@@ -2959,7 +4283,7 @@ uint32_t addMaterial(const char* pMaterialFileName, Material** pOutMaterial, Syn
                 TextureLoadDesc desc = {};
                 desc.pFileName = pMaterialDesc->pTextureNames[pTextureSet->pTextureIdxs[j]];
                 desc.ppTexture = &pLib->ppMaterialTextures[textureIndex];
-                if (pMaterialDesc->pTextureFlags[j] & MaterialDesc::TextureFlags::SRGB)
+                if (pMaterialDesc->pTextureFlags[pTextureSet->pTextureIdxs[j]] & MaterialDesc::TextureFlags::SRGB)
                     desc.mCreationFlag |= TEXTURE_CREATION_FLAG_SRGB;
                 addResource(&desc, &token);
 #ifdef TARGET_IOS
@@ -3048,6 +4372,7 @@ void removeMaterial(Material* pMaterial)
     }
 
     --pLib->mLoadedMaterialCount;
+    tf_free(pMaterial->pFileData);
     tf_free(pMaterial);
 }
 
@@ -3149,7 +4474,8 @@ void addResource(BufferLoadDesc* pBufferDesc, SyncToken* token)
         pBufferDesc->mDesc.mStartState = startState;
     }
 
-    const uint64_t bufferSize = pBufferDesc->mDesc.mSize;
+    const uint64_t            bufferSize = pBufferDesc->mDesc.mSize;
+    const ResourceLoadOptions options = getLoadOptions(pBufferDesc);
     addBuffer(pRenderer, &pBufferDesc->mDesc, pBufferDesc->ppBuffer);
 
     if (update)
@@ -3171,7 +4497,11 @@ void addResource(BufferLoadDesc* pBufferDesc, SyncToken* token)
             loadDesc.pSrcBuffer = loadDesc.pBuffer;
             loadDesc.mSrcOffset = 0;
         }
-        queueBufferLoad(pResourceLoader, &loadDesc, token);
+        queueBufferLoad(pResourceLoader, &loadDesc, &options, token);
+    }
+    else
+    {
+        completeLoadWithoutRequest(pResourceLoader, &options);
     }
 }
 
@@ -3184,6 +4514,8 @@ void addResource(TextureLoadDesc* pTextureDesc, SyncToken* token)
         *token = max<uint64_t>(0, *token);
     }
 
+    const ResourceLoadOptions options = getLoadOptions(pTextureDesc);
+
     if (!pTextureDesc->pFileName && pTextureDesc->pDesc)
     {
         ASSERT(pTextureDesc->pDesc->mStartState);
@@ -3220,12 +4552,13 @@ void addResource(TextureLoadDesc* pTextureDesc, SyncToken* token)
 #error : Not implemented
 #endif
             memset(ptr, 0, size);
+            completeLoadWithoutRequest(pResourceLoader, &options);
 #else
             TextureLoadDescInternal loadDesc = {};
             loadDesc.ppTexture = pTextureDesc->ppTexture;
             loadDesc.mForceReset = true;
             loadDesc.mStartState = pTextureDesc->pDesc->mStartState;
-            queueTextureLoad(pResourceLoader, &loadDesc, token);
+            queueTextureLoad(pResourceLoader, &loadDesc, &options, token);
 #endif
             return;
         }
@@ -3238,7 +4571,11 @@ void addResource(TextureLoadDesc* pTextureDesc, SyncToken* token)
             {
                 startState = ResourceStartState(pTextureDesc->pDesc->mDescriptors & DESCRIPTOR_TYPE_RW_TEXTURE);
             }
-            queueTextureBarrier(pResourceLoader, *pTextureDesc->ppTexture, startState, token);
+            queueTextureBarrier(pResourceLoader, *pTextureDesc->ppTexture, startState, &options, token);
+        }
+        else
+        {
+            completeLoadWithoutRequest(pResourceLoader, &options);
         }
     }
     else
@@ -3250,7 +4587,7 @@ void addResource(TextureLoadDesc* pTextureDesc, SyncToken* token)
         loadDesc.mNodeIndex = pTextureDesc->mNodeIndex;
         loadDesc.pFileName = pTextureDesc->pFileName;
         loadDesc.pYcbcrSampler = pTextureDesc->pYcbcrSampler;
-        queueTextureLoad(pResourceLoader, &loadDesc, token);
+        queueTextureLoad(pResourceLoader, &loadDesc, &options, token);
     }
 }
 
@@ -3299,7 +4636,7 @@ void removeResource(Geometry* pGeom)
         }
     }
 
-    tf_free(pGeom->meshlets.mMeshlets);
+    // Meshlets are part of the Geometry allocation
     tf_free(pGeom);
 }
 
@@ -3324,83 +4661,356 @@ typedef struct BufferChunkAllocatorDesc
     Buffer* pBuffer;
 } BufferChunkAllocatorDesc;
 
-static void addBufferChunkAllocator(BufferChunkAllocatorDesc* pDesc, BufferChunkAllocator* pOut)
+// Two level segregated fit: first level is the power of two of the chunk size, second level splits it in BUFFER_CHUNK_SL_COUNT ranges
+#define BUFFER_CHUNK_SL_BITS  4U
+#define BUFFER_CHUNK_SL_COUNT (1U << BUFFER_CHUNK_SL_BITS)
+#define BUFFER_CHUNK_FL_COUNT (32U - BUFFER_CHUNK_SL_BITS + 1U)
+#define BUFFER_CHUNK_NONE     UINT32_MAX
+
+typedef struct BufferChunkUsedEntry
 {
-    ASSERT(pDesc);
-    ASSERT(pOut);
+    uint32_t key;
+    uint32_t value;
+} BufferChunkUsedEntry;
 
-    pOut->pBuffer = pDesc->pBuffer;
-    pOut->mSize = (uint32_t)pDesc->pBuffer->mSize;
+struct BufferChunkAllocatorInternal
+{
+    uint32_t mFirstLevelBitmap;
+    uint32_t mSecondLevelBitmaps[BUFFER_CHUNK_FL_COUNT];
+    uint32_t mFreeLists[BUFFER_CHUNK_FL_COUNT][BUFFER_CHUNK_SL_COUNT];
+    // stb_ds hash map from offsets of used chunks to their nodes
+    BufferChunkUsedEntry* pUsedNodes;
+};
 
-    BufferChunk firstUnusedChunk{ 0, (uint32_t)pDesc->pBuffer->mSize };
-    arrpush(pOut->mUnusedChunks, firstUnusedChunk);
+static uint32_t bitScanReverse(uint32_t value)
+{
+    ASSERT(value);
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index = 0;
+    _BitScanReverse(&index, value);
+    return (uint32_t)index;
+#else
+    return 31U - (uint32_t)__builtin_clz(value);
+#endif
 }
 
-static void removeBufferChunkAllocator(BufferChunkAllocator* pBuffer)
+static uint32_t bitScanForward(uint32_t value)
 {
-    ASSERT(pBuffer);
-    ASSERT(pBuffer->mUsedChunkCount == 0 && "Expecting all parts to be released at this point");
+    ASSERT(value);
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index = 0;
+    _BitScanForward(&index, value);
+    return (uint32_t)index;
+#else
+    return (uint32_t)__builtin_ctz(value);
+#endif
+}
 
-    if (pBuffer->pBuffer)
+static void getChunkSizeClass(uint32_t size, uint32_t* pFirstLevel, uint32_t* pSecondLevel)
+{
+    if (size < BUFFER_CHUNK_SL_COUNT)
     {
-        ASSERT(arrlen(pBuffer->mUnusedChunks) == 1 && "Expecting just one chunk since the buffer is completely empty");
+        *pFirstLevel = 0;
+        *pSecondLevel = size;
+        return;
+    }
 
-        // We are checking that the unnused chunk offset is 0 because we currently assume that a BufferChunkAllocator covers the entire
-        // buffer, but we could change this to allow to have several BufferChunkAllocators over the same buffer, each working on a fixed
-        // memory range of the buffer.
-        //
-        // For example: In buffer below we could do the following splits
-        // Buffer: [------------------------------------------------------]
-        // Splits: [------------------A-------------------|--------B------]
-        //
-        // One BufferChunkAllocator would cover memory range A and would be use by the App to store big chunks of data while other
-        // BufferChunkAllocator would cover memory range B and be used to fit smaller ammounts of data.
-        //
-        // Note: If we want this behavior we would need extend BufferChunkAllocatorDesc to provide mOffset and mSize that the
-        // BufferChunkAllocator would cover,
-        //       if mSize is 0 we would use the size of the buffer.
-        //       We would also need to consider if we want to expose the add/removeBufferChunkAllocator interface to the user and let him
-        //       allocate the BufferChunkAllocator or we want to include this splitting logic in addGeometryBuffer.
-        ASSERT(pBuffer->mUnusedChunks && (pBuffer->mUnusedChunks[0].mOffset == 0) && (pBuffer->mUnusedChunks[0].mSize == pBuffer->mSize) &&
-               "Expecting just one chunk since the buffer is completely empty");
+    const uint32_t log2 = bitScanReverse(size);
+    *pFirstLevel = log2 - BUFFER_CHUNK_SL_BITS + 1;
+    *pSecondLevel = (size >> (log2 - BUFFER_CHUNK_SL_BITS)) ^ BUFFER_CHUNK_SL_COUNT;
+}
+
+static uint32_t addChunkNode(BufferChunkAllocator* pAllocator, uint32_t offset, uint32_t size)
+{
+    BufferChunkNode node = { { offset, size }, BUFFER_CHUNK_NONE, BUFFER_CHUNK_NONE, BUFFER_CHUNK_NONE, BUFFER_CHUNK_NONE, false };
 
-        arrfree(pBuffer->mUnusedChunks);
+    uint32_t index = pAllocator->mFirstUnusedNode;
+    if (index != BUFFER_CHUNK_NONE)
+    {
+        pAllocator->mFirstUnusedNode = pAllocator->pNodes[index].mNextFree;
+        pAllocator->pNodes[index] = node;
     }
+    else
+    {
+        index = (uint32_t)arrlenu(pAllocator->pNodes);
+        arrpush(pAllocator->pNodes, node);
+    }
+    return index;
 }
 
-void addGeometryBuffer(GeometryBufferLoadDesc* pDesc)
+static void removeChunkNode(BufferChunkAllocator* pAllocator, uint32_t index)
 {
-    DescriptorType flags = DESCRIPTOR_TYPE_BUFFER_RAW | DESCRIPTOR_TYPE_RW_BUFFER_RAW;
+    BufferChunkNode* pNode = &pAllocator->pNodes[index];
+    if (pNode->mPrev != BUFFER_CHUNK_NONE)
+        pAllocator->pNodes[pNode->mPrev].mNext = pNode->mNext;
+    else
+        pAllocator->mFirstNode = pNode->mNext;
+    if (pNode->mNext != BUFFER_CHUNK_NONE)
+        pAllocator->pNodes[pNode->mNext].mPrev = pNode->mPrev;
 
-    GeometryBuffer* pBuffer = (GeometryBuffer*)tf_calloc(1, sizeof *pBuffer);
+    pNode->mNextFree = pAllocator->mFirstUnusedNode;
+    pAllocator->mFirstUnusedNode = index;
+}
 
-    if (!VERIFYMSG(pBuffer, "Couldn't allocate GeometryBuffer"))
+// Splits node so that it keeps size bytes, returns node with the rest, which follows it in the buffer
+static uint32_t splitChunkNode(BufferChunkAllocator* pAllocator, uint32_t index, uint32_t size)
+{
+    const BufferChunk chunk = pAllocator->pNodes[index].mChunk;
+    ASSERT(size < chunk.mSize);
+
+    const uint32_t restIndex = addChunkNode(pAllocator, chunk.mOffset + size, chunk.mSize - size);
+    BufferChunkNode* pNode = &pAllocator->pNodes[index];
+    BufferChunkNode* pRest = &pAllocator->pNodes[restIndex];
+    pNode->mChunk.mSize = size;
+    pRest->mPrev = index;
+    pRest->mNext = pNode->mNext;
+    if (pNode->mNext != BUFFER_CHUNK_NONE)
+        pAllocator->pNodes[pNode->mNext].mPrev = restIndex;
+    pNode->mNext = restIndex;
+    return restIndex;
+}
+
+static void insertFreeChunk(BufferChunkAllocator* pAllocator, uint32_t index)
+{
+    BufferChunkAllocatorInternal* pInternal = pAllocator->pInternal;
+    BufferChunkNode*              pNode = &pAllocator->pNodes[index];
+
+    uint32_t fl = 0;
+    uint32_t sl = 0;
+    getChunkSizeClass(pNode->mChunk.mSize, &fl, &sl);
+
+    const uint32_t head = pInternal->mFreeLists[fl][sl];
+    pNode->mFree = true;
+    pNode->mPrevFree = BUFFER_CHUNK_NONE;
+    pNode->mNextFree = head;
+    if (head != BUFFER_CHUNK_NONE)
+        pAllocator->pNodes[head].mPrevFree = index;
+    pInternal->mFreeLists[fl][sl] = index;
+    pInternal->mFirstLevelBitmap |= 1U << fl;
+    pInternal->mSecondLevelBitmaps[fl] |= 1U << sl;
+
+    ++pAllocator->mFreeChunkCount;
+    pAllocator->mFreeSize += pNode->mChunk.mSize;
+}
+
+static void removeFreeChunk(BufferChunkAllocator* pAllocator, uint32_t index)
+{
+    BufferChunkAllocatorInternal* pInternal = pAllocator->pInternal;
+    BufferChunkNode*              pNode = &pAllocator->pNodes[index];
+    ASSERT(pNode->mFree);
+
+    uint32_t fl = 0;
+    uint32_t sl = 0;
+    getChunkSizeClass(pNode->mChunk.mSize, &fl, &sl);
+
+    if (pNode->mPrevFree != BUFFER_CHUNK_NONE)
+        pAllocator->pNodes[pNode->mPrevFree].mNextFree = pNode->mNextFree;
+    else
+        pInternal->mFreeLists[fl][sl] = pNode->mNextFree;
+    if (pNode->mNextFree != BUFFER_CHUNK_NONE)
+        pAllocator->pNodes[pNode->mNextFree].mPrevFree = pNode->mPrevFree;
+
+    if (pInternal->mFreeLists[fl][sl] == BUFFER_CHUNK_NONE)
     {
-        return;
+        pInternal->mSecondLevelBitmaps[fl] &= ~(1U << sl);
+        if (!pInternal->mSecondLevelBitmaps[fl])
+            pInternal->mFirstLevelBitmap &= ~(1U << fl);
     }
 
-    *pDesc->pOutGeometryBuffer = pBuffer;
+    pNode->mFree = false;
+    --pAllocator->mFreeChunkCount;
+    pAllocator->mFreeSize -= pNode->mChunk.mSize;
+}
 
-    BufferLoadDesc loadDesc = {};
+// Size classes from fl/sl up
+static uint32_t findFreeChunkClass(const BufferChunkAllocatorInternal* pInternal, uint32_t fl, uint32_t sl)
+{
+    uint32_t slBitmap = sl < BUFFER_CHUNK_SL_COUNT ? pInternal->mSecondLevelBitmaps[fl] & (~0U << sl) : 0;
+    if (!slBitmap)
+    {
+        const uint32_t flBitmap = fl + 1 < 32 ? pInternal->mFirstLevelBitmap & (~0U << (fl + 1)) : 0;
+        if (!flBitmap)
+            return BUFFER_CHUNK_NONE;
+        fl = bitScanForward(flBitmap);
+        slBitmap = pInternal->mSecondLevelBitmaps[fl];
+    }
+    return pInternal->mFreeLists[fl][bitScanForward(slBitmap)];
+}
 
-    Buffer* pIndexBuffer = NULL;
-    Buffer* pVertexBuffer = NULL;
+static uint32_t getChunkAlignmentPadding(uint32_t offset, uint32_t alignment)
+{
+    const uint32_t padding = alignment > 1 ? offset % alignment : 0;
+    return padding ? alignment - padding : 0;
+}
 
-    loadDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_GPU_ONLY;
-    loadDesc.mDesc.mSize = pDesc->mIndicesSize;
-    loadDesc.ppBuffer = &pIndexBuffer;
-    loadDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_INDEX_BUFFER | flags;
-    loadDesc.mDesc.mStructStride = sizeof(uint32_t);
-    loadDesc.mDesc.mElementCount = (uint32_t)(loadDesc.mDesc.mSize / loadDesc.mDesc.mStructStride);
-    loadDesc.mDesc.mStartState = gUma ? gIndexBufferState : pDesc->mStartState;
-    loadDesc.mDesc.pName = pDesc->pNameIndexBuffer ? pDesc->pNameIndexBuffer : "GeometryBuffer Indices (unnamed)";
-    loadDesc.mDesc.pPlacement = pDesc->pIndicesPlacement;
-    addResource(&loadDesc, nullptr);
+static bool chunkFits(const BufferChunk* pChunk, uint32_t size, uint32_t alignment)
+{
+    const uint32_t padding = getChunkAlignmentPadding(pChunk->mOffset, alignment);
+    return pChunk->mSize >= padding && pChunk->mSize - padding >= size;
+}
 
-    BufferChunkAllocatorDesc allocDesc = { pIndexBuffer };
-    addBufferChunkAllocator(&allocDesc, &pBuffer->mIndex);
+static uint32_t findFreeChunk(const BufferChunkAllocator* pAllocator, uint32_t size, uint32_t alignment)
+{
+    const BufferChunkAllocatorInternal* pInternal = pAllocator->pInternal;
 
-    for (size_t i = 0; i < TF_ARRAY_COUNT(pDesc->mVerticesSizes); ++i)
+    // Any chunk of the class above the worst case size fits without looking at it
+    uint64_t searchSize = (uint64_t)size + (alignment > 1 ? alignment - 1 : 0);
+    if (searchSize >= BUFFER_CHUNK_SL_COUNT)
+    {
+        searchSize += (1ULL << (bitScanReverse((uint32_t)min<uint64_t>(searchSize, UINT32_MAX)) - BUFFER_CHUNK_SL_BITS)) - 1;
+    }
+
+    uint32_t fl = 0;
+    uint32_t sl = 0;
+    if (searchSize <= UINT32_MAX)
+    {
+        getChunkSizeClass((uint32_t)searchSize, &fl, &sl);
+        const uint32_t index = findFreeChunkClass(pInternal, fl, sl);
+        if (index != BUFFER_CHUNK_NONE)
+            return index;
+    }
+
+    // Nearly full buffer, chunks of the class of the requested size may still fit
+    getChunkSizeClass(size, &fl, &sl);
+    for (uint32_t index = pInternal->mFreeLists[fl][sl]; index != BUFFER_CHUNK_NONE; index = pAllocator->pNodes[index].mNextFree)
+    {
+        if (chunkFits(&pAllocator->pNodes[index].mChunk, size, alignment))
+            return index;
+    }
+
+    // Larger classes whose first chunk did not fit because of alignment padding
+    for (uint32_t index = findFreeChunkClass(pInternal, fl, sl + 1); index != BUFFER_CHUNK_NONE;)
+    {
+        const BufferChunkNode* pNode = &pAllocator->pNodes[index];
+        if (chunkFits(&pNode->mChunk, size, alignment))
+            return index;
+        if (pNode->mNextFree != BUFFER_CHUNK_NONE)
+        {
+            index = pNode->mNextFree;
+            continue;
+        }
+        getChunkSizeClass(pNode->mChunk.mSize, &fl, &sl);
+        index = findFreeChunkClass(pInternal, fl, sl + 1);
+    }
+
+    return BUFFER_CHUNK_NONE;
+}
+
+// Takes range of free chunk at index as used, what is left before and after it stays free
+static void allocateChunkRange(BufferChunkAllocator* pAllocator, uint32_t index, uint32_t offset, uint32_t size)
+{
+    removeFreeChunk(pAllocator, index);
+
+    const BufferChunk chunk = pAllocator->pNodes[index].mChunk;
+    ASSERT(chunk.mOffset <= offset && offset + size <= chunk.mOffset + chunk.mSize);
+    if (offset > chunk.mOffset)
+    {
+        const uint32_t usedIndex = splitChunkNode(pAllocator, index, offset - chunk.mOffset);
+        insertFreeChunk(pAllocator, index);
+        index = usedIndex;
+    }
+    if (size < pAllocator->pNodes[index].mChunk.mSize)
+    {
+        const uint32_t restIndex = splitChunkNode(pAllocator, index, size);
+        insertFreeChunk(pAllocator, restIndex);
+    }
+
+    hmput(pAllocator->pInternal->pUsedNodes, offset, index);
+    ++pAllocator->mUsedChunkCount;
+}
+
+static void initBufferChunkAllocator(BufferChunkAllocator* pAllocator, uint32_t size)
+{
+    pAllocator->mSize = size;
+    pAllocator->mFirstNode = BUFFER_CHUNK_NONE;
+    pAllocator->mFirstUnusedNode = BUFFER_CHUNK_NONE;
+    pAllocator->pInternal = (BufferChunkAllocatorInternal*)tf_calloc(1, sizeof(BufferChunkAllocatorInternal));
+    memset(pAllocator->pInternal->mFreeLists, 0xFF, sizeof(pAllocator->pInternal->mFreeLists));
+
+    pAllocator->mFirstNode = addChunkNode(pAllocator, 0, size);
+    insertFreeChunk(pAllocator, pAllocator->mFirstNode);
+}
+
+static void exitBufferChunkAllocator(BufferChunkAllocator* pAllocator)
+{
+    hmfree(pAllocator->pInternal->pUsedNodes);
+    tf_free(pAllocator->pInternal);
+    arrfree(pAllocator->pNodes);
+    pAllocator->pInternal = NULL;
+}
+
+static void addBufferChunkAllocator(BufferChunkAllocatorDesc* pDesc, BufferChunkAllocator* pOut)
+{
+    ASSERT(pDesc);
+    ASSERT(pOut);
+
+    pOut->pBuffer = pDesc->pBuffer;
+    initBufferChunkAllocator(pOut, (uint32_t)pDesc->pBuffer->mSize);
+}
+
+static void removeBufferChunkAllocator(BufferChunkAllocator* pBuffer)
+{
+    ASSERT(pBuffer);
+    ASSERT(pBuffer->mUsedChunkCount == 0 && "Expecting all parts to be released at this point");
+
+    if (pBuffer->pBuffer)
+    {
+        // We are checking that the unnused chunk offset is 0 because we currently assume that a BufferChunkAllocator covers the entire
+        // buffer, but we could change this to allow to have several BufferChunkAllocators over the same buffer, each working on a fixed
+        // memory range of the buffer.
+        //
+        // For example: In buffer below we could do the following splits
+        // Buffer: [------------------------------------------------------]
+        // Splits: [------------------A-------------------|--------B------]
+        //
+        // One BufferChunkAllocator would cover memory range A and would be use by the App to store big chunks of data while other
+        // BufferChunkAllocator would cover memory range B and be used to fit smaller ammounts of data.
+        //
+        // Note: If we want this behavior we would need extend BufferChunkAllocatorDesc to provide mOffset and mSize that the
+        // BufferChunkAllocator would cover,
+        //       if mSize is 0 we would use the size of the buffer.
+        //       We would also need to consider if we want to expose the add/removeBufferChunkAllocator interface to the user and let him
+        //       allocate the BufferChunkAllocator or we want to include this splitting logic in addGeometryBuffer.
+        ASSERT(pBuffer->mFreeChunkCount == 1 && pBuffer->mFreeSize == pBuffer->mSize &&
+               "Expecting just one chunk since the buffer is completely empty");
+
+        exitBufferChunkAllocator(pBuffer);
+    }
+}
+
+void addGeometryBuffer(GeometryBufferLoadDesc* pDesc)
+{
+    DescriptorType flags = DESCRIPTOR_TYPE_BUFFER_RAW | DESCRIPTOR_TYPE_RW_BUFFER_RAW;
+
+    GeometryBuffer* pBuffer = (GeometryBuffer*)tf_calloc(1, sizeof *pBuffer);
+
+    if (!VERIFYMSG(pBuffer, "Couldn't allocate GeometryBuffer"))
+    {
+        return;
+    }
+
+    *pDesc->pOutGeometryBuffer = pBuffer;
+
+    BufferLoadDesc loadDesc = {};
+
+    Buffer* pIndexBuffer = NULL;
+    Buffer* pVertexBuffer = NULL;
+
+    loadDesc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_GPU_ONLY;
+    loadDesc.mDesc.mSize = pDesc->mIndicesSize;
+    loadDesc.ppBuffer = &pIndexBuffer;
+    loadDesc.mDesc.mDescriptors = DESCRIPTOR_TYPE_INDEX_BUFFER | flags;
+    loadDesc.mDesc.mStructStride = sizeof(uint32_t);
+    loadDesc.mDesc.mElementCount = (uint32_t)(loadDesc.mDesc.mSize / loadDesc.mDesc.mStructStride);
+    loadDesc.mDesc.mStartState = gUma ? gIndexBufferState : pDesc->mStartState;
+    loadDesc.mDesc.pName = pDesc->pNameIndexBuffer ? pDesc->pNameIndexBuffer : "GeometryBuffer Indices (unnamed)";
+    loadDesc.mDesc.pPlacement = pDesc->pIndicesPlacement;
+    addResource(&loadDesc, nullptr);
+
+    BufferChunkAllocatorDesc allocDesc = { pIndexBuffer };
+    addBufferChunkAllocator(&allocDesc, &pBuffer->mIndex);
+
+    for (size_t i = 0; i < TF_ARRAY_COUNT(pDesc->mVerticesSizes); ++i)
     {
         if (!pDesc->mVerticesSizes[i])
             continue;
@@ -3455,48 +5065,20 @@ void addGeometryBufferPart(BufferChunkAllocator* pBuffer, uint32_t size, uint32_
     {
         ASSERT(pRequestedChunk->mOffset + pRequestedChunk->mSize <= pBuffer->mSize);
 
-        // Try to allocate the requested slot
-        for (uint32_t i = 0; i < arrlenu(pBuffer->mUnusedChunks); ++i)
+        // Try to allocate the requested slot, free chunks are not indexed by offset so this walks the buffer
+        for (uint32_t i = pBuffer->mFirstNode; i != BUFFER_CHUNK_NONE; i = pBuffer->pNodes[i].mNext)
         {
-            BufferChunk* chunk = &pBuffer->mUnusedChunks[i];
+            const BufferChunkNode* chunk = &pBuffer->pNodes[i];
 
-            const uint32_t chunkEnd = chunk->mOffset + chunk->mSize;
+            const uint32_t chunkEnd = chunk->mChunk.mOffset + chunk->mChunk.mSize;
             const uint32_t requestedEnd = pRequestedChunk->mOffset + pRequestedChunk->mSize;
-            if (chunk->mOffset <= pRequestedChunk->mOffset && chunkEnd >= requestedEnd)
+            if (chunk->mChunk.mOffset <= pRequestedChunk->mOffset && chunkEnd >= requestedEnd)
             {
-                ++pBuffer->mUsedChunkCount;
+                if (!chunk->mFree)
+                    break;
 
+                allocateChunkRange(pBuffer, i, pRequestedChunk->mOffset, pRequestedChunk->mSize);
                 *pOut = *pRequestedChunk;
-
-                if (chunk->mOffset == pRequestedChunk->mOffset && chunkEnd == requestedEnd)
-                {
-                    // Exact chunk
-                    arrdel(pBuffer->mUnusedChunks, i);
-                    return;
-                }
-
-                // There's unnused memory before the requested chunk
-                if (chunk->mOffset < pRequestedChunk->mOffset)
-                {
-                    BufferChunk prevChunk = { chunk->mOffset, pRequestedChunk->mOffset - chunk->mOffset };
-                    arrins(pBuffer->mUnusedChunks, i, prevChunk);
-                    i++;
-                    chunk = &pBuffer->mUnusedChunks[i];
-                }
-
-                if (chunkEnd == requestedEnd)
-                {
-                    // We consummed the full chunk
-                    arrdel(pBuffer->mUnusedChunks, i);
-                }
-                else
-                {
-                    // There's unnused memory after the requested chunk
-                    chunk->mSize = chunkEnd - requestedEnd;
-                    chunk->mOffset = pRequestedChunk->mOffset + pRequestedChunk->mSize;
-                    ASSERT(chunk->mSize > 0);
-                }
-
                 return;
             }
         }
@@ -3505,56 +5087,18 @@ void addGeometryBufferPart(BufferChunkAllocator* pBuffer, uint32_t size, uint32_
         return;
     }
 
-    // TODO binary search. (unused chunk array is sorted already)
-    for (uint32_t i = 0; i < arrlenu(pBuffer->mUnusedChunks); ++i)
+    const uint32_t index = findFreeChunk(pBuffer, size, alignment);
+    if (index == BUFFER_CHUNK_NONE)
     {
-        BufferChunk* chunk = &pBuffer->mUnusedChunks[i];
-
-        if (chunk->mSize < size)
-            continue;
-
-        if (alignment > 0)
-        {
-            uint32_t padding = chunk->mOffset % alignment;
-            if (padding > 0)
-                padding = alignment - padding;
-
-            if (chunk->mSize - padding < size)
-                continue;
-
-            if (padding > 0)
-            {
-                BufferChunk paddingChunk = {
-                    chunk->mOffset,
-                    padding,
-                };
-
-                arrins(pBuffer->mUnusedChunks, i, paddingChunk);
-                i++;
-
-                chunk = &pBuffer->mUnusedChunks[i];
-                chunk->mOffset += padding;
-                chunk->mSize -= padding;
-            }
-        }
-
-        pOut->mOffset = chunk->mOffset;
-        pOut->mSize = size;
-
-        chunk->mOffset += size;
-        chunk->mSize -= size;
-
-        if (chunk->mSize == 0)
-        {
-            arrdel(pBuffer->mUnusedChunks, i);
-        }
-
-        ++pBuffer->mUsedChunkCount;
+        *pOut = {};
+        ASSERT(false);
         return;
     }
 
-    *pOut = {};
-    ASSERT(false);
+    const uint32_t offset = pBuffer->pNodes[index].mChunk.mOffset;
+    pOut->mOffset = offset + getChunkAlignmentPadding(offset, alignment);
+    pOut->mSize = size;
+    allocateChunkRange(pBuffer, index, pOut->mOffset, size);
 }
 
 void removeGeometryBufferPart(BufferChunkAllocator* pBuffer, BufferChunk* pChunk)
@@ -3565,42 +5109,64 @@ void removeGeometryBufferPart(BufferChunkAllocator* pBuffer, BufferChunk* pChunk
 
     ASSERT(pBuffer->mUsedChunkCount);
 
+    const ptrdiff_t entry = hmgeti(pBuffer->pInternal->pUsedNodes, pChunk->mOffset);
+    if (entry < 0)
+    {
+        ASSERT(false && "Chunk was not allocated from this buffer");
+        return;
+    }
+
+    uint32_t index = pBuffer->pInternal->pUsedNodes[entry].value;
+    hmdel(pBuffer->pInternal->pUsedNodes, pChunk->mOffset);
+    ASSERT(pBuffer->pNodes[index].mChunk.mSize == pChunk->mSize);
     --pBuffer->mUsedChunkCount;
 
-    const uint64_t partEnd = pChunk->mOffset + pChunk->mSize;
+    // Merge with free neighbours
+    const uint32_t prev = pBuffer->pNodes[index].mPrev;
+    if (prev != BUFFER_CHUNK_NONE && pBuffer->pNodes[prev].mFree)
+    {
+        removeFreeChunk(pBuffer, prev);
+        pBuffer->pNodes[prev].mChunk.mSize += pBuffer->pNodes[index].mChunk.mSize;
+        removeChunkNode(pBuffer, index);
+        index = prev;
+    }
 
-    // TODO binary search. (unused chunk array is sorted already)
-    uint64_t i = 0;
-    for (; i < arrlenu(pBuffer->mUnusedChunks); ++i)
+    const uint32_t next = pBuffer->pNodes[index].mNext;
+    if (next != BUFFER_CHUNK_NONE && pBuffer->pNodes[next].mFree)
     {
-        BufferChunk* chunk = &pBuffer->mUnusedChunks[i];
-        if (partEnd < chunk->mOffset)
-            break;
+        removeFreeChunk(pBuffer, next);
+        pBuffer->pNodes[index].mChunk.mSize += pBuffer->pNodes[next].mChunk.mSize;
+        removeChunkNode(pBuffer, next);
+    }
 
-        auto chunkEnd = chunk->mOffset + chunk->mSize;
-        if (chunkEnd == pChunk->mOffset) // if pChunk goes after chunk, merge both
-        {
-            chunk->mSize += pChunk->mSize;
-            if (i + 1 < arrlenu(pBuffer->mUnusedChunks)) // If there's another empty chunk after pChunk, merge that one too
-            {
-                if (partEnd == pBuffer->mUnusedChunks[i + 1].mOffset)
-                {
-                    chunk->mSize += pBuffer->mUnusedChunks[i + 1].mSize;
-                    arrdel(pBuffer->mUnusedChunks, i + 1);
-                }
-            }
-            return;
-        }
+    insertFreeChunk(pBuffer, index);
+}
 
-        if (partEnd == chunk->mOffset) // If pChunk goes after chunk, merge both
+void getGeometryBufferPartStats(const BufferChunkAllocator* pBuffer, BufferChunkAllocatorStats* pOutStats)
+{
+    *pOutStats = {};
+    pOutStats->mSize = pBuffer->mSize;
+    pOutStats->mUsedChunkCount = pBuffer->mUsedChunkCount;
+    pOutStats->mUsedSize = pBuffer->mSize - pBuffer->mFreeSize;
+    pOutStats->mFreeChunkCount = pBuffer->mFreeChunkCount;
+    pOutStats->mFreeSize = pBuffer->mFreeSize;
+
+    // Largest chunk is in the highest non empty class
+    const BufferChunkAllocatorInternal* pInternal = pBuffer->pInternal;
+    if (pInternal && pInternal->mFirstLevelBitmap)
+    {
+        const uint32_t fl = bitScanReverse(pInternal->mFirstLevelBitmap);
+        const uint32_t sl = bitScanReverse(pInternal->mSecondLevelBitmaps[fl]);
+        for (uint32_t i = pInternal->mFreeLists[fl][sl]; i != BUFFER_CHUNK_NONE; i = pBuffer->pNodes[i].mNextFree)
         {
-            chunk->mOffset = pChunk->mOffset;
-            chunk->mSize += pChunk->mSize;
-            return;
+            pOutStats->mLargestFreeChunkSize = max(pOutStats->mLargestFreeChunkSize, pBuffer->pNodes[i].mChunk.mSize);
         }
     }
 
-    arrins(pBuffer->mUnusedChunks, i, *pChunk);
+    if (pOutStats->mFreeSize)
+    {
+        pOutStats->mFragmentation = 1.0f - (float)pOutStats->mLargestFreeChunkSize / (float)pOutStats->mFreeSize;
+    }
 }
 
 void beginUpdateResource(BufferUpdateDesc* pBufferUpdate)
@@ -3657,165 +5223,597 @@ void beginUpdateResource(BufferUpdateDesc* pBufferUpdate)
     }
 }
 
-void endUpdateResource(BufferUpdateDesc* pBufferUpdate)
+void endUpdateResource(BufferUpdateDesc* pBufferUpdate)
+{
+    const uint32_t nodeIndex = pBufferUpdate->pBuffer->mNodeIndex;
+    if (pBufferUpdate->mInternal.mMappedRange.mFlags & MAPPED_RANGE_FLAG_UNMAP_BUFFER)
+    {
+        unmapBuffer(pResourceLoader->ppRenderers[nodeIndex], pBufferUpdate->pBuffer);
+    }
+
+    ResourceMemoryUsage memoryUsage = (ResourceMemoryUsage)pBufferUpdate->pBuffer->mMemoryUsage;
+    if (!gUma && memoryUsage == RESOURCE_MEMORY_USAGE_GPU_ONLY)
+    {
+        MutexLock   lock(pResourceLoader->mUploadEngineMutex);
+        CopyEngine* pCopyEngine = &pResourceLoader->pUploadEngines[nodeIndex];
+        updateBuffer(pResourceLoader->ppRenderers[nodeIndex], pCopyEngine, *pBufferUpdate);
+    }
+
+    // Restore the state to before the beginUpdateResource call.
+    pBufferUpdate->pMappedData = NULL;
+    pBufferUpdate->mInternal = {};
+}
+
+TextureSubresourceUpdate TextureUpdateDesc::getSubresourceUpdateDesc(uint32_t mip, uint32_t layer)
+{
+    TextureSubresourceUpdate ret = {};
+    Texture*                 texture = pTexture;
+    const TinyImageFormat    fmt = (TinyImageFormat)texture->mFormat;
+    Renderer*                pRenderer = pResourceLoader->ppRenderers[texture->mNodeIndex];
+    const uint32_t           sliceAlignment = util_get_texture_subresource_alignment(pRenderer, fmt);
+
+    bool success = util_get_surface_info(MIP_REDUCE(texture->mWidth, mip), MIP_REDUCE(texture->mHeight, mip), fmt, &ret.mSrcSliceStride,
+                                         &ret.mSrcRowStride, &ret.mRowCount);
+    ASSERT(success);
+    UNREF_PARAM(success);
+
+    ret.mDstRowStride = round_up(ret.mSrcRowStride, util_get_texture_row_alignment(pRenderer));
+    ret.mDstSliceStride = round_up(ret.mDstRowStride * ret.mRowCount, sliceAlignment);
+    ret.pMappedData = mInternal.mMappedRange.pData + (mInternal.mDstSliceStride * (layer - mBaseArrayLayer));
+    // Calculate the offset for the mip in this array layer
+    for (uint32_t i = mBaseMipLevel; i < mip; ++i)
+    {
+        uint32_t srcSliceStride = 0;
+        uint32_t srcRowStride = 0;
+        uint32_t rowCount = 0;
+        success = util_get_surface_info(MIP_REDUCE(texture->mWidth, i), MIP_REDUCE(texture->mHeight, i), fmt, &srcSliceStride,
+                                        &srcRowStride, &rowCount);
+        ASSERT(success);
+        uint32_t d = MIP_REDUCE(texture->mDepth, i);
+
+        uint32_t dstRowStride = round_up(srcRowStride, util_get_texture_row_alignment(pRenderer));
+        uint32_t dstSliceStride = round_up(dstRowStride * rowCount, sliceAlignment);
+        ret.pMappedData += (dstSliceStride * d);
+    }
+
+    return ret;
+}
+
+void beginUpdateResource(TextureUpdateDesc* pTextureUpdate)
+{
+    const Texture*        texture = pTextureUpdate->pTexture;
+    const TinyImageFormat fmt = (TinyImageFormat)texture->mFormat;
+    Renderer*             pRenderer = pResourceLoader->ppRenderers[texture->mNodeIndex];
+    const uint32_t        sliceAlignment = util_get_texture_subresource_alignment(pRenderer, fmt);
+    pTextureUpdate->mMipLevels = max(1u, pTextureUpdate->mMipLevels);
+    pTextureUpdate->mLayerCount = max(1u, pTextureUpdate->mLayerCount);
+
+    const uint32_t rowAlignment = util_get_texture_row_alignment(pRenderer);
+    const uint64_t requiredSize = util_get_surface_size(fmt, texture->mWidth, texture->mHeight, texture->mDepth, rowAlignment,
+                                                        sliceAlignment, pTextureUpdate->mBaseMipLevel, pTextureUpdate->mMipLevels,
+                                                        pTextureUpdate->mBaseArrayLayer, pTextureUpdate->mLayerCount);
+
+    // We need to use a staging buffer.
+    MutexLock         lock(pResourceLoader->mUploadEngineMutex);
+    const uint32_t    nodeIndex = pTextureUpdate->pTexture->mNodeIndex;
+    CopyEngine*       pCopyEngine = &pResourceLoader->pUploadEngines[nodeIndex];
+    MappedMemoryRange range = allocateStagingMemory(pCopyEngine, requiredSize, sliceAlignment, texture->mNodeIndex);
+    if (!range.pData)
+    {
+        range = allocateUploadMemory(pRenderer, requiredSize, sliceAlignment);
+        arrpush(pCopyEngine->resourceSets[pCopyEngine->activeSet].mTempBuffers, range.pBuffer);
+    }
+
+    pTextureUpdate->mInternal = {};
+    pTextureUpdate->mInternal.mMappedRange = range;
+
+    // Pre-calculate stride for the mip chain. Will be used in getSubresourceUpdateDesc
+    for (uint32_t mip = pTextureUpdate->mBaseMipLevel; mip < pTextureUpdate->mMipLevels; ++mip)
+    {
+        uint32_t srcSliceStride = 0;
+        uint32_t srcRowStride = 0;
+        uint32_t rowCount = 0;
+        bool     success = util_get_surface_info(MIP_REDUCE(texture->mWidth, mip), MIP_REDUCE(texture->mHeight, mip), fmt, &srcSliceStride,
+                                             &srcRowStride, &rowCount);
+        ASSERT(success);
+        uint32_t d = MIP_REDUCE(texture->mDepth, mip);
+
+        uint32_t dstRowStride = round_up(srcRowStride, util_get_texture_row_alignment(pRenderer));
+        uint32_t dstSliceStride = round_up(dstRowStride * rowCount, sliceAlignment);
+        pTextureUpdate->mInternal.mDstSliceStride += (dstSliceStride * d);
+    }
+}
+
+void endUpdateResource(TextureUpdateDesc* pTextureUpdate)
+{
+    TextureUpdateDescInternal desc = {};
+    desc.pTexture = pTextureUpdate->pTexture;
+    desc.mRange = pTextureUpdate->mInternal.mMappedRange;
+    desc.pCmd = pTextureUpdate->pCmd;
+    desc.mBaseMipLevel = pTextureUpdate->mBaseMipLevel;
+    desc.mMipLevels = pTextureUpdate->mMipLevels;
+    desc.mBaseArrayLayer = pTextureUpdate->mBaseArrayLayer;
+    desc.mLayerCount = pTextureUpdate->mLayerCount;
+    desc.mCurrentState = pTextureUpdate->mCurrentState;
+    MutexLock      lock(pResourceLoader->mUploadEngineMutex);
+    const uint32_t nodeIndex = pTextureUpdate->pTexture->mNodeIndex;
+    CopyEngine*    pCopyEngine = &pResourceLoader->pUploadEngines[nodeIndex];
+    updateTexture(pResourceLoader->ppRenderers[nodeIndex], pCopyEngine, desc);
+
+    // Restore the state to before the beginUpdateResource call.
+    pTextureUpdate->mInternal = {};
+}
+
+void copyResource(TextureCopyDesc* pTextureDesc, SyncToken* token) { queueTextureCopy(pResourceLoader, pTextureDesc, token); }
+
+void flushResourceUpdates(FlushResourceUpdateDesc* pDesc)
+{
+    MutexLock lock(pResourceLoader->mUploadEngineMutex);
+
+    static FlushResourceUpdateDesc dummyDesc = {};
+    FlushResourceUpdateDesc&       desc = pDesc ? *pDesc : dummyDesc;
+    const uint32_t                 nodeIndex = desc.mNodeIndex;
+    CopyEngine*                    pCopyEngine = &pResourceLoader->pUploadEngines[nodeIndex];
+    const uint32_t                 activeSet = pCopyEngine->activeSet;
+
+    desc.pOutFence = pCopyEngine->resourceSets[activeSet].pFence;
+    desc.pOutSubmittedSemaphore = pCopyEngine->resourceSets[activeSet].pSemaphore;
+
+    if (!pCopyEngine->isRecording)
+    {
+        return;
+    }
+    for (uint32_t i = 0; i < desc.mWaitSemaphoreCount; ++i)
+    {
+        arrpush(pCopyEngine->mWaitSemaphores, desc.ppWaitSemaphores[i]);
+    }
+    streamerFlush(pCopyEngine);
+    pCopyEngine->activeSet = (activeSet + 1) % pCopyEngine->bufferCount;
+}
+
+SyncToken getLastTokenCompleted() { return tfrg_atomic64_load_acquire(&pResourceLoader->mTokenCompleted); }
+
+bool isTokenCompleted(const SyncToken* token) { return *token <= tfrg_atomic64_load_acquire(&pResourceLoader->mTokenCompleted); }
+
+void waitForToken(const SyncToken* token) { waitForToken(pResourceLoader, token); }
+
+SyncToken getLastTokenSubmitted() { return tfrg_atomic64_load_acquire(&pResourceLoader->mTokenSubmitted); }
+
+bool isTokenSubmitted(const SyncToken* token) { return *token <= tfrg_atomic64_load_acquire(&pResourceLoader->mTokenSubmitted); }
+
+void waitForTokenSubmitted(const SyncToken* token) { waitForTokenSubmitted(pResourceLoader, token); }
+
+bool cancelResourceLoad(SyncToken token)
+{
+    ResourceLoader* pLoader = pResourceLoader;
+
+    acquireMutex(&pLoader->mQueueMutex);
+
+    uint32_t  nodeIndex = 0;
+    uint32_t  priority = 0;
+    ptrdiff_t index = 0;
+    if (!findQueuedRequest(pLoader, token, &nodeIndex, &priority, &index))
+    {
+        releaseMutex(&pLoader->mQueueMutex);
+        return false;
+    }
+
+    UpdateRequest request = pLoader->mRequestQueue[nodeIndex][priority][index];
+    if ((request.mType != UPDATE_REQUEST_LOAD_BUFFER && request.mType != UPDATE_REQUEST_LOAD_TEXTURE &&
+         request.mType != UPDATE_REQUEST_LOAD_GEOMETRY) ||
+        (request.pPrepareJob && !cancelPrepareJob(pLoader, request.pPrepareJob)))
+    {
+        releaseMutex(&pLoader->mQueueMutex);
+        return false;
+    }
+
+    arrdel(pLoader->mRequestQueue[nodeIndex][priority], index);
+    setLoadCallbackStatus(pLoader, token, RESOURCE_LOAD_STATUS_CANCELLED);
+    markTokenExecuted(pLoader, token);
+
+    releaseMutex(&pLoader->mQueueMutex);
+    // Streamer thread publishes the token as completed
+    wakeOneConditionVariable(&pLoader->mQueueCond);
+
+    if (request.pPrepareJob)
+    {
+        freePrepareJobData(request.pPrepareJob);
+        releasePrepareJob(pLoader, request.pPrepareJob);
+    }
+    if (request.mType == UPDATE_REQUEST_LOAD_GEOMETRY)
+    {
+        tf_free((void*)request.geomLoadDesc.pVertexLayout);
+    }
+
+    return true;
+}
+
+bool setResourceLoadPriority(SyncToken token, ResourceLoadPriority priority)
+{
+    ResourceLoader* pLoader = pResourceLoader;
+    const uint32_t  newPriority = getLoadPriorityIndex(priority);
+
+    acquireMutex(&pLoader->mQueueMutex);
+
+    uint32_t  nodeIndex = 0;
+    uint32_t  oldPriority = 0;
+    ptrdiff_t index = 0;
+    if (!findQueuedRequest(pLoader, token, &nodeIndex, &oldPriority, &index))
+    {
+        releaseMutex(&pLoader->mQueueMutex);
+        return false;
+    }
+
+    UpdateRequest request = pLoader->mRequestQueue[nodeIndex][oldPriority][index];
+    if (oldPriority != newPriority)
+    {
+        arrdel(pLoader->mRequestQueue[nodeIndex][oldPriority], index);
+        arrpush(pLoader->mRequestQueue[nodeIndex][newPriority], request);
+    }
+
+    // Still inside mQueueMutex, streamer thread cannot take the request and free its job meanwhile
+    if (request.pPrepareJob)
+    {
+        setPrepareJobPriority(pLoader, request.pPrepareJob, newPriority);
+    }
+
+    releaseMutex(&pLoader->mQueueMutex);
+
+    return true;
+}
+
+uint32_t drainCompletedResourceLoads(uint32_t maxCount)
+{
+    ResourceLoader* pLoader = pResourceLoader;
+
+    ResourceLoadCallbackEntry batch[64];
+    uint32_t                  calledCount = 0;
+    for (;;)
+    {
+        uint32_t count = TF_ARRAY_COUNT(batch);
+        if (maxCount)
+        {
+            count = min(count, maxCount - calledCount);
+        }
+
+        acquireMutex(&pLoader->mCallbackMutex);
+        count = (uint32_t)min((ptrdiff_t)count, arrlen(pLoader->mReadyCallbacks));
+        if (count)
+        {
+            memcpy(batch, pLoader->mReadyCallbacks, count * sizeof(*batch));
+            arrdeln(pLoader->mReadyCallbacks, 0, count);
+        }
+        releaseMutex(&pLoader->mCallbackMutex);
+
+        if (!count)
+        {
+            break;
+        }
+
+        // Outside of the lock, callbacks may queue new loads
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            batch[i].pCallback(batch[i].pUserData, batch[i].mToken, batch[i].mStatus);
+        }
+        calledCount += count;
+    }
+
+    return calledCount;
+}
+
+/************************************************************************/
+// Texture streaming
+/************************************************************************/
+static void unlinkStreamedTexture(ResourceLoader* pLoader, StreamedTextureInternal* pTexture)
+{
+    if (pTexture->pPrev)
+        pTexture->pPrev->pNext = pTexture->pNext;
+    else
+        pLoader->pStreamedTexturesHead = pTexture->pNext;
+
+    if (pTexture->pNext)
+        pTexture->pNext->pPrev = pTexture->pPrev;
+    else
+        pLoader->pStreamedTexturesTail = pTexture->pPrev;
+
+    pTexture->pPrev = NULL;
+    pTexture->pNext = NULL;
+}
+
+static void linkStreamedTextureFirst(ResourceLoader* pLoader, StreamedTextureInternal* pTexture)
+{
+    pTexture->pNext = pLoader->pStreamedTexturesHead;
+    if (pLoader->pStreamedTexturesHead)
+        pLoader->pStreamedTexturesHead->pPrev = pTexture;
+    else
+        pLoader->pStreamedTexturesTail = pTexture;
+    pLoader->pStreamedTexturesHead = pTexture;
+}
+
+static uint64_t getStreamedTextureSize(const StreamedTextureInternal* pTexture, uint32_t mipCount)
+{
+    ASSERT(mipCount >= pTexture->mPublic.mMinMipCount && mipCount <= pTexture->mPublic.mMipLevels);
+    return pTexture->pSizes[mipCount - pTexture->mPublic.mMinMipCount];
+}
+
+static void queueStreamedTextureLoad(ResourceLoader* pLoader, StreamedTextureInternal* pTexture, uint32_t mipCount)
+{
+    TextureLoadDescInternal loadDesc = {};
+    loadDesc.ppTexture = &pTexture->pPendingTexture;
+    loadDesc.pFileName = pTexture->pFileName;
+    loadDesc.mFlags = pTexture->mFlags;
+    loadDesc.mContainer = pTexture->mContainer;
+    loadDesc.mNodeIndex = pTexture->mDesc.mNodeIndex;
+    loadDesc.mSkipMipCount = pTexture->mPublic.mMipLevels - mipCount;
+
+    // Texture cannot be used before its smallest mips are loaded, and evictions free memory
+    ResourceLoadOptions options = {};
+    options.mPriority = (!pTexture->mPublic.pTexture || mipCount < pTexture->mPublic.mResidentMipCount) ? RESOURCE_LOAD_PRIORITY_HIGH
+                                                                                                          : RESOURCE_LOAD_PRIORITY_NORMAL;
+
+    pTexture->pPendingTexture = NULL;
+    pTexture->mPendingToken = 0;
+    pTexture->mPendingMipCount = mipCount;
+    pTexture->mLoadPending = true;
+    queueTextureLoad(pLoader, &loadDesc, &options, &pTexture->mPendingToken);
+}
+
+bool addStreamedTexture(const StreamedTextureLoadDesc* pDesc)
+{
+    ASSERT(pDesc->ppTexture);
+    ASSERT(pDesc->pFileName);
+
+    ResourceLoader*      pLoader = pResourceLoader;
+    TextureContainerType container = resolveTextureContainer(pDesc->mContainer);
+    if (!canReadTextureFileAhead(container))
+    {
+        LOGF(eERROR, "Texture %s cannot be streamed, only DDS and KTX files loaded by the resource loader can be streamed",
+             pDesc->pFileName);
+        return false;
+    }
+
+    TextureLoadDescInternal loadDesc = {};
+    loadDesc.pFileName = pDesc->pFileName;
+    loadDesc.mFlags = pDesc->mCreationFlag;
+    loadDesc.mContainer = container;
+
+    // Header only, mip data is read by the loads
+    TextureDesc               textureDesc = {};
+    TextureUpdateDescInternal updateDesc = {};
+    if (!readTextureFile(&loadDesc, container, false, &textureDesc, &updateDesc, NULL))
+    {
+        LOGF(eERROR, "Failed to open texture file %s", pDesc->pFileName);
+        return false;
+    }
+    fsCloseStream(&updateDesc.mStream);
+
+    textureDesc.mNodeIndex = pDesc->mNodeIndex;
+    textureDesc.mStartState = RESOURCE_STATE_COPY_DEST;
+
+    // Block compressed textures need their top mip to be whole blocks
+    const uint32_t blockWidth = TinyImageFormat_WidthOfBlock(textureDesc.mFormat);
+    const uint32_t blockHeight = TinyImageFormat_HeightOfBlock(textureDesc.mFormat);
+    uint32_t       maxSkipMipCount = textureDesc.mMipLevels - 1;
+    while (maxSkipMipCount && (MIP_REDUCE(textureDesc.mWidth, maxSkipMipCount) % blockWidth ||
+                               MIP_REDUCE(textureDesc.mHeight, maxSkipMipCount) % blockHeight))
+    {
+        --maxSkipMipCount;
+    }
+    const uint32_t minMipCount = textureDesc.mMipLevels - maxSkipMipCount;
+    const uint32_t sizeCount = textureDesc.mMipLevels - minMipCount + 1;
+
+    size_t                   fileNameSize = strlen(pDesc->pFileName) + 1;
+    size_t                   totalSize = sizeof(StreamedTextureInternal) + sizeCount * sizeof(uint64_t) + fileNameSize;
+    StreamedTextureInternal* pTexture = (StreamedTextureInternal*)tf_calloc(1, totalSize);
+    pTexture->pSizes = (uint64_t*)(pTexture + 1);
+    pTexture->pFileName = (const char*)memcpy(pTexture->pSizes + sizeCount, pDesc->pFileName, fileNameSize);
+    pTexture->mDesc = textureDesc;
+    pTexture->mDesc.pName = pTexture->pFileName;
+    pTexture->mFlags = pDesc->mCreationFlag;
+    pTexture->mContainer = container;
+    pTexture->mPublic.mMipLevels = textureDesc.mMipLevels;
+    pTexture->mPublic.mMinMipCount = minMipCount;
+    pTexture->mPublic.mRequestedMipCount = minMipCount;
+
+    Renderer* pRenderer = pLoader->ppRenderers[pDesc->mNodeIndex];
+    for (uint32_t i = 0; i < sizeCount; ++i)
+    {
+        const uint32_t skipMipCount = maxSkipMipCount - i;
+        TextureDesc    mipsDesc = textureDesc;
+        mipsDesc.mWidth = MIP_REDUCE(textureDesc.mWidth, skipMipCount);
+        mipsDesc.mHeight = MIP_REDUCE(textureDesc.mHeight, skipMipCount);
+        mipsDesc.mDepth = MIP_REDUCE(textureDesc.mDepth, skipMipCount);
+        mipsDesc.mMipLevels = textureDesc.mMipLevels - skipMipCount;
+
+        ResourceSizeAlign sizeAlign = {};
+        getTextureSizeAlign(pRenderer, &mipsDesc, &sizeAlign);
+        pTexture->pSizes[i] = sizeAlign.mSize;
+    }
+
+    linkStreamedTextureFirst(pLoader, pTexture);
+    queueStreamedTextureLoad(pLoader, pTexture, minMipCount);
+
+    *pDesc->ppTexture = &pTexture->mPublic;
+    return true;
+}
+
+void removeStreamedTexture(StreamedTexture* pStreamedTexture)
 {
-    const uint32_t nodeIndex = pBufferUpdate->pBuffer->mNodeIndex;
-    if (pBufferUpdate->mInternal.mMappedRange.mFlags & MAPPED_RANGE_FLAG_UNMAP_BUFFER)
+    ResourceLoader*          pLoader = pResourceLoader;
+    StreamedTextureInternal* pTexture = (StreamedTextureInternal*)pStreamedTexture;
+
+    // Load reads pTexture->pFileName, which is freed with pTexture below. Cancel only succeeds if no thread
+    // reads the file or executes the load, otherwise the load must finish before the memory goes away.
+    if (pTexture->mLoadPending && !cancelResourceLoad(pTexture->mPendingToken))
     {
-        unmapBuffer(pResourceLoader->ppRenderers[nodeIndex], pBufferUpdate->pBuffer);
+        waitForToken(pLoader, &pTexture->mPendingToken);
     }
-
-    ResourceMemoryUsage memoryUsage = (ResourceMemoryUsage)pBufferUpdate->pBuffer->mMemoryUsage;
-    if (!gUma && memoryUsage == RESOURCE_MEMORY_USAGE_GPU_ONLY)
+    if (pTexture->pPendingTexture)
     {
-        MutexLock   lock(pResourceLoader->mUploadEngineMutex);
-        CopyEngine* pCopyEngine = &pResourceLoader->pUploadEngines[nodeIndex];
-        updateBuffer(pResourceLoader->ppRenderers[nodeIndex], pCopyEngine, *pBufferUpdate);
+        removeResource(pTexture->pPendingTexture);
+    }
+    if (pTexture->mPublic.pTexture)
+    {
+        removeResource(pTexture->mPublic.pTexture);
     }
 
-    // Restore the state to before the beginUpdateResource call.
-    pBufferUpdate->pMappedData = NULL;
-    pBufferUpdate->mInternal = {};
+    unlinkStreamedTexture(pLoader, pTexture);
+    tf_free(pTexture);
 }
 
-TextureSubresourceUpdate TextureUpdateDesc::getSubresourceUpdateDesc(uint32_t mip, uint32_t layer)
+void requestStreamedTextureMips(StreamedTexture* pStreamedTexture, uint32_t mipCount)
 {
-    TextureSubresourceUpdate ret = {};
-    Texture*                 texture = pTexture;
-    const TinyImageFormat    fmt = (TinyImageFormat)texture->mFormat;
-    Renderer*                pRenderer = pResourceLoader->ppRenderers[texture->mNodeIndex];
-    const uint32_t           sliceAlignment = util_get_texture_subresource_alignment(pRenderer, fmt);
-
-    bool success = util_get_surface_info(MIP_REDUCE(texture->mWidth, mip), MIP_REDUCE(texture->mHeight, mip), fmt, &ret.mSrcSliceStride,
-                                         &ret.mSrcRowStride, &ret.mRowCount);
-    ASSERT(success);
-    UNREF_PARAM(success);
+    ResourceLoader*          pLoader = pResourceLoader;
+    StreamedTextureInternal* pTexture = (StreamedTextureInternal*)pStreamedTexture;
 
-    ret.mDstRowStride = round_up(ret.mSrcRowStride, util_get_texture_row_alignment(pRenderer));
-    ret.mDstSliceStride = round_up(ret.mDstRowStride * ret.mRowCount, sliceAlignment);
-    ret.pMappedData = mInternal.mMappedRange.pData + (mInternal.mDstSliceStride * (layer - mBaseArrayLayer));
-    // Calculate the offset for the mip in this array layer
-    for (uint32_t i = mBaseMipLevel; i < mip; ++i)
+    pTexture->mPublic.mRequestedMipCount = clamp(mipCount, pTexture->mPublic.mMinMipCount, pTexture->mPublic.mMipLevels);
+    if (pLoader->pStreamedTexturesHead != pTexture)
     {
-        uint32_t srcSliceStride = 0;
-        uint32_t srcRowStride = 0;
-        uint32_t rowCount = 0;
-        success = util_get_surface_info(MIP_REDUCE(texture->mWidth, i), MIP_REDUCE(texture->mHeight, i), fmt, &srcSliceStride,
-                                        &srcRowStride, &rowCount);
-        ASSERT(success);
-        uint32_t d = MIP_REDUCE(texture->mDepth, i);
-
-        uint32_t dstRowStride = round_up(srcRowStride, util_get_texture_row_alignment(pRenderer));
-        uint32_t dstSliceStride = round_up(dstRowStride * rowCount, sliceAlignment);
-        ret.pMappedData += (dstSliceStride * d);
+        unlinkStreamedTexture(pLoader, pTexture);
+        linkStreamedTextureFirst(pLoader, pTexture);
     }
-
-    return ret;
 }
 
-void beginUpdateResource(TextureUpdateDesc* pTextureUpdate)
+uint32_t updateTextureStreaming()
 {
-    const Texture*        texture = pTextureUpdate->pTexture;
-    const TinyImageFormat fmt = (TinyImageFormat)texture->mFormat;
-    Renderer*             pRenderer = pResourceLoader->ppRenderers[texture->mNodeIndex];
-    const uint32_t        sliceAlignment = util_get_texture_subresource_alignment(pRenderer, fmt);
-    pTextureUpdate->mMipLevels = max(1u, pTextureUpdate->mMipLevels);
-    pTextureUpdate->mLayerCount = max(1u, pTextureUpdate->mLayerCount);
-
-    const uint32_t rowAlignment = util_get_texture_row_alignment(pRenderer);
-    const uint64_t requiredSize = util_get_surface_size(fmt, texture->mWidth, texture->mHeight, texture->mDepth, rowAlignment,
-                                                        sliceAlignment, pTextureUpdate->mBaseMipLevel, pTextureUpdate->mMipLevels,
-                                                        pTextureUpdate->mBaseArrayLayer, pTextureUpdate->mLayerCount);
+    ResourceLoader* pLoader = pResourceLoader;
+    ++pLoader->mStreamingFrame;
 
-    // We need to use a staging buffer.
-    MutexLock         lock(pResourceLoader->mUploadEngineMutex);
-    const uint32_t    nodeIndex = pTextureUpdate->pTexture->mNodeIndex;
-    CopyEngine*       pCopyEngine = &pResourceLoader->pUploadEngines[nodeIndex];
-    MappedMemoryRange range = allocateStagingMemory(pCopyEngine, requiredSize, sliceAlignment, texture->mNodeIndex);
-    if (!range.pData)
+    for (ptrdiff_t i = 0; i < arrlen(pLoader->mRetiredTextures);)
     {
-        range = allocateUploadMemory(pRenderer, requiredSize, sliceAlignment);
-        arrpush(pCopyEngine->resourceSets[pCopyEngine->activeSet].mTempBuffers, range.pBuffer);
+        if (pLoader->mStreamingFrame - pLoader->mRetiredTextures[i].mFrame >= MAX_FRAMES)
+        {
+            removeResource(pLoader->mRetiredTextures[i].pTexture);
+            arrdelswap(pLoader->mRetiredTextures, i);
+        }
+        else
+        {
+            ++i;
+        }
     }
 
-    pTextureUpdate->mInternal = {};
-    pTextureUpdate->mInternal.mMappedRange = range;
-
-    // Pre-calculate stride for the mip chain. Will be used in getSubresourceUpdateDesc
-    for (uint32_t mip = pTextureUpdate->mBaseMipLevel; mip < pTextureUpdate->mMipLevels; ++mip)
+    uint32_t changedCount = 0;
+    for (StreamedTextureInternal* pTexture = pLoader->pStreamedTexturesHead; pTexture; pTexture = pTexture->pNext)
     {
-        uint32_t srcSliceStride = 0;
-        uint32_t srcRowStride = 0;
-        uint32_t rowCount = 0;
-        bool     success = util_get_surface_info(MIP_REDUCE(texture->mWidth, mip), MIP_REDUCE(texture->mHeight, mip), fmt, &srcSliceStride,
-                                             &srcRowStride, &rowCount);
-        ASSERT(success);
-        uint32_t d = MIP_REDUCE(texture->mDepth, mip);
+        if (!pTexture->mLoadPending || !isTokenCompleted(&pTexture->mPendingToken))
+        {
+            continue;
+        }
 
-        uint32_t dstRowStride = round_up(srcRowStride, util_get_texture_row_alignment(pRenderer));
-        uint32_t dstSliceStride = round_up(dstRowStride * rowCount, sliceAlignment);
-        pTextureUpdate->mInternal.mDstSliceStride += (dstSliceStride * d);
+        pTexture->mLoadPending = false;
+        if (!pTexture->pPendingTexture)
+        {
+            // Not retried, resident mips stay as they are
+            LOGF(eERROR, "Failed to stream %u mips of texture %s", pTexture->mPendingMipCount, pTexture->pFileName);
+            pTexture->mFailed = true;
+            continue;
+        }
+
+        if (pTexture->mPublic.pTexture)
+        {
+            RetiredTexture retired = { pTexture->mPublic.pTexture, pLoader->mStreamingFrame };
+            arrpush(pLoader->mRetiredTextures, retired);
+        }
+        pTexture->mPublic.pTexture = pTexture->pPendingTexture;
+        pTexture->mPublic.mResidentMipCount = pTexture->mPendingMipCount;
+        pTexture->mPublic.mResidentSize = getStreamedTextureSize(pTexture, pTexture->mPendingMipCount);
+        pTexture->pPendingTexture = NULL;
+        ++changedCount;
     }
-}
 
-void endUpdateResource(TextureUpdateDesc* pTextureUpdate)
-{
-    TextureUpdateDescInternal desc = {};
-    desc.pTexture = pTextureUpdate->pTexture;
-    desc.mRange = pTextureUpdate->mInternal.mMappedRange;
-    desc.pCmd = pTextureUpdate->pCmd;
-    desc.mBaseMipLevel = pTextureUpdate->mBaseMipLevel;
-    desc.mMipLevels = pTextureUpdate->mMipLevels;
-    desc.mBaseArrayLayer = pTextureUpdate->mBaseArrayLayer;
-    desc.mLayerCount = pTextureUpdate->mLayerCount;
-    desc.mCurrentState = pTextureUpdate->mCurrentState;
-    MutexLock      lock(pResourceLoader->mUploadEngineMutex);
-    const uint32_t nodeIndex = pTextureUpdate->pTexture->mNodeIndex;
-    CopyEngine*    pCopyEngine = &pResourceLoader->pUploadEngines[nodeIndex];
-    updateTexture(pResourceLoader->ppRenderers[nodeIndex], pCopyEngine, desc);
+    // Most recently requested textures get their requested mips first, the rest gets what fits into the budget
+    const uint64_t budget = pLoader->mDesc.mTextureStreamingBudget;
+    uint64_t       usedSize = 0;
+    for (StreamedTextureInternal* pTexture = pLoader->pStreamedTexturesHead; pTexture; pTexture = pTexture->pNext)
+    {
+        const StreamedTexture* pPublic = &pTexture->mPublic;
+        if (pTexture->mFailed || pTexture->mLoadPending)
+        {
+            const uint32_t mipCount = pTexture->mLoadPending ? max(pPublic->mResidentMipCount, pTexture->mPendingMipCount)
+                                                             : pPublic->mResidentMipCount;
+            usedSize += mipCount ? getStreamedTextureSize(pTexture, mipCount) : 0;
+            continue;
+        }
 
-    // Restore the state to before the beginUpdateResource call.
-    pTextureUpdate->mInternal = {};
-}
+        // Smallest mips stay resident regardless of the budget
+        uint32_t mipCount = pPublic->mRequestedMipCount;
+        while (budget && mipCount > pPublic->mMinMipCount && usedSize + getStreamedTextureSize(pTexture, mipCount) > budget)
+        {
+            --mipCount;
+        }
+        usedSize += getStreamedTextureSize(pTexture, mipCount);
 
-void copyResource(TextureCopyDesc* pTextureDesc, SyncToken* token) { queueTextureCopy(pResourceLoader, pTextureDesc, token); }
+        if (mipCount != pPublic->mResidentMipCount)
+        {
+            if (mipCount < pPublic->mResidentMipCount)
+            {
+                ++pLoader->mStreamingEvictionCount;
+            }
+            queueStreamedTextureLoad(pLoader, pTexture, mipCount);
+        }
+    }
 
-void flushResourceUpdates(FlushResourceUpdateDesc* pDesc)
-{
-    MutexLock lock(pResourceLoader->mUploadEngineMutex);
+    return changedCount;
+}
 
-    static FlushResourceUpdateDesc dummyDesc = {};
-    FlushResourceUpdateDesc&       desc = pDesc ? *pDesc : dummyDesc;
-    const uint32_t                 nodeIndex = desc.mNodeIndex;
-    CopyEngine*                    pCopyEngine = &pResourceLoader->pUploadEngines[nodeIndex];
-    const uint32_t                 activeSet = pCopyEngine->activeSet;
+void setTextureStreamingBudget(uint64_t budget) { pResourceLoader->mDesc.mTextureStreamingBudget = budget; }
 
-    desc.pOutFence = pCopyEngine->resourceSets[activeSet].pFence;
-    desc.pOutSubmittedSemaphore = pCopyEngine->resourceSets[activeSet].pSemaphore;
+void getTextureStreamingStats(TextureStreamingStats* pOutStats)
+{
+    ResourceLoader* pLoader = pResourceLoader;
 
-    if (!pCopyEngine->isRecording)
-    {
-        return;
-    }
-    for (uint32_t i = 0; i < desc.mWaitSemaphoreCount; ++i)
+    *pOutStats = {};
+    pOutStats->mBudget = pLoader->mDesc.mTextureStreamingBudget;
+    pOutStats->mEvictionCount = pLoader->mStreamingEvictionCount;
+    for (StreamedTextureInternal* pTexture = pLoader->pStreamedTexturesHead; pTexture; pTexture = pTexture->pNext)
     {
-        arrpush(pCopyEngine->mWaitSemaphores, desc.ppWaitSemaphores[i]);
+        pOutStats->mResidentSize += pTexture->mPublic.mResidentSize;
+        pOutStats->mRequestedSize += getStreamedTextureSize(pTexture, pTexture->mPublic.mRequestedMipCount);
+        pOutStats->mPendingLoadCount += pTexture->mLoadPending ? 1 : 0;
+        ++pOutStats->mTextureCount;
     }
-    streamerFlush(pCopyEngine);
-    pCopyEngine->activeSet = (activeSet + 1) % pCopyEngine->bufferCount;
 }
 
-SyncToken getLastTokenCompleted() { return tfrg_atomic64_load_acquire(&pResourceLoader->mTokenCompleted); }
+void advanceResourceLoaderFrame()
+{
+    ResourceLoader* pLoader = pResourceLoader;
 
-bool isTokenCompleted(const SyncToken* token) { return *token <= tfrg_atomic64_load_acquire(&pResourceLoader->mTokenCompleted); }
+    acquireMutex(&pLoader->mQueueMutex);
+    beginUploadFrame(pLoader);
+    ++pLoader->mFrameIndex;
+    releaseMutex(&pLoader->mQueueMutex);
+    wakeOneConditionVariable(&pLoader->mQueueCond);
+}
 
-void waitForToken(const SyncToken* token) { waitForToken(pResourceLoader, token); }
+void setResourceLoaderUploadBudget(uint64_t size, uint32_t requestCount)
+{
+    ResourceLoader* pLoader = pResourceLoader;
 
-SyncToken getLastTokenSubmitted() { return tfrg_atomic64_load_acquire(&pResourceLoader->mTokenSubmitted); }
+    acquireMutex(&pLoader->mQueueMutex);
+    pLoader->mDesc.mUploadBudgetSize = size;
+    pLoader->mDesc.mUploadBudgetRequestCount = requestCount;
+    releaseMutex(&pLoader->mQueueMutex);
+    wakeOneConditionVariable(&pLoader->mQueueCond);
+}
 
-bool isTokenSubmitted(const SyncToken* token) { return *token <= tfrg_atomic64_load_acquire(&pResourceLoader->mTokenSubmitted); }
+bool getResourceLoaderStats(ResourceLoaderStats* pOutStats)
+{
+    ResourceLoader* pLoader = pResourceLoader;
+    if (!pLoader)
+    {
+        return false;
+    }
 
-void waitForTokenSubmitted(const SyncToken* token) { waitForTokenSubmitted(pResourceLoader, token); }
+    acquireMutex(&pLoader->mQueueMutex);
+    *pOutStats = pLoader->mStats;
+    pOutStats->mQueuedRequestCount = 0;
+    for (uint32_t nodeIndex = 0; nodeIndex < pLoader->mGpuCount; ++nodeIndex)
+    {
+        pOutStats->mQueuedRequestCount += (uint32_t)getQueuedRequestCount(pLoader, nodeIndex);
+    }
+    releaseMutex(&pLoader->mQueueMutex);
+    return true;
+}
 
 bool allResourceLoadsCompleted()
 {
@@ -4014,6 +6012,10 @@ const char* getShaderPlatformName()
 #if defined(PROSPERO)
     return "PROSPERO";
 #endif
+#if defined(NULL_RENDERER)
+    // Shaders are not compiled for the null renderer, Vulkan bytecode is loaded for the metadata and otherwise ignored
+    return "VULKAN";
+#endif
 }
 
 void addShader(Renderer* pRenderer, const ShaderLoadDesc* pDesc, Shader** ppShader)
@@ -4207,7 +6209,7 @@ void loadPipelineCache(Renderer* pRenderer, const PipelineCacheLoadDesc* pDesc,
         tf_free(data);
     }
 #endif
-#if defined(DIRECT3D11)
+#if defined(DIRECT3D11) || defined(NULL_RENDERER)
 
     UNREF_PARAM(pRenderer);
     UNREF_PARAM(pDesc);
@@ -4242,7 +6244,7 @@ void savePipelineCache(Renderer* pRenderer, PipelineCache* pPipelineCache, Pipel
     }
 #endif
 
-#if defined(DIRECT3D11)
+#if defined(DIRECT3D11) || defined(NULL_RENDERER)
 
     UNREF_PARAM(pRenderer);
     UNREF_PARAM(pDesc);
@@ -4251,6 +6253,218 @@ void savePipelineCache(Renderer* pRenderer, PipelineCache* pPipelineCache, Pipel
 #endif
 }
 /************************************************************************/
+// Pipeline warm-up
+/************************************************************************/
+struct PipelineWarmUp
+{
+    Renderer*                 pRenderer;
+    const PipelineWarmUpDesc* pDesc;
+    RootSignature*            pRootSignature;
+    Mutex                     mMutex;
+    PipelineWarmUpProgress    mProgress;
+    bool                      mFailed;
+};
+
+struct PipelineWarmUpTask
+{
+    PipelineWarmUp* pWarmUp;
+    uint32_t        mIndex;
+};
+
+static void pipelineWarmUpReport(PipelineWarmUp* pWarmUp, uint32_t pipelineIndex, const char* pName, int64_t timeUs, bool failed)
+{
+    acquireMutex(&pWarmUp->mMutex);
+    PipelineWarmUpProgress* pProgress = &pWarmUp->mProgress;
+    if (UINT32_MAX == pipelineIndex)
+    {
+        ++pProgress->mShadersCompleted;
+    }
+    else
+    {
+        ++pProgress->mPipelinesCompleted;
+    }
+    pProgress->mPipelineIndex = pipelineIndex;
+    pProgress->pPipelineName = pName;
+    pProgress->mPipelineTimeUs = timeUs;
+    pProgress->mFailed = failed;
+    pWarmUp->mFailed |= failed;
+    if (pWarmUp->pDesc->pCallback)
+    {
+        pWarmUp->pDesc->pCallback(pProgress, pWarmUp->pDesc->pUserData);
+    }
+    releaseMutex(&pWarmUp->mMutex);
+}
+
+static void pipelineWarmUpShaderTask(void* pUser, uint64_t threadId)
+{
+    UNREF_PARAM(threadId);
+    PipelineWarmUpTask*       pTask = (PipelineWarmUpTask*)pUser;
+    const PipelineWarmUpDesc* pDesc = pTask->pWarmUp->pDesc;
+
+    addShader(pTask->pWarmUp->pRenderer, &pDesc->pShaderDescs[pTask->mIndex], &pDesc->ppShaders[pTask->mIndex]);
+    pipelineWarmUpReport(pTask->pWarmUp, UINT32_MAX, NULL, 0, !pDesc->ppShaders[pTask->mIndex]);
+}
+
+static void pipelineWarmUpPipelineTask(void* pUser, uint64_t threadId)
+{
+    UNREF_PARAM(threadId);
+    PipelineWarmUpTask*       pTask = (PipelineWarmUpTask*)pUser;
+    PipelineWarmUp*           pWarmUp = pTask->pWarmUp;
+    const PipelineWarmUpDesc* pDesc = pWarmUp->pDesc;
+    const uint32_t            index = pTask->mIndex;
+
+    PipelineDesc desc = pDesc->pPipelineDescs[index];
+    if (pDesc->pCache)
+    {
+        desc.pCache = pDesc->pCache;
+    }
+
+    Shader**        ppShaderProgram = NULL;
+    RootSignature** ppRootSignature = NULL;
+    switch (desc.mType)
+    {
+    case PIPELINE_TYPE_COMPUTE:
+        ppShaderProgram = &desc.mComputeDesc.pShaderProgram;
+        ppRootSignature = &desc.mComputeDesc.pRootSignature;
+        break;
+    case PIPELINE_TYPE_GRAPHICS:
+        ppShaderProgram = &desc.mGraphicsDesc.pShaderProgram;
+        ppRootSignature = &desc.mGraphicsDesc.pRootSignature;
+        break;
+    default:
+        break;
+    }
+
+    if (ppShaderProgram && !*ppShaderProgram && pDesc->pPipelineShaderIndices)
+    {
+        ASSERT(pDesc->pPipelineShaderIndices[index] < pDesc->mShaderCount);
+        *ppShaderProgram = pDesc->ppShaders[pDesc->pPipelineShaderIndices[index]];
+    }
+    if (ppRootSignature && !*ppRootSignature)
+    {
+        *ppRootSignature = pWarmUp->pRootSignature;
+    }
+
+    pDesc->ppPipelines[index] = NULL;
+    int64_t timeUs = 0;
+    // Shader or root signature failed to load, pipeline would fail as well
+    if (!ppShaderProgram || (*ppShaderProgram && *ppRootSignature))
+    {
+        const int64_t start = getUSec(true);
+        addPipeline(pWarmUp->pRenderer, &desc, &pDesc->ppPipelines[index]);
+        timeUs = getUSec(true) - start;
+    }
+
+    if (pDesc->pPipelineTimesUs)
+    {
+        pDesc->pPipelineTimesUs[index] = timeUs;
+    }
+    pipelineWarmUpReport(pWarmUp, index, desc.pName, timeUs, !pDesc->ppPipelines[index]);
+}
+
+bool warmUpPipelines(Renderer* pRenderer, const PipelineWarmUpDesc* pDesc)
+{
+    ASSERT(pRenderer);
+    ASSERT(pDesc);
+    ASSERT(!pDesc->mShaderCount || (pDesc->pShaderDescs && pDesc->ppShaders));
+    ASSERT(!pDesc->mPipelineCount || (pDesc->pPipelineDescs && pDesc->ppPipelines));
+    ASSERT(!pDesc->pRootSignatureDesc || pDesc->ppRootSignature);
+
+    const int64_t start = getUSec(false);
+
+    for (uint32_t i = 0; i < pDesc->mShaderCount; ++i)
+    {
+        pDesc->ppShaders[i] = NULL;
+    }
+    for (uint32_t i = 0; i < pDesc->mPipelineCount; ++i)
+    {
+        pDesc->ppPipelines[i] = NULL;
+    }
+
+    const uint32_t      taskCount = max(pDesc->mShaderCount, pDesc->mPipelineCount);
+    PipelineWarmUpTask* pTasks = (PipelineWarmUpTask*)tf_malloc(sizeof(PipelineWarmUpTask) * max(taskCount, 1u));
+    if (!pTasks)
+    {
+        LOGF(eERROR, "Failed to allocate %u pipeline warm-up tasks", taskCount);
+        return false;
+    }
+
+    PipelineWarmUp warmUp = {};
+    warmUp.pRenderer = pRenderer;
+    warmUp.pDesc = pDesc;
+    warmUp.mProgress.mShaderCount = pDesc->mShaderCount;
+    warmUp.mProgress.mPipelineCount = pDesc->mPipelineCount;
+    if (!initMutex(&warmUp.mMutex))
+    {
+        tf_free(pTasks);
+        return false;
+    }
+
+    ThreadSystemInitDesc threadDesc = gThreadSystemInitDescDefault;
+    threadDesc.threadCount = pDesc->mThreadCount;
+    threadDesc.threadName = "PipelineWarmUp";
+    ThreadSystem threadSystem = NULL;
+    if (!threadSystemInit(&threadSystem, &threadDesc))
+    {
+        exitMutex(&warmUp.mMutex);
+        tf_free(pTasks);
+        return false;
+    }
+
+    for (uint32_t i = 0; i < taskCount; ++i)
+    {
+        pTasks[i].pWarmUp = &warmUp;
+        pTasks[i].mIndex = i;
+    }
+
+    // Shaders first, pipelines and the root signature need all of them
+    threadSystemAddTaskGroup(threadSystem, pipelineWarmUpShaderTask, pDesc->mShaderCount, pTasks);
+    while (threadSystemAssist(threadSystem))
+        ;
+    threadSystemWaitIdle(threadSystem);
+
+    if (pDesc->pRootSignatureDesc)
+    {
+        *pDesc->ppRootSignature = NULL;
+        if (!warmUp.mFailed)
+        {
+            RootSignatureDesc rootDesc = *pDesc->pRootSignatureDesc;
+            rootDesc.ppShaders = pDesc->ppShaders;
+            rootDesc.mShaderCount = pDesc->mShaderCount;
+            addRootSignature(pRenderer, &rootDesc, pDesc->ppRootSignature);
+        }
+        warmUp.pRootSignature = *pDesc->ppRootSignature;
+        warmUp.mFailed |= !warmUp.pRootSignature;
+    }
+
+    // Externally synchronized cache can't be used by several threads at once
+    if (pDesc->pCache && (pDesc->mCacheFlags & PIPELINE_CACHE_FLAG_EXTERNALLY_SYNCHRONIZED))
+    {
+        for (uint32_t i = 0; i < pDesc->mPipelineCount; ++i)
+        {
+            pipelineWarmUpPipelineTask(&pTasks[i], 0);
+        }
+    }
+    else
+    {
+        threadSystemAddTaskGroup(threadSystem, pipelineWarmUpPipelineTask, pDesc->mPipelineCount, pTasks);
+        while (threadSystemAssist(threadSystem))
+            ;
+        threadSystemWaitIdle(threadSystem);
+    }
+
+    struct ThreadSystemInfo threadInfo = {};
+    threadSystemGetInfo(threadSystem, &threadInfo);
+    threadSystemExit(&threadSystem, &gThreadSystemExitDescDefault);
+    tf_free(pTasks);
+    exitMutex(&warmUp.mMutex);
+
+    LOGF(eINFO, "Warmed up %u shaders and %u pipelines in %.2f ms with %llu threads%s", pDesc->mShaderCount, pDesc->mPipelineCount,
+         (double)(getUSec(false) - start) / 1000.0, (unsigned long long)threadInfo.threadCount, warmUp.mFailed ? ", some failed" : "");
+
+    return !warmUp.mFailed;
+}
+/************************************************************************/
 /************************************************************************/
 
 void waitCopyQueueIdle()
@@ -28,6 +28,7 @@
 #include "../../../Utilities/ThirdParty/OpenSource/ModifiedSonyMath/vectormath.hpp"
 
 #include "../../../Utilities/Math/ShaderUtilities.h"
+#include "../../../Utilities/Math/Quantization.h"
 
 // OZZ
 #include "../../../Resources/AnimationSystem/ThirdParty/OpenSource/ozz-animation/include/ozz/animation/offline/animation_builder.h"
@@ -1323,26 +1324,19 @@ static inline void util_pack_float2_to_half2(uint32_t count, uint32_t srcStride,
                                              uint8_t* dst)
 {
     COMPILE_ASSERT(sizeof(float2) == sizeof(float[2]));
-    ASSERT(srcStride == sizeof(float2));
-    ASSERT(dstStride == sizeof(uint32_t));
+    ASSERT(srcStride >= sizeof(float2));
+    ASSERT(dstStride >= sizeof(uint32_t));
 
-    float2* f = (float2*)src;
-    for (uint32_t e = 0; e < count; ++e)
-    {
-        *(uint32_t*)(dst + e * sizeof(uint32_t) + offset) = packFloat2ToHalf2(f[e]);
-    }
+    quantizeStream(QUANTIZE_FLOAT_TO_HALF, count, 2, src, srcStride, dst + offset, dstStride);
 }
 
 static inline void util_pack_float3_direction_to_half2(uint32_t count, uint32_t srcStride, uint32_t dstStride, uint32_t offset,
                                                        const uint8_t* src, uint8_t* dst)
 {
     COMPILE_ASSERT(sizeof(float3) == sizeof(float[3]));
-    ASSERT(dstStride == sizeof(uint32_t));
-    for (uint32_t e = 0; e < count; ++e)
-    {
-        float3 f = *(float3*)(src + e * srcStride);
-        *(uint32_t*)(dst + e * dstStride + offset) = packFloat3DirectionToHalf2(f);
-    }
+    ASSERT(dstStride >= sizeof(uint32_t));
+
+    quantizeStream(QUANTIZE_DIRECTION_TO_OCT_UNORM16X2, count, 3, src, srcStride, dst + offset, dstStride);
 }
 
 static inline void util_unpack_uint8_to_uint16_joints(uint32_t count, uint32_t srcStride, uint32_t dstStride, uint32_t offset,
@@ -1350,15 +1344,7 @@ static inline void util_unpack_uint8_to_uint16_joints(uint32_t count, uint32_t s
 {
     ASSERT(srcStride == 4 && "Expecting stride of 4 (sizeof(uint8_t) * 4 joints)");
 
-    for (uint32_t e = 0; e < count; ++e)
-    {
-        const uint8_t* srcBase = (const uint8_t*)(src + e * srcStride);
-        uint16_t*      dstBase = (uint16_t*)(dst + e * dstStride + offset);
-        dstBase[0] = srcBase[0];
-        dstBase[1] = srcBase[1];
-        dstBase[2] = srcBase[2];
-        dstBase[3] = srcBase[3];
-    }
+    quantizeStream(QUANTIZE_UINT8_TO_UINT16, count, 4, src, srcStride, dst + offset, dstStride);
 }
 
 void OnGLTFFind(ResourceDirectory resourceDir, const char* filename, void* pUserData)
@@ -2232,40 +2218,84 @@ bool ProcessGLTF(AssetPipelineParams* assetParams, ProcessGLTFParams* glTFParams
         }
         else
         {
-            fsWriteToStream(&fStream, GEOMETRY_FILE_MAGIC_STR, sizeof(GEOMETRY_FILE_MAGIC_STR));
+            // Sections are written in GeometryFileSection order, the loader reads each of them with one call
+            const uint64_t meshletsSize = geom->meshlets.mMeshletCount
+                                              ? geom->meshlets.mMeshletCount * (sizeof(*geom->meshlets.mMeshlets) +
+                                                                                sizeof(*geom->meshlets.mMeshletsData)) +
+                                                    geom->meshlets.mVertexCount * sizeof(*geom->meshlets.mVertices) +
+                                                    geom->meshlets.mTriangleCount * sizeof(*geom->meshlets.mTriangles)
+                                              : 0;
 
-            fsWriteToStream(&fStream, &totalGeomSize, sizeof(uint32_t));
-            fsWriteToStream(&fStream, geom, totalGeomSize);
+            GeometryFileHeader header = {};
+            memcpy(header.mMagic, GEOMETRY_FILE_MAGIC_STR, sizeof(header.mMagic));
+            memcpy(header.mVersion, &GEOMETRY_FILE_VERSION, sizeof(header.mVersion));
+            header.mSectionSizes[GEOMETRY_FILE_SECTION_GEOMETRY] = totalGeomSize;
+            header.mSectionSizes[GEOMETRY_FILE_SECTION_MESHLETS] = meshletsSize;
+            header.mSectionSizes[GEOMETRY_FILE_SECTION_GEOMETRY_DATA] = totalGeomDataSize;
+            header.mSectionSizes[GEOMETRY_FILE_SECTION_SHADOW] = shadowSize;
+
+            uint64_t sectionOffset = round_up_64(sizeof(header), 16);
+            for (uint32_t i = 0; i < GEOMETRY_FILE_SECTION_COUNT; ++i)
+            {
+                header.mSectionOffsets[i] = sectionOffset;
+                sectionOffset = round_up_64(sectionOffset + header.mSectionSizes[i], 16);
+            }
 
             // Write null values to file since the pointers are set afterwars
             GeometryData::ShadowData* pTempShadow = geomData->pShadow;
             void*                     pTempUserData = geomData->pUserData;
             geomData->pShadow = NULL;
             geomData->pUserData = NULL;
-            fsWriteToStream(&fStream, &totalGeomDataSize, sizeof(uint32_t));
-            fsWriteToStream(&fStream, geomData, totalGeomDataSize);
-            geomData->pShadow = pTempShadow;
-            geomData->pUserData = pTempUserData;
 
-            fsWriteToStream(&fStream, &shadowSize, sizeof(uint32_t));
-            fsWriteToStream(&fStream, geomData->pShadow, shadowSize);
-
-            if (geom->meshlets.mMeshletCount)
-            {
-                if (fsWriteToStream(&fStream, geom->meshlets.mMeshlets, sizeof(*geom->meshlets.mMeshlets) * geom->meshlets.mMeshletCount) !=
-                        sizeof(*geom->meshlets.mMeshlets) * geom->meshlets.mMeshletCount ||
-                    fsWriteToStream(&fStream, geom->meshlets.mMeshletsData,
-                                    sizeof(*geom->meshlets.mMeshletsData) * geom->meshlets.mMeshletCount) !=
-                        sizeof(*geom->meshlets.mMeshletsData) * geom->meshlets.mMeshletCount ||
-                    fsWriteToStream(&fStream, geom->meshlets.mVertices, sizeof(*geom->meshlets.mVertices) * geom->meshlets.mVertexCount) !=
-                        sizeof(*geom->meshlets.mVertices) * geom->meshlets.mVertexCount ||
-                    fsWriteToStream(&fStream, geom->meshlets.mTriangles,
-                                    sizeof(*geom->meshlets.mTriangles) * geom->meshlets.mTriangleCount) !=
-                        sizeof(*geom->meshlets.mTriangles) * geom->meshlets.mTriangleCount)
+            struct
+            {
+                const void* pData;
+                uint64_t    mSize;
+            } sectionParts[] = {
+                { &header, sizeof(header) },
+                { geom, totalGeomSize },
+                { geom->meshlets.mMeshlets, sizeof(*geom->meshlets.mMeshlets) * geom->meshlets.mMeshletCount },
+                { geom->meshlets.mMeshletsData, sizeof(*geom->meshlets.mMeshletsData) * geom->meshlets.mMeshletCount },
+                { geom->meshlets.mVertices, sizeof(*geom->meshlets.mVertices) * geom->meshlets.mVertexCount },
+                { geom->meshlets.mTriangles, sizeof(*geom->meshlets.mTriangles) * geom->meshlets.mTriangleCount },
+                { geomData, totalGeomDataSize },
+                { pTempShadow, shadowSize },
+            };
+            // Padding is written before the part which starts a section
+            const uint32_t sectionStarts[] = { 1, 2, 6, 7 };
+            COMPILE_ASSERT(TF_ARRAY_COUNT(sectionStarts) == GEOMETRY_FILE_SECTION_COUNT);
+
+            const uint8_t zeros[16] = {};
+            uint64_t      writtenSize = 0;
+            uint32_t      section = 0;
+            bool          writeError = false;
+            for (uint32_t i = 0; i < TF_ARRAY_COUNT(sectionParts) && !writeError; ++i)
+            {
+                if (section < GEOMETRY_FILE_SECTION_COUNT && sectionStarts[section] == i)
                 {
-                    LOGF(eERROR, "Failed to write stream '%s'.", newFileName);
-                    error = true;
+                    const uint64_t padding = header.mSectionOffsets[section++] - writtenSize;
+                    if ((uint64_t)fsWriteToStream(&fStream, zeros, (size_t)padding) != padding)
+                    {
+                        writeError = true;
+                    }
+                    writtenSize += padding;
+                }
+
+                if (sectionParts[i].mSize && (uint64_t)fsWriteToStream(&fStream, sectionParts[i].pData, (size_t)sectionParts[i].mSize) !=
+                                                 sectionParts[i].mSize)
+                {
+                    writeError = true;
                 }
+                writtenSize += sectionParts[i].mSize;
+            }
+
+            geomData->pShadow = pTempShadow;
+            geomData->pUserData = pTempUserData;
+
+            if (writeError)
+            {
+                LOGF(eERROR, "Failed to write stream '%s'.", newFileName);
+                error = true;
             }
 
             if (!fsCloseStream(&fStream))
@@ -41,6 +41,12 @@
 #include "../../Utilities/ThirdParty/OpenSource/lz4/lz4hc.h"
 #include "../../Utilities/ThirdParty/OpenSource/zstd/zstd.h"
 #include "../../Utilities/ThirdParty/OpenSource/zstd/zstd_errors.h"
+// XXH64_state_t definition
+#define XXH_STATIC_LINKING_ONLY
+#include "../../Utilities/ThirdParty/OpenSource/zstd/common/xxhash.h"
+
+// Buffer for hashing input files and copying data of unchanged files
+#define BUNYAR_LIB_COPY_BUFFER_SIZE (1024 * 1024)
 
 ////////////////////////////////////////////////////////////////////////////////
 /// Function bunyArLibCreate (part one)                                     ///
@@ -243,6 +249,24 @@ static int bunyArLibEntryDescCmp(const void* v0, const void* v1)
     return strcmp(e0->outputName, e1->outputName);
 }
 
+struct BunyArLibLayoutKey
+{
+    // position in layout order, UINT64_MAX if entry is not listed
+    uint64_t rank;
+    // position in name order
+    uint64_t index;
+};
+
+// Sorts by rank, entries with equal rank keep name order
+static int bunyArLibLayoutKeyCmp(const void* v0, const void* v1)
+{
+    const struct BunyArLibLayoutKey* k0 = (const struct BunyArLibLayoutKey*)v0;
+    const struct BunyArLibLayoutKey* k1 = (const struct BunyArLibLayoutKey*)v1;
+    if (k0->rank != k1->rank)
+        return k0->rank < k1->rank ? -1 : 1;
+    return k0->index < k1->index ? -1 : (k0->index > k1->index);
+}
+
 static bool bunyArLibCreatePreprocessDesc(const struct BunyArLibCreateDesc* inDesc, struct BunyArLibCreateDesc* outDesc, char*** strings)
 {
     *outDesc = *inDesc;
@@ -403,12 +427,90 @@ static void bunyArLibCreatePostprocessDesc(struct BunyArLibCreateDesc* desc, cha
     *strings = NULL;
 }
 
+// Entries are sorted by name at this point.
+// Reorders them into write order, 'index' keeps position of the entry in name order.
+static bool bunyArLibApplyLayoutOrder(struct BunyArLibCreateDesc* desc)
+{
+    for (uint64_t i = 0; i < desc->entryCount; ++i)
+        desc->entries[i].index = i;
+
+    if (!desc->layoutOrderCount || !desc->entryCount)
+        return true;
+
+    struct BunyArLibLayoutKey*       keys = (struct BunyArLibLayoutKey*)tf_malloc(sizeof(*keys) * desc->entryCount);
+    struct BunyArLibEntryCreateDesc* sorted =
+        (struct BunyArLibEntryCreateDesc*)tf_malloc(sizeof(*sorted) * desc->entryCount);
+    if (!keys || !sorted)
+    {
+        tf_free(keys);
+        tf_free(sorted);
+        return false;
+    }
+
+    for (uint64_t i = 0; i < desc->entryCount; ++i)
+        keys[i] = (struct BunyArLibLayoutKey){ UINT64_MAX, i };
+
+    uint64_t found = 0;
+    for (uint64_t li = 0; li < desc->layoutOrderCount; ++li)
+    {
+        struct BunyArLibEntryCreateDesc key = { 0 };
+        key.outputName = desc->layoutOrder[li];
+
+        const struct BunyArLibEntryCreateDesc* entry = (const struct BunyArLibEntryCreateDesc*)bsearch(
+            &key, desc->entries, (size_t)desc->entryCount, sizeof(*desc->entries), bunyArLibEntryDescCmp);
+
+        // unknown names and repeated names are skipped
+        if (!entry || keys[entry->index].rank != UINT64_MAX)
+            continue;
+
+        keys[entry->index].rank = li;
+        ++found;
+    }
+
+    qsort(keys, (size_t)desc->entryCount, sizeof(*keys), bunyArLibLayoutKeyCmp);
+
+    for (uint64_t i = 0; i < desc->entryCount; ++i)
+        sorted[i] = desc->entries[keys[i].index];
+
+    memcpy(desc->entries, sorted, sizeof(*sorted) * desc->entryCount);
+
+    if (desc->verbose)
+    {
+        fprintf(stdout, "Layout order: %llu of %llu files placed first\n", (unsigned long long)found, (unsigned long long)desc->entryCount);
+    }
+
+    tf_free(sorted);
+    tf_free(keys);
+    return true;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// Function bunyArLibCreate (part two)                                     ///
 /// Second step.                                                             ///
 /// Prepare archive metadata                                                 ///
 ////////////////////////////////////////////////////////////////////////////////
 
+struct BunyArLibDictionary
+{
+    uint8_t*    content;
+    uint64_t    size;
+    ZSTD_CDict* cdict;
+};
+
+struct BunyArLibReusedNode
+{
+    // compressed file data inside previous archive
+    struct BunyArPointer64 data;
+    uint64_t               fileSize;
+};
+
+struct BunyArLibDuplicateNode
+{
+    // index + 1 of the entry which data is stored, 0 if entry is not a duplicate
+    uint64_t original;
+    uint64_t fileSize;
+};
+
 struct BunyArLibCreateMetadata
 {
     uint64_t                nodeCount;
@@ -419,6 +521,23 @@ struct BunyArLibCreateMetadata
     uint32_t                namesSize;
     bool                    lz4Used;
     bool                    zstdUsed;
+
+    // node format refers to dictionaries[BUNYAR_NODE_DICTIONARY(format) - 1]
+    uint32_t                    dictionaryCount;
+    struct BunyArLibDictionary* dictionaries;
+
+    // XXH64 of original content, same order as nodes
+    uint64_t* contentHashes;
+
+    // Entries copied from previous archive, NULL if there is no previous archive.
+    // Entry is not reused if data.size is 0
+    struct BunyArLibReusedNode* reusedNodes;
+    uint64_t                    reusedCount;
+    FileStream                  previousArchive;
+
+    // Entries with the same content as an earlier entry, NULL if there are none
+    struct BunyArLibDuplicateNode* duplicateNodes;
+    uint64_t                       duplicateCount;
 };
 
 // TODO experiment with this
@@ -438,6 +557,16 @@ static uint32_t convertBlockSize(enum BunyArFileFormat format, uint32_t blockSiz
 
 static void bunyArLibCreateMetadataDestroy(struct BunyArLibCreateMetadata* md)
 {
+    for (uint32_t i = 0; i < md->dictionaryCount; ++i)
+    {
+        ZSTD_freeCDict(md->dictionaries[i].cdict);
+        tf_free(md->dictionaries[i].content);
+    }
+    arrfree(md->dictionaries);
+    fsCloseStream(&md->previousArchive);
+    tf_free(md->reusedNodes);
+    tf_free(md->duplicateNodes);
+    tf_free(md->contentHashes);
     tf_free(md->nodes);
     tf_free(md->names);
     tf_free(md->hashTable);
@@ -449,7 +578,8 @@ static bool bunyArLibCreateMetadataDetail(const struct BunyArLibCreateDesc* desc
     md->nodeCount = desc->entryCount;
 
     md->nodes = (struct BunyArNode*)tf_calloc(1, (sizeof(*md->nodes)) * md->nodeCount);
-    if (!md->nodes)
+    md->contentHashes = (uint64_t*)tf_calloc(1, sizeof(*md->contentHashes) * md->nodeCount);
+    if (!md->nodes || !md->contentHashes)
         return false;
 
     md->maxBlockSize = 0;
@@ -609,6 +739,9 @@ struct FileAssemblyLine
 
     tfrg_atomic32_t readStatusId_Atomic32;
 
+    XXH64_state_t contentHashState;
+    uint64_t      contentHash;
+
     bool error;
 
     bool writeComplete;
@@ -640,6 +773,8 @@ struct ThreadsSharedMemory
 
     struct CompressionContext* compressionContexts;
 
+    const struct BunyArLibCreateMetadata* md;
+
     tfrg_atomic64_t priorityEntryIndex_Atomic64;
 
     uint64_t                 maxAssemblyLines;
@@ -820,8 +955,8 @@ static void compressionContextDestroy(struct CompressionContext* ctx)
     memset(ctx, 0, sizeof *ctx);
 }
 
-static bool bunyArLibTaskCompress(struct CompressionContext* ctx, enum BunyArFileFormat format, int compressionLevel, const void* src,
-                                  uint64_t size, void* dst,
+static bool bunyArLibTaskCompress(struct CompressionContext* ctx, enum BunyArFileFormat format, int compressionLevel,
+                                  const ZSTD_CDict* dictionary, const void* src, uint64_t size, void* dst,
                                   uint64_t* dstLimitAndOutSize) // UINT64_MAX if not fit
 {
     if (size == 0)
@@ -852,7 +987,9 @@ static bool bunyArLibTaskCompress(struct CompressionContext* ctx, enum BunyArFil
     }
     case BUNYAR_FILE_FORMAT_ZSTD_BLOCKS:
     {
-        size_t compressedSize = ZSTD_compressCCtx(ctx->zstdCtx, dst, *dstLimitAndOutSize, src, size, compressionLevel);
+        // compression level is baked into dictionary
+        size_t compressedSize = dictionary ? ZSTD_compress_usingCDict(ctx->zstdCtx, dst, *dstLimitAndOutSize, src, size, dictionary)
+                                           : ZSTD_compressCCtx(ctx->zstdCtx, dst, *dstLimitAndOutSize, src, size, compressionLevel);
 
         ZSTD_ErrorCode error = ZSTD_getErrorCode(compressedSize);
 
@@ -877,206 +1014,924 @@ static bool bunyArLibTaskCompress(struct CompressionContext* ctx, enum BunyArFil
     }
 }
 
-static bool tf_seek(FileStream* fs, size_t pos) { return fsSeekStream(fs, SBO_START_OF_FILE, (ssize_t)pos); }
+////////////////////////////////////////////////////////////////////////////////
+/// Function bunyArLibCreate (dictionaries)                                 ///
+/// Small files share zstd dictionaries built from their content.           ///
+/// Dictionaries are raw content: samples of files from the same group,     ///
+/// concatenated. Group is a file extension + compression level pair.       ///
+////////////////////////////////////////////////////////////////////////////////
 
-static bool tf_write(FileStream* fs, size_t size, void* data)
+// Groups with less files don't get a dictionary
+#define BUNYAR_LIB_DICTIONARY_MIN_FILES   8
+#define BUNYAR_LIB_DICTIONARY_MIN_SIZE    1024
+#define BUNYAR_LIB_DICTIONARY_SAMPLE_SIZE 4096
+
+struct BunyArLibDictionaryCandidate
 {
-    size_t read = fsWriteToStream(fs, data, size);
-    if (read != size)
-    {
-        LOGF(eERROR,
-             "Failed to write %llu bytes to archive stream. %llu bytes written. "
-             "Stream position is %lli",
-             (unsigned long long)size, (unsigned long long)read, (long long)fsGetStreamSeekPosition(fs));
-        return false;
-    }
-    return true;
+    const struct BunyArLibEntryCreateDesc* entry;
+    const char*                            extension;
+    uint64_t                               entryIndex;
+    uint64_t                               fileSize;
+};
+
+static const char* bunyArLibFileExtension(const char* name)
+{
+    const char* ext = strrchr(name, '.');
+    if (!ext || strchr(ext, '/'))
+        return "";
+    return ext + 1;
 }
 
-static bool initializeEntryBlockStream(enum BunyArFileFormat format, uint32_t blockSizeKb, uint64_t fileSize,
-                                       struct BunyArBlockFormatHeader* dstHeader, BunyArBlockPointer** dstBlocks,
-                                       uint64_t* outBlocksWithHeaderSize)
+static int bunyArLibDictionaryCandidateCmp(const void* v0, const void* v1)
 {
-    memset(dstHeader, 0, sizeof *dstHeader);
-    *outBlocksWithHeaderSize = 0;
+    const struct BunyArLibDictionaryCandidate* c0 = (const struct BunyArLibDictionaryCandidate*)v0;
+    const struct BunyArLibDictionaryCandidate* c1 = (const struct BunyArLibDictionaryCandidate*)v1;
+
+    int cmp = strcmp(c0->extension, c1->extension);
+    if (cmp)
+        return cmp;
+    if (c0->entry->compressionLevel != c1->entry->compressionLevel)
+        return c0->entry->compressionLevel < c1->entry->compressionLevel ? -1 : 1;
+    return c0->entryIndex < c1->entryIndex ? -1 : (c0->entryIndex > c1->entryIndex);
+}
 
-    switch (format)
-    {
-    case BUNYAR_FILE_FORMAT_LZ4_BLOCKS:
-    case BUNYAR_FILE_FORMAT_ZSTD_BLOCKS:
-        break;
-    default:
+static bool bunyArLibGetFileSize(const struct BunyArLibEntryCreateDesc* entry, uint64_t* outSize)
+{
+    FileStream fs = { 0 };
+    if (!fsOpenStreamFromPath(entry->inputRd, entry->inputPath, FM_READ | FM_ALLOW_READ, &fs))
+        return false;
+    ssize_t size = fsGetStreamFileSize(&fs);
+    fsCloseStream(&fs);
+    *outSize = size > 0 ? (uint64_t)size : 0;
+    return size >= 0;
+}
+
+// Fills dictionary content with samples from the group, spread evenly over it
+static bool bunyArLibSampleDictionary(const struct BunyArLibDictionaryCandidate* group, uint64_t count, uint64_t totalSize,
+                                      uint64_t dictionarySizeLimit, struct BunyArLibDictionary* dictionary)
+{
+    // Dictionary can not cover the whole group, otherwise it is no better than a solid archive
+    uint64_t size = totalSize / 4 < dictionarySizeLimit ? totalSize / 4 : dictionarySizeLimit;
+    if (size < BUNYAR_LIB_DICTIONARY_MIN_SIZE)
         return true;
-    }
 
-    uint64_t blockSize = convertBlockSize(format, blockSizeKb);
-    uint64_t blockCount = fileSize / blockSize + ((fileSize % blockSize) > 0);
-    size_t   blocksSize = sizeof(BunyArBlockPointer) * blockCount;
+    uint64_t sampleSize = size / count;
+    if (sampleSize < BUNYAR_LIB_DICTIONARY_SAMPLE_SIZE)
+        sampleSize = BUNYAR_LIB_DICTIONARY_SAMPLE_SIZE;
 
-    if (blockCount)
+    uint64_t sampleCount = size / sampleSize + 1;
+    uint64_t step = count > sampleCount ? count / sampleCount : 1;
+
+    dictionary->content = (uint8_t*)tf_malloc(size);
+    if (!dictionary->content)
+        return false;
+
+    for (uint64_t i = 0; i < count && dictionary->size < size; i += step)
     {
-        void* mem = *dstBlocks;
-        *dstBlocks = (BunyArBlockPointer*)tf_realloc(mem, blocksSize);
-        if (!*dstBlocks)
+        const struct BunyArLibEntryCreateDesc* entry = group[i].entry;
+
+        uint64_t readSize = group[i].fileSize < sampleSize ? group[i].fileSize : sampleSize;
+        if (readSize > size - dictionary->size)
+            readSize = size - dictionary->size;
+
+        FileStream fs = { 0 };
+        if (!fsOpenStreamFromPath(entry->inputRd, entry->inputPath, FM_READ | FM_ALLOW_READ, &fs))
         {
-            tf_free(mem);
+            LOGF(eERROR, "Failed to open file '%s' for dictionary sampling", entry->inputPath);
             return false;
         }
-    }
 
-    *outBlocksWithHeaderSize = sizeof(struct BunyArBlockFormatHeader) + blocksSize;
+        dictionary->size += fsReadFromStream(&fs, dictionary->content + dictionary->size, readSize);
+        fsCloseStream(&fs);
+    }
 
-    dstHeader->blockSize = blockSize;
-    dstHeader->blockSizeLast = fileSize - (fileSize / blockSize) * blockSize;
-    if (dstHeader->blockSizeLast == 0)
-        dstHeader->blockSizeLast = blockSize;
-    dstHeader->blockCount = blockCount;
     return true;
 }
 
-// Writes archive file. Gets compressed file data through 'packetIo'.
-// It just writes data given by 'packetIo' for each node one by one.
-static bool bunyArLibArchiveWrite(ResourceDirectory rd, const char* dstPath, struct bunyArLibPacketIo packetIo,
-                                  const struct BunyArLibCreateDesc* desc, struct BunyArLibCreateMetadata* md)
+static bool bunyArLibCreateDictionaries(const struct BunyArLibCreateDesc* desc, struct BunyArLibCreateMetadata* md)
 {
-    enum BunyArLibWriteResult
-    {
-        BUNYAR_LIB_RESULT_SUCCESS,
-        BUNYAR_LIB_RESULT_OUTPUT_ERROR,
-        BUNYAR_LIB_RESULT_INPUT_ERROR,
-        BUNYAR_LIB_RESULT_COMPRESSION_ERROR,
-        BUNYAR_LIB_RESULT_MEMORY_ERROR,
-    };
-
-    FileStream archiveFs = { 0 };
-    if (!fsOpenStreamFromPath(rd, dstPath, FM_WRITE, &archiveFs))
-    {
-        LOGF(eERROR, "Failed to create/open archive file '%s'", dstPath);
-        return false;
-    }
-
-    enum BunyArLibWriteResult result = BUNYAR_LIB_RESULT_SUCCESS;
+    if (!desc->dictionaryFileSizeLimitKb)
+        return true;
 
-    uint64_t offset = sizeof(struct BunyArHeader) + desc->entryCount * sizeof(struct BunyArNode) + md->namesSize;
+    uint64_t fileSizeLimit = (uint64_t)desc->dictionaryFileSizeLimitKb * 1024;
+    uint64_t dictionarySizeLimit = desc->dictionarySizeKb ? (uint64_t)desc->dictionarySizeKb * 1024 : 64 * 1024;
 
-    uint64_t           filesDone = 0;
-    struct BunyArNode* refNode = NULL;
-    uint64_t           blockIndex = 0;
+    struct BunyArLibDictionaryCandidate* candidates = NULL;
 
-    uint64_t                       blockMetadataSize = 0;
-    struct BunyArBlockFormatHeader blocksHeader = { 0 };
-    BunyArBlockPointer*            blockPointers = NULL;
+    bool success = true;
 
-    size_t totalFilesSize = 0;
+    for (uint64_t i = 0; i < desc->entryCount; ++i)
+    {
+        const struct BunyArLibEntryCreateDesc* entry = desc->entries + i;
+        if (entry->format != BUNYAR_FILE_FORMAT_ZSTD_BLOCKS || (md->reusedNodes && md->reusedNodes[i].data.size) ||
+            (md->duplicateNodes && md->duplicateNodes[i].original))
+            continue;
 
-    int counterWidth = 0;
+        struct BunyArLibDictionaryCandidate candidate = { entry, bunyArLibFileExtension(entry->outputName), i, 0 };
+        if (!bunyArLibGetFileSize(entry, &candidate.fileSize))
+        {
+            LOGF(eERROR, "Failed to get size of file '%s'", entry->inputPath);
+            success = false;
+            break;
+        }
 
-    if (desc->verbose)
-    {
-        char buffer[32];
-        counterWidth = snprintf(buffer, sizeof buffer, "%llu", (unsigned long long)md->nodeCount);
+        if (candidate.fileSize && candidate.fileSize <= fileSizeLimit)
+            arrpush(candidates, candidate);
     }
 
-    int64_t time = getUSec(true);
+    uint64_t candidateCount = arrlenu(candidates);
 
-    int prevPrintedLen = 0;
+    if (success && candidateCount)
+        qsort(candidates, (size_t)candidateCount, sizeof *candidates, bunyArLibDictionaryCandidateCmp);
 
-    struct FileAssemblyLine* file = NULL;
-    struct FileBlock*        block = NULL;
-    for (; packetIo.receive(packetIo.pUser, &file, &block); releaseFileBlock(file, block), ++blockIndex)
+    for (uint64_t groupBeg = 0, groupEnd = 0; success && groupBeg < candidateCount; groupBeg = groupEnd)
     {
-        if (!file)
+        const struct BunyArLibDictionaryCandidate* group = candidates + groupBeg;
+
+        uint64_t totalSize = 0;
+        for (groupEnd = groupBeg; groupEnd < candidateCount; ++groupEnd)
         {
-            if (!block)
-            {
-                result = BUNYAR_LIB_RESULT_MEMORY_ERROR;
+            const struct BunyArLibDictionaryCandidate* c = candidates + groupEnd;
+            if (strcmp(c->extension, group->extension) != 0 || c->entry->compressionLevel != group->entry->compressionLevel)
                 break;
-            }
-
-            file = block->asmLine;
+            totalSize += c->fileSize;
         }
 
-        struct BunyArNode* node = md->nodes + file->entryIndex;
-        if (refNode != node)
-        {
-            if (refNode || (block && blockIndex != block->blockIndex))
-            {
-                LOGF(eERROR, "Received unexpected file block");
-                result = BUNYAR_LIB_RESULT_INPUT_ERROR;
-                break;
-            }
+        uint64_t count = groupEnd - groupBeg;
+        if (count < BUNYAR_LIB_DICTIONARY_MIN_FILES)
+            continue;
 
-            node->filePointer.offset = offset;
-            node->originalFileSize = file->fsize;
+        struct BunyArLibDictionary dictionary = { 0 };
+        success = bunyArLibSampleDictionary(group, count, totalSize, dictionarySizeLimit, &dictionary);
 
-            totalFilesSize += file->fsize;
+        if (success && dictionary.size)
+        {
+            ZSTD_compressionParameters params = ZSTD_getCParams(group->entry->compressionLevel, totalSize / count, dictionary.size);
 
-            if (!block)
-                node->format = BUNYAR_FILE_FORMAT_RAW;
+            dictionary.cdict = ZSTD_createCDict_advanced(dictionary.content, dictionary.size, ZSTD_dlm_byRef, ZSTD_dct_rawContent, params,
+                                                         ZSTD_MEMORY_ALLOCATOR);
+            success = dictionary.cdict != NULL;
+        }
 
-            prevPrintedLen = 0;
+        if (!success || !dictionary.size)
+        {
+            ZSTD_freeCDict(dictionary.cdict);
+            tf_free(dictionary.content);
+            continue;
+        }
 
-            if (desc->verbose)
-            {
-                prevPrintedLen += fprintf(stdout, "%*llu/%*llu ", counterWidth, (unsigned long long)file->entryIndex + 1, counterWidth,
-                                          (unsigned long long)md->nodeCount);
+        arrpush(md->dictionaries, dictionary);
+        md->dictionaryCount = (uint32_t)arrlenu(md->dictionaries);
 
-                const char* name = md->names + node->namePointer.offset;
+        for (uint64_t i = 0; i < count; ++i)
+            md->nodes[group[i].entryIndex].format = BUNYAR_NODE_FORMAT_MAKE(BUNYAR_FILE_FORMAT_ZSTD_BLOCKS, md->dictionaryCount);
 
-                prevPrintedLen += (int)utf8_strlen(name) + 1;
-                fprintf(stdout, "'%s'", name);
+        if (desc->verbose > 1)
+        {
+            fprintf(stdout, "Dictionary #%u for %llu '%s' files: %s\n", md->dictionaryCount, (unsigned long long)count, group->extension,
+                    humanReadableSize(dictionary.size).str);
+        }
+    }
 
-                if (desc->verbose > 1)
-                {
-                    prevPrintedLen += fprintf(stdout, " %s", humanReadableSize(file->fsize).str);
+    arrfree(candidates);
 
-                    if (node->format != BUNYAR_FILE_FORMAT_RAW)
-                    {
-                        prevPrintedLen += fprintf(stdout, " | %s %i\n", bunyArFormatName((enum BunyArFileFormat)node->format),
-                                                  file->entry->compressionLevel);
-                    }
-                    else
-                    {
-                        prevPrintedLen += fprintf(stdout, " %s\n", bunyArFormatName(BUNYAR_FILE_FORMAT_RAW));
-                    }
-                }
-                else
-                {
-                    putc('\n', stdout);
-                    ++prevPrintedLen;
-                }
-            }
+    if (!success)
+        LOGF(eERROR, "Failed to create archive dictionaries");
+    return success;
+}
 
-            if (!initializeEntryBlockStream((enum BunyArFileFormat)node->format, file->entry->blockSizeKb, file->fsize, &blocksHeader,
-                                            &blockPointers, &blockMetadataSize))
-            {
-                result = BUNYAR_LIB_RESULT_MEMORY_ERROR;
-                break;
-            }
+////////////////////////////////////////////////////////////////////////////////
+/// Function bunyArLibCreate (archive update)                               ///
+/// Finds entries which are unchanged since the previous archive version.   ///
+/// Their compressed data is copied by archive writer as is.                ///
+////////////////////////////////////////////////////////////////////////////////
 
-            offset += blockMetadataSize;
+struct BunyArLibPreviousArchive
+{
+    uint64_t           nodeCount;
+    struct BunyArNode* nodes;
+    char*              names;
+    uint64_t*          contentHashes;
+};
 
-            node->filePointer.size += blockMetadataSize;
+static bool bunyArLibReadAt(FileStream* fs, uint64_t offset, void* dst, uint64_t size)
+{
+    return fsSeekStream(fs, SBO_START_OF_FILE, (ssize_t)offset) && fsReadFromStream(fs, dst, (size_t)size) == size;
+}
 
-            if (!tf_seek(&archiveFs, offset))
-            {
-                result = BUNYAR_LIB_RESULT_OUTPUT_ERROR;
-                break;
-            }
+static bool bunyArLibCopyData(FileStream* src, struct BunyArPointer64 data, FileStream* dst, uint8_t* buffer, uint64_t bufferSize)
+{
+    if (!fsSeekStream(src, SBO_START_OF_FILE, (ssize_t)data.offset))
+        return false;
 
-            refNode = node;
-        }
+    for (uint64_t done = 0; done < data.size;)
+    {
+        size_t size = (size_t)(data.size - done < bufferSize ? data.size - done : bufferSize);
+        if (fsReadFromStream(src, buffer, size) != size || fsWriteToStream(dst, buffer, size) != size)
+            return false;
+        done += size;
+    }
+    return true;
+}
 
-        size_t sizeToWrite = 0;
-        void*  src = NULL;
+static void bunyArLibPreviousArchiveDestroy(struct BunyArLibPreviousArchive* prev)
+{
+    tf_free(prev->nodes);
+    tf_free(prev->names);
+    tf_free(prev->contentHashes);
+    memset(prev, 0, sizeof(*prev));
+}
 
-        if (blocksHeader.blockSize)
-        {
-            if (!block || !blockPointers)
-            {
-                result = BUNYAR_LIB_RESULT_MEMORY_ERROR;
-                break;
-            }
+// Leaves 'prev' empty if previous archive has no content hashes
+static bool bunyArLibPreviousArchiveLoad(FileStream* fs, const char* path, struct BunyArLibPreviousArchive* prev)
+{
+    struct BunyArHeader header = { 0 };
+    if (!bunyArLibReadAt(fs, 0, &header, BUNYAR_HEADER_BASE_SIZE))
+    {
+        LOGF(eERROR, "Failed to read header of previous archive '%s'", path);
+        return false;
+    }
+
+    // Optional fields up to the stored header size, see BunyArHeader
+    uint64_t headerSize = header.nodesPointer.offset < sizeof(header) ? header.nodesPointer.offset : sizeof(header);
+    if (headerSize > BUNYAR_HEADER_BASE_SIZE &&
+        fsReadFromStream(fs, (uint8_t*)&header + BUNYAR_HEADER_BASE_SIZE, (size_t)(headerSize - BUNYAR_HEADER_BASE_SIZE)) !=
+            headerSize - BUNYAR_HEADER_BASE_SIZE)
+    {
+        LOGF(eERROR, "Failed to read header of previous archive '%s'", path);
+        return false;
+    }
+
+    if (memcmp(header.magic, BUNYAR_MAGIC, sizeof(header.magic)) != 0 || header.version.compatible != 0 ||
+        header.nodesPointer.offset < bunyArHeaderRequiredSize(header.flags))
+    {
+        LOGF(eERROR, "Previous archive '%s' has unsupported format", path);
+        return false;
+    }
+
+    if (!(header.flags & BUNYAR_HEADER_FLAG_CONTENT_HASHES))
+    {
+        LOGF(eWARNING, "Previous archive '%s' has no content hashes, all files are compressed again", path);
+        return true;
+    }
+
+    uint64_t nodeCount = header.nodesPointer.size / sizeof(struct BunyArNode);
+    uint64_t namesSize = header.namesPointer.size;
+    uint64_t archiveSize = (uint64_t)fsGetStreamFileSize(fs);
+
+    if (header.contentHashesPointer.size != nodeCount * sizeof(uint64_t))
+    {
+        LOGF(eERROR, "Previous archive '%s' has invalid content hash table", path);
+        return false;
+    }
+
+    prev->nodes = (struct BunyArNode*)tf_malloc(header.nodesPointer.size + 1);
+    prev->names = (char*)tf_malloc(namesSize + 1);
+    prev->contentHashes = (uint64_t*)tf_malloc(header.contentHashesPointer.size + 1);
+
+    bool success = prev->nodes && prev->names && prev->contentHashes &&
+                   bunyArLibReadAt(fs, header.nodesPointer.offset, prev->nodes, header.nodesPointer.size) &&
+                   bunyArLibReadAt(fs, header.namesPointer.offset, prev->names, namesSize) &&
+                   bunyArLibReadAt(fs, header.contentHashesPointer.offset, prev->contentHashes, header.contentHashesPointer.size);
+
+    if (success)
+        prev->names[namesSize] = 0;
+
+    for (uint64_t i = 0; success && i < nodeCount; ++i)
+    {
+        const struct BunyArNode* node = prev->nodes + i;
+
+        success = (uint64_t)node->namePointer.offset + node->namePointer.size < namesSize + 1 &&
+                  prev->names[node->namePointer.offset + node->namePointer.size] == 0 &&
+                  node->filePointer.offset + node->filePointer.size <= archiveSize;
+    }
+
+    if (!success)
+    {
+        LOGF(eERROR, "Failed to read metadata of previous archive '%s'", path);
+        bunyArLibPreviousArchiveDestroy(prev);
+        return false;
+    }
+
+    prev->nodeCount = nodeCount;
+    return true;
+}
+
+// Archive nodes are sorted by name
+static const struct BunyArNode* bunyArLibPreviousArchiveFind(const struct BunyArLibPreviousArchive* prev, const char* name)
+{
+    uint64_t beg = 0;
+    uint64_t end = prev->nodeCount;
+    while (beg < end)
+    {
+        uint64_t mid = beg + (end - beg) / 2;
+        int      cmp = strcmp(name, prev->names + prev->nodes[mid].namePointer.offset);
+        if (cmp == 0)
+            return prev->nodes + mid;
+        if (cmp < 0)
+            end = mid;
+        else
+            beg = mid + 1;
+    }
+    return NULL;
+}
+
+// Hashes file content only if file size is equal to 'expectedSize'
+static bool bunyArLibHashFile(const struct BunyArLibEntryCreateDesc* entry, uint64_t expectedSize, uint8_t* buffer, uint64_t* outSize,
+                              uint64_t* outHash)
+{
+    FileStream fs = { 0 };
+    if (!fsOpenStreamFromPath(entry->inputRd, entry->inputPath, FM_READ | FM_ALLOW_READ, &fs))
+        return false;
+
+    ssize_t fileSize = fsGetStreamFileSize(&fs);
+    bool    success = fileSize >= 0;
+
+    *outSize = success ? (uint64_t)fileSize : 0;
+
+    if (success && *outSize == expectedSize)
+    {
+        XXH64_state_t state;
+        XXH64_reset(&state, 0);
+
+        for (uint64_t done = 0; success && done < *outSize;)
+        {
+            size_t readSize = fsReadFromStream(&fs, buffer, BUNYAR_LIB_COPY_BUFFER_SIZE);
+            XXH64_update(&state, buffer, readSize);
+            done += readSize;
+            success = readSize > 0;
+        }
+
+        *outHash = XXH64_digest(&state);
+    }
+
+    fsCloseStream(&fs);
+    return success;
+}
+
+static bool bunyArLibFindReusedEntries(const struct BunyArLibCreateDesc* desc, struct BunyArLibCreateMetadata* md)
+{
+    if (!desc->previousArchivePath)
+        return true;
+
+    if (!fsOpenStreamFromPath(desc->previousArchiveRd, desc->previousArchivePath, FM_READ, &md->previousArchive))
+    {
+        LOGF(eERROR, "Failed to open previous archive '%s'", desc->previousArchivePath);
+        return false;
+    }
+
+    struct BunyArLibPreviousArchive prev = { 0 };
+    bool                            success = bunyArLibPreviousArchiveLoad(&md->previousArchive, desc->previousArchivePath, &prev);
+
+    uint8_t* buffer = NULL;
+    if (success && prev.nodeCount && md->nodeCount)
+    {
+        md->reusedNodes = (struct BunyArLibReusedNode*)tf_calloc(1, sizeof(*md->reusedNodes) * md->nodeCount);
+        buffer = (uint8_t*)tf_malloc(BUNYAR_LIB_COPY_BUFFER_SIZE);
+        success = md->reusedNodes && buffer;
+    }
+
+    for (uint64_t i = 0; success && md->reusedNodes && i < desc->entryCount; ++i)
+    {
+        const struct BunyArLibEntryCreateDesc* entry = desc->entries + i;
+
+        // Nodes with dictionaries never match, because format keeps dictionary index
+        const struct BunyArNode* prevNode = bunyArLibPreviousArchiveFind(&prev, entry->outputName);
+        if (!prevNode || prevNode->format != (uint64_t)entry->format || !prevNode->filePointer.size)
+            continue;
+
+        if (entry->format != BUNYAR_FILE_FORMAT_RAW)
+        {
+            struct BunyArBlockFormatHeader blocksHeader;
+            if (!bunyArLibReadAt(&md->previousArchive, prevNode->filePointer.offset, &blocksHeader, sizeof(blocksHeader)))
+            {
+                LOGF(eERROR, "Failed to read file '%s' from previous archive", entry->outputName);
+                success = false;
+                break;
+            }
+
+            if (blocksHeader.blockSize != convertBlockSize(entry->format, entry->blockSizeKb))
+                continue;
+        }
+
+        uint64_t size = 0;
+        uint64_t hash = 0;
+        if (!bunyArLibHashFile(entry, prevNode->originalFileSize, buffer, &size, &hash))
+        {
+            LOGF(eERROR, "Failed to read file '%s'", entry->inputPath);
+            success = false;
+            break;
+        }
+
+        if (size != prevNode->originalFileSize || hash != prev.contentHashes[prevNode - prev.nodes])
+            continue;
+
+        md->reusedNodes[i].data = prevNode->filePointer;
+        md->reusedNodes[i].fileSize = size;
+        md->contentHashes[i] = hash;
+        ++md->reusedCount;
+    }
+
+    if (success && desc->verbose)
+    {
+        fprintf(stdout, "Previous archive '%s': %llu of %llu files unchanged\n\n", desc->previousArchivePath,
+                (unsigned long long)md->reusedCount, (unsigned long long)md->nodeCount);
+    }
+
+    // Stream is kept open for archive writer only if there is something to copy
+    if (!success || !md->reusedCount)
+    {
+        fsCloseStream(&md->previousArchive);
+        tf_free(md->reusedNodes);
+        md->reusedNodes = NULL;
+        md->reusedCount = 0;
+    }
+
+    tf_free(buffer);
+    bunyArLibPreviousArchiveDestroy(&prev);
+    return success;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// Function bunyArLibCreate (deduplication)                                ///
+/// Finds entries with identical content, only the first one is stored.     ///
+/// Only files of equal size are hashed, hash matches are verified          ///
+/// by comparing file content.                                              ///
+////////////////////////////////////////////////////////////////////////////////
+
+struct BunyArLibDuplicateCandidate
+{
+    enum BunyArFileFormat format;
+    uint64_t              fileSize;
+    uint64_t              hash;
+    uint64_t              entryIndex;
+};
+
+static int bunyArLibDuplicateCandidateCmpContent(const struct BunyArLibDuplicateCandidate* c0, const struct BunyArLibDuplicateCandidate* c1)
+{
+    if (c0->format != c1->format)
+        return c0->format < c1->format ? -1 : 1;
+    if (c0->fileSize != c1->fileSize)
+        return c0->fileSize < c1->fileSize ? -1 : 1;
+    if (c0->hash != c1->hash)
+        return c0->hash < c1->hash ? -1 : 1;
+    return 0;
+}
+
+static int bunyArLibDuplicateCandidateCmp(const void* v0, const void* v1)
+{
+    const struct BunyArLibDuplicateCandidate* c0 = (const struct BunyArLibDuplicateCandidate*)v0;
+    const struct BunyArLibDuplicateCandidate* c1 = (const struct BunyArLibDuplicateCandidate*)v1;
+
+    int cmp = bunyArLibDuplicateCandidateCmpContent(c0, c1);
+    if (cmp)
+        return cmp;
+    return c0->entryIndex < c1->entryIndex ? -1 : (c0->entryIndex > c1->entryIndex);
+}
+
+// 'buffer' size must be 2 * BUNYAR_LIB_COPY_BUFFER_SIZE
+static bool bunyArLibCompareFiles(const struct BunyArLibEntryCreateDesc* e0, const struct BunyArLibEntryCreateDesc* e1, uint8_t* buffer,
+                                  bool* outEqual)
+{
+    FileStream fs0 = { 0 };
+    FileStream fs1 = { 0 };
+
+    bool success = fsOpenStreamFromPath(e0->inputRd, e0->inputPath, FM_READ | FM_ALLOW_READ, &fs0) &&
+                   fsOpenStreamFromPath(e1->inputRd, e1->inputPath, FM_READ | FM_ALLOW_READ, &fs1);
+
+    *outEqual = success;
+    while (*outEqual)
+    {
+        size_t size0 = fsReadFromStream(&fs0, buffer, BUNYAR_LIB_COPY_BUFFER_SIZE);
+        size_t size1 = fsReadFromStream(&fs1, buffer + BUNYAR_LIB_COPY_BUFFER_SIZE, BUNYAR_LIB_COPY_BUFFER_SIZE);
+
+        *outEqual = size0 == size1 && memcmp(buffer, buffer + BUNYAR_LIB_COPY_BUFFER_SIZE, size0) == 0;
+        if (!size0)
+            break;
+    }
+
+    fsCloseStream(&fs0);
+    fsCloseStream(&fs1);
+    return success;
+}
+
+static bool bunyArLibFindDuplicateEntries(const struct BunyArLibCreateDesc* desc, struct BunyArLibCreateMetadata* md)
+{
+    if (desc->skipDeduplication || desc->entryCount < 2)
+        return true;
+
+    uint64_t count = desc->entryCount;
+
+    struct BunyArLibDuplicateCandidate* candidates =
+        (struct BunyArLibDuplicateCandidate*)tf_calloc(1, sizeof(*candidates) * (size_t)count);
+    uint8_t* buffer = (uint8_t*)tf_malloc(2 * BUNYAR_LIB_COPY_BUFFER_SIZE);
+
+    bool success = candidates && buffer;
+
+    for (uint64_t i = 0; success && i < count; ++i)
+    {
+        const struct BunyArLibEntryCreateDesc* entry = desc->entries + i;
+
+        candidates[i].format = entry->format;
+        candidates[i].entryIndex = i;
+
+        success = bunyArLibGetFileSize(entry, &candidates[i].fileSize);
+        if (!success)
+            LOGF(eERROR, "Failed to get size of file '%s'", entry->inputPath);
+    }
+
+    // Hash is not known yet, so candidates are sorted by format and size
+    if (success)
+        qsort(candidates, (size_t)count, sizeof(*candidates), bunyArLibDuplicateCandidateCmp);
+
+    for (uint64_t i = 0; success && i < count; ++i)
+    {
+        struct BunyArLibDuplicateCandidate* c = candidates + i;
+
+        bool sizeShared = (i > 0 && c[-1].format == c->format && c[-1].fileSize == c->fileSize) ||
+                          (i + 1 < count && c[1].format == c->format && c[1].fileSize == c->fileSize);
+        if (!sizeShared || !c->fileSize)
+            continue;
+
+        const struct BunyArLibEntryCreateDesc* entry = desc->entries + c->entryIndex;
+
+        uint64_t size = 0;
+        success = bunyArLibHashFile(entry, c->fileSize, buffer, &size, &c->hash) && size == c->fileSize;
+        if (!success)
+            LOGF(eERROR, "Failed to read file '%s'", entry->inputPath);
+    }
+
+    if (success)
+        qsort(candidates, (size_t)count, sizeof(*candidates), bunyArLibDuplicateCandidateCmp);
+
+    for (uint64_t beg = 0, end = 0; success && beg < count; beg = end)
+    {
+        for (end = beg + 1; end < count && bunyArLibDuplicateCandidateCmpContent(candidates + beg, candidates + end) == 0; ++end)
+        {
+        }
+
+        if (end - beg < 2 || !candidates[beg].fileSize)
+            continue;
+
+        if (!md->duplicateNodes)
+        {
+            md->duplicateNodes = (struct BunyArLibDuplicateNode*)tf_calloc(1, sizeof(*md->duplicateNodes) * (size_t)count);
+            success = md->duplicateNodes != NULL;
+        }
+
+        // Group is sorted by entry index, so the stored entry is written first
+        const struct BunyArLibEntryCreateDesc* original = desc->entries + candidates[beg].entryIndex;
+
+        for (uint64_t i = beg + 1; success && i < end; ++i)
+        {
+            uint64_t                               entryIndex = candidates[i].entryIndex;
+            const struct BunyArLibEntryCreateDesc* entry = desc->entries + entryIndex;
+
+            bool equal = false;
+            success = bunyArLibCompareFiles(original, entry, buffer, &equal);
+            if (!success)
+            {
+                LOGF(eERROR, "Failed to compare files '%s' and '%s'", original->inputPath, entry->inputPath);
+                break;
+            }
+
+            // hash collision
+            if (!equal)
+                continue;
+
+            md->duplicateNodes[entryIndex].original = candidates[beg].entryIndex + 1;
+            md->duplicateNodes[entryIndex].fileSize = candidates[i].fileSize;
+            ++md->duplicateCount;
+
+            // Nothing is copied for duplicate
+            if (md->reusedNodes && md->reusedNodes[entryIndex].data.size)
+            {
+                memset(md->reusedNodes + entryIndex, 0, sizeof(*md->reusedNodes));
+                --md->reusedCount;
+            }
+        }
+    }
+
+    if (success && desc->verbose && md->duplicateCount)
+    {
+        fprintf(stdout, "Found %llu duplicate files, their content is stored once\n\n", (unsigned long long)md->duplicateCount);
+    }
+
+    tf_free(buffer);
+    tf_free(candidates);
+    return success;
+}
+
+static bool tf_seek(FileStream* fs, size_t pos) { return fsSeekStream(fs, SBO_START_OF_FILE, (ssize_t)pos); }
+
+static bool tf_write(FileStream* fs, size_t size, void* data)
+{
+    size_t read = fsWriteToStream(fs, data, size);
+    if (read != size)
+    {
+        LOGF(eERROR,
+             "Failed to write %llu bytes to archive stream. %llu bytes written. "
+             "Stream position is %lli",
+             (unsigned long long)size, (unsigned long long)read, (long long)fsGetStreamSeekPosition(fs));
+        return false;
+    }
+    return true;
+}
+
+static bool initializeEntryBlockStream(enum BunyArFileFormat format, uint32_t blockSizeKb, uint64_t fileSize,
+                                       struct BunyArBlockFormatHeader* dstHeader, BunyArBlockPointer** dstBlocks,
+                                       uint64_t* outBlocksWithHeaderSize)
+{
+    memset(dstHeader, 0, sizeof *dstHeader);
+    *outBlocksWithHeaderSize = 0;
+
+    switch (format)
+    {
+    case BUNYAR_FILE_FORMAT_LZ4_BLOCKS:
+    case BUNYAR_FILE_FORMAT_ZSTD_BLOCKS:
+        break;
+    default:
+        return true;
+    }
+
+    uint64_t blockSize = convertBlockSize(format, blockSizeKb);
+    uint64_t blockCount = fileSize / blockSize + ((fileSize % blockSize) > 0);
+    size_t   blocksSize = sizeof(BunyArBlockPointer) * blockCount;
+
+    if (blockCount)
+    {
+        void* mem = *dstBlocks;
+        *dstBlocks = (BunyArBlockPointer*)tf_realloc(mem, blocksSize);
+        if (!*dstBlocks)
+        {
+            tf_free(mem);
+            return false;
+        }
+    }
+
+    *outBlocksWithHeaderSize = sizeof(struct BunyArBlockFormatHeader) + blocksSize;
+
+    dstHeader->blockSize = blockSize;
+    dstHeader->blockSizeLast = fileSize - (fileSize / blockSize) * blockSize;
+    if (dstHeader->blockSizeLast == 0)
+        dstHeader->blockSizeLast = blockSize;
+    dstHeader->blockCount = blockCount;
+    return true;
+}
+
+// Nodes are created in write order, reader requires them in name order.
+// File data stays in write order.
+static bool bunyArLibSortNodesByName(const struct BunyArLibCreateDesc* desc, struct BunyArLibCreateMetadata* md)
+{
+    struct BunyArNode* nodes = (struct BunyArNode*)tf_malloc(sizeof(*nodes) * md->nodeCount);
+    if (!nodes)
+        return false;
+
+    uint64_t* contentHashes = (uint64_t*)tf_malloc(sizeof(*contentHashes) * md->nodeCount);
+    if (!contentHashes)
+    {
+        tf_free(nodes);
+        return false;
+    }
+
+    for (uint64_t i = 0; i < md->nodeCount; ++i)
+    {
+        nodes[desc->entries[i].index] = md->nodes[i];
+        contentHashes[desc->entries[i].index] = md->contentHashes[i];
+    }
+
+    tf_free(md->nodes);
+    md->nodes = nodes;
+    tf_free(md->contentHashes);
+    md->contentHashes = contentHashes;
+
+    if (!desc->skipHashTable)
+        md->hashTable = bunyArHashTableConstruct(md->nodeCount, md->nodes, md->names);
+    return true;
+}
+
+// Location of stored block, referenced by identical blocks of the same file
+struct BunyArLibStoredBlock
+{
+    struct BunyArBlockInfo info;
+    // second hash of the block to rule out hash map key collision
+    uint64_t               checksum;
+};
+
+// Writes archive file. Gets compressed file data through 'packetIo'.
+// It just writes data given by 'packetIo' for each node one by one.
+static bool bunyArLibArchiveWrite(ResourceDirectory rd, const char* dstPath, struct bunyArLibPacketIo packetIo,
+                                  const struct BunyArLibCreateDesc* desc, struct BunyArLibCreateMetadata* md)
+{
+    enum BunyArLibWriteResult
+    {
+        BUNYAR_LIB_RESULT_SUCCESS,
+        BUNYAR_LIB_RESULT_OUTPUT_ERROR,
+        BUNYAR_LIB_RESULT_INPUT_ERROR,
+        BUNYAR_LIB_RESULT_COMPRESSION_ERROR,
+        BUNYAR_LIB_RESULT_MEMORY_ERROR,
+    };
+
+    FileStream archiveFs = { 0 };
+    if (!fsOpenStreamFromPath(rd, dstPath, FM_WRITE, &archiveFs))
+    {
+        LOGF(eERROR, "Failed to create/open archive file '%s'", dstPath);
+        return false;
+    }
+
+    enum BunyArLibWriteResult result = BUNYAR_LIB_RESULT_SUCCESS;
+
+    // Content hashes are always written, so header always has optional fields.
+    // Nodes follow the header, readers take nodesPointer.offset as the header size
+    uint64_t headerSize = sizeof(struct BunyArHeader);
+
+    uint64_t dictionariesSize = md->dictionaryCount * sizeof(struct BunyArPointer64);
+    for (uint32_t i = 0; i < md->dictionaryCount; ++i)
+        dictionariesSize += md->dictionaries[i].size;
+
+    uint64_t contentHashesSize = md->nodeCount * sizeof(*md->contentHashes);
+
+    uint64_t offset = headerSize + desc->entryCount * sizeof(struct BunyArNode) + md->namesSize + dictionariesSize + contentHashesSize;
+
+    uint8_t* copyBuffer = NULL;
+
+    struct
+    {
+        uint64_t                    key;
+        struct BunyArLibStoredBlock value;
+    }* storedBlocks = NULL;
+    uint64_t duplicateBlockCount = 0;
+
+    uint64_t           filesDone = 0;
+    struct BunyArNode* refNode = NULL;
+    uint64_t           blockIndex = 0;
+
+    uint64_t                       blockMetadataSize = 0;
+    struct BunyArBlockFormatHeader blocksHeader = { 0 };
+    BunyArBlockPointer*            blockPointers = NULL;
+
+    size_t totalFilesSize = 0;
+
+    int counterWidth = 0;
+
+    if (desc->verbose)
+    {
+        char buffer[32];
+        counterWidth = snprintf(buffer, sizeof buffer, "%llu", (unsigned long long)md->nodeCount);
+    }
+
+    int64_t time = getUSec(true);
+
+    int prevPrintedLen = 0;
+
+    struct FileAssemblyLine*          file = NULL;
+    struct FileBlock*                 block = NULL;
+    const struct BunyArLibReusedNode* reused = NULL;
+    for (; packetIo.receive(packetIo.pUser, &file, &block); releaseFileBlock(file, block), ++blockIndex)
+    {
+        if (!file)
+        {
+            if (!block)
+            {
+                result = BUNYAR_LIB_RESULT_MEMORY_ERROR;
+                break;
+            }
+
+            file = block->asmLine;
+        }
+
+        struct BunyArNode* node = md->nodes + file->entryIndex;
+        if (refNode != node)
+        {
+            if (refNode || (block && blockIndex != block->blockIndex))
+            {
+                LOGF(eERROR, "Received unexpected file block");
+                result = BUNYAR_LIB_RESULT_INPUT_ERROR;
+                break;
+            }
+
+            node->originalFileSize = file->fsize;
+
+            totalFilesSize += file->fsize;
+
+            // Duplicate shares data of the original entry, nothing is written
+            uint64_t original = md->duplicateNodes ? md->duplicateNodes[file->entryIndex].original : 0;
+            if (original)
+            {
+                const struct BunyArNode* originalNode = md->nodes + original - 1;
+
+                node->format = originalNode->format;
+                node->filePointer = originalNode->filePointer;
+                md->contentHashes[file->entryIndex] = md->contentHashes[original - 1];
+
+                if (desc->verbose)
+                {
+                    fprintf(stdout, "%*llu/%*llu '%s' = '%s'\n", counterWidth, (unsigned long long)file->entryIndex + 1, counterWidth,
+                            (unsigned long long)md->nodeCount, md->names + node->namePointer.offset,
+                            md->names + originalNode->namePointer.offset);
+                }
+
+                ++filesDone;
+                blockIndex = UINT64_MAX;
+                continue;
+            }
+
+            node->filePointer.offset = offset;
+
+            reused = md->reusedNodes ? md->reusedNodes + file->entryIndex : NULL;
+            if (reused && !reused->data.size)
+                reused = NULL;
+
+            if (!block && !reused)
+                node->format = BUNYAR_FILE_FORMAT_RAW;
+
+            prevPrintedLen = 0;
+
+            if (desc->verbose)
+            {
+                prevPrintedLen += fprintf(stdout, "%*llu/%*llu ", counterWidth, (unsigned long long)file->entryIndex + 1, counterWidth,
+                                          (unsigned long long)md->nodeCount);
+
+                const char* name = md->names + node->namePointer.offset;
+
+                prevPrintedLen += (int)utf8_strlen(name) + 1;
+                fprintf(stdout, "'%s'", name);
+
+                if (desc->verbose > 1)
+                {
+                    prevPrintedLen += fprintf(stdout, " %s", humanReadableSize(file->fsize).str);
+
+                    if (node->format != BUNYAR_FILE_FORMAT_RAW)
+                    {
+                        prevPrintedLen += fprintf(stdout, " | %s %i\n", bunyArFormatName(BUNYAR_NODE_FORMAT(node->format)),
+                                                  file->entry->compressionLevel);
+                    }
+                    else
+                    {
+                        prevPrintedLen += fprintf(stdout, " %s\n", bunyArFormatName(BUNYAR_FILE_FORMAT_RAW));
+                    }
+                }
+                else
+                {
+                    putc('\n', stdout);
+                    ++prevPrintedLen;
+                }
+            }
+
+            if (reused)
+            {
+                // Compressed data and block metadata are copied as is, block offsets are relative to the file data
+                memset(&blocksHeader, 0, sizeof blocksHeader);
+                blockMetadataSize = 0;
+
+                if (!copyBuffer)
+                    copyBuffer = (uint8_t*)tf_malloc(BUNYAR_LIB_COPY_BUFFER_SIZE);
+
+                if (!copyBuffer)
+                {
+                    result = BUNYAR_LIB_RESULT_MEMORY_ERROR;
+                    break;
+                }
+
+                if (!tf_seek(&archiveFs, offset) ||
+                    !bunyArLibCopyData(&md->previousArchive, reused->data, &archiveFs, copyBuffer, BUNYAR_LIB_COPY_BUFFER_SIZE))
+                {
+                    result = BUNYAR_LIB_RESULT_OUTPUT_ERROR;
+                    break;
+                }
+
+                node->filePointer.size = reused->data.size;
+            }
+            else if (!initializeEntryBlockStream(BUNYAR_NODE_FORMAT(node->format), file->entry->blockSizeKb, file->fsize, &blocksHeader,
+                                                 &blockPointers, &blockMetadataSize))
+            {
+                result = BUNYAR_LIB_RESULT_MEMORY_ERROR;
+                break;
+            }
+
+            offset += blockMetadataSize;
+
+            node->filePointer.size += blockMetadataSize;
+
+            if (!tf_seek(&archiveFs, offset))
+            {
+                result = BUNYAR_LIB_RESULT_OUTPUT_ERROR;
+                break;
+            }
+
+            refNode = node;
+        }
+
+        size_t sizeToWrite = 0;
+        void*  src = NULL;
+
+        if (blocksHeader.blockSize)
+        {
+            if (!block || !blockPointers)
+            {
+                result = BUNYAR_LIB_RESULT_MEMORY_ERROR;
+                break;
+            }
 
             struct BunyArBlockInfo blockInfo = { 0 };
 
@@ -1084,14 +1939,37 @@ static bool bunyArLibArchiveWrite(ResourceDirectory rd, const char* dstPath, str
             blockInfo.offset = node->filePointer.size - blockMetadataSize;
             blockInfo.size = blockInfo.isCompressed ? (uint32_t)block->compressedSize : (uint32_t)block->rawSize;
 
+            src = blockInfo.isCompressed ? block->bufferCompressed : block->bufferUncompressed;
+            sizeToWrite = blockInfo.size;
+
+            // Block offsets are relative to file data, so only earlier blocks of the same file can be referenced.
+            // Blocks are compressed independently, identical raw blocks give identical stored blocks.
+            if (!desc->skipDeduplication)
+            {
+                struct BunyArLibStoredBlock stored = { blockInfo, XXH64(src, blockInfo.size, 1) };
+
+                uint64_t  key = XXH64(src, blockInfo.size, 0);
+                ptrdiff_t storedIndex = hmgeti(storedBlocks, key);
+
+                if (storedIndex >= 0 && storedBlocks[storedIndex].value.info.size == blockInfo.size &&
+                    storedBlocks[storedIndex].value.info.isCompressed == blockInfo.isCompressed &&
+                    storedBlocks[storedIndex].value.checksum == stored.checksum)
+                {
+                    blockInfo.offset = storedBlocks[storedIndex].value.info.offset;
+                    sizeToWrite = 0;
+                    ++duplicateBlockCount;
+                }
+                else
+                {
+                    hmput(storedBlocks, key, stored);
+                }
+            }
+
             if (!bunyArEncodeBlockPointer(blockInfo, blockPointers + block->blockIndex))
             {
                 result = BUNYAR_LIB_RESULT_MEMORY_ERROR;
                 break;
             }
-
-            sizeToWrite = blockInfo.size;
-            src = blockInfo.isCompressed ? block->bufferCompressed : block->bufferUncompressed;
         }
         else if (block)
         {
@@ -1131,6 +2009,11 @@ static bool bunyArLibArchiveWrite(ResourceDirectory rd, const char* dstPath, str
 
         ASSERT(node->format == BUNYAR_FILE_FORMAT_RAW || node->filePointer.size > 0);
 
+        if (!reused)
+            md->contentHashes[file->entryIndex] = file->contentHash;
+
+        hmfree(storedBlocks);
+
         refNode = NULL;
         blockIndex = UINT64_MAX;
 
@@ -1183,6 +2066,8 @@ static bool bunyArLibArchiveWrite(ResourceDirectory rd, const char* dstPath, str
     }
 
     tf_free(blockPointers);
+    tf_free(copyBuffer);
+    hmfree(storedBlocks);
 
     size_t archiveSize = offset;
 
@@ -1191,6 +2076,10 @@ static bool bunyArLibArchiveWrite(ResourceDirectory rd, const char* dstPath, str
         LOGF(eERROR, "%s", "Archive write can not continue, aborting.");
         result = BUNYAR_LIB_RESULT_INPUT_ERROR;
     }
+    else if (result == BUNYAR_LIB_RESULT_SUCCESS && desc->layoutOrderCount && !bunyArLibSortNodesByName(desc, md))
+    {
+        result = BUNYAR_LIB_RESULT_MEMORY_ERROR;
+    }
     else if (result == BUNYAR_LIB_RESULT_SUCCESS)
     {
         size_t hashTableSize = bunyArHashTableSize(md->hashTable);
@@ -1208,7 +2097,7 @@ static bool bunyArLibArchiveWrite(ResourceDirectory rd, const char* dstPath, str
         struct BunyArHeader header = { 0 };
         memcpy(&header.magic, BUNYAR_MAGIC, sizeof(header.magic));
 
-        header.nodesPointer.offset = sizeof(struct BunyArHeader);
+        header.nodesPointer.offset = headerSize;
         header.nodesPointer.size = sizeof(struct BunyArNode) * desc->entryCount;
 
         header.namesPointer.offset = header.nodesPointer.offset + header.nodesPointer.size;
@@ -1217,15 +2106,55 @@ static bool bunyArLibArchiveWrite(ResourceDirectory rd, const char* dstPath, str
         header.hashTablePointer.offset = offset;
         header.hashTablePointer.size = hashTableSize;
 
-        if (!tf_seek(&archiveFs, 0) || !tf_write(&archiveFs, sizeof(header), &header) ||
-            !tf_write(&archiveFs, header.nodesPointer.size, md->nodes) || !tf_write(&archiveFs, header.namesPointer.size, md->names) ||
+        header.flags |= BUNYAR_HEADER_FLAG_CONTENT_HASHES;
+        header.version.actual = 1;
+
+        header.dictionariesPointer.offset = header.namesPointer.offset + header.namesPointer.size;
+
+        // content hashes follow dictionaries
+        header.contentHashesPointer.offset = header.dictionariesPointer.offset + dictionariesSize;
+        header.contentHashesPointer.size = contentHashesSize;
+
+        // dictionary contents follow the pointer table
+        struct BunyArPointer64* dictionaryPointers = NULL;
+        if (md->dictionaryCount)
+        {
+            header.flags |= BUNYAR_HEADER_FLAG_DICTIONARIES;
+
+            header.dictionariesPointer.size = md->dictionaryCount * sizeof(struct BunyArPointer64);
+
+            dictionaryPointers = (struct BunyArPointer64*)tf_malloc(header.dictionariesPointer.size);
+
+            uint64_t dictionaryOffset = header.dictionariesPointer.offset + header.dictionariesPointer.size;
+            for (uint32_t i = 0; dictionaryPointers && i < md->dictionaryCount; ++i)
+            {
+                dictionaryPointers[i].offset = dictionaryOffset;
+                dictionaryPointers[i].size = md->dictionaries[i].size;
+                dictionaryOffset += md->dictionaries[i].size;
+            }
+        }
+
+        bool written = (dictionaryPointers || !md->dictionaryCount) && tf_seek(&archiveFs, 0) && tf_write(&archiveFs, headerSize, &header) &&
+                       tf_write(&archiveFs, header.nodesPointer.size, md->nodes) &&
+                       tf_write(&archiveFs, header.namesPointer.size, md->names) &&
+                       (!dictionaryPointers || tf_write(&archiveFs, header.dictionariesPointer.size, dictionaryPointers));
+
+        for (uint32_t i = 0; written && i < md->dictionaryCount; ++i)
+            written = tf_write(&archiveFs, md->dictionaries[i].size, md->dictionaries[i].content);
+
+        written = written && tf_write(&archiveFs, header.contentHashesPointer.size, md->contentHashes);
+
+        tf_free(dictionaryPointers);
+
+        if (!written ||
             (md->hashTable &&
              (!tf_seek(&archiveFs, header.hashTablePointer.offset) || !tf_write(&archiveFs, header.hashTablePointer.size, md->hashTable))))
-            return BUNYAR_LIB_RESULT_OUTPUT_ERROR;
+            result = BUNYAR_LIB_RESULT_OUTPUT_ERROR;
 
-        if (desc->verbose > 1)
+        if (desc->verbose > 1 && result == BUNYAR_LIB_RESULT_SUCCESS)
         {
-            size_t metadataSize = sizeof(header) + header.nodesPointer.size + header.namesPointer.size + header.hashTablePointer.size;
+            size_t metadataSize = headerSize + header.nodesPointer.size + header.namesPointer.size + dictionariesSize +
+                                  contentHashesSize + header.hashTablePointer.size;
 
             fprintf(stdout, "|- %s\n\n", humanReadableSize(metadataSize).str);
         }
@@ -1263,8 +2192,14 @@ static bool bunyArLibArchiveWrite(ResourceDirectory rd, const char* dstPath, str
 
     if (desc->verbose && result == BUNYAR_LIB_RESULT_SUCCESS)
     {
-        fprintf(stdout, "Archive '%s' completed.\n|- %llu files\n|- %s -> %s (x%.2f)\n\n", dstPath, (unsigned long long)desc->entryCount,
+        fprintf(stdout, "Archive '%s' completed.\n|- %llu files\n|- %s -> %s (x%.2f)\n", dstPath, (unsigned long long)desc->entryCount,
                 humanReadableSize(totalFilesSize).str, humanReadableSize(archiveSize).str, (double)totalFilesSize / (double)archiveSize);
+        if (md->reusedNodes)
+            fprintf(stdout, "|- %llu files copied from previous archive\n", (unsigned long long)md->reusedCount);
+        if (md->duplicateCount || duplicateBlockCount)
+            fprintf(stdout, "|- %llu duplicate files, %llu duplicate blocks stored once\n", (unsigned long long)md->duplicateCount,
+                    (unsigned long long)duplicateBlockCount);
+        putc('\n', stdout);
     }
 
     return result == BUNYAR_LIB_RESULT_SUCCESS;
@@ -1294,9 +2229,12 @@ static void fileAssemblyCompressTask(void* data, uint64_t thid)
 
     struct CompressionContext* ctx = tsm->compressionContexts + thid;
 
+    uint32_t          dictionaryIndex = BUNYAR_NODE_DICTIONARY(tsm->md->nodes[file->entryIndex].format);
+    const ZSTD_CDict* dictionary = dictionaryIndex ? tsm->md->dictionaries[dictionaryIndex - 1].cdict : NULL;
+
     block->compressedSize = block->bufferSize;
-    if (!bunyArLibTaskCompress(ctx, file->entry->format, file->entry->compressionLevel, block->bufferUncompressed, block->rawSize,
-                               block->bufferCompressed, &block->compressedSize))
+    if (!bunyArLibTaskCompress(ctx, file->entry->format, file->entry->compressionLevel, dictionary, block->bufferUncompressed,
+                               block->rawSize, block->bufferCompressed, &block->compressedSize))
     {
         tfrg_atomic32_store_relaxed(&block->compressStatusId_Atomic32, BLOCK_TASK_STATUS_ERROR);
         file->error = true;
@@ -1320,6 +2258,25 @@ static void fileAssemblyReadTask(void* data, uint64_t thid)
 
     if (!file->fileStream.pIO)
     {
+        // Unchanged file is copied from previous archive by writer
+        const struct BunyArLibReusedNode* reused = file->tsm->md->reusedNodes ? file->tsm->md->reusedNodes + file->entryIndex : NULL;
+        if (reused && reused->data.size)
+        {
+            file->fsize = reused->fileSize;
+            file->blockCount = 0;
+            goto COMPLETE;
+        }
+
+        // Duplicate refers to data of the original entry
+        const struct BunyArLibDuplicateNode* duplicate =
+            file->tsm->md->duplicateNodes ? file->tsm->md->duplicateNodes + file->entryIndex : NULL;
+        if (duplicate && duplicate->original)
+        {
+            file->fsize = duplicate->fileSize;
+            file->blockCount = 0;
+            goto COMPLETE;
+        }
+
         if (!fsOpenStreamFromPath(file->entry->inputRd, file->entry->inputPath, FM_READ | FM_ALLOW_READ, &file->fileStream))
         {
             char buffer[MAX_THREAD_NAME_LENGTH + 1];
@@ -1334,6 +2291,7 @@ static void fileAssemblyReadTask(void* data, uint64_t thid)
 
         file->streamOffset = 0;
         file->fsize = (size_t)fsGetStreamFileSize(&file->fileStream);
+        XXH64_reset(&file->contentHashState, 0);
 
         if (file->entry->format == BUNYAR_FILE_FORMAT_RAW)
         {
@@ -1347,7 +2305,10 @@ static void fileAssemblyReadTask(void* data, uint64_t thid)
         file->blockCount = file->fsize / file->blockSize + ((file->fsize % file->blockSize) > 0);
 
         if (!file->blockCount)
+        {
+            file->contentHash = XXH64_digest(&file->contentHashState);
             goto COMPLETE;
+        }
 
         ASSERT(!file->blocks_AtomicPtr);
         file->blocks_AtomicPtr = (FileBlockAtomic*)tf_calloc(1, sizeof *file->blocks_AtomicPtr * file->blockCount);
@@ -1368,9 +2329,14 @@ static void fileAssemblyReadTask(void* data, uint64_t thid)
         block->rawSize = fsReadFromStream(&file->fileStream, block->bufferUncompressed, file->blockSize);
 
         file->streamOffset += block->rawSize;
+        XXH64_update(&file->contentHashState, block->bufferUncompressed, block->rawSize);
 
         bool done = file->streamOffset >= file->fsize;
 
+        // Writer may finish the file as soon as the last block is completed
+        if (done)
+            file->contentHash = XXH64_digest(&file->contentHashState);
+
         if (!done && block->rawSize != file->blockSize)
         {
             LOGF(eERROR, "Unexpected end of file stream %s%s", fsGetResourceDirectory(file->entry->inputRd), file->entry->inputPath);
@@ -1552,7 +2518,7 @@ static void bunyArLibCreateTaskManager(struct ThreadsSharedMemory* tsm, const st
             if (file->entryIndex != entryId)
                 continue;
 
-            if (readStatus == BLOCK_TASK_STATUS_COMPLETED && file->fsize == 0)
+            if (readStatus == BLOCK_TASK_STATUS_COMPLETED && file->blockCount == 0)
             {
                 packetSend(&tsm->packetIo, file, NULL);
             NEXT_ENTRY:
@@ -1638,6 +2604,8 @@ static bool initThreadSharedMemory(struct ThreadsSharedMemory* tsm, ResourceDire
 {
     memset(tsm, 0, sizeof(*tsm));
 
+    tsm->md = md;
+
     // waiter + scheduler + thread pool
     uint64_t threadPoolSize = (uint64_t)desc->threadPoolSize;
 
@@ -1736,7 +2704,8 @@ static bool initThreadSharedMemory(struct ThreadsSharedMemory* tsm, ResourceDire
 
     tsm->realBlockSize = blockSize * 2;
 
-    if (!desc->skipHashTable)
+    // With layout order nodes are sorted by name after writing, hash table is constructed then
+    if (!desc->skipHashTable && !desc->layoutOrderCount)
     {
         ThreadDesc threadInfo = { 0 };
         threadInfo.pFunc = hashTableTask;
@@ -1865,26 +2834,484 @@ static bool packetSingleThreadProducerFunc(void* pUser, struct FileAssemblyLine*
             return true;
         }
 
-        if (!file->blocks_AtomicPtr)
-            continue;
+        if (!file->blocks_AtomicPtr)
+            continue;
+
+        // packet receiver must mark file->writeComplete or exit
+        ASSERT(ctx->blockId < file->blockCount);
+
+        struct FileBlock* block = (struct FileBlock*)file->blocks_AtomicPtr[ctx->blockId]; // atomic read
+        if (!block)
+            continue;
+
+        // atomic read
+        if (block->compressStatusId_Atomic32 == BLOCK_TASK_STATUS_COMPLETED)
+        {
+            ++ctx->blockId;
+            *outBlock = block;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// Function bunyArLibCreate (codec selection)                              ///
+/// Trial-compresses a sample of every entry with several codecs, levels    ///
+/// and block sizes, drops results which decode too slowly on this machine ///
+/// and picks the smallest of the rest. Choice depends only on file content,///
+/// so identical files get identical codecs.                                ///
+////////////////////////////////////////////////////////////////////////////////
+
+// Sample of a large file consists of chunks spread evenly over it
+#define BUNYAR_LIB_ANALYSIS_CHUNK_SIZE  (1024 * 1024)
+#define BUNYAR_LIB_ANALYSIS_CHUNK_COUNT 2
+#define BUNYAR_LIB_ANALYSIS_SAMPLE_SIZE (BUNYAR_LIB_ANALYSIS_CHUNK_SIZE * BUNYAR_LIB_ANALYSIS_CHUNK_COUNT)
+// Decompression is timed in several passes, each repeats it at least this long
+// so that timer resolution does not matter for small files. Fastest pass counts,
+// slower ones were interrupted or ran on cold caches and would make the speed threshold flip between runs.
+#define BUNYAR_LIB_ANALYSIS_DECODE_PASS_USEC 250
+#define BUNYAR_LIB_ANALYSIS_DECODE_PASSES    8
+// Files which can not be compressed below 97% of their size are stored raw
+#define BUNYAR_LIB_ANALYSIS_MIN_GAIN 0.97
+
+struct BunyArLibCodec
+{
+    enum BunyArFileFormat format;
+    int                   compressionLevel;
+};
+
+// Equally sized results are resolved by this order, faster decoding codecs first
+static const struct BunyArLibCodec BUNYAR_LIB_ANALYSIS_CODECS[] = {
+    { BUNYAR_FILE_FORMAT_LZ4_BLOCKS, 0 },
+    { BUNYAR_FILE_FORMAT_LZ4_BLOCKS, LZ4HC_CLEVEL_DEFAULT },
+    { BUNYAR_FILE_FORMAT_ZSTD_BLOCKS, 1 },
+    { BUNYAR_FILE_FORMAT_ZSTD_BLOCKS, 3 },
+    { BUNYAR_FILE_FORMAT_ZSTD_BLOCKS, 9 },
+};
+
+// Ascending
+static const uint32_t BUNYAR_LIB_ANALYSIS_BLOCK_SIZES_KB[] = { 64, 256, 1024 };
+
+#define BUNYAR_LIB_ANALYSIS_MAX_BLOCKS (BUNYAR_LIB_ANALYSIS_SAMPLE_SIZE / (64 * 1024) + BUNYAR_LIB_ANALYSIS_CHUNK_COUNT)
+
+struct BunyArLibCodecChoice
+{
+    struct BunyArLibCodec codec;
+    uint32_t              blockSizeKb;
+    uint64_t              sampleSize;
+    uint64_t              storedSize;
+    // 0 for raw files and files reused from previous archive
+    double                decodeSpeedMBps;
+};
+
+// Choices by hash of sample seeded with file size, identical files must get identical codecs
+// even if timing noise moves them across the decode speed threshold, otherwise they are not deduplicated.
+struct BunyArLibSampleChoice
+{
+    uint64_t                    key;
+    struct BunyArLibCodecChoice value;
+};
+
+struct BunyArLibAnalysisContext
+{
+    struct CompressionContext     compression;
+    ZSTD_DCtx*                    zstdDctx;
+    struct BunyArLibSampleChoice* sampleChoices;
+
+    uint64_t chunkCount;
+    uint64_t chunkSizes[BUNYAR_LIB_ANALYSIS_CHUNK_COUNT];
+    uint8_t* sample;
+    uint8_t* stored;
+    uint8_t* decoded;
+
+    uint64_t blockCount;
+    uint64_t blockRawSizes[BUNYAR_LIB_ANALYSIS_MAX_BLOCKS];
+    uint64_t blockStoredSizes[BUNYAR_LIB_ANALYSIS_MAX_BLOCKS];
+};
+
+static bool bunyArLibAnalysisReadSample(struct BunyArLibAnalysisContext* ctx, const struct BunyArLibEntryCreateDesc* entry,
+                                        uint64_t* outFileSize)
+{
+    FileStream fs = { 0 };
+    if (!fsOpenStreamFromPath(entry->inputRd, entry->inputPath, FM_READ | FM_ALLOW_READ, &fs))
+        return false;
+
+    ssize_t fileSize = fsGetStreamFileSize(&fs);
+    bool    success = fileSize >= 0;
+
+    *outFileSize = success ? (uint64_t)fileSize : 0;
+
+    ctx->chunkCount = 0;
+    if (success && *outFileSize <= BUNYAR_LIB_ANALYSIS_SAMPLE_SIZE)
+    {
+        ctx->chunkCount = *outFileSize ? 1 : 0;
+        ctx->chunkSizes[0] = *outFileSize;
+        success = fsReadFromStream(&fs, ctx->sample, (size_t)*outFileSize) == *outFileSize;
+    }
+    else if (success)
+    {
+        ctx->chunkCount = BUNYAR_LIB_ANALYSIS_CHUNK_COUNT;
+
+        uint64_t step = (*outFileSize - BUNYAR_LIB_ANALYSIS_CHUNK_SIZE) / (BUNYAR_LIB_ANALYSIS_CHUNK_COUNT - 1);
+        for (uint64_t i = 0; success && i < ctx->chunkCount; ++i)
+        {
+            ctx->chunkSizes[i] = BUNYAR_LIB_ANALYSIS_CHUNK_SIZE;
+            success = fsSeekStream(&fs, SBO_START_OF_FILE, (ssize_t)(step * i)) &&
+                      fsReadFromStream(&fs, ctx->sample + BUNYAR_LIB_ANALYSIS_CHUNK_SIZE * i, BUNYAR_LIB_ANALYSIS_CHUNK_SIZE) ==
+                          BUNYAR_LIB_ANALYSIS_CHUNK_SIZE;
+        }
+    }
+
+    fsCloseStream(&fs);
+    return success;
+}
+
+// Compresses sample blocks to ctx->stored, block is stored raw if it does not compress
+static bool bunyArLibAnalysisCompress(struct BunyArLibAnalysisContext* ctx, struct BunyArLibCodec codec, uint64_t blockSize,
+                                      uint64_t* outStoredSize)
+{
+    const uint8_t* src = ctx->sample;
+    uint8_t*       dst = ctx->stored;
+
+    ctx->blockCount = 0;
+    *outStoredSize = 0;
+
+    for (uint64_t ci = 0; ci < ctx->chunkCount; ++ci)
+    {
+        for (uint64_t offset = 0; offset < ctx->chunkSizes[ci]; offset += blockSize)
+        {
+            uint64_t rawSize = ctx->chunkSizes[ci] - offset < blockSize ? ctx->chunkSizes[ci] - offset : blockSize;
+            uint64_t storedSize = rawSize;
+
+            if (!bunyArLibTaskCompress(&ctx->compression, codec.format, codec.compressionLevel, NULL, src + offset, rawSize, dst,
+                                       &storedSize))
+                return false;
+
+            if (storedSize >= rawSize)
+            {
+                storedSize = rawSize;
+                memcpy(dst, src + offset, rawSize);
+            }
+
+            ctx->blockRawSizes[ctx->blockCount] = rawSize;
+            ctx->blockStoredSizes[ctx->blockCount] = storedSize;
+            ++ctx->blockCount;
+
+            dst += storedSize;
+            *outStoredSize += storedSize;
+        }
+        src += ctx->chunkSizes[ci];
+    }
+    return true;
+}
+
+static bool bunyArLibAnalysisDecode(struct BunyArLibAnalysisContext* ctx, enum BunyArFileFormat format)
+{
+    const uint8_t* src = ctx->stored;
+    for (uint64_t bi = 0; bi < ctx->blockCount; ++bi)
+    {
+        uint64_t rawSize = ctx->blockRawSizes[bi];
+        uint64_t storedSize = ctx->blockStoredSizes[bi];
+
+        bool success = true;
+        if (storedSize == rawSize)
+        {
+            memcpy(ctx->decoded, src, rawSize);
+        }
+        else if (format == BUNYAR_FILE_FORMAT_LZ4_BLOCKS)
+        {
+            success = LZ4_decompress_safe((const char*)src, (char*)ctx->decoded, (int)storedSize, (int)rawSize) == (int)rawSize;
+        }
+        else
+        {
+            success = ZSTD_decompressDCtx(ctx->zstdDctx, ctx->decoded, rawSize, src, storedSize) == rawSize;
+        }
+
+        if (!success)
+            return false;
+
+        src += storedSize;
+    }
+    return true;
+}
+
+// Returns decoded MB per second of the fastest pass, 0 on failure
+static double bunyArLibAnalysisDecodeSpeed(struct BunyArLibAnalysisContext* ctx, uint64_t sampleSize, enum BunyArFileFormat format)
+{
+    double bestSpeed = 0;
+
+    for (uint32_t pass = 0; pass < BUNYAR_LIB_ANALYSIS_DECODE_PASSES; ++pass)
+    {
+        uint64_t decodedSize = 0;
+        int64_t  beg = getUSec(true);
+        int64_t  elapsed = 0;
+
+        do
+        {
+            if (!bunyArLibAnalysisDecode(ctx, format))
+                return 0;
+
+            decodedSize += sampleSize;
+            elapsed = getUSec(true) - beg;
+        } while (elapsed < BUNYAR_LIB_ANALYSIS_DECODE_PASS_USEC);
+
+        double speed = (double)decodedSize / (double)elapsed;
+        bestSpeed = speed > bestSpeed ? speed : bestSpeed;
+    }
+
+    return bestSpeed;
+}
+
+static bool bunyArLibAnalyzeEntry(struct BunyArLibAnalysisContext* ctx, const struct BunyArLibEntryCreateDesc* entry,
+                                  double decodeSpeedMBps, struct BunyArLibCodecChoice* outChoice)
+{
+    uint64_t fileSize = 0;
+    if (!bunyArLibAnalysisReadSample(ctx, entry, &fileSize))
+    {
+        LOGF(eERROR, "Failed to read file '%s' for codec analysis", entry->inputPath);
+        return false;
+    }
+
+    uint64_t sampleSize = 0;
+    uint64_t maxChunkSize = 0;
+    for (uint64_t i = 0; i < ctx->chunkCount; ++i)
+    {
+        sampleSize += ctx->chunkSizes[i];
+        maxChunkSize = ctx->chunkSizes[i] > maxChunkSize ? ctx->chunkSizes[i] : maxChunkSize;
+    }
+
+    uint64_t  sampleKey = XXH64(ctx->sample, (size_t)sampleSize, fileSize);
+    ptrdiff_t sampleIndex = hmgeti(ctx->sampleChoices, sampleKey);
+    if (sampleIndex >= 0)
+    {
+        *outChoice = ctx->sampleChoices[sampleIndex].value;
+        return true;
+    }
+
+    struct BunyArLibCodecChoice raw = { { BUNYAR_FILE_FORMAT_RAW, 0 }, BUNYAR_LIB_BLOCK_SIZE_KB_DEFAULT, sampleSize, sampleSize, 0 };
+
+    struct BunyArLibCodecChoice results[TF_ARRAY_COUNT(BUNYAR_LIB_ANALYSIS_CODECS) * TF_ARRAY_COUNT(BUNYAR_LIB_ANALYSIS_BLOCK_SIZES_KB)];
+    uint64_t                    resultCount = 0;
+
+    for (uint64_t bi = 0; sampleSize && bi < TF_ARRAY_COUNT(BUNYAR_LIB_ANALYSIS_BLOCK_SIZES_KB); ++bi)
+    {
+        uint32_t blockSizeKb = BUNYAR_LIB_ANALYSIS_BLOCK_SIZES_KB[bi];
+
+        // Larger blocks give the same result for small file
+        if (bi > 0 && (uint64_t)BUNYAR_LIB_ANALYSIS_BLOCK_SIZES_KB[bi - 1] * 1024 >= maxChunkSize)
+            break;
+
+        for (uint64_t ci = 0; ci < TF_ARRAY_COUNT(BUNYAR_LIB_ANALYSIS_CODECS); ++ci)
+        {
+            struct BunyArLibCodecChoice* result = results + resultCount;
+
+            result->codec = BUNYAR_LIB_ANALYSIS_CODECS[ci];
+            result->blockSizeKb = blockSizeKb;
+            result->sampleSize = sampleSize;
+
+            if (!bunyArLibAnalysisCompress(ctx, result->codec, (uint64_t)blockSizeKb * 1024, &result->storedSize))
+                return false;
+
+            result->decodeSpeedMBps = bunyArLibAnalysisDecodeSpeed(ctx, sampleSize, result->codec.format);
+            if (result->decodeSpeedMBps <= 0)
+            {
+                LOGF(eERROR, "Failed to decompress trial of file '%s' with %s", entry->inputPath, bunyArFormatName(result->codec.format));
+                return false;
+            }
+
+            if (result->decodeSpeedMBps >= decodeSpeedMBps)
+                ++resultCount;
+        }
+    }
+
+    uint64_t smallest = UINT64_MAX;
+    for (uint64_t i = 0; i < resultCount; ++i)
+        smallest = results[i].storedSize < smallest ? results[i].storedSize : smallest;
+
+    *outChoice = raw;
+
+    if (resultCount == 0 || (double)smallest > (double)sampleSize * BUNYAR_LIB_ANALYSIS_MIN_GAIN)
+    {
+        hmput(ctx->sampleChoices, sampleKey, raw);
+        return true;
+    }
+
+    // Decode speed only filters results, timing noise must not pick between them.
+    // Results are ordered by block size, then by codec table, so the first smallest one wins.
+    const struct BunyArLibCodecChoice* best = NULL;
+    for (uint64_t i = 0; i < resultCount; ++i)
+    {
+        if (results[i].storedSize == smallest)
+        {
+            best = results + i;
+            break;
+        }
+    }
+
+    *outChoice = *best;
+    hmput(ctx->sampleChoices, sampleKey, *best);
+    return true;
+}
+
+// Unchanged entry keeps codec of the previous archive, so bunyArLibFindReusedEntries can copy its data
+static bool bunyArLibAnalysisFindPrevious(const struct BunyArLibPreviousArchive* prev, FileStream* prevFs,
+                                          const struct BunyArLibEntryCreateDesc* entry, uint8_t* buffer, bool* outFound,
+                                          struct BunyArLibCodecChoice* outChoice)
+{
+    *outFound = false;
+
+    // Nodes with dictionaries are compressed again anyway
+    const struct BunyArNode* prevNode = bunyArLibPreviousArchiveFind(prev, entry->outputName);
+    if (!prevNode || !prevNode->filePointer.size || BUNYAR_NODE_DICTIONARY(prevNode->format))
+        return true;
+
+    enum BunyArFileFormat format = BUNYAR_NODE_FORMAT(prevNode->format);
+    if (format != BUNYAR_FILE_FORMAT_RAW && format != BUNYAR_FILE_FORMAT_LZ4_BLOCKS && format != BUNYAR_FILE_FORMAT_ZSTD_BLOCKS)
+        return true;
+
+    uint32_t blockSizeKb = BUNYAR_LIB_BLOCK_SIZE_KB_DEFAULT;
+    if (format != BUNYAR_FILE_FORMAT_RAW)
+    {
+        struct BunyArBlockFormatHeader blocksHeader;
+        if (!bunyArLibReadAt(prevFs, prevNode->filePointer.offset, &blocksHeader, sizeof(blocksHeader)))
+        {
+            LOGF(eERROR, "Failed to read file '%s' from previous archive", entry->outputName);
+            return false;
+        }
+
+        if (blocksHeader.blockSize % 1024 || blocksHeader.blockSize / 1024 > UINT32_MAX)
+            return true;
+        blockSizeKb = (uint32_t)(blocksHeader.blockSize / 1024);
+    }
+
+    uint64_t size = 0;
+    uint64_t hash = 0;
+    if (!bunyArLibHashFile(entry, prevNode->originalFileSize, buffer, &size, &hash))
+    {
+        LOGF(eERROR, "Failed to read file '%s'", entry->inputPath);
+        return false;
+    }
+
+    if (size != prevNode->originalFileSize || hash != prev->contentHashes[prevNode - prev->nodes])
+        return true;
+
+    // Compression level is not stored in archive, it does not matter because data is copied as is
+    struct BunyArLibCodecChoice choice = { { format, entry->compressionLevel }, blockSizeKb, size, prevNode->filePointer.size, 0 };
+    *outChoice = choice;
+    *outFound = true;
+    return true;
+}
+
+static bool bunyArLibSelectCodecs(const struct BunyArLibCreateDesc* desc)
+{
+    struct BunyArLibAnalysisContext ctx = { 0 };
+
+    bool success = compressionContextInit(&ctx.compression, true, true);
+
+    ctx.zstdDctx = ZSTD_createDCtx_advanced(ZSTD_MEMORY_ALLOCATOR);
+    ctx.sample = (uint8_t*)tf_malloc(BUNYAR_LIB_ANALYSIS_SAMPLE_SIZE);
+    ctx.stored = (uint8_t*)tf_malloc(BUNYAR_LIB_ANALYSIS_SAMPLE_SIZE);
+    ctx.decoded = (uint8_t*)tf_malloc(BUNYAR_LIB_ANALYSIS_CHUNK_SIZE);
+    success = success && ctx.zstdDctx && ctx.sample && ctx.stored && ctx.decoded;
+
+    FileStream report = { 0 };
+    if (success && desc->autoCodecReportPath)
+    {
+        success = fsOpenStreamFromPath(desc->autoCodecReportRd, desc->autoCodecReportPath, FM_WRITE, &report);
+        if (!success)
+            LOGF(eERROR, "Failed to open codec report file '%s'", desc->autoCodecReportPath);
+    }
+
+    char line[FS_MAX_PATH + 128];
+    int  lineSize = snprintf(line, sizeof line, "# decode speed target %u MB/s\n# name\tformat\tlevel\tblock KB\tratio\tdecode MB/s\n",
+                             desc->autoCodecDecodeSpeedMBps);
+    if (success && report.pIO)
+        success = fsWriteToStream(&report, line, (size_t)lineSize) == (size_t)lineSize;
+
+    FileStream                      prevFs = { 0 };
+    struct BunyArLibPreviousArchive prev = { 0 };
+    uint8_t*                        hashBuffer = NULL;
+    if (success && desc->previousArchivePath)
+    {
+        success = fsOpenStreamFromPath(desc->previousArchiveRd, desc->previousArchivePath, FM_READ, &prevFs);
+        if (!success)
+            LOGF(eERROR, "Failed to open previous archive '%s'", desc->previousArchivePath);
+
+        success = success && bunyArLibPreviousArchiveLoad(&prevFs, desc->previousArchivePath, &prev);
+        if (success && prev.nodeCount)
+        {
+            hashBuffer = (uint8_t*)tf_malloc(BUNYAR_LIB_COPY_BUFFER_SIZE);
+            success = hashBuffer != NULL;
+        }
+    }
+
+    uint64_t totalSample = 0;
+    uint64_t totalStored = 0;
+    uint64_t reusedCount = 0;
+
+    for (uint64_t i = 0; success && i < desc->entryCount; ++i)
+    {
+        struct BunyArLibEntryCreateDesc* entry = desc->entries + i;
+
+        struct BunyArLibCodecChoice choice;
+        bool                        found = false;
+        if (prev.nodeCount)
+            success = bunyArLibAnalysisFindPrevious(&prev, &prevFs, entry, hashBuffer, &found, &choice);
+
+        if (success && found)
+            ++reusedCount;
+        else if (success)
+            success = bunyArLibAnalyzeEntry(&ctx, entry, (double)desc->autoCodecDecodeSpeedMBps, &choice);
+
+        if (!success)
+            break;
+
+        entry->format = choice.codec.format;
+        entry->compressionLevel = choice.codec.compressionLevel;
+        entry->blockSizeKb = choice.blockSizeKb;
+
+        totalSample += choice.sampleSize;
+        totalStored += choice.storedSize;
+
+        double ratio = choice.storedSize ? (double)choice.sampleSize / (double)choice.storedSize : 1.0;
 
-        // packet receiver must mark file->writeComplete or exit
-        ASSERT(ctx->blockId < file->blockCount);
+        lineSize = snprintf(line, sizeof line, "%s\t%s\t%i\t%u\t%.3f\t%.0f\n", entry->outputName, bunyArFormatName(choice.codec.format),
+                            choice.codec.compressionLevel, choice.codec.format == BUNYAR_FILE_FORMAT_RAW ? 0 : choice.blockSizeKb, ratio,
+                            choice.decodeSpeedMBps);
+        if (lineSize >= (int)sizeof line)
+            lineSize = (int)sizeof line - 1;
 
-        struct FileBlock* block = (struct FileBlock*)file->blocks_AtomicPtr[ctx->blockId]; // atomic read
-        if (!block)
-            continue;
+        if (report.pIO)
+            success = fsWriteToStream(&report, line, (size_t)lineSize) == (size_t)lineSize;
 
-        // atomic read
-        if (block->compressStatusId_Atomic32 == BLOCK_TASK_STATUS_COMPLETED)
-        {
-            ++ctx->blockId;
-            *outBlock = block;
-            return true;
-        }
+        if (desc->verbose > 1)
+            fputs(line, stdout);
     }
 
-    return false;
+    if (report.pIO && !fsCloseStream(&report))
+        success = false;
+
+    tf_free(hashBuffer);
+    bunyArLibPreviousArchiveDestroy(&prev);
+    if (prevFs.pIO)
+        fsCloseStream(&prevFs);
+
+    if (success && desc->verbose)
+    {
+        fprintf(stdout, "Codec analysis of %llu files, %llu unchanged kept codec of previous archive: samples %s -> %s (x%.2f)\n\n",
+                (unsigned long long)desc->entryCount, (unsigned long long)reusedCount, humanReadableSize(totalSample).str,
+                humanReadableSize(totalStored).str, totalStored ? (double)totalSample / (double)totalStored : 1.0);
+    }
+
+    hmfree(ctx.sampleChoices);
+    tf_free(ctx.decoded);
+    tf_free(ctx.stored);
+    tf_free(ctx.sample);
+    ZSTD_freeDCtx(ctx.zstdDctx);
+    compressionContextDestroy(&ctx.compression);
+    return success;
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1960,6 +3387,39 @@ static bool bunyArLibCreateArchive(ResourceDirectory rd, const char* dstPath, co
     return success;
 }
 
+// 'desc' entries are unique and sorted by name
+static bool bunyArLibCreateFromEntries(ResourceDirectory rd, const char* dstPath, struct BunyArLibCreateDesc* desc)
+{
+    if (!bunyArLibApplyLayoutOrder(desc))
+    {
+        LOGF(eERROR, "Failed to apply layout order for archive '%s'", dstPath);
+        return false;
+    }
+
+    struct BunyArLibCreateMetadata md;
+    bool                           success = bunyArLibCreateMetadata(desc, &md);
+
+    if (!success)
+    {
+        LOGF(eERROR, "Failed to initialize metadata for archive '%s'", dstPath);
+    }
+
+    if (success)
+        success = bunyArLibFindReusedEntries(desc, &md);
+
+    if (success)
+        success = bunyArLibFindDuplicateEntries(desc, &md);
+
+    if (success)
+        success = bunyArLibCreateDictionaries(desc, &md);
+
+    if (success)
+        success = bunyArLibCreateArchive(rd, dstPath, desc, &md);
+
+    bunyArLibCreateMetadataDestroy(&md);
+    return success;
+}
+
 bool bunyArLibCreate(ResourceDirectory rd, const char* dstPath, const struct BunyArLibCreateDesc* inDesc)
 {
     char** strings = NULL;
@@ -1972,22 +3432,101 @@ bool bunyArLibCreate(ResourceDirectory rd, const char* dstPath, const struct Bun
         return false;
     }
 
-    struct BunyArLibCreateMetadata md;
-    bool                           success = bunyArLibCreateMetadata(&desc, &md);
+    bool success = true;
 
-    if (!success)
+    if (desc.autoCodecDecodeSpeedMBps)
     {
-        LOGF(eERROR, "Failed to initialize metadata for archive '%s'", dstPath);
+        success = bunyArLibSelectCodecs(&desc);
+        if (!success)
+            LOGF(eERROR, "Failed to select codecs for archive '%s'", dstPath);
     }
 
-    if (success)
-        success = bunyArLibCreateArchive(rd, dstPath, &desc, &md);
+    if (success && !desc.analyzeOnly)
+        success = bunyArLibCreateFromEntries(rd, dstPath, &desc);
 
-    bunyArLibCreateMetadataDestroy(&md);
     bunyArLibCreatePostprocessDesc(&desc, &strings);
     return success;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+/// Function bunyArLibRepack                                                ///
+////////////////////////////////////////////////////////////////////////////////
+
+bool bunyArLibRepack(struct IFileSystem* archive, ResourceDirectory archiveRd, ResourceDirectory rd, const char* dstPath,
+                     const struct BunyArLibCreateDesc* inDesc, int lz4Level, int zstdLevel)
+{
+    struct BunyArDescription archiveInfo;
+    fsArchiveGetDescription(archive, &archiveInfo);
+
+    struct BunyArLibCreateDesc desc = *inDesc;
+
+    desc.entryCount = archiveInfo.nodeCount;
+    desc.entries = NULL;
+
+    if (desc.entryCount)
+    {
+        desc.entries = (struct BunyArLibEntryCreateDesc*)tf_calloc((size_t)desc.entryCount, sizeof(*desc.entries));
+        if (!desc.entries)
+            return false;
+    }
+
+    bool success = true;
+
+    // Archive nodes are unique and sorted by name already
+    for (uint64_t i = 0; success && i < desc.entryCount; ++i)
+    {
+        struct BunyArNodeDescription node;
+        fsArchiveGetNodeDescription(archive, i, &node);
+
+        struct BunyArLibEntryCreateDesc* entry = desc.entries + i;
+
+        *entry = BUNYAR_LIB_FUNC_CREATE_DEFAULT_ENTRY_DESC;
+        entry->inputRd = archiveRd;
+        entry->inputPath = node.name;
+        entry->outputName = node.name;
+        entry->format = node.format;
+
+        if (node.format != BUNYAR_FILE_FORMAT_RAW)
+        {
+            FileStream                     fs;
+            struct BunyArBlockFormatHeader blocksHeader;
+            const BunyArBlockPointer*      blocks;
+
+            success = fsIoOpenByUid(archive, i, FM_READ, &fs);
+            if (!success)
+            {
+                LOGF(eERROR, "Failed to open archive file '%s'", node.name);
+                break;
+            }
+
+            if (fsArchiveGetFileBlockMetadata(&fs, &blocksHeader, &blocks) && blocksHeader.blockSize % 1024 == 0)
+                entry->blockSizeKb = (uint32_t)(blocksHeader.blockSize / 1024);
+
+            fsCloseStream(&fs);
+        }
+
+        switch (entry->format)
+        {
+        case BUNYAR_FILE_FORMAT_LZ4_BLOCKS:
+            entry->compressionLevel = lz4Level;
+            break;
+        case BUNYAR_FILE_FORMAT_ZSTD_BLOCKS:
+            entry->compressionLevel = zstdLevel;
+            break;
+        case BUNYAR_FILE_FORMAT_RAW:
+        default:
+            entry->compressionLevel = 0;
+        }
+        validateCompressionLevel(entry->format, &entry->compressionLevel);
+    }
+
+    if (success)
+        success = bunyArLibCreateFromEntries(rd, dstPath, &desc);
+
+    tf_free(desc.entries);
+    return success;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 /// Function bunyArLibExtract                                               ///
 ////////////////////////////////////////////////////////////////////////////////
@@ -2342,3 +3881,383 @@ CLEANUP:
 
     return success;
 }
+
+////////////////////////////////////////////////////////////////////////////////
+/// Function bunyArLibReadBenchmarks                                        ///
+////////////////////////////////////////////////////////////////////////////////
+
+// Files are read in pieces of this size at most
+#define BUNYAR_LIB_BENCHMARK_READ_SIZE_MAX (64 * 1024 * 1024)
+
+static const enum BunyArFileFormat BUNYAR_LIB_BENCHMARK_FORMATS[] = {
+    BUNYAR_FILE_FORMAT_RAW,
+    BUNYAR_FILE_FORMAT_LZ4_BLOCKS,
+    BUNYAR_FILE_FORMAT_ZSTD_BLOCKS,
+};
+
+#define BUNYAR_LIB_BENCHMARK_FORMAT_COUNT TF_ARRAY_COUNT(BUNYAR_LIB_BENCHMARK_FORMATS)
+
+struct BunyArLibBenchmarkResult
+{
+    uint64_t  operations;
+    uint64_t  bytes;
+    int64_t   usec;
+    // microseconds of every operation, stb_ds array
+    uint64_t* latencies;
+};
+
+struct BunyArLibBenchmarkContext
+{
+    const struct BunyArLibReadBenchmarkDesc* desc;
+
+    IFileSystem* archive;
+    uint64_t     nodeCount;
+    uint64_t     readSize;
+
+    FileStream output;
+
+    const char* mode;
+    uint32_t    iteration;
+};
+
+struct BunyArLibBenchmarkThread
+{
+    struct BunyArLibBenchmarkContext* ctx;
+    uint32_t                          index;
+    uint32_t                          count;
+    bool                              success;
+    struct BunyArLibBenchmarkResult   result;
+};
+
+// Opens file, reads it whole and closes it
+static bool bunyArLibBenchmarkReadFile(IFileSystem* archive, uint64_t nodeId, uint8_t* buffer, uint64_t bufferSize, uint64_t* outSize)
+{
+    FileStream fs = { 0 };
+    if (!fsIoOpenByUid(archive, nodeId, FM_READ, &fs))
+        return false;
+
+    ssize_t fileSize = fsGetStreamFileSize(&fs);
+    bool    success = fileSize >= 0;
+
+    uint64_t sizeLeft = success ? (uint64_t)fileSize : 0;
+    while (success && sizeLeft)
+    {
+        uint64_t readSize = sizeLeft < bufferSize ? sizeLeft : bufferSize;
+        success = fsReadFromStream(&fs, buffer, (size_t)readSize) == readSize;
+        sizeLeft -= readSize;
+    }
+
+    fsCloseStream(&fs);
+
+    *outSize = success ? (uint64_t)fileSize : 0;
+    return success;
+}
+
+static void bunyArLibBenchmarkAdd(struct BunyArLibBenchmarkResult* result, uint64_t bytes, int64_t usec)
+{
+    ++result->operations;
+    result->bytes += bytes;
+    arrpush(result->latencies, usec > 0 ? (uint64_t)usec : 0);
+}
+
+static int bunyArLibUint64Cmp(const void* v0, const void* v1)
+{
+    uint64_t a = *(const uint64_t*)v0;
+    uint64_t b = *(const uint64_t*)v1;
+    return a < b ? -1 : a > b;
+}
+
+static bool bunyArLibBenchmarkReport(struct BunyArLibBenchmarkContext* ctx, const char* test, const char* format, uint32_t threads,
+                                     struct BunyArLibBenchmarkResult* result)
+{
+    uint64_t count = arrlenu(result->latencies);
+    qsort(result->latencies, count, sizeof *result->latencies, bunyArLibUint64Cmp);
+
+    uint64_t p50 = count ? result->latencies[count / 2] : 0;
+    uint64_t p99 = count ? result->latencies[(count * 99) / 100] : 0;
+    uint64_t max = count ? result->latencies[count - 1] : 0;
+
+    double seconds = (double)result->usec / 1e6;
+    double mbps = result->usec > 0 ? (double)result->bytes / (double)result->usec : 0;
+
+    char line[512];
+    int  lineSize = snprintf(line, sizeof line, "%s\t%s\t%s\t%u\t%u\t%llu\t%llu\t%.6f\t%.1f\t%llu\t%llu\t%llu\n", test, ctx->mode, format,
+                             threads, ctx->iteration, (unsigned long long)result->operations, (unsigned long long)result->bytes, seconds, mbps,
+                             (unsigned long long)p50, (unsigned long long)p99, (unsigned long long)max);
+
+    arrfree(result->latencies);
+    memset(result, 0, sizeof *result);
+
+    if (!ctx->output.pIO)
+    {
+        fputs(line, stdout);
+        return true;
+    }
+    return fsWriteToStream(&ctx->output, line, (size_t)lineSize) == (size_t)lineSize;
+}
+
+static bool bunyArLibBenchmarkSequential(struct BunyArLibBenchmarkContext* ctx, uint8_t* buffer)
+{
+    struct BunyArLibBenchmarkResult all = { 0 };
+    struct BunyArLibBenchmarkResult formats[BUNYAR_LIB_BENCHMARK_FORMAT_COUNT] = { { 0 } };
+
+    bool    success = true;
+    int64_t beg = getUSec(true);
+
+    for (uint64_t i = 0; success && i < ctx->nodeCount; ++i)
+    {
+        struct BunyArNodeDescription node;
+        fsArchiveGetNodeDescription(ctx->archive, i, &node);
+
+        uint64_t size = 0;
+        int64_t  fileBeg = getUSec(true);
+        success = bunyArLibBenchmarkReadFile(ctx->archive, i, buffer, ctx->readSize, &size);
+        int64_t fileUsec = getUSec(true) - fileBeg;
+
+        bunyArLibBenchmarkAdd(&all, size, fileUsec);
+
+        for (uint64_t fi = 0; fi < BUNYAR_LIB_BENCHMARK_FORMAT_COUNT; ++fi)
+        {
+            if (BUNYAR_LIB_BENCHMARK_FORMATS[fi] != node.format)
+                continue;
+            bunyArLibBenchmarkAdd(formats + fi, size, fileUsec);
+            formats[fi].usec += fileUsec;
+        }
+
+        if (!success)
+            LOGF(eERROR, "Failed to read file '%s'", node.name);
+    }
+
+    all.usec = getUSec(true) - beg;
+
+    success = bunyArLibBenchmarkReport(ctx, "sequential", "all", 1, &all) && success;
+
+    for (uint64_t fi = 0; fi < BUNYAR_LIB_BENCHMARK_FORMAT_COUNT; ++fi)
+    {
+        if (formats[fi].operations)
+            success = bunyArLibBenchmarkReport(ctx, "sequential", bunyArFormatName(BUNYAR_LIB_BENCHMARK_FORMATS[fi]), 1, formats + fi) &&
+                      success;
+    }
+    return success;
+}
+
+static bool bunyArLibBenchmarkRandom(struct BunyArLibBenchmarkContext* ctx, uint8_t* buffer)
+{
+    struct BunyArLibBenchmarkResult result = { 0 };
+
+    uint64_t* nodes = NULL;
+    uint64_t* sizes = NULL;
+    for (uint64_t i = 0; i < ctx->nodeCount; ++i)
+    {
+        struct BunyArNodeDescription node;
+        fsArchiveGetNodeDescription(ctx->archive, i, &node);
+        if (!node.fileSize)
+            continue;
+        arrpush(nodes, i);
+        arrpush(sizes, node.fileSize);
+    }
+
+    uint64_t nodeCount = arrlenu(nodes);
+    uint64_t readSize = ctx->desc->randomReadSize;
+
+    // same sequence for every run, so runs and archives are comparable
+    uint64_t random = 0x9E3779B97F4A7C15ull;
+
+    bool    success = true;
+    int64_t beg = getUSec(true);
+
+    for (uint64_t r = 0; success && nodeCount && r < ctx->desc->randomReadCount; ++r)
+    {
+        random ^= random << 13;
+        random ^= random >> 7;
+        random ^= random << 17;
+
+        uint64_t ni = random % nodeCount;
+        uint64_t size = sizes[ni] < readSize ? sizes[ni] : readSize;
+        uint64_t offset = (random >> 20) % (sizes[ni] - size + 1);
+
+        int64_t    readBeg = getUSec(true);
+        FileStream fs = { 0 };
+        success = fsIoOpenByUid(ctx->archive, nodes[ni], FM_READ, &fs) && fsSeekStream(&fs, SBO_START_OF_FILE, (ssize_t)offset) &&
+                  fsReadFromStream(&fs, buffer, (size_t)size) == size;
+        fsCloseStream(&fs);
+
+        bunyArLibBenchmarkAdd(&result, size, getUSec(true) - readBeg);
+    }
+
+    result.usec = getUSec(true) - beg;
+
+    if (!success)
+        LOGF(eERROR, "Random read failed");
+
+    arrfree(sizes);
+    arrfree(nodes);
+
+    return bunyArLibBenchmarkReport(ctx, "random", "all", 1, &result) && success;
+}
+
+static void bunyArLibBenchmarkThreadFunc(void* user)
+{
+    struct BunyArLibBenchmarkThread* thread = (struct BunyArLibBenchmarkThread*)user;
+    struct BunyArLibBenchmarkContext* ctx = thread->ctx;
+
+    uint8_t* buffer = (uint8_t*)tf_malloc(ctx->readSize);
+    thread->success = buffer != NULL;
+
+    for (uint64_t i = thread->index; thread->success && i < ctx->nodeCount; i += thread->count)
+    {
+        uint64_t size = 0;
+        int64_t  beg = getUSec(true);
+        thread->success = bunyArLibBenchmarkReadFile(ctx->archive, i, buffer, ctx->readSize, &size);
+        bunyArLibBenchmarkAdd(&thread->result, size, getUSec(true) - beg);
+    }
+
+    tf_free(buffer);
+}
+
+static bool bunyArLibBenchmarkConcurrent(struct BunyArLibBenchmarkContext* ctx)
+{
+    uint32_t threadCount = ctx->desc->threadCount;
+
+    struct BunyArLibBenchmarkThread* threads = (struct BunyArLibBenchmarkThread*)tf_calloc(threadCount, sizeof *threads);
+    ThreadHandle*                    handles = (ThreadHandle*)tf_calloc(threadCount, sizeof *handles);
+
+    bool    success = true;
+    int64_t beg = getUSec(true);
+
+    uint32_t started = 0;
+    for (; started < threadCount; ++started)
+    {
+        struct BunyArLibBenchmarkThread* thread = threads + started;
+        thread->ctx = ctx;
+        thread->index = started;
+        thread->count = threadCount;
+
+        ThreadDesc threadDesc = { 0 };
+        threadDesc.pFunc = bunyArLibBenchmarkThreadFunc;
+        threadDesc.pData = thread;
+        snprintf(threadDesc.mThreadName, sizeof threadDesc.mThreadName, "BunyBench %u", started);
+
+        if (!initThread(&threadDesc, handles + started))
+        {
+            LOGF(eERROR, "Failed to start benchmark thread");
+            success = false;
+            break;
+        }
+    }
+
+    struct BunyArLibBenchmarkResult result = { 0 };
+
+    for (uint32_t i = 0; i < started; ++i)
+    {
+        joinThread(handles[i]);
+
+        struct BunyArLibBenchmarkThread* thread = threads + i;
+        success = success && thread->success;
+
+        result.operations += thread->result.operations;
+        result.bytes += thread->result.bytes;
+        for (uint64_t li = 0; li < arrlenu(thread->result.latencies); ++li)
+            arrpush(result.latencies, thread->result.latencies[li]);
+        arrfree(thread->result.latencies);
+    }
+
+    result.usec = getUSec(true) - beg;
+
+    if (!success)
+        LOGF(eERROR, "Concurrent read failed");
+
+    tf_free(handles);
+    tf_free(threads);
+
+    return bunyArLibBenchmarkReport(ctx, "concurrent", "all", threadCount, &result) && success;
+}
+
+bool bunyArLibReadBenchmarks(ResourceDirectory rd, const char* archivePath, const struct BunyArLibReadBenchmarkDesc* inDesc)
+{
+    struct BunyArLibReadBenchmarkDesc desc = *inDesc;
+
+    if (!desc.iterations)
+        desc.iterations = 3;
+    if (!desc.randomReadCount)
+        desc.randomReadCount = 10000;
+    if (!desc.randomReadSize)
+        desc.randomReadSize = 4 * 1024;
+    if (!desc.threadCount)
+        desc.threadCount = getNumCPUCores();
+
+    struct BunyArLibBenchmarkContext ctx = { 0 };
+    ctx.desc = &desc;
+
+    bool success = true;
+
+    if (desc.outputPath && !fsOpenStreamFromPath(desc.outputRd, desc.outputPath, FM_WRITE, &ctx.output))
+    {
+        LOGF(eERROR, "Failed to open benchmark output file '%s'", desc.outputPath);
+        return false;
+    }
+
+    char line[FS_MAX_PATH + 128];
+    int  lineSize = snprintf(line, sizeof line,
+                             "# archive %s\n# random reads %llu x %u bytes\n"
+                             "# test\tmode\tformat\tthreads\titeration\toperations\tbytes\tseconds\tMB/s\tp50 us\tp99 us\tmax us\n",
+                             archivePath, (unsigned long long)desc.randomReadCount, desc.randomReadSize);
+    if (lineSize >= (int)sizeof line)
+        lineSize = (int)sizeof line - 1;
+
+    if (ctx.output.pIO)
+        success = fsWriteToStream(&ctx.output, line, (size_t)lineSize) == (size_t)lineSize;
+    else
+        fputs(line, stdout);
+
+    static const char* MODES[] = { "stream", "mmap" };
+
+    for (uint32_t mi = 0; success && mi < TF_ARRAY_COUNT(MODES); ++mi)
+    {
+        struct ArchiveOpenDesc openDesc = { 0 };
+        openDesc.disableHashTable = true;
+        // concurrent test reads files of one archive from several threads
+        openDesc.protectStreamCriticalSection = true;
+        openDesc.mmap = mi == 1;
+
+        IFileSystem archive = { 0 };
+        if (!fsArchiveOpen(rd, archivePath, &openDesc, &archive))
+        {
+            success = false;
+            break;
+        }
+
+        struct BunyArDescription info;
+        fsArchiveGetDescription(&archive, &info);
+
+        uint64_t maxFileSize = desc.randomReadSize;
+        for (uint64_t i = 0; i < info.nodeCount; ++i)
+        {
+            struct BunyArNodeDescription node;
+            fsArchiveGetNodeDescription(&archive, i, &node);
+            maxFileSize = node.fileSize > maxFileSize ? node.fileSize : maxFileSize;
+        }
+
+        ctx.archive = &archive;
+        ctx.nodeCount = info.nodeCount;
+        ctx.readSize = maxFileSize < BUNYAR_LIB_BENCHMARK_READ_SIZE_MAX ? maxFileSize : BUNYAR_LIB_BENCHMARK_READ_SIZE_MAX;
+        ctx.mode = MODES[mi];
+
+        uint8_t* buffer = (uint8_t*)tf_malloc(ctx.readSize);
+        success = buffer != NULL;
+
+        for (ctx.iteration = 0; success && ctx.iteration < desc.iterations; ++ctx.iteration)
+        {
+            success = bunyArLibBenchmarkSequential(&ctx, buffer) && bunyArLibBenchmarkRandom(&ctx, buffer) &&
+                      bunyArLibBenchmarkConcurrent(&ctx);
+        }
+
+        tf_free(buffer);
+        fsArchiveClose(&archive);
+    }
+
+    if (ctx.output.pIO && !fsCloseStream(&ctx.output))
+        success = false;
+
+    return success;
+}
@@ -71,6 +71,9 @@ extern "C"
         struct BunyArLibEntryCreateDesc* entries;
 
         bool     skipHashTable;
+        // By default files with identical content are stored once,
+        // identical blocks of one file are stored once too
+        bool     skipDeduplication;
         // larger value, more details
         unsigned verbose;
 
@@ -88,6 +91,45 @@ extern "C"
         // Minimum is 4KB
         // If 0, it sets to default 4MB
         size_t memorySizePerThread;
+
+        // zstd entries with size <= limit share dictionaries sampled from their content.
+        // One dictionary is built per file extension and compression level.
+        // If 0, dictionaries are not used
+        uint32_t dictionaryFileSizeLimitKb;
+
+        // Size limit of one dictionary.
+        // If 0, it sets to default 64KB
+        uint32_t dictionarySizeKb;
+
+        // Output names of entries to write first, in this order,
+        // e.g. access trace saved by fsArchiveSaveAccessTrace.
+        // Other entries follow in name order. Node table is sorted by name regardless.
+        uint64_t           layoutOrderCount;
+        const char* const* layoutOrder;
+
+        // Previous version of the archive to update, ignored if NULL.
+        // Entries with the same name, size, format, block size and content hash
+        // are copied from it without compression, only new or changed entries are compressed.
+        // Changes of compression level are not detected.
+        // Entries compressed with dictionaries are always compressed again.
+        // Must not be the same file as the archive being written.
+        ResourceDirectory previousArchiveRd;
+        const char*       previousArchivePath;
+
+        // If not 0, format, compression level and block size of every entry are chosen automatically.
+        // Sample of each file is compressed with LZ4 and ZSTD at several levels and block sizes,
+        // the smallest result which decompresses on this machine at least at this speed is used,
+        // equally sized results are resolved by a fixed codec order. Files which do not compress
+        // well enough are stored raw. Entry settings are overridden.
+        // Entries unchanged since previousArchivePath keep their previous format and block size.
+        uint32_t autoCodecDecodeSpeedMBps;
+
+        // Tab separated report of chosen settings, one line per entry. Ignored if NULL
+        ResourceDirectory autoCodecReportRd;
+        const char*       autoCodecReportPath;
+
+        // Only select codecs and write report, archive is not created
+        bool analyzeOnly;
     };
 
     static const struct BunyArLibEntryCreateDesc BUNYAR_LIB_FUNC_CREATE_DEFAULT_ENTRY_DESC = {
@@ -105,6 +147,15 @@ extern "C"
 
     bool bunyArLibCreate(ResourceDirectory rd, const char* dstPath, const struct BunyArLibCreateDesc* desc);
 
+    // Writes all files of 'archive' to a new archive, keeping their formats and block sizes.
+    // Archive doesn't store compression levels. Set desc->previousArchivePath to the file of 'archive'
+    // to copy compressed files as they are, see BunyArLibCreateDesc::previousArchivePath.
+    // Files which are compressed again use lz4Level and zstdLevel, BUNYAR_LIB_COMPRESSION_LEVEL_DEFAULT for defaults.
+    // 'archiveRd' must be bound to 'archive' with empty path, see fsSetPathForResourceDir.
+    // desc->entries are ignored, other settings are used the same way as in bunyArLibCreate.
+    bool bunyArLibRepack(struct IFileSystem* archive, ResourceDirectory archiveRd, ResourceDirectory rd, const char* dstPath,
+                         const struct BunyArLibCreateDesc* desc, int lz4Level, int zstdLevel);
+
     struct BunyArLibExtractDesc
     {
         // if fileNameCount is 0, all files are extracted
@@ -128,6 +179,31 @@ extern "C"
 
     bool bunyArLibHashTableBenchmarks(size_t keyCount, size_t keySize);
 
+    struct BunyArLibReadBenchmarkDesc
+    {
+        // Every test runs this many times, each run is reported. If 0, it sets to default 3
+        uint32_t iterations;
+
+        // Random reads of 'randomReadSize' bytes at random offsets of random files.
+        // If 0, defaults are 10000 reads of 4KB
+        uint64_t randomReadCount;
+        uint32_t randomReadSize;
+
+        // Threads reading different files at once. If 0, uses getNumCPUCores()
+        uint32_t threadCount;
+
+        // Tab separated results, one line per run. If NULL, results are printed to stdout
+        ResourceDirectory outputRd;
+        const char*       outputPath;
+    };
+
+    // Measures reading 'archivePath' the way applications do:
+    //     sequential - every file is read whole, in node order, results are also split by file format
+    //     random     - small reads at random offsets, every read opens the file again
+    //     concurrent - files are read whole by several threads with their own streams
+    // Each test runs with the archive read through a file stream and through memory map.
+    bool bunyArLibReadBenchmarks(ResourceDirectory rd, const char* archivePath, const struct BunyArLibReadBenchmarkDesc* desc);
+
 #ifdef __cplusplus
 }
 #endif
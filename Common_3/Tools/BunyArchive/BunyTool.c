@@ -37,6 +37,8 @@ static const char DIR_SEP = '/';
 static const char BUNYAR_TOOL_NAME[] = "buny";
 
 static const enum ResourceDirectory TF_RD = 0;
+// Source archive of "repack" command
+static const enum ResourceDirectory TF_ARCHIVE_RD = RD_OTHER_FILES;
 
 enum ArgType
 {
@@ -46,6 +48,7 @@ enum ArgType
     AT_COMPRESSION_LEVEL,
     AT_BLOCK_SIZE,
     AT_HASHMAP,
+    AT_DEDUP,
     AT_OPTIONAL,
     AT_BLOCKS,
     AT_NAME,
@@ -56,6 +59,17 @@ enum ArgType
     AT_PARALLEL_READS,
     AT_MEMORY_SIZE,
     AT_THREADS,
+    AT_DICT_FILES,
+    AT_DICT_SIZE,
+    AT_TRACE,
+    AT_UPDATE,
+    AT_AUTO_CODEC,
+    AT_REPORT,
+    AT_ANALYZE_ONLY,
+    AT_ITERATIONS,
+    AT_RANDOM_READS,
+    AT_READ_SIZE,
+    AT_OUTPUT,
 };
 
 struct ArgTracker
@@ -71,6 +85,7 @@ struct BunyArToolCtx
 {
     // archive create flags
     bool hashMap;
+    bool dedup;
 
     // archive create entry args
     size_t                outputNameCutLength; // only set by drag&drop
@@ -83,6 +98,13 @@ struct BunyArToolCtx
     int                   threadCount;
     size_t                parallelFileReads;
     size_t                MBPerThread;
+    uint32_t              dictionaryFileLimitKb;
+    uint32_t              dictionarySizeKb;
+    char*                 tracePath;
+    char*                 updatePath;
+    uint32_t              autoCodecMBps;
+    char*                 reportPath;
+    bool                  analyzeOnly;
 
     // inspect
     bool inspectBlocks;
@@ -91,8 +113,12 @@ struct BunyArToolCtx
     bool keepGoing;
 
     // benchmark
-    size_t keyCount;
-    size_t keySize;
+    size_t   keyCount;
+    size_t   keySize;
+    uint32_t iterations;
+    uint64_t randomReadCount;
+    uint32_t randomReadSize;
+    char*    outputPath;
 
     // global
     bool     archivePathDontWanna;
@@ -126,8 +152,17 @@ static struct ArgTracker ARG_TRACKER_CREATE[] = {
 	{ "--parallel-reads", AT_PARALLEL_READS,    1, 99, "max number of file streams when thread pool enabled" },
 	{ "--thread-memory",  AT_MEMORY_SIZE,       1, 64, "MB of memory allocated per thread. Threads can starve on low amount." },
 	{ "--bsize",          AT_BLOCK_SIZE,        1, (BUNYAR_BLOCK_MAX_SIZE_MINUS_ONE + 1) / 1024, "size of compressed data block in KB" },
+	{ "--dict-files",     AT_DICT_FILES,        0, 1024 * 1024, "ZSTD files up to this size in KB share dictionaries. 0 disables" },
+	{ "--dict-size",      AT_DICT_SIZE,         1, 1024 * 1024, "dictionary size limit in KB (default 64)" },
+	{ "--trace",          AT_TRACE,             1, 0, "write files listed in this file first, one name per line" },
+	{ "--update",         AT_UPDATE,            1, 0, "copy unchanged files from this archive instead of compressing. Can be the output archive" },
+	{ "--auto-codec",     AT_AUTO_CODEC,        1, 1000 * 1000, "choose codec per file, smallest one decoding at least this fast in MB/s" },
+	{ "--report",         AT_REPORT,            1, 0, "write codecs chosen by --auto-codec to this file" },
+	{ "--analyze-only",   AT_ANALYZE_ONLY,      0, 0, "only choose codecs and write the report, no archive is written" },
 	{ "--hashmap",        AT_HASHMAP,           0, 0, "precompute hash table (enabled by default)" },
 	{ "--no-hashmap",     AT_HASHMAP,           0, 0, "disable hash table precomputing" },
+	{ "--dedup",          AT_DEDUP,             0, 0, "store identical files and blocks once (enabled by default)" },
+	{ "--no-dedup",       AT_DEDUP,             0, 0, "disable deduplication" },
 	{ "--optional",       AT_OPTIONAL,          0, 0, "keep going if next entries are missing" },
 	{ "--required",       AT_OPTIONAL,          0, 0, "undo --optional" },
 	{ "--help",           AT_HELP,              0, 0, "be provided with something that is useful or necessary in achieving" },
@@ -145,9 +180,30 @@ static struct ArgTracker ARG_TRACKER_EXTRACT[] = {
 	{ "--help",       AT_HELP,              0, 0, "gain assistance or support to achieve goals" },
 	{ NULL,           AT_UNRECOGNIZED,      0, 0, NULL },
 };
+static struct ArgTracker ARG_TRACKER_REPACK[] = {
+	{ "--zstdcl",         AT_COMPRESSION_LEVEL, 0, 0, "compression level for ZSTD files which are compressed again" },
+	{ "--lz4cl",          AT_COMPRESSION_LEVEL, 0, 0, "compression level for LZ4 files which are compressed again" },
+	{ "--trace",          AT_TRACE,             1, 0, "write files listed in this file first, one name per line" },
+	{ "--threads",        AT_THREADS,          -1, 99, "thread pool size. 0 singlethreaded. -1 auto" },
+	{ "--dict-files",     AT_DICT_FILES,        0, 1024 * 1024, "ZSTD files up to this size in KB share dictionaries. 0 disables" },
+	{ "--dict-size",      AT_DICT_SIZE,         1, 1024 * 1024, "dictionary size limit in KB (default 64)" },
+	{ "--hashmap",        AT_HASHMAP,           0, 0, "precompute hash table (enabled by default)" },
+	{ "--no-hashmap",     AT_HASHMAP,           0, 0, "disable hash table precomputing" },
+	{ "--dedup",          AT_DEDUP,             0, 0, "store identical files and blocks once (enabled by default)" },
+	{ "--no-dedup",       AT_DEDUP,             0, 0, "disable deduplication" },
+	{ "--quiet",          AT_VERBOSITY,         0, 0, "disable stdout output (log not affected)" },
+	{ "--verbose",        AT_VERBOSITY,         0, 0, "display useful statistics" },
+	{ "--help",           AT_HELP,              0, 0, "assistance in putting things back in order" },
+	{ NULL,               AT_UNRECOGNIZED,      0, 0, NULL },
+};
 static struct ArgTracker ARG_TRACKER_BENCHMARK[] = {
 	{ "--key-count",  AT_KEY_COUNT,         0, 1000 * 1000 * 1000, "number of keys" },
 	{ "--key-size",   AT_KEYSIZE,           1, 512, "size of key in bytes" },
+	{ "--iterations", AT_ITERATIONS,        1, 1000, "archive read benchmark: runs of every test (default 3)" },
+	{ "--random-reads", AT_RANDOM_READS,    1, 1000 * 1000 * 1000, "archive read benchmark: number of random reads (default 10000)" },
+	{ "--read-size",  AT_READ_SIZE,         1, 64 * 1024 * 1024, "archive read benchmark: bytes per random read (default 4096)" },
+	{ "--threads",    AT_THREADS,          -1, 256, "archive read benchmark: concurrent readers. -1 auto" },
+	{ "--output",     AT_OUTPUT,            1, 0, "archive read benchmark: write results to this file instead of stdout" },
 	{ "--help",       AT_HELP,              0, 0, "get support or aid" },
 	{ NULL,           AT_UNRECOGNIZED,      0, 0, NULL },
 };
@@ -258,6 +314,9 @@ static bool nextArg(struct BunyArToolCtx* ctx, char** out)
         case AT_HASHMAP:
             ctx->hashMap = resolver != 'n';
             break;
+        case AT_DEDUP:
+            ctx->dedup = resolver != 'n';
+            break;
         case AT_VERBOSITY:
             ctx->verbose = resolver == 'q' ? 0 : 2;
             break;
@@ -291,6 +350,39 @@ static bool nextArg(struct BunyArToolCtx* ctx, char** out)
         case AT_MEMORY_SIZE:
             ctx->MBPerThread = (size_t)value;
             break;
+        case AT_DICT_FILES:
+            ctx->dictionaryFileLimitKb = (uint32_t)value;
+            break;
+        case AT_DICT_SIZE:
+            ctx->dictionarySizeKb = (uint32_t)value;
+            break;
+        case AT_TRACE:
+            ctx->tracePath = b;
+            break;
+        case AT_UPDATE:
+            ctx->updatePath = b;
+            break;
+        case AT_AUTO_CODEC:
+            ctx->autoCodecMBps = (uint32_t)value;
+            break;
+        case AT_REPORT:
+            ctx->reportPath = b;
+            break;
+        case AT_ANALYZE_ONLY:
+            ctx->analyzeOnly = true;
+            break;
+        case AT_ITERATIONS:
+            ctx->iterations = (uint32_t)value;
+            break;
+        case AT_RANDOM_READS:
+            ctx->randomReadCount = (uint64_t)value;
+            break;
+        case AT_READ_SIZE:
+            ctx->randomReadSize = (uint32_t)value;
+            break;
+        case AT_OUTPUT:
+            ctx->outputPath = b;
+            break;
         case AT_UNRECOGNIZED:
         default:
             fprintf(stderr, "Unrecognized argument '%s'\n", a);
@@ -335,6 +427,59 @@ static void displayArgsHelp(struct ArgTracker* args)
     putc('\n', stdout);
 }
 
+// Splits trace file into lines, 'outContent' owns strings referenced by desc->layoutOrder
+static bool loadTrace(const char* path, char** outContent, struct BunyArLibCreateDesc* desc)
+{
+    FileStream fs = { 0 };
+    if (!fsOpenStreamFromPath(TF_RD, path, FM_READ, &fs))
+    {
+        fprintf(stderr, "Failed to open trace file '%s'\n", path);
+        return false;
+    }
+
+    ssize_t size = fsGetStreamFileSize(&fs);
+    char*   content = size >= 0 ? tf_malloc((size_t)size + 1) : NULL;
+    bool    success = content && fsReadFromStream(&fs, content, (size_t)size) == (size_t)size;
+    fsCloseStream(&fs);
+
+    if (!success)
+    {
+        fprintf(stderr, "Failed to read trace file '%s'\n", path);
+        tf_free(content);
+        return false;
+    }
+
+    content[size] = 0;
+
+    uint64_t lineCount = 1;
+    for (ssize_t i = 0; i < size; ++i)
+        lineCount += content[i] == '\n';
+
+    const char** names = tf_malloc(sizeof *names * lineCount);
+    uint64_t     nameCount = 0;
+
+    for (char* line = content; line;)
+    {
+        char* next = strchr(line, '\n');
+        if (next)
+            *next++ = 0;
+
+        size_t len = strlen(line);
+        if (len && line[len - 1] == '\r')
+            line[--len] = 0;
+
+        if (len)
+            names[nameCount++] = line;
+
+        line = next;
+    }
+
+    *outContent = content;
+    desc->layoutOrder = names;
+    desc->layoutOrderCount = nameCount;
+    return true;
+}
+
 static int bunyArToolCreate(struct BunyArToolCtx* ctx)
 {
     {
@@ -357,7 +502,11 @@ static int bunyArToolCreate(struct BunyArToolCtx* ctx)
 	  "Create archive from the list of entries. Entries are directory or file paths.\n"
 	  "\nUsage:\n\tcreate output_file --zstd Art --lz4 readme.txt --name backup /home/Downloads\n\n"
 	  "Each entry has its own set of options, e.g. Art directory is compressed using ZSTD, while \"readme.txt\" and \"/home/Downloads\" entries are compressed using LZ4.\n\n"
-	  "\"--name\" argument is used to set name for next entry, so files from \"/home/Downloads/\" are going to be located in the \"backup/\" archive directory.\n";
+	  "\"--name\" argument is used to set name for next entry, so files from \"/home/Downloads/\" are going to be located in the \"backup/\" archive directory.\n\n"
+	  "\"--update\" argument compresses only new or changed files, unchanged files are copied from the given archive:\n\tcreate output_file --update output_file --zstd Art\n\n"
+	  "\"--auto-codec\" argument overrides format, compression level and block size of every file. "
+	  "Codecs are benchmarked on a sample of each file, the smallest result decompressing at the given speed is used:\n"
+	  "\tcreate output_file --auto-codec 1000 --report codecs.tsv Art\n";
     // clang-format on
 
     struct BunyArLibCreateDesc info = { 0 };
@@ -415,15 +564,66 @@ static int bunyArToolCreate(struct BunyArToolCtx* ctx)
     if (success)
     {
         info.skipHashTable = !ctx->hashMap;
+        info.skipDeduplication = !ctx->dedup;
         info.verbose = ctx->verbose;
 
         info.maxParallelFileReads = ctx->parallelFileReads;
         info.threadPoolSize = ctx->threadCount;
         info.memorySizePerThread = ctx->MBPerThread * 1024 * 1024;
+        info.dictionaryFileSizeLimitKb = ctx->dictionaryFileLimitKb;
+        info.dictionarySizeKb = ctx->dictionarySizeKb;
+
+        info.autoCodecDecodeSpeedMBps = ctx->autoCodecMBps;
+        info.autoCodecReportRd = TF_RD;
+        info.autoCodecReportPath = ctx->reportPath;
+        info.analyzeOnly = ctx->analyzeOnly;
+
+        if ((ctx->reportPath || ctx->analyzeOnly) && !ctx->autoCodecMBps)
+        {
+            fprintf(stderr, "\"--report\" and \"--analyze-only\" require \"--auto-codec\"\n");
+            success = false;
+        }
+    }
+
+    char* traceContent = NULL;
+
+    if (success && ctx->tracePath)
+        success = loadTrace(ctx->tracePath, &traceContent, &info);
+
+    // Updated archive is written next to the previous one and replaces it on success
+    char        tmpPath[FS_MAX_PATH];
+    const char* dstPath = ctx->archivePath;
+
+    if (success && ctx->updatePath && !ctx->analyzeOnly)
+    {
+        info.previousArchiveRd = TF_RD;
+        info.previousArchivePath = ctx->updatePath;
 
-        success = bunyArLibCreate(TF_RD, ctx->archivePath, &info);
+        if (strcmp(ctx->updatePath, ctx->archivePath) == 0)
+        {
+            snprintf(tmpPath, sizeof tmpPath, "%s.tmp", ctx->archivePath);
+            dstPath = tmpPath;
+        }
     }
 
+    if (success)
+        success = bunyArLibCreate(TF_RD, dstPath, &info);
+
+    if (dstPath != ctx->archivePath)
+    {
+        if (success && (!fsRemoveFile(TF_RD, ctx->archivePath) || !fsRenameFile(TF_RD, dstPath, ctx->archivePath)))
+        {
+            fprintf(stderr, "Failed to replace archive '%s' with '%s'\n", ctx->archivePath, dstPath);
+            success = false;
+        }
+        else if (!success)
+        {
+            fsRemoveFile(TF_RD, dstPath);
+        }
+    }
+
+    tf_free(traceContent);
+    tf_free((void*)info.layoutOrder);
     tf_free(info.entries);
 
     return success ? 0 : -1;
@@ -475,6 +675,9 @@ static int bunyArToolInspect(struct BunyArToolCtx* ctx)
         fprintf(stdout, "'%s'\n|- %s %s -> %s (x%.2f)\n", node.name, bunyArFormatName(node.format), humanReadableSize(node.fileSize).str,
                 humanReadableSize(node.compressedSize).str, (double)node.fileSize / (double)node.compressedSize);
 
+        if (node.dictionary)
+            fprintf(stdout, "|- dictionary #%u\n", node.dictionary);
+
         if (ctx->inspectBlocks && node.format != BUNYAR_FILE_FORMAT_RAW)
         {
             FileStream fs;
@@ -569,6 +772,101 @@ static int bunyArToolExtract(struct BunyArToolCtx* ctx)
     return success ? 0 : -1;
 }
 
+static int bunyArToolRepack(struct BunyArToolCtx* ctx)
+{
+    {
+        int min;
+        int max;
+
+        bunyArLibCompressionLevelLimits(BUNYAR_FILE_FORMAT_ZSTD_BLOCKS, &min, &max);
+        ARG_TRACKER_REPACK[0].min = min;
+        ARG_TRACKER_REPACK[0].max = max;
+
+        bunyArLibCompressionLevelLimits(BUNYAR_FILE_FORMAT_LZ4_BLOCKS, &min, &max);
+        ARG_TRACKER_REPACK[1].min = min;
+        ARG_TRACKER_REPACK[1].max = max;
+    }
+
+    ctx->argTrackers = ARG_TRACKER_REPACK;
+
+    // clang-format off
+	ctx->helpStr =
+	  "Rewrite archive to a new file. Files listed in the trace are written first, in the listed order.\n"
+	  "Record the trace with ArchiveOpenDesc::recordAccessTrace and fsArchiveSaveAccessTrace,\n"
+	  "so files are laid out in the order they are loaded.\n"
+	  "Compressed files are copied as they are. Files which share ZSTD dictionaries, and all files of archives\n"
+	  "without content hashes, are compressed again at --zstdcl and --lz4cl levels, default levels if not given.\n"
+	  "\nUsage:\n\trepack archive_file output_file --trace trace.txt\n";
+    // clang-format on
+
+    const char* output = NULL;
+    for (;;)
+    {
+        char* arg;
+        if (!nextArg(ctx, &arg))
+            return -1;
+
+        if (arg == NULL)
+            break;
+
+        if (output)
+        {
+            fprintf(stderr, "Unexpected argument '%s'\n", arg);
+            return -1;
+        }
+
+        output = arg;
+    }
+
+    if (ctx->help)
+        return -1;
+
+    if (!ctx->archivePath || !output)
+    {
+        fprintf(stderr, "Expected archive path and output path\n");
+        return -1;
+    }
+
+    struct BunyArLibCreateDesc info = { 0 };
+
+    info.skipHashTable = !ctx->hashMap;
+    info.skipDeduplication = !ctx->dedup;
+    info.verbose = ctx->verbose;
+    info.threadPoolSize = ctx->threadCount;
+    info.dictionaryFileSizeLimitKb = ctx->dictionaryFileLimitKb;
+    info.dictionarySizeKb = ctx->dictionarySizeKb;
+    // Archive doesn't keep compression levels, unchanged files are copied from it instead
+    info.previousArchiveRd = TF_RD;
+    info.previousArchivePath = ctx->archivePath;
+
+    char* traceContent = NULL;
+    bool  success = !ctx->tracePath || loadTrace(ctx->tracePath, &traceContent, &info);
+
+    // files are read by several threads
+    struct ArchiveOpenDesc adesc = { 0 };
+    adesc.protectStreamCriticalSection = true;
+
+    IFileSystem archiveFs = { 0 };
+    if (success && !fsArchiveOpen(TF_RD, ctx->archivePath, &adesc, &archiveFs))
+    {
+        fprintf(stderr, "Failed to open archive %s\n", ctx->archivePath);
+        success = false;
+    }
+
+    if (success)
+    {
+        fsSetPathForResourceDir(&archiveFs, TF_ARCHIVE_RD, "");
+        success = bunyArLibRepack(&archiveFs, TF_ARCHIVE_RD, TF_RD, output, &info, ctx->lz4cl, ctx->zstdcl);
+    }
+
+    fsArchiveClose(&archiveFs);
+
+    tf_free(traceContent);
+    tf_free((void*)info.layoutOrder);
+
+    return success ? 0 : -1;
+}
+
 static int bunyArToolBenchmark(struct BunyArToolCtx* ctx)
 {
     ctx->archivePathDontWanna = true;
@@ -576,10 +874,14 @@ static int bunyArToolBenchmark(struct BunyArToolCtx* ctx)
 
     // clang-format off
 	ctx->helpStr =
-	  "Hash table benchmark.\n"
-	  "\nUsage:\n\tbenchmark --key-size=8 --key-count=100000000\n";
+	  "Hash table benchmark, or archive read benchmark if archive is given.\n"
+	  "Read benchmark prints tab separated results: sequential reads of whole files (also split by format),\n"
+	  "random small reads and concurrent reads, through file stream and memory map.\n"
+	  "\nUsage:\n\tbenchmark --key-size=8 --key-count=100000000\n"
+	  "\tbenchmark archive_file --iterations=5 --output=results.tsv\n";
     // clang-format on
 
+    const char* archivePath = NULL;
     for (;;)
     {
         char* arg;
@@ -589,11 +891,28 @@ static int bunyArToolBenchmark(struct BunyArToolCtx* ctx)
         if (arg == NULL)
             break;
 
-        fprintf(stderr, "Unexpected argument '%s'\n", arg);
-        return -1;
+        if (archivePath)
+        {
+            fprintf(stderr, "Unexpected argument '%s'\n", arg);
+            return -1;
+        }
+
+        archivePath = arg;
     }
 
-    return bunyArLibHashTableBenchmarks(ctx->keyCount, ctx->keySize) ? 0 : -1;
+    if (!archivePath)
+        return bunyArLibHashTableBenchmarks(ctx->keyCount, ctx->keySize) ? 0 : -1;
+
+    struct BunyArLibReadBenchmarkDesc desc = { 0 };
+
+    desc.iterations = ctx->iterations;
+    desc.randomReadCount = ctx->randomReadCount;
+    desc.randomReadSize = ctx->randomReadSize;
+    desc.threadCount = ctx->threadCount > 0 ? (uint32_t)ctx->threadCount : 0;
+    desc.outputRd = TF_RD;
+    desc.outputPath = ctx->outputPath;
+
+    return bunyArLibReadBenchmarks(TF_RD, archivePath, &desc) ? 0 : -1;
 }
 
 static inline bool isRootPath(char* path)
@@ -827,6 +1146,7 @@ static int bunyArTool(int argCount, char** args)
         fprintf(stdout, "\tcreate      Create archive\n");
         fprintf(stdout, "\tinspect     Lookup archive content\n");
         fprintf(stdout, "\textract     Extract archive\n");
+        fprintf(stdout, "\trepack      Rewrite archive in recorded access order\n");
         fprintf(stdout, "\tbenchmark   Run benchmarks\n");
         putc('\n', stdout);
         return argCount != 1;
@@ -840,6 +1160,7 @@ static int bunyArTool(int argCount, char** args)
 
     ctx.verbose = 1;
     ctx.hashMap = true;
+    ctx.dedup = true;
 
     ctx.blockSizeKb = defaults.blockSizeKb;
     ctx.format = defaults.format;
@@ -864,6 +1185,8 @@ static int bunyArTool(int argCount, char** args)
         res = bunyArToolInspect(&ctx);
     else if (strcmp(cmd, "extract") == 0)
         res = bunyArToolExtract(&ctx);
+    else if (strcmp(cmd, "repack") == 0)
+        res = bunyArToolRepack(&ctx);
     else if (strcmp(cmd, "benchmark") == 0)
         res = bunyArToolBenchmark(&ctx);
     else
@@ -26,6 +26,7 @@ Forge Material Compiler
 
 import os, sys, argparse
 import string
+import struct
 from enum import Enum
 
 class TextureFlags(Enum):
@@ -66,7 +67,7 @@ class ShaderSet:
         
     @staticmethod
     def shader_extension(index):
-        types = [ ".vert", ".frag", ".tesc", "tese", ".geom", ".comp" ]
+        types = [ ".vert", ".frag", ".tesc", ".tese", ".geom", ".comp" ]
         return types[index]
 
 class MaterialSet:    
@@ -197,11 +198,117 @@ def build_material_header(mat):
     header = "{0} {1} {2} {3} {4} {5} {6}".format(len(mat.shader_sets), len(mat.texture_sets), len(mat.material_sets), total_num_shaders, total_num_textures, max_shader_bindings, max_textures_in_set)
     return ":FMC " + header
 
+# Binary material format, read by parseMaterialBinary in ResourceLoader.cpp.
+# Little endian, every section is 4 byte aligned and offsets are from the start of the file.
+#   header         magic ":FMB", version, counts and section offsets, see MaterialBinaryHeader
+#   shader sets    id, vert, frag, hull, domain, geom, comp shader indexes, first binding, binding count
+#   texture sets   first index in texture indexes, texture count
+#   material sets  name string offset, shader set index, texture set index
+#   texture idxs   texture indexes of all texture sets
+#   texture ids    global texture ids
+#   texture names  string offsets
+#   shader names   string offsets
+#   binding names  string offsets
+#   texture flags  one byte per texture
+#   strings        null terminated, every string is stored once
+BINARY_MAGIC = b":FMB"
+BINARY_VERSION = 1
+BINARY_INVALID_INDEX = 0xFFFFFFFF
+
+class StringTable:
+    def __init__(self):
+        self.data = bytearray()
+        self.offsets = {}
+
+    def add(self, value):
+        if value not in self.offsets:
+            self.offsets[value] = len(self.data)
+            self.data += value.encode("utf-8") + b"\0"
+        return self.offsets[value]
+
+def align4(data):
+    data += b"\0" * (-len(data) % 4)
+
+def build_binary_material(mat, unique_shader_sets, unique_texture_idxs):
+    strings = StringTable()
+
+    # Shaders and textures used by several sets are stored once
+    shader_names = []
+    texture_keys = []
+    texture_ids = []
+    texture_names = []
+    texture_flags = []
+    binding_names = []
+    texture_idxs = []
+
+    shader_sets = bytearray()
+    for shader_set in mat.shader_sets:
+        stages = []
+        for index, name in enumerate(shader_set.shaders):
+            if not name:
+                stages += [ BINARY_INVALID_INDEX ]
+                continue
+            full_name = strings.add(name + shader_set.shader_extension(index))
+            if full_name not in shader_names: shader_names += [ full_name ]
+            stages += [ shader_names.index(full_name) ]
+
+        first_binding = len(binding_names)
+        binding_names += [ strings.add(binding) for binding in shader_set.bindings ]
+        shader_sets += struct.pack("<9I", unique_shader_sets.index(shader_set.name), *stages, first_binding, len(shader_set.bindings))
+
+    texture_sets = bytearray()
+    for texture_set in mat.texture_sets:
+        texture_sets += struct.pack("<2I", len(texture_idxs), len(texture_set.textures))
+        for texture in texture_set.textures:
+            if texture.unique_name not in texture_keys:
+                texture_keys += [ texture.unique_name ]
+                texture_ids += [ unique_texture_idxs.index(texture.unique_name) ]
+                texture_names += [ strings.add(texture.name) ]
+                texture_flags += [ texture.combined_flags ]
+            texture_idxs += [ texture_keys.index(texture.unique_name) ]
+
+    material_sets = bytearray()
+    for material_set in mat.material_sets:
+        material_sets += struct.pack("<3I", strings.add(material_set.name), material_set.shader_set_idx, material_set.texture_set_idx)
+
+    max_shader_bindings = max([ len(shader_set.bindings) for shader_set in mat.shader_sets ], default=0)
+    max_textures_in_set = max([ len(texture_set.textures) for texture_set in mat.texture_sets ], default=0)
+
+    sections = [
+        shader_sets,
+        texture_sets,
+        material_sets,
+        struct.pack("<{0}I".format(len(texture_idxs)), *texture_idxs),
+        struct.pack("<{0}I".format(len(texture_ids)), *texture_ids),
+        struct.pack("<{0}I".format(len(texture_names)), *texture_names),
+        struct.pack("<{0}I".format(len(shader_names)), *shader_names),
+        struct.pack("<{0}I".format(len(binding_names)), *binding_names),
+        bytes(texture_flags),
+        strings.data,
+    ]
+
+    counts = [ len(mat.shader_sets), len(mat.texture_sets), len(mat.material_sets), len(shader_names), len(texture_ids),
+               len(binding_names), len(texture_idxs), max_shader_bindings, max_textures_in_set, len(strings.data) ]
+    header_size = 4 + 4 * (1 + len(counts) + len(sections))
+
+    offsets = []
+    body = bytearray()
+    for section in sections:
+        offsets += [ header_size + len(body) ]
+        body += section
+        align4(body)
+
+    header = BINARY_MAGIC + struct.pack("<{0}I".format(1 + len(counts) + len(offsets)), BINARY_VERSION, *counts, *offsets)
+    assert(len(header) == header_size)
+    return header + body
+
 def get_args():
     parser = argparse.ArgumentParser()
     parser.add_argument('-d', '--directory', help='input directory', required=True)
     parser.add_argument('-o', '--output', help='output directory', required=True)
     parser.add_argument('--verbose', default=False, action='store_true')
+    # Text output is readable and is loaded by the runtime too, binary output is loaded without parsing
+    parser.add_argument('--text', default=False, action='store_true', help='output materials in text format')
     # TODO: Add incremental compilation
     #parser.add_argument('--incremental', default=False, action='store_true')
     args = parser.parse_args()
@@ -216,6 +323,7 @@ def main():
     in_directory = args.directory
     out_directory = args.output
     verbose = args.verbose
+    text = args.text
 
     all_mat_filenames = []
     for f in os.listdir(in_directory): 
@@ -279,6 +387,12 @@ def main():
 
     # 3. Output compiled materials that reference resources using unique ids (indexes in the unique resource arrays from previous step)
     for mat in all_materials:
+        output_filepath = make_full_filepath(out_directory, mat.filename)
+        if not text:
+            with open(output_filepath, "wb") as out_file:
+                out_file.write(build_binary_material(mat, unique_shader_sets, unique_texture_idxs))
+            continue
+
         lines = [ build_material_header(mat) ]
 
         # shader sets
@@ -307,7 +421,6 @@ def main():
             lines += [ "t {0}".format(material_set.texture_set_idx) ]
 
         lines += [ "" ]
-        output_filepath = make_full_filepath(out_directory, mat.filename)
         with open(output_filepath, "w", newline='') as out_file:
             out_file.write("\n".join(lines))
 
@@ -265,8 +265,6 @@ static void uiSetWidgetAllocatorPlotBufferChunkAllocatorData(UIWidget* pWidget,
     uint32_t nValues = (uint32_t)pPlotWidget->mSize[0];
     int64_t* values = pPlotWidget->pValues;
 
-    uint32_t unusedChunkCount = (uint32_t)arrlenu(data->mUnusedChunks);
-
     values[0] = (int64_t)data->mSize;
     ++values;
 
@@ -276,15 +274,19 @@ static void uiSetWidgetAllocatorPlotBufferChunkAllocatorData(UIWidget* pWidget,
     uint32_t point = 0;
     int64_t  intensity = 0;
 
-    int64_t floatingOccupiedChunks = unusedChunkCount + 1;
+    int64_t floatingOccupiedChunks = data->mFreeChunkCount + 1;
 
-    for (uint32_t ci = 0; ci < unusedChunkCount; ++ci)
+    // Nodes are linked in offset order
+    for (uint32_t ni = data->mFirstNode; ni != UINT32_MAX; ni = data->pNodes[ni].mNext)
     {
-        BufferChunk* freeChunk = data->mUnusedChunks + ci;
+        if (!data->pNodes[ni].mFree)
+            continue;
+
+        BufferChunk* freeChunk = &data->pNodes[ni].mChunk;
 
-        if (ci == 0 && freeChunk->mOffset == 0)
+        if (freeChunk->mOffset == 0)
             floatingOccupiedChunks -= 1;
-        if (ci == unusedChunkCount - 1 && freeChunk->mOffset + freeChunk->mSize == data->mSize)
+        if (freeChunk->mOffset + freeChunk->mSize == data->mSize)
             floatingOccupiedChunks -= 1;
 
         uint64_t point_beg = 0;
@@ -24,12 +24,14 @@
 
 #include <errno.h>
 
+#include "../ThirdParty/OpenSource/Nothings/stb_ds.h"
 #include "../ThirdParty/OpenSource/bstrlib/bstrlib.h"
 
 #include "../../Utilities/Interfaces/IFileSystem.h"
 #include "../../Utilities/Interfaces/ILog.h"
 #include "../../Utilities/Interfaces/IThread.h"
 #include "../../Utilities/Interfaces/ITime.h"
+#include "../Threading/Atomics.h"
 
 #include "../../Utilities/Interfaces/IMemory.h"
 
@@ -163,6 +165,69 @@ void parse_path_statement(char* PathStatment, size_t size)
     }
 }
 
+/************************************************************************/
+// IO statistics
+/************************************************************************/
+
+#if defined(ENABLE_FS_IO_STATS)
+// Shared with system file IO implementations
+struct FsIoStats        gResourceDirectoryIoStats[RD_COUNT] = { { 0 } };
+static struct FsIoStats gMemoryStreamIoStats = { 0 };
+
+void fsIoStatsAddOpen(struct FsIoStats* stats) { tfrg_atomic64_add_relaxed(&stats->openCount, 1); }
+
+void fsIoStatsAddRead(struct FsIoStats* stats, uint64_t size, int64_t usec)
+{
+    uint64_t latency = usec > 0 ? (uint64_t)usec : 0;
+
+    uint32_t bucket = 0;
+    while (bucket < FS_IO_LATENCY_BUCKET_COUNT - 1 && latency >= ((uint64_t)1 << bucket))
+        ++bucket;
+
+    tfrg_atomic64_add_relaxed(&stats->readCount, 1);
+    tfrg_atomic64_add_relaxed(&stats->bytesRead, size);
+    tfrg_atomic64_add_relaxed(&stats->readTimeUsec, latency);
+    tfrg_atomic64_add_relaxed(&stats->readLatencyHistogram[bucket], 1);
+}
+
+static void fsIoStatsAddDecompression(struct FsIoStats* stats, uint64_t size, int64_t usec)
+{
+    tfrg_atomic64_add_relaxed(&stats->decompressedBytes, size);
+    tfrg_atomic64_add_relaxed(&stats->decompressionTimeUsec, usec > 0 ? (uint64_t)usec : 0);
+}
+
+static void fsIoStatsLoad(const struct FsIoStats* stats, struct FsIoStats* out)
+{
+    const uint64_t* src = (const uint64_t*)stats;
+    uint64_t*       dst = (uint64_t*)out;
+    for (size_t i = 0; i < sizeof(*stats) / sizeof(uint64_t); ++i)
+        dst[i] = tfrg_atomic64_load_relaxed((tfrg_atomic64_t*)(uintptr_t)(src + i));
+}
+#endif
+
+bool fsGetIoStats(ResourceDirectory rd, struct FsIoStats* outStats)
+{
+    memset(outStats, 0, sizeof *outStats);
+#if defined(ENABLE_FS_IO_STATS)
+    fsIoStatsLoad(&gResourceDirectoryIoStats[rd], outStats);
+    return true;
+#else
+    UNREF_PARAM(rd);
+    return false;
+#endif
+}
+
+bool fsGetMemoryStreamIoStats(struct FsIoStats* outStats)
+{
+    memset(outStats, 0, sizeof *outStats);
+#if defined(ENABLE_FS_IO_STATS)
+    fsIoStatsLoad(&gMemoryStreamIoStats, outStats);
+    return true;
+#else
+    return false;
+#endif
+}
+
 /************************************************************************/
 // Memory Stream Functions
 /************************************************************************/
@@ -220,9 +285,17 @@ static size_t ioMemoryStreamRead(FileStream* fs, void* dst, size_t size)
         return 0;
     }
 
+#if defined(ENABLE_FS_IO_STATS)
+    int64_t beg = getUSec(true);
+#endif
+
     size_t bytesToRead = MemoryStreamAvailableSize(stream, size);
     memcpy(dst, stream->pBuffer + stream->mCursor, bytesToRead);
     stream->mCursor += bytesToRead;
+
+#if defined(ENABLE_FS_IO_STATS)
+    fsIoStatsAddRead(&gMemoryStreamIoStats, bytesToRead, getUSec(true) - beg);
+#endif
     return bytesToRead;
 }
 
@@ -312,6 +385,32 @@ static bool ioMemoryStreamSeek(FileStream* fs, SeekBaseOffset baseOffset, ssize_
     return true;
 }
 
+static size_t ioMemoryStreamReadAt(FileStream* fs, void* dst, size_t size, uint64_t offset)
+{
+    if (!(fs->mMode & FM_READ))
+    {
+        LOGF(eWARNING, "Attempting to read from stream that doesn't have FM_READ flag.");
+        return 0;
+    }
+
+    MEMSD(stream, fs);
+
+    if (stream->mSize < 0 || offset >= (uint64_t)stream->mSize)
+        return 0;
+
+#if defined(ENABLE_FS_IO_STATS)
+    int64_t beg = getUSec(true);
+#endif
+
+    size_t bytesToRead = (uint64_t)stream->mSize - offset < size ? (size_t)((uint64_t)stream->mSize - offset) : size;
+    memcpy(dst, stream->pBuffer + offset, bytesToRead);
+
+#if defined(ENABLE_FS_IO_STATS)
+    fsIoStatsAddRead(&gMemoryStreamIoStats, bytesToRead, getUSec(true) - beg);
+#endif
+    return bytesToRead;
+}
+
 static ssize_t ioMemoryStreamGetPosition(FileStream* fs)
 {
     MEMSD(stream, fs);
@@ -362,6 +461,7 @@ static IFileSystem gMemoryFileIO = {
     NULL,
     ioMemoryStreamMemoryMap,
     NULL,
+    ioMemoryStreamReadAt,
 };
 
 /************************************************************************/
@@ -398,6 +498,10 @@ bool fsOpenStreamFromMemory(const void* buffer, size_t bufferSize, FileMode mode
     fs->pIO = &gMemoryFileIO;
     fs->mMode = mode;
 
+#if defined(ENABLE_FS_IO_STATS)
+    fsIoStatsAddOpen(&gMemoryStreamIoStats);
+#endif
+
     MEMSD(stream, fs);
 
     stream->pBuffer = (uint8_t*)buffer;
@@ -448,6 +552,20 @@ size_t fsReadBstringFromStream(FileStream* stream, bstring* pStr, size_t symbols
     return readBytes;
 }
 
+size_t fsReadFromStreamAt(FileStream* fs, void* pOutputBuffer, size_t bufferSizeInBytes, uint64_t offset)
+{
+    if (fs->pIO->ReadAt)
+        return fs->pIO->ReadAt(fs, pOutputBuffer, bufferSizeInBytes, offset);
+
+    ssize_t position = fsGetStreamSeekPosition(fs);
+    if (position < 0 || !fsSeekStream(fs, SBO_START_OF_FILE, (ssize_t)offset))
+        return 0;
+
+    size_t readBytes = fsReadFromStream(fs, pOutputBuffer, bufferSizeInBytes);
+    fsSeekStream(fs, SBO_START_OF_FILE, position);
+    return readBytes;
+}
+
 bool fsFindStream(FileStream* pStream, const void* pFind, size_t findSize, ssize_t maxSeek, ssize_t* pPosition)
 {
     ASSERT(pStream && pFind && pPosition);
@@ -915,11 +1033,45 @@ struct BunyArFileStream
     struct BunyArNode*             node;
     size_t                         position;
     ZSTD_DCtx*                     zstd_ctx;
+    // archive dictionary the file is compressed with, NULL if none
+    const ZSTD_DDict*              zstd_dict;
     struct BunyArBlockBuffer       compressed;
     struct BunyArBlockBuffer       decompressed;
     BunyArBlockPointer*            currentBlock;
     struct BunyArBlockFormatHeader blocksHeader;
     BunyArBlockPointer*            blocks;
+    // Read-ahead ring, created once sequential access is detected
+    struct BunyArReadAhead*        readAhead;
+    uint64_t                       lastBlockIndex;
+    // node is already in the access trace
+    bool                           traced;
+};
+
+// Default for ArchiveOpenDesc::parallelReadMinBlocks
+#ifndef BUNYAR_PARALLEL_READ_MIN_BLOCKS
+#define BUNYAR_PARALLEL_READ_MIN_BLOCKS 4
+#endif
+
+// Limit for ArchiveOpenDesc::readAheadBlocks
+#define BUNYAR_READ_AHEAD_BLOCKS_MAX 64
+
+// Decompressed block shared between streams, data follows the struct
+struct BunyArCachedBlock
+{
+    // LRU list, most recently used first
+    struct BunyArCachedBlock* prev;
+    struct BunyArCachedBlock* next;
+    uint64_t                  key;
+    uint64_t                  size;
+    // readers copying data out of the block, evicted block is freed by the last one
+    uint32_t                  references;
+    bool                      evicted;
+};
+
+struct BunyArBlockCacheNode
+{
+    uint64_t                  key;
+    struct BunyArCachedBlock* value;
 };
 
 struct BunyArMetadata
@@ -929,6 +1081,10 @@ struct BunyArMetadata
     char*                   nodeNames;
     struct BunyArHashTable* hashTable;
 
+    // Digested once on open, shared by all streams
+    uint64_t     dictionaryCount;
+    ZSTD_DDict** dictionaries;
+
     const uint8_t* memoryBeg;
     const uint8_t* memoryEnd;
 
@@ -936,8 +1092,38 @@ struct BunyArMetadata
     FileStream* archiveStream;
     uint64_t    virtualStreamCount; // only for validation
 
+    // Archive stream supports ReadAt, no locking required
+    bool positionalReads;
+
     bool  archiveStreamLocking;
     Mutex mutex;
+
+    // Parallel decompression of big reads
+    ThreadSystem decompressionThreads;
+    uint32_t     parallelReadMinBlocks;
+    uint32_t     readAheadBlocks;
+    uint32_t     workerCount;
+    // [workerCount], created by worker threads on demand
+    ZSTD_DCtx**  workerZstdContexts;
+
+    // Decompressed block cache, protected by blockCacheMutex
+    struct BunyArBlockCacheNode* blockCacheMap;
+    struct BunyArCachedBlock*    blockCacheHead;
+    struct BunyArCachedBlock*    blockCacheTail;
+    struct BunyArBlockCacheStats blockCacheStats;
+    Mutex                        blockCacheMutex;
+
+    // Node ids in order of first read, protected by traceMutex
+    bool      traceEnabled;
+    uint64_t* traceNodes;
+    // bit per node, set when node is in traceNodes
+    uint8_t*  traceVisited;
+    Mutex     traceMutex;
+
+#if defined(ENABLE_FS_IO_STATS)
+    // Block cache counters are kept in blockCacheStats
+    struct FsIoStats ioStats;
+#endif
 };
 
 struct BunyArNodeSearchCtx
@@ -970,6 +1156,7 @@ static int bunyArNameNodeCmp(const void* v1, const void* v2)
 }
 
 static void initBunyArFsInterface(IFileSystem*, struct BunyArMetadata*);
+static void bunyArReadAheadDestroy(struct BunyArReadAhead* ring);
 
 static inline struct BunyArMetadata* getFsArchive(IFileSystem* fs) { return (struct BunyArMetadata*)fs->pUser; }
 
@@ -996,6 +1183,9 @@ static inline size_t bunyArStreamRead(struct BunyArMetadata* a, uint64_t positio
         return read;
     }
 
+    if (a->positionalReads)
+        return a->archiveStream->pIO->ReadAt(a->archiveStream, dst, size, position);
+
     if (a->archiveStreamLocking)
         acquireMutex(&a->mutex);
 
@@ -1023,6 +1213,62 @@ static inline bool bunyArReadLocation(struct BunyArMetadata* a,
     return bunyArStreamRead(a, ptr.offset, ptr.size, dst) == ptr.size;
 }
 
+static void bunyArDictionariesDestroy(struct BunyArMetadata* a)
+{
+    for (uint64_t i = 0; i < a->dictionaryCount; ++i)
+        ZSTD_freeDDict(a->dictionaries[i]);
+    tf_free(a->dictionaries);
+    a->dictionaries = NULL;
+    a->dictionaryCount = 0;
+}
+
+static bool bunyArDictionariesLoad(struct BunyArMetadata* a, struct BunyArPointer64 table)
+{
+    if (table.size % sizeof(struct BunyArPointer64) != 0)
+        return false;
+
+    uint64_t count = table.size / sizeof(struct BunyArPointer64);
+    if (!count)
+        return true;
+
+    struct BunyArPointer64* pointers = (struct BunyArPointer64*)tf_malloc(table.size);
+    a->dictionaries = (ZSTD_DDict**)tf_calloc(count, sizeof(ZSTD_DDict*));
+
+    bool     success = pointers && a->dictionaries && bunyArReadLocation(a, table, pointers);
+    uint8_t* content = NULL;
+
+    for (uint64_t i = 0; success && i < count; ++i)
+    {
+        const uint8_t* src;
+
+        if (a->memoryBeg)
+        {
+            uint64_t read;
+            bunyArMemoryReadPrepare(a, pointers[i], &src, &read);
+            success = read == pointers[i].size;
+        }
+        else
+        {
+            content = (uint8_t*)tf_realloc(content, pointers[i].size);
+            success = content && bunyArReadLocation(a, pointers[i], content);
+            src = content;
+        }
+
+        if (success)
+        {
+            // ddict keeps its own copy, archive memory is not referenced after open
+            a->dictionaries[i] = ZSTD_createDDict_advanced(src, pointers[i].size, ZSTD_dlm_byCopy, ZSTD_dct_rawContent,
+                                                           ZSTD_MEMORY_ALLOCATOR);
+            success = a->dictionaries[i] != NULL;
+            a->dictionaryCount = i + 1;
+        }
+    }
+
+    tf_free(content);
+    tf_free(pointers);
+    return success;
+}
+
 static const struct ArchiveOpenDesc BUNYAR_OPEN_DESC_DEFAULT = { 0 };
 
 static bool bunyArchiveOpen(FileStream* stream, uint64_t memorySize, const void* memory, const struct ArchiveOpenDesc* desc,
@@ -1039,20 +1285,41 @@ static bool bunyArchiveOpen(FileStream* stream, uint64_t memorySize, const void*
     ////////////////////////
     // Read and check header
 
-    struct BunyArHeader header;
+    struct BunyArHeader header = { 0 };
 
     bool headerReaded = false;
 
     if (streamMode)
     {
-        headerReaded = fsSeekStream(stream, SBO_START_OF_FILE, 0) && fsReadFromStream(stream, &header, sizeof header) == sizeof header;
+        headerReaded = fsSeekStream(stream, SBO_START_OF_FILE, 0) &&
+                       fsReadFromStream(stream, &header, BUNYAR_HEADER_BASE_SIZE) == BUNYAR_HEADER_BASE_SIZE;
     }
-    else if (memorySize >= sizeof header)
+    else if (memorySize >= BUNYAR_HEADER_BASE_SIZE)
     {
-        memcpy(&header, memory, sizeof header);
+        memcpy(&header, memory, BUNYAR_HEADER_BASE_SIZE);
         headerReaded = true;
     }
 
+    // Optional header fields follow the base part, up to the stored header size.
+    // Fields of newer archives which this reader doesn't know are skipped.
+    if (headerReaded && header.nodesPointer.offset > BUNYAR_HEADER_BASE_SIZE)
+    {
+        const uint64_t headerSize = header.nodesPointer.offset < sizeof header ? header.nodesPointer.offset : sizeof header;
+        const size_t   extensionSize = (size_t)(headerSize - BUNYAR_HEADER_BASE_SIZE);
+        uint8_t*       extension = (uint8_t*)&header + BUNYAR_HEADER_BASE_SIZE;
+
+        if (streamMode)
+        {
+            headerReaded = fsReadFromStream(stream, extension, extensionSize) == extensionSize;
+        }
+        else
+        {
+            headerReaded = memorySize >= BUNYAR_HEADER_BASE_SIZE + extensionSize;
+            if (headerReaded)
+                memcpy(extension, (const uint8_t*)memory + BUNYAR_HEADER_BASE_SIZE, extensionSize);
+        }
+    }
+
     if (!headerReaded)
     {
         if (desc->tryMode)
@@ -1076,6 +1343,13 @@ static bool bunyArchiveOpen(FileStream* stream, uint64_t memorySize, const void*
         return false;
     }
 
+    if (header.nodesPointer.offset < bunyArHeaderRequiredSize(header.flags))
+    {
+        LOGF(eERROR, "Failed to open archive: header of %llu bytes is smaller than %llu bytes required by its flags",
+             (unsigned long long)header.nodesPointer.offset, (unsigned long long)bunyArHeaderRequiredSize(header.flags));
+        return false;
+    }
+
     ///////////////////////////////////////
     // Allocate memory for archive metadata
     // includes Archive struct, file nodes, file names
@@ -1092,6 +1366,7 @@ static bool bunyArchiveOpen(FileStream* stream, uint64_t memorySize, const void*
         archive->memoryEnd = archive->memoryBeg + memorySize;
 
         archive->archiveStream = stream;
+        archive->positionalReads = streamMode && stream->pIO->ReadAt;
 
         archive->nodeCount = header.nodesPointer.size / sizeof(struct BunyArNode);
         archive->nodes = (struct BunyArNode*)memPtr;
@@ -1142,10 +1417,35 @@ static bool bunyArchiveOpen(FileStream* stream, uint64_t memorySize, const void*
     {
         LOGF(eERROR, "Failed to open archive: missing node names");
     CANCEL:
+        bunyArDictionariesDestroy(archive);
         tf_free(archive);
         return false;
     }
 
+    ////////////////////
+    // Read dictionaries
+
+    if (header.flags & BUNYAR_HEADER_FLAG_DICTIONARIES)
+    {
+        if (!bunyArDictionariesLoad(archive, header.dictionariesPointer))
+        {
+            LOGF(eERROR, "Failed to open archive: dictionaries reading failure");
+            goto CANCEL;
+        }
+    }
+
+    for (uint64_t fi = 0; fi < archive->nodeCount; ++fi)
+    {
+        const struct BunyArNode* node = archive->nodes + fi;
+
+        uint32_t dictionary = BUNYAR_NODE_DICTIONARY(node->format);
+        if (dictionary && (BUNYAR_NODE_FORMAT(node->format) != BUNYAR_FILE_FORMAT_ZSTD_BLOCKS || dictionary > archive->dictionaryCount))
+        {
+            LOGF(eERROR, "Failed to open archive: invalid dictionary %u for node %llu", dictionary, (unsigned long long)fi);
+            goto CANCEL;
+        }
+    }
+
     //////////////////
     // Read hash table
 
@@ -1273,7 +1573,9 @@ static bool bunyArchiveOpen(FileStream* stream, uint64_t memorySize, const void*
 
     initBunyArFsInterface(out, archive);
 
-    if (streamMode && desc->protectStreamCriticalSection)
+    // Read-ahead tasks read archive stream in the background
+    if (streamMode && !archive->positionalReads &&
+        (desc->protectStreamCriticalSection || (desc->decompressionThreads && desc->readAheadBlocks)))
     {
         if (!initMutex(&archive->mutex))
         {
@@ -1284,6 +1586,44 @@ static bool bunyArchiveOpen(FileStream* stream, uint64_t memorySize, const void*
         archive->archiveStreamLocking = true;
     }
 
+    if (desc->decompressionThreads)
+    {
+        struct ThreadSystemInfo info;
+        threadSystemGetInfo(desc->decompressionThreads, &info);
+
+        archive->decompressionThreads = desc->decompressionThreads;
+        archive->parallelReadMinBlocks = desc->parallelReadMinBlocks ? desc->parallelReadMinBlocks : BUNYAR_PARALLEL_READ_MIN_BLOCKS;
+        archive->readAheadBlocks =
+            desc->readAheadBlocks < BUNYAR_READ_AHEAD_BLOCKS_MAX ? desc->readAheadBlocks : BUNYAR_READ_AHEAD_BLOCKS_MAX;
+        archive->workerCount = (uint32_t)info.threadCount;
+        archive->workerZstdContexts = (ZSTD_DCtx**)tf_calloc(archive->workerCount, sizeof(ZSTD_DCtx*));
+    }
+
+    if (desc->blockCacheSize)
+    {
+        if (!initMutex(&archive->blockCacheMutex))
+        {
+            fsArchiveClose(out);
+            return false;
+        }
+
+        archive->blockCacheStats.budget = desc->blockCacheSize;
+    }
+
+    if (desc->recordAccessTrace)
+    {
+        archive->traceVisited = (uint8_t*)tf_calloc(archive->nodeCount / 8 + 1, 1);
+        if (!archive->traceVisited || !initMutex(&archive->traceMutex))
+        {
+            tf_free(archive->traceVisited);
+            archive->traceVisited = NULL;
+            fsArchiveClose(out);
+            return false;
+        }
+
+        archive->traceEnabled = true;
+    }
+
     return true;
 }
 
@@ -1350,6 +1690,31 @@ FORGE_API bool fsArchiveClose(IFileSystem* fs)
         exitMutex(&archive->mutex);
     }
 
+    for (uint32_t i = 0; i < archive->workerCount; ++i)
+        ZSTD_freeDCtx(archive->workerZstdContexts[i]);
+    tf_free(archive->workerZstdContexts);
+
+    if (archive->blockCacheStats.budget)
+    {
+        for (struct BunyArCachedBlock* block = archive->blockCacheHead; block;)
+        {
+            struct BunyArCachedBlock* next = block->next;
+            ASSERT(block->references == 0);
+            tf_free(block);
+            block = next;
+        }
+        hmfree(archive->blockCacheMap);
+        exitMutex(&archive->blockCacheMutex);
+    }
+
+    if (archive->traceEnabled)
+    {
+        arrfree(archive->traceNodes);
+        tf_free(archive->traceVisited);
+        exitMutex(&archive->traceMutex);
+    }
+
+    bunyArDictionariesDestroy(archive);
     tf_free(archive->hashTable);
     tf_free(archive);
     return true;
@@ -1399,7 +1764,8 @@ static bool ioArchiveOpenByUid(IFileSystem* inFs, uint64_t index, FileMode mode,
 
     struct BunyArNode* node = &archive->nodes[index];
 
-    if (mode != FM_READ)
+    // FM_ALLOW_READ is a sharing hint, archive is always readable by others
+    if ((mode & ~FM_ALLOW_READ) != FM_READ)
     {
         LOGF(eERROR, "Cannot open archive file '%s': only FM_READ is supported", archive->nodeNames + node->namePointer.offset);
         return false;
@@ -1410,7 +1776,7 @@ static bool ioArchiveOpenByUid(IFileSystem* inFs, uint64_t index, FileMode mode,
 
     struct BunyArBlockFormatHeader blocksHeader = { 0 };
 
-    switch (node->format)
+    switch (BUNYAR_NODE_FORMAT(node->format))
     {
     case BUNYAR_FILE_FORMAT_RAW:
     {
@@ -1459,6 +1825,7 @@ static bool ioArchiveOpenByUid(IFileSystem* inFs, uint64_t index, FileMode mode,
     memset(fs, 0, sizeof(*fs));
 
     fs->node = node;
+    fs->lastBlockIndex = UINT64_MAX;
     fs->blocksHeader = blocksHeader;
     fs->blocks = (BunyArBlockPointer*)(fs + 1);
     fs->compressed.memory = (uint8_t*)(fs->blocks) + blocksSize;
@@ -1474,7 +1841,7 @@ static bool ioArchiveOpenByUid(IFileSystem* inFs, uint64_t index, FileMode mode,
         return false;
     }
 
-    switch (node->format)
+    switch (BUNYAR_NODE_FORMAT(node->format))
     {
     case BUNYAR_FILE_FORMAT_ZSTD_BLOCKS:
     {
@@ -1484,7 +1851,14 @@ static bool ioArchiveOpenByUid(IFileSystem* inFs, uint64_t index, FileMode mode,
             LOGF(eERROR, "Failed to create ZSTD decompression context");
             goto CANCEL;
         }
+
+        uint32_t dictionary = BUNYAR_NODE_DICTIONARY(node->format);
+        if (dictionary)
+            fs->zstd_dict = archive->dictionaries[dictionary - 1];
     }
+    break;
+    default:
+        break;
     }
 
     pOutStream->pIO = inFs;
@@ -1494,6 +1868,10 @@ static bool ioArchiveOpenByUid(IFileSystem* inFs, uint64_t index, FileMode mode,
 
     ++archive->virtualStreamCount;
 
+#if defined(ENABLE_FS_IO_STATS)
+    fsIoStatsAddOpen(&archive->ioStats);
+#endif
+
     return true;
 }
 
@@ -1517,6 +1895,7 @@ static bool ioArchiveFsClose(FileStream* fs)
     --archive->virtualStreamCount;
 
     struct BunyArFileStream* stream = getFsBunyArStream(fs);
+    bunyArReadAheadDestroy(stream->readAhead);
     ZSTD_freeDCtx(stream->zstd_ctx);
     tf_free(stream);
 
@@ -1533,8 +1912,9 @@ static inline struct BunyArPointer64 bunyArDecodeBlockPointerInfo(struct BunyArN
     };
 }
 
-static bool bunyArReadBlockToBuffer(struct BunyArMetadata* archive, struct BunyArFileStream* fs, BunyArBlockPointer* blockToRead,
-                                    struct BunyArBlockBuffer* dst)
+// 'compressed' is staging memory of blockSize for stream mode archives
+static bool bunyArReadBlockWith(struct BunyArMetadata* archive, struct BunyArFileStream* fs, BunyArBlockPointer* blockToRead,
+                                ZSTD_DCtx* zstd, uint8_t* compressed, struct BunyArBlockBuffer* dst)
 {
     uint64_t       srcSize;
     const uint8_t* srcMemory;
@@ -1554,17 +1934,21 @@ static bool bunyArReadBlockToBuffer(struct BunyArMetadata* archive, struct BunyA
         }
         else
         {
-            if (!bunyArReadLocation(archive, loc, fs->compressed.memory))
+            if (loc.size > fs->blocksHeader.blockSize || !bunyArReadLocation(archive, loc, compressed))
                 return false;
-            srcMemory = fs->compressed.memory;
+            srcMemory = compressed;
             srcSize = loc.size;
         }
     }
 
     const char* error = NULL;
 
+#if defined(ENABLE_FS_IO_STATS)
+    int64_t beg = getUSec(true);
+#endif
+
     // this function fills readSize and writeSize
-    switch (fs->node->format)
+    switch (BUNYAR_NODE_FORMAT(fs->node->format))
     {
     case BUNYAR_FILE_FORMAT_LZ4_BLOCKS:
     {
@@ -1581,7 +1965,9 @@ static bool bunyArReadBlockToBuffer(struct BunyArMetadata* archive, struct BunyA
     break;
     case BUNYAR_FILE_FORMAT_ZSTD_BLOCKS:
     {
-        size_t decompressedSize = ZSTD_decompressDCtx(fs->zstd_ctx, dst->memory, dst->memorySize, srcMemory, srcSize);
+        size_t decompressedSize = fs->zstd_dict
+                                      ? ZSTD_decompress_usingDDict(zstd, dst->memory, dst->memorySize, srcMemory, srcSize, fs->zstd_dict)
+                                      : ZSTD_decompressDCtx(zstd, dst->memory, dst->memorySize, srcMemory, srcSize);
 
         if (ZSTD_isError(decompressedSize))
         {
@@ -1597,104 +1983,800 @@ static bool bunyArReadBlockToBuffer(struct BunyArMetadata* archive, struct BunyA
     }
 
     if (!error)
+    {
+#if defined(ENABLE_FS_IO_STATS)
+        fsIoStatsAddDecompression(&archive->ioStats, dst->usedSize, getUSec(true) - beg);
+#endif
         return true;
+    }
 
     LOGF(eERROR, "Failed to decompress block #%llu: %s", (unsigned long long)(blockToRead - fs->blocks), error);
     return false;
 }
 
-static bool bunyArReadBlockToStagingBuffer(struct BunyArMetadata* archive, struct BunyArFileStream* fs, BunyArBlockPointer* blockToRead)
+static inline bool bunyArReadBlockToBuffer(struct BunyArMetadata* archive, struct BunyArFileStream* fs, BunyArBlockPointer* blockToRead,
+                                           struct BunyArBlockBuffer* dst)
 {
-    if (fs->currentBlock == blockToRead)
-        return true;
+    return bunyArReadBlockWith(archive, fs, blockToRead, fs->zstd_ctx, fs->compressed.memory, dst);
+}
 
-    if (bunyArReadBlockToBuffer(archive, fs, blockToRead, &fs->decompressed))
-    {
-        fs->currentBlock = blockToRead;
-        return true;
-    }
+/************************************************************************/
+// MARK: - Decompressed block cache
+/************************************************************************/
 
-    // decompressed buffer data is corrupted, so we have to reset handle
-    fs->currentBlock = NULL;
-    return false;
+static void bunyArCacheUnlink(struct BunyArMetadata* archive, struct BunyArCachedBlock* block)
+{
+    if (block->prev)
+        block->prev->next = block->next;
+    else
+        archive->blockCacheHead = block->next;
+
+    if (block->next)
+        block->next->prev = block->prev;
+    else
+        archive->blockCacheTail = block->prev;
+
+    block->prev = NULL;
+    block->next = NULL;
 }
 
-static size_t ioArchiveFsRead(FileStream* pFile, void* outputBuffer, size_t outputSize)
+static void bunyArCachePushFront(struct BunyArMetadata* archive, struct BunyArCachedBlock* block)
 {
-    struct BunyArFileStream* fs = getFsBunyArStream(pFile);
-    struct BunyArMetadata*   archive = getFsArchive(pFile->pIO);
-    struct BunyArNode*       node = fs->node;
+    block->prev = NULL;
+    block->next = archive->blockCacheHead;
+    if (archive->blockCacheHead)
+        archive->blockCacheHead->prev = block;
+    else
+        archive->blockCacheTail = block;
+    archive->blockCacheHead = block;
+}
 
-    switch (node->format)
-    {
-    case BUNYAR_FILE_FORMAT_RAW:
-    {
-        size_t limit = node->filePointer.size - fs->position;
-        if (outputSize > limit)
-            outputSize = limit;
+// Copies cached block to 'dst'. Returns false on cache miss.
+static bool bunyArCacheRead(struct BunyArMetadata* archive, uint64_t key, struct BunyArBlockBuffer* dst)
+{
+    acquireMutex(&archive->blockCacheMutex);
 
-        size_t readSize = bunyArStreamRead(archive, node->filePointer.offset + fs->position, outputSize, outputBuffer);
-        fs->position += readSize;
-        return readSize;
-    }
-    case BUNYAR_FILE_FORMAT_LZ4_BLOCKS:
-    case BUNYAR_FILE_FORMAT_ZSTD_BLOCKS:
+    struct BunyArCachedBlock* block = hmget(archive->blockCacheMap, key);
+    if (!block || block->size > dst->memorySize)
     {
-        uint8_t* dstMemory = (uint8_t*)outputBuffer;
-        size_t   sizeToWrite = outputSize;
+        ++archive->blockCacheStats.misses;
+        releaseMutex(&archive->blockCacheMutex);
+        return false;
+    }
 
-        while (sizeToWrite > 0)
-        {
-            uint64_t blockIndex = fs->position / fs->blocksHeader.blockSize;
+    ++archive->blockCacheStats.hits;
+    ++block->references;
+    if (archive->blockCacheHead != block)
+    {
+        bunyArCacheUnlink(archive, block);
+        bunyArCachePushFront(archive, block);
+    }
+    releaseMutex(&archive->blockCacheMutex);
 
-            if (blockIndex >= fs->blocksHeader.blockCount)
-                break;
+    // Copy outside of the lock, block can't be freed while referenced
+    memcpy(dst->memory, block + 1, block->size);
+    dst->usedSize = block->size;
 
-            uint64_t offsetInBlock = fs->position - blockIndex * fs->blocksHeader.blockSize;
+    acquireMutex(&archive->blockCacheMutex);
+    bool freeBlock = --block->references == 0 && block->evicted;
+    releaseMutex(&archive->blockCacheMutex);
 
-            uint64_t blockSize =
-                blockIndex == fs->blocksHeader.blockCount - 1 ? fs->blocksHeader.blockSizeLast : fs->blocksHeader.blockSize;
+    if (freeBlock)
+        tf_free(block);
+    return true;
+}
 
-            // reached end of file
-            if (offsetInBlock >= blockSize)
-                break;
+static void bunyArCacheInsert(struct BunyArMetadata* archive, uint64_t key, const uint8_t* data, uint64_t size)
+{
+    if (size > archive->blockCacheStats.budget)
+        return;
 
-            BunyArBlockPointer* block = fs->blocks + blockIndex;
+    struct BunyArCachedBlock* block = (struct BunyArCachedBlock*)tf_malloc(sizeof(*block) + size);
+    if (!block)
+        return;
 
-            struct BunyArBlockInfo blockInfo = bunyArDecodeBlockPointer(*block);
+    memset(block, 0, sizeof *block);
+    block->key = key;
+    block->size = size;
+    memcpy(block + 1, data, size);
 
-            uint64_t sizeDone = 0;
+    struct BunyArCachedBlock* evicted = NULL;
 
-            if (!blockInfo.isCompressed)
-            {
-                // Block is uncompressed, read it directly
+    acquireMutex(&archive->blockCacheMutex);
 
-                if (blockSize != blockInfo.size)
-                {
-                    LOGF(eERROR, "Raw black size is wrong (%llu vs %llu)", (unsigned long long)blockSize,
-                         (unsigned long long)blockInfo.size);
-                    break;
-                }
+    // Other stream might have decompressed the same block concurrently
+    if (hmgeti(archive->blockCacheMap, key) >= 0)
+    {
+        releaseMutex(&archive->blockCacheMutex);
+        tf_free(block);
+        return;
+    }
 
-                struct BunyArPointer64 location = bunyArDecodeBlockPointerInfo(node, &fs->blocksHeader, &blockInfo);
+    hmput(archive->blockCacheMap, key, block);
+    bunyArCachePushFront(archive, block);
+    archive->blockCacheStats.usedSize += size;
 
-                size_t sizeLeft = location.size - offsetInBlock;
+    while (archive->blockCacheStats.usedSize > archive->blockCacheStats.budget)
+    {
+        struct BunyArCachedBlock* last = archive->blockCacheTail;
+        ASSERT(last != block);
 
-                ASSERT(sizeLeft);
+        bunyArCacheUnlink(archive, last);
+        (void)hmdel(archive->blockCacheMap, last->key);
+        archive->blockCacheStats.usedSize -= last->size;
+        ++archive->blockCacheStats.evictions;
 
-                sizeDone =
-                    bunyArStreamRead(archive, location.offset + offsetInBlock, sizeToWrite > sizeLeft ? sizeLeft : sizeToWrite, dstMemory);
-            }
-            else if (offsetInBlock == 0 && sizeToWrite >= blockSize)
-            {
-                // Avoid usage of staging buffer.
-                // We can uncompress entire block to user memory.
+        if (last->references)
+        {
+            last->evicted = true;
+        }
+        else
+        {
+            // free outside of the lock
+            last->next = evicted;
+            evicted = last;
+        }
+    }
 
-                struct BunyArBlockBuffer buffer = { 0 };
+    releaseMutex(&archive->blockCacheMutex);
 
-                buffer.memory = dstMemory;
+    while (evicted)
+    {
+        struct BunyArCachedBlock* next = evicted->next;
+        tf_free(evicted);
+        evicted = next;
+    }
+}
+
+// Same as bunyArReadBlockToBuffer, but goes through block cache if it's enabled
+static bool bunyArReadBlockCached(struct BunyArMetadata* archive, struct BunyArFileStream* fs, BunyArBlockPointer* blockToRead,
+                                  struct BunyArBlockBuffer* dst)
+{
+    if (!archive->blockCacheStats.budget)
+        return bunyArReadBlockToBuffer(archive, fs, blockToRead, dst);
+
+    struct BunyArBlockInfo blockInfo = bunyArDecodeBlockPointer(*blockToRead);
+    // Location in the archive identifies the block
+    uint64_t               key = bunyArDecodeBlockPointerInfo(fs->node, &fs->blocksHeader, &blockInfo).offset;
+
+    if (bunyArCacheRead(archive, key, dst))
+        return true;
+
+    if (!bunyArReadBlockToBuffer(archive, fs, blockToRead, dst))
+        return false;
+
+    bunyArCacheInsert(archive, key, dst->memory, dst->usedSize);
+    return true;
+}
+
+/************************************************************************/
+// MARK: - Sequential read-ahead
+/************************************************************************/
+
+enum
+{
+    BUNYAR_READ_AHEAD_EMPTY = 0,
+    BUNYAR_READ_AHEAD_QUEUED,
+    BUNYAR_READ_AHEAD_RUNNING,
+    BUNYAR_READ_AHEAD_READY,
+    BUNYAR_READ_AHEAD_FAILED,
+};
+
+struct BunyArReadAheadSlot
+{
+    struct BunyArReadAhead* ring;
+    // Written by the stream only while slot isn't queued or running
+    uint64_t                blockIndex;
+    uint64_t                size;
+    uint8_t*                decompressed;
+    // blockSize of staging memory for stream mode archives
+    uint8_t*                compressed;
+    tfrg_atomic32_t         state;
+};
+
+// Owned by the stream and by scheduled tasks, freed by the last one.
+// Tasks which find their slot no longer queued only touch this struct.
+struct BunyArReadAhead
+{
+    struct BunyArMetadata*      archive;
+    struct BunyArFileStream*    fs;
+    uint32_t                    slotCount;
+    struct BunyArReadAheadSlot* slots;
+    tfrg_atomic32_t             references;
+    Mutex                       mutex;
+    ConditionVariable           slotDoneCondition;
+};
+
+static void bunyArReadAheadRelease(struct BunyArReadAhead* ring)
+{
+    if ((uint32_t)tfrg_atomic32_add_relaxed(&ring->references, -1) != 1)
+        return;
+    exitConditionVariable(&ring->slotDoneCondition);
+    exitMutex(&ring->mutex);
+    tf_free(ring);
+}
+
+static void bunyArReadAheadTask(void* user, uint64_t threadId)
+{
+    struct BunyArReadAheadSlot* slot = (struct BunyArReadAheadSlot*)user;
+    struct BunyArReadAhead*     ring = slot->ring;
+
+    // Slot was taken back by the stream, or this is a stale task of a reused slot
+    if ((uint32_t)tfrg_atomic32_cas_relaxed(&slot->state, BUNYAR_READ_AHEAD_QUEUED, BUNYAR_READ_AHEAD_RUNNING) != BUNYAR_READ_AHEAD_QUEUED)
+    {
+        bunyArReadAheadRelease(ring);
+        return;
+    }
+
+    struct BunyArMetadata*   archive = ring->archive;
+    struct BunyArFileStream* fs = ring->fs;
+
+    // Worker threads own their contexts, anything else (e.g. threadSystemAssist) gets a temporary one
+    ZSTD_DCtx* tempZstd = NULL;
+    ZSTD_DCtx* zstd = NULL;
+    if (BUNYAR_NODE_FORMAT(fs->node->format) == BUNYAR_FILE_FORMAT_ZSTD_BLOCKS)
+    {
+        ZSTD_DCtx** pZstd = threadId < archive->workerCount ? &archive->workerZstdContexts[threadId] : &tempZstd;
+        if (!*pZstd)
+            *pZstd = ZSTD_createDCtx_advanced(ZSTD_MEMORY_ALLOCATOR);
+        zstd = *pZstd;
+    }
+
+    struct BunyArBlockBuffer dst = { 0, fs->blocksHeader.blockSize, slot->decompressed };
+    bool                     success = (zstd || BUNYAR_NODE_FORMAT(fs->node->format) != BUNYAR_FILE_FORMAT_ZSTD_BLOCKS) &&
+                   bunyArReadBlockWith(archive, fs, fs->blocks + slot->blockIndex, zstd, slot->compressed, &dst);
+    slot->size = dst.usedSize;
+    ZSTD_freeDCtx(tempZstd);
+
+    acquireMutex(&ring->mutex);
+    tfrg_atomic32_store_release(&slot->state, success ? BUNYAR_READ_AHEAD_READY : BUNYAR_READ_AHEAD_FAILED);
+    wakeAllConditionVariable(&ring->slotDoneCondition);
+    releaseMutex(&ring->mutex);
+
+    bunyArReadAheadRelease(ring);
+}
+
+static struct BunyArReadAhead* bunyArReadAheadCreate(struct BunyArMetadata* archive, struct BunyArFileStream* fs)
+{
+    uint32_t slotCount = archive->readAheadBlocks;
+    size_t   blockSize = fs->blocksHeader.blockSize;
+    size_t   slotMemory = archive->memoryBeg ? blockSize : blockSize * 2;
+
+    struct BunyArReadAhead* ring = (struct BunyArReadAhead*)tf_calloc(
+        1, sizeof(*ring) + slotCount * (sizeof(struct BunyArReadAheadSlot) + slotMemory));
+    if (!ring)
+        return NULL;
+
+    if (!initMutex(&ring->mutex))
+    {
+        tf_free(ring);
+        return NULL;
+    }
+    if (!initConditionVariable(&ring->slotDoneCondition))
+    {
+        exitMutex(&ring->mutex);
+        tf_free(ring);
+        return NULL;
+    }
+
+    ring->archive = archive;
+    ring->fs = fs;
+    ring->slotCount = slotCount;
+    ring->slots = (struct BunyArReadAheadSlot*)(ring + 1);
+    ring->references = 1;
+
+    uint8_t* memory = (uint8_t*)(ring->slots + slotCount);
+    for (uint32_t i = 0; i < slotCount; ++i)
+    {
+        struct BunyArReadAheadSlot* slot = &ring->slots[i];
+        slot->ring = ring;
+        slot->blockIndex = UINT64_MAX;
+        slot->decompressed = memory;
+        slot->compressed = archive->memoryBeg ? NULL : memory + blockSize;
+        memory += slotMemory;
+    }
+    return ring;
+}
+
+// Takes back slots which weren't picked up by workers yet
+static void bunyArReadAheadCancel(struct BunyArReadAhead* ring)
+{
+    for (uint32_t i = 0; i < ring->slotCount; ++i)
+    {
+        struct BunyArReadAheadSlot* slot = &ring->slots[i];
+        tfrg_atomic32_cas_relaxed(&slot->state, BUNYAR_READ_AHEAD_QUEUED, BUNYAR_READ_AHEAD_EMPTY);
+    }
+}
+
+static void bunyArReadAheadWaitSlot(struct BunyArReadAhead* ring, struct BunyArReadAheadSlot* slot)
+{
+    if (tfrg_atomic32_load_acquire(&slot->state) != BUNYAR_READ_AHEAD_RUNNING)
+        return;
+    acquireMutex(&ring->mutex);
+    while (tfrg_atomic32_load_acquire(&slot->state) == BUNYAR_READ_AHEAD_RUNNING)
+        waitConditionVariable(&ring->slotDoneCondition, &ring->mutex, TIMEOUT_INFINITE);
+    releaseMutex(&ring->mutex);
+}
+
+static void bunyArReadAheadDestroy(struct BunyArReadAhead* ring)
+{
+    if (!ring)
+        return;
+
+    // Running tasks use stream data, so they have to be finished
+    bunyArReadAheadCancel(ring);
+    for (uint32_t i = 0; i < ring->slotCount; ++i)
+        bunyArReadAheadWaitSlot(ring, &ring->slots[i]);
+
+    bunyArReadAheadRelease(ring);
+}
+
+// Copies prefetched block to 'dst'. Returns false if block wasn't prefetched.
+static bool bunyArReadAheadTake(struct BunyArReadAhead* ring, uint64_t blockIndex, struct BunyArBlockBuffer* dst)
+{
+    struct BunyArReadAheadSlot* slot = &ring->slots[blockIndex % ring->slotCount];
+    if (slot->blockIndex != blockIndex)
+        return false;
+
+    // Worker didn't start yet, decompressing on this thread is faster than waiting
+    if ((uint32_t)tfrg_atomic32_cas_relaxed(&slot->state, BUNYAR_READ_AHEAD_QUEUED, BUNYAR_READ_AHEAD_EMPTY) == BUNYAR_READ_AHEAD_QUEUED)
+        return false;
+
+    bunyArReadAheadWaitSlot(ring, slot);
+
+    uint32_t state = tfrg_atomic32_load_acquire(&slot->state);
+    tfrg_atomic32_store_release(&slot->state, BUNYAR_READ_AHEAD_EMPTY);
+    // Failed blocks are decompressed again on this thread, so errors are reported to the caller
+    if (state != BUNYAR_READ_AHEAD_READY || slot->size > dst->memorySize)
+        return false;
+
+    memcpy(dst->memory, slot->decompressed, slot->size);
+    dst->usedSize = slot->size;
+    return true;
+}
+
+// Keeps the blocks after 'blockIndex' scheduled
+static void bunyArReadAheadSchedule(struct BunyArReadAhead* ring, uint64_t blockIndex)
+{
+    struct BunyArFileStream* fs = ring->fs;
+    uint64_t                 endBlock = blockIndex + ring->slotCount + 1;
+    if (endBlock > fs->blocksHeader.blockCount)
+        endBlock = fs->blocksHeader.blockCount;
+
+    for (uint64_t i = blockIndex + 1; i < endBlock; ++i)
+    {
+        // Uncompressed blocks are read directly
+        if (!bunyArDecodeBlockPointer(fs->blocks[i]).isCompressed)
+            continue;
+
+        struct BunyArReadAheadSlot* slot = &ring->slots[i % ring->slotCount];
+        uint32_t                    state = tfrg_atomic32_load_acquire(&slot->state);
+
+        if (slot->blockIndex == i && state != BUNYAR_READ_AHEAD_EMPTY)
+            continue;
+        // Slot is busy with a stale block
+        if (state == BUNYAR_READ_AHEAD_RUNNING)
+            continue;
+        if (state == BUNYAR_READ_AHEAD_QUEUED &&
+            (uint32_t)tfrg_atomic32_cas_relaxed(&slot->state, BUNYAR_READ_AHEAD_QUEUED, BUNYAR_READ_AHEAD_EMPTY) != BUNYAR_READ_AHEAD_QUEUED)
+            continue;
+
+        slot->blockIndex = i;
+        tfrg_atomic32_add_relaxed(&ring->references, 1);
+        tfrg_atomic32_store_release(&slot->state, BUNYAR_READ_AHEAD_QUEUED);
+        threadSystemAddTask(ring->archive->decompressionThreads, bunyArReadAheadTask, slot);
+    }
+}
+
+// Reads compressed block, using and feeding read-ahead ring on sequential access
+static bool bunyArReadBlock(struct BunyArMetadata* archive, struct BunyArFileStream* fs, BunyArBlockPointer* blockToRead,
+                            struct BunyArBlockBuffer* dst)
+{
+    uint64_t blockIndex = (uint64_t)(blockToRead - fs->blocks);
+    // Reading the first block counts as sequential access too
+    bool     sequential = blockIndex == fs->lastBlockIndex + 1;
+    fs->lastBlockIndex = blockIndex;
+
+    if (!archive->readAheadBlocks || !archive->decompressionThreads)
+        return bunyArReadBlockCached(archive, fs, blockToRead, dst);
+
+    if (sequential && !fs->readAhead && blockIndex + 1 < fs->blocksHeader.blockCount)
+        fs->readAhead = bunyArReadAheadCreate(archive, fs);
+
+    struct BunyArReadAhead* ring = fs->readAhead;
+    if (!ring)
+        return bunyArReadBlockCached(archive, fs, blockToRead, dst);
+
+    if (!sequential)
+        bunyArReadAheadCancel(ring);
+
+    bool done = bunyArReadAheadTake(ring, blockIndex, dst);
+
+    // Schedule next blocks before decompressing current one, so they are processed in parallel
+    if (sequential)
+        bunyArReadAheadSchedule(ring, blockIndex);
+
+    return done || bunyArReadBlockCached(archive, fs, blockToRead, dst);
+}
+
+static bool bunyArReadBlockToStagingBuffer(struct BunyArMetadata* archive, struct BunyArFileStream* fs, BunyArBlockPointer* blockToRead)
+{
+    if (fs->currentBlock == blockToRead)
+        return true;
+
+    if (bunyArReadBlock(archive, fs, blockToRead, &fs->decompressed))
+    {
+        fs->currentBlock = blockToRead;
+        return true;
+    }
+
+    // decompressed buffer data is corrupted, so we have to reset handle
+    fs->currentBlock = NULL;
+    return false;
+}
+
+/************************************************************************/
+// MARK: - Parallel block decompression
+/************************************************************************/
+
+// Shared by calling thread and worker tasks of one parallel read.
+// Tasks might start after the read is complete, so only this struct is accessed before a block is claimed.
+struct BunyArParallelRead
+{
+    // [workerCount], owned by archive
+    ZSTD_DCtx**               workerZstdContexts;
+    uint32_t                  workerCount;
+    uint32_t                  format;
+    const ZSTD_DDict*         dictionary;
+    uint64_t                  firstBlock;
+    const BunyArBlockPointer* blocks;
+    // block data, 'srcOffset' is the block offset of the first byte
+    const uint8_t*            src;
+    uint64_t                  srcOffset;
+    uint64_t                  srcSize;
+    uint8_t*                  dst;
+    uint64_t                  blockSize;
+    uint64_t                  lastBlockSize;
+    uint32_t                  blockCount;
+
+    tfrg_atomic32_t nextBlock;
+    tfrg_atomic32_t doneBlocks;
+    // blockCount - index of the first failed block, 0 if there are no errors
+    tfrg_atomic32_t failedInv;
+    tfrg_atomic32_t references;
+
+    Mutex             mutex;
+    ConditionVariable finishedCondition;
+    bool              finished;
+
+#if defined(ENABLE_FS_IO_STATS)
+    // owned by archive
+    struct FsIoStats* ioStats;
+#endif
+};
+
+static bool bunyArDecodeBlock(uint32_t format, ZSTD_DCtx* zstd, const ZSTD_DDict* dictionary, bool isCompressed, const uint8_t* src,
+                              uint64_t srcSize, uint8_t* dst, uint64_t dstSize)
+{
+    if (!isCompressed)
+    {
+        if (srcSize != dstSize)
+            return false;
+        memcpy(dst, src, dstSize);
+        return true;
+    }
+
+    switch (format)
+    {
+    case BUNYAR_FILE_FORMAT_LZ4_BLOCKS:
+        return LZ4_decompress_safe((const char*)src, (char*)dst, (int)srcSize, (int)dstSize) == (int)dstSize;
+    case BUNYAR_FILE_FORMAT_ZSTD_BLOCKS:
+        if (dictionary)
+            return ZSTD_decompress_usingDDict(zstd, dst, dstSize, src, srcSize, dictionary) == dstSize;
+        return ZSTD_decompressDCtx(zstd, dst, dstSize, src, srcSize) == dstSize;
+    default:
+        return false;
+    }
+}
+
+static void bunyArParallelReadRelease(struct BunyArParallelRead* ctx)
+{
+    if ((uint32_t)tfrg_atomic32_add_relaxed(&ctx->references, -1) != 1)
+        return;
+    exitConditionVariable(&ctx->finishedCondition);
+    exitMutex(&ctx->mutex);
+    tf_free(ctx);
+}
+
+// Decompresses blocks until none is left. 'zstd' can be NULL, context is created on demand in that case.
+static void bunyArParallelReadBlocks(struct BunyArParallelRead* ctx, ZSTD_DCtx** zstd)
+{
+    for (;;)
+    {
+        uint32_t blockIndex = (uint32_t)tfrg_atomic32_add_relaxed(&ctx->nextBlock, 1);
+        if (blockIndex >= ctx->blockCount)
+            return;
+
+        struct BunyArBlockInfo info = bunyArDecodeBlockPointer(ctx->blocks[blockIndex]);
+        uint64_t               dstSize = blockIndex == ctx->blockCount - 1 ? ctx->lastBlockSize : ctx->blockSize;
+
+        if (info.isCompressed && ctx->format == BUNYAR_FILE_FORMAT_ZSTD_BLOCKS && !*zstd)
+            *zstd = ZSTD_createDCtx_advanced(ZSTD_MEMORY_ALLOCATOR);
+
+        bool success = info.offset >= ctx->srcOffset && info.offset - ctx->srcOffset + info.size <= ctx->srcSize &&
+                       (*zstd || !info.isCompressed || ctx->format != BUNYAR_FILE_FORMAT_ZSTD_BLOCKS);
+        if (success)
+        {
+#if defined(ENABLE_FS_IO_STATS)
+            int64_t beg = getUSec(true);
+#endif
+            success = bunyArDecodeBlock(ctx->format, *zstd, ctx->dictionary, info.isCompressed, ctx->src + (info.offset - ctx->srcOffset), info.size,
+                                        ctx->dst + blockIndex * ctx->blockSize, dstSize);
+#if defined(ENABLE_FS_IO_STATS)
+            if (success && info.isCompressed)
+                fsIoStatsAddDecompression(ctx->ioStats, dstSize, getUSec(true) - beg);
+#endif
+        }
+        if (!success)
+        {
+            LOGF(eERROR, "Failed to decompress block #%llu", (unsigned long long)(ctx->firstBlock + blockIndex));
+            tfrg_atomic32_max_relaxed(&ctx->failedInv, ctx->blockCount - blockIndex);
+        }
+
+        if ((uint32_t)tfrg_atomic32_add_relaxed(&ctx->doneBlocks, 1) + 1 == ctx->blockCount)
+        {
+            acquireMutex(&ctx->mutex);
+            ctx->finished = true;
+            wakeAllConditionVariable(&ctx->finishedCondition);
+            releaseMutex(&ctx->mutex);
+        }
+    }
+}
+
+static void bunyArParallelReadTask(void* user, uint64_t threadId)
+{
+    struct BunyArParallelRead* ctx = (struct BunyArParallelRead*)user;
+
+    // Worker threads own their contexts, anything else (e.g. threadSystemAssist) gets a temporary one
+    ZSTD_DCtx*  tempZstd = NULL;
+    ZSTD_DCtx** zstd = threadId < ctx->workerCount ? &ctx->workerZstdContexts[threadId] : &tempZstd;
+
+    bunyArParallelReadBlocks(ctx, zstd);
+
+    ZSTD_freeDCtx(tempZstd);
+    bunyArParallelReadRelease(ctx);
+}
+
+// Number of whole blocks starting at 'blockIndex' that fit into 'size'
+static uint64_t bunyArCountWholeBlocks(const struct BunyArFileStream* fs, uint64_t blockIndex, uint64_t size)
+{
+    uint64_t blocksLeft = fs->blocksHeader.blockCount - blockIndex;
+    uint64_t count = size / fs->blocksHeader.blockSize;
+    if (count >= blocksLeft)
+        return blocksLeft;
+    // last block might be smaller
+    if (count + 1 == blocksLeft && size - count * fs->blocksHeader.blockSize >= fs->blocksHeader.blockSizeLast)
+        return blocksLeft;
+    return count;
+}
+
+// Decompresses whole blocks directly to 'dst' using archive thread system.
+// Returns number of bytes written, less than requested if some block failed.
+static uint64_t bunyArReadBlocksParallel(struct BunyArMetadata* archive, struct BunyArFileStream* fs, uint64_t firstBlock,
+                                         uint64_t blockCount, uint8_t* dst)
+{
+    ASSERT(blockCount && blockCount <= UINT32_MAX);
+
+    const BunyArBlockPointer* blocks = fs->blocks + firstBlock;
+    const bool                includesLast = firstBlock + blockCount == fs->blocksHeader.blockCount;
+
+    // Range of block data covered by the read
+    uint64_t dataBeg = UINT64_MAX;
+    uint64_t dataEnd = 0;
+    uint64_t dataSize = 0;
+    for (uint64_t i = 0; i < blockCount; ++i)
+    {
+        struct BunyArBlockInfo info = bunyArDecodeBlockPointer(blocks[i]);
+        dataBeg = info.offset < dataBeg ? info.offset : dataBeg;
+        dataEnd = info.offset + info.size > dataEnd ? info.offset + info.size : dataEnd;
+        dataSize += info.size;
+    }
+
+    // Block data is read by one request in stream mode, don't do it if blocks are scattered
+    uint64_t stagingSize = archive->memoryBeg ? 0 : dataEnd - dataBeg;
+    if (stagingSize > dataSize * 2)
+        return 0;
+
+    struct BunyArParallelRead* ctx = (struct BunyArParallelRead*)tf_calloc(1, sizeof(*ctx) + stagingSize);
+    if (!ctx)
+        return 0;
+
+    if (!initMutex(&ctx->mutex))
+    {
+        tf_free(ctx);
+        return 0;
+    }
+    if (!initConditionVariable(&ctx->finishedCondition))
+    {
+        exitMutex(&ctx->mutex);
+        tf_free(ctx);
+        return 0;
+    }
+
+    // same as bunyArDecodeBlockPointerInfo, but the range can be bigger than one block
+    struct BunyArPointer64 dataLocation = {
+        fs->node->filePointer.offset + sizeof(fs->blocksHeader) + sizeof(BunyArBlockPointer) * fs->blocksHeader.blockCount + dataBeg,
+        dataEnd - dataBeg,
+    };
+
+    ctx->workerZstdContexts = archive->workerZstdContexts;
+    ctx->workerCount = archive->workerCount;
+#if defined(ENABLE_FS_IO_STATS)
+    ctx->ioStats = &archive->ioStats;
+#endif
+    ctx->format = BUNYAR_NODE_FORMAT(fs->node->format);
+    ctx->dictionary = fs->zstd_dict;
+    ctx->firstBlock = firstBlock;
+    ctx->blocks = blocks;
+    ctx->srcOffset = dataBeg;
+    ctx->dst = dst;
+    ctx->blockSize = fs->blocksHeader.blockSize;
+    ctx->lastBlockSize = includesLast ? fs->blocksHeader.blockSizeLast : fs->blocksHeader.blockSize;
+    ctx->blockCount = (uint32_t)blockCount;
+    ctx->references = 1;
+
+    if (archive->memoryBeg)
+    {
+        bunyArMemoryReadPrepare(archive, dataLocation, &ctx->src, &ctx->srcSize);
+    }
+    else
+    {
+        ctx->src = (const uint8_t*)(ctx + 1);
+        ctx->srcSize = bunyArStreamRead(archive, dataLocation.offset, dataLocation.size, (uint8_t*)(ctx + 1));
+    }
+
+    uint64_t taskCount = blockCount - 1 < archive->workerCount ? blockCount - 1 : archive->workerCount;
+    tfrg_atomic32_add_relaxed(&ctx->references, (uint32_t)taskCount);
+    threadSystemAddTasks(archive->decompressionThreads, bunyArParallelReadTask, taskCount, 0, ctx);
+
+    // Calling thread works on blocks too, so the read completes even if workers are busy
+    bunyArParallelReadBlocks(ctx, &fs->zstd_ctx);
+
+    acquireMutex(&ctx->mutex);
+    while (!ctx->finished)
+        waitConditionVariable(&ctx->finishedCondition, &ctx->mutex, TIMEOUT_INFINITE);
+    releaseMutex(&ctx->mutex);
+
+    uint64_t validBlocks = blockCount - tfrg_atomic32_load_acquire(&ctx->failedInv);
+    bunyArParallelReadRelease(ctx);
+
+    if (validBlocks == blockCount)
+        return (blockCount - 1) * fs->blocksHeader.blockSize + (includesLast ? fs->blocksHeader.blockSizeLast : fs->blocksHeader.blockSize);
+    return validBlocks * fs->blocksHeader.blockSize;
+}
+
+static void bunyArTraceAccess(struct BunyArMetadata* archive, struct BunyArFileStream* fs)
+{
+    if (!archive->traceEnabled || fs->traced)
+        return;
+
+    fs->traced = true;
+
+    uint64_t nodeId = (uint64_t)(fs->node - archive->nodes);
+    uint8_t  bit = (uint8_t)(1 << (nodeId % 8));
+
+    acquireMutex(&archive->traceMutex);
+    if (!(archive->traceVisited[nodeId / 8] & bit))
+    {
+        archive->traceVisited[nodeId / 8] |= bit;
+        arrpush(archive->traceNodes, nodeId);
+    }
+    releaseMutex(&archive->traceMutex);
+}
+
+static size_t bunyArFileRead(FileStream* pFile, void* outputBuffer, size_t outputSize)
+{
+    struct BunyArFileStream* fs = getFsBunyArStream(pFile);
+    struct BunyArMetadata*   archive = getFsArchive(pFile->pIO);
+    struct BunyArNode*       node = fs->node;
+
+    bunyArTraceAccess(archive, fs);
+
+    switch (BUNYAR_NODE_FORMAT(node->format))
+    {
+    case BUNYAR_FILE_FORMAT_RAW:
+    {
+        size_t limit = node->filePointer.size - fs->position;
+        if (outputSize > limit)
+            outputSize = limit;
+
+        size_t readSize = bunyArStreamRead(archive, node->filePointer.offset + fs->position, outputSize, outputBuffer);
+        fs->position += readSize;
+        return readSize;
+    }
+    case BUNYAR_FILE_FORMAT_LZ4_BLOCKS:
+    case BUNYAR_FILE_FORMAT_ZSTD_BLOCKS:
+    {
+        uint8_t* dstMemory = (uint8_t*)outputBuffer;
+        size_t   sizeToWrite = outputSize;
+
+        while (sizeToWrite > 0)
+        {
+            uint64_t blockIndex = fs->position / fs->blocksHeader.blockSize;
+
+            if (blockIndex >= fs->blocksHeader.blockCount)
+                break;
+
+            uint64_t offsetInBlock = fs->position - blockIndex * fs->blocksHeader.blockSize;
+
+            uint64_t blockSize =
+                blockIndex == fs->blocksHeader.blockCount - 1 ? fs->blocksHeader.blockSizeLast : fs->blocksHeader.blockSize;
+
+            // reached end of file
+            if (offsetInBlock >= blockSize)
+                break;
+
+            if (offsetInBlock == 0 && archive->decompressionThreads)
+            {
+                uint64_t blockCount = bunyArCountWholeBlocks(fs, blockIndex, sizeToWrite);
+                if (blockCount >= archive->parallelReadMinBlocks)
+                {
+                    uint64_t expectedSize = (blockCount - 1) * fs->blocksHeader.blockSize +
+                                            (blockIndex + blockCount == fs->blocksHeader.blockCount ? fs->blocksHeader.blockSizeLast
+                                                                                                    : fs->blocksHeader.blockSize);
+                    uint64_t sizeDone = bunyArReadBlocksParallel(archive, fs, blockIndex, blockCount, dstMemory);
+                    if (sizeDone)
+                        fs->lastBlockIndex = blockIndex + blockCount - 1;
+
+                    dstMemory += sizeDone;
+                    sizeToWrite -= sizeDone;
+                    fs->position += sizeDone;
+
+                    if (sizeDone == expectedSize)
+                        continue;
+                    // Stop at corrupted block, if nothing is read blocks are scattered and regular path is used
+                    if (sizeDone != 0)
+                        break;
+                }
+            }
+
+            BunyArBlockPointer* block = fs->blocks + blockIndex;
+
+            struct BunyArBlockInfo blockInfo = bunyArDecodeBlockPointer(*block);
+
+            uint64_t sizeDone = 0;
+
+            if (!blockInfo.isCompressed)
+            {
+                // Block is uncompressed, read it directly
+
+                if (blockSize != blockInfo.size)
+                {
+                    LOGF(eERROR, "Raw black size is wrong (%llu vs %llu)", (unsigned long long)blockSize,
+                         (unsigned long long)blockInfo.size);
+                    break;
+                }
+
+                struct BunyArPointer64 location = bunyArDecodeBlockPointerInfo(node, &fs->blocksHeader, &blockInfo);
+
+                size_t sizeLeft = location.size - offsetInBlock;
+
+                ASSERT(sizeLeft);
+
+                sizeDone =
+                    bunyArStreamRead(archive, location.offset + offsetInBlock, sizeToWrite > sizeLeft ? sizeLeft : sizeToWrite, dstMemory);
+            }
+            else if (offsetInBlock == 0 && sizeToWrite >= blockSize)
+            {
+                // Avoid usage of staging buffer.
+                // We can uncompress entire block to user memory.
+
+                struct BunyArBlockBuffer buffer = { 0 };
+
+                buffer.memory = dstMemory;
                 buffer.memorySize = sizeToWrite;
-                bunyArReadBlockToBuffer(archive, fs, block, &buffer);
+                if (!bunyArReadBlock(archive, fs, block, &buffer))
+                    break;
 
                 sizeDone = buffer.usedSize;
             }
@@ -1730,6 +2812,18 @@ static size_t ioArchiveFsRead(FileStream* pFile, void* outputBuffer, size_t outp
     }
 }
 
+static size_t ioArchiveFsRead(FileStream* pFile, void* outputBuffer, size_t outputSize)
+{
+#if defined(ENABLE_FS_IO_STATS)
+    int64_t beg = getUSec(true);
+    size_t  readSize = bunyArFileRead(pFile, outputBuffer, outputSize);
+    fsIoStatsAddRead(&getFsArchive(pFile->pIO)->ioStats, readSize, getUSec(true) - beg);
+    return readSize;
+#else
+    return bunyArFileRead(pFile, outputBuffer, outputSize);
+#endif
+}
+
 static bool ioArchiveFsSeek(FileStream* pFile, SeekBaseOffset baseOffset, ssize_t seekOffset)
 {
     struct BunyArFileStream* stream = getFsBunyArStream(pFile);
@@ -1783,6 +2877,8 @@ static bool ioArchiveMemoryMap(FileStream* fs, size_t* outSize, void const** out
     if (!archive->memoryBeg)
         return false;
 
+    bunyArTraceAccess(archive, stream);
+
     struct BunyArNode* node = stream->node;
     if (node->format != BUNYAR_FILE_FORMAT_RAW)
         return false;
@@ -1824,6 +2920,7 @@ void fsArchiveGetDescription(IFileSystem* fs, struct BunyArDescription* outInfo)
 
     outInfo->nodeCount = archive->nodeCount;
     outInfo->hashTable = archive->hashTable;
+    outInfo->dictionaryCount = archive->dictionaryCount;
 }
 
 bool fsArchiveGetNodeDescription(IFileSystem* fs, uint64_t nodeId, struct BunyArNodeDescription* outInfo)
@@ -1840,9 +2937,94 @@ bool fsArchiveGetNodeDescription(IFileSystem* fs, uint64_t nodeId, struct BunyAr
     outInfo->name = archive->nodeNames + node->namePointer.offset;
     outInfo->fileSize = node->originalFileSize;
     outInfo->compressedSize = node->filePointer.size;
-    outInfo->format = (enum BunyArFileFormat)node->format;
+    outInfo->format = BUNYAR_NODE_FORMAT(node->format);
+    outInfo->dictionary = BUNYAR_NODE_DICTIONARY(node->format);
+
+    return true;
+}
+
+bool fsArchiveGetBlockCacheStats(IFileSystem* fs, struct BunyArBlockCacheStats* outStats)
+{
+    memset(outStats, 0, sizeof *outStats);
+
+    struct BunyArMetadata* archive = getFsArchive(fs);
+    if (!archive->blockCacheStats.budget)
+        return false;
+
+    acquireMutex(&archive->blockCacheMutex);
+    *outStats = archive->blockCacheStats;
+    releaseMutex(&archive->blockCacheMutex);
+    return true;
+}
+
+uint64_t fsArchiveGetAccessTrace(IFileSystem* fs, uint64_t* outNodeIds, uint64_t capacity)
+{
+    struct BunyArMetadata* archive = getFsArchive(fs);
+    if (!archive->traceEnabled)
+        return 0;
+
+    acquireMutex(&archive->traceMutex);
+    uint64_t count = arrlenu(archive->traceNodes);
+    if (outNodeIds)
+        memcpy(outNodeIds, archive->traceNodes, sizeof(*outNodeIds) * (count < capacity ? count : capacity));
+    releaseMutex(&archive->traceMutex);
+    return count;
+}
+
+bool fsArchiveGetIoStats(IFileSystem* fs, struct FsIoStats* outStats)
+{
+    memset(outStats, 0, sizeof *outStats);
+#if defined(ENABLE_FS_IO_STATS)
+    struct BunyArMetadata* archive = getFsArchive(fs);
 
+    fsIoStatsLoad(&archive->ioStats, outStats);
+
+    if (archive->blockCacheStats.budget)
+    {
+        acquireMutex(&archive->blockCacheMutex);
+        outStats->blockCacheHits = archive->blockCacheStats.hits;
+        outStats->blockCacheMisses = archive->blockCacheStats.misses;
+        releaseMutex(&archive->blockCacheMutex);
+    }
     return true;
+#else
+    UNREF_PARAM(fs);
+    return false;
+#endif
+}
+
+bool fsArchiveSaveAccessTrace(IFileSystem* fs, ResourceDirectory rd, const char* fileName)
+{
+    struct BunyArMetadata* archive = getFsArchive(fs);
+    if (!archive->traceEnabled)
+    {
+        LOGF(eERROR, "Access trace is not recorded, set ArchiveOpenDesc::recordAccessTrace");
+        return false;
+    }
+
+    uint64_t  count = fsArchiveGetAccessTrace(fs, NULL, 0);
+    uint64_t* nodeIds = (uint64_t*)tf_malloc(sizeof(*nodeIds) * (count + 1));
+    count = nodeIds ? fsArchiveGetAccessTrace(fs, nodeIds, count) : 0;
+
+    FileStream stream = { 0 };
+    bool       success = nodeIds && fsOpenStreamFromPath(rd, fileName, FM_WRITE, &stream);
+
+    for (uint64_t i = 0; success && i < count; ++i)
+    {
+        const struct BunyArNode* node = archive->nodes + nodeIds[i];
+        success = fsWriteToStream(&stream, archive->nodeNames + node->namePointer.offset, node->namePointer.size) ==
+                      node->namePointer.size &&
+                  fsWriteToStream(&stream, "\n", 1) == 1;
+    }
+
+    if (stream.pIO && !fsCloseStream(&stream))
+        success = false;
+
+    tf_free(nodeIds);
+
+    if (!success)
+        LOGF(eERROR, "Failed to save archive access trace to '%s'", fileName);
+    return success;
 }
 
 bool fsArchiveGetFileBlockMetadata(FileStream* pFile, struct BunyArBlockFormatHeader* outHeader, const BunyArBlockPointer** outBlockPtrs)
@@ -1857,5 +3039,255 @@ bool fsArchiveGetFileBlockMetadata(FileStream* pFile, struct BunyArBlockFormatHe
     return *outBlockPtrs != NULL;
 }
 
+/************************************************************************/
+// MARK: - Overlay filesystem
+/************************************************************************/
+
+#define OVERLAY_HASH_SEED 0x9E3779B97F4A7C15ULL
+
+struct OverlayLayer
+{
+    IFileSystem*      pArchive;
+    ResourceDirectory rd;
+    const char*       directory;
+};
+
+struct OverlayFile
+{
+    // points to archive node name or to OverlayMetadata::strings
+    const char* name;
+    uint64_t    hash;
+    // node id for archive layer, index of file name for directory layer
+    uint64_t    uid;
+    uint32_t    layer;
+};
+
+struct OverlayMetadata
+{
+    uint32_t             layerCount;
+    struct OverlayLayer* layers;
+
+    uint64_t            fileCount;
+    struct OverlayFile* files;
+
+    // open addressing, stores file index + 1, 0 is an empty slot
+    uint64_t  slotMask;
+    uint64_t* slots;
+
+    char* strings;
+};
+
+static inline struct OverlayMetadata* getFsOverlay(IFileSystem* fs) { return (struct OverlayMetadata*)fs->pUser; }
+
+static uint64_t* overlayFindSlot(struct OverlayMetadata* overlay, const char* name, uint64_t hash)
+{
+    for (uint64_t i = hash & overlay->slotMask;; i = (i + 1) & overlay->slotMask)
+    {
+        uint64_t* slot = overlay->slots + i;
+        if (*slot == 0)
+            return slot;
+
+        const struct OverlayFile* file = overlay->files + *slot - 1;
+        if (file->hash == hash && strcmp(file->name, name) == 0)
+            return slot;
+    }
+}
+
+// Later layers replace files of earlier ones
+static void overlayAddFile(struct OverlayMetadata* overlay, const char* name, uint32_t layer, uint64_t uid)
+{
+    uint64_t  hash = (uint64_t)stbds_hash_string(name, (size_t)OVERLAY_HASH_SEED);
+    uint64_t* slot = overlayFindSlot(overlay, name, hash);
+
+    if (*slot == 0)
+    {
+        struct OverlayFile* file = overlay->files + overlay->fileCount++;
+        file->name = name;
+        file->hash = hash;
+        *slot = overlay->fileCount;
+    }
+
+    struct OverlayFile* file = overlay->files + *slot - 1;
+    file->uid = uid;
+    file->layer = layer;
+}
+
+static bool ioOverlayGetFileUid(IFileSystem* fs, ResourceDirectory rd, const char* fileName, uint64_t* outUid)
+{
+    char path[FS_MAX_PATH] = { 0 };
+    strcat(path, gResourceDirectories[rd].mPath);
+    strncat(path, fileName, sizeof(path) - strlen(path) - 1);
+
+    struct OverlayMetadata* overlay = getFsOverlay(fs);
+
+    uint64_t slot = *overlayFindSlot(overlay, path, (uint64_t)stbds_hash_string(path, (size_t)OVERLAY_HASH_SEED));
+    *outUid = slot - 1;
+    return slot != 0;
+}
+
+static bool ioOverlayOpenByUid(IFileSystem* fs, uint64_t uid, FileMode mode, FileStream* pOutStream)
+{
+    memset(pOutStream, 0, sizeof *pOutStream);
+
+    struct OverlayMetadata* overlay = getFsOverlay(fs);
+
+    if (uid >= overlay->fileCount)
+    {
+        LOGF(eERROR, "Cannot open overlay file by UID %llu: bad UID", (unsigned long long)uid);
+        return false;
+    }
+
+    const struct OverlayFile*  file = overlay->files + uid;
+    const struct OverlayLayer* layer = overlay->layers + file->layer;
+
+    if ((mode & ~FM_ALLOW_READ) != FM_READ)
+    {
+        LOGF(eERROR, "Cannot open overlay file '%s': only FM_READ is supported", file->name);
+        return false;
+    }
+
+    if (layer->pArchive)
+        return layer->pArchive->OpenByUid(layer->pArchive, file->uid, mode, pOutStream);
+
+    char path[FS_MAX_PATH];
+    int  length = snprintf(path, sizeof path, "%s%s%s", layer->directory, *layer->directory ? "/" : "", file->name);
+    if (length < 0 || length >= (int)sizeof path)
+    {
+        LOGF(eERROR, "Overlay file path is too long: '%s/%s'", layer->directory, file->name);
+        return false;
+    }
+
+    return fsOpenStreamFromPath(layer->rd, path, mode, pOutStream);
+}
+
+static bool ioOverlayOpen(IFileSystem* fs, const ResourceDirectory rd, const char* fileName, FileMode mode, FileStream* pOutStream)
+{
+    uint64_t uid;
+    if (!fs->GetFileUid(fs, rd, fileName, &uid))
+        return false;
+    return fs->OpenByUid(fs, uid, mode, pOutStream);
+}
+
+bool fsOverlayOpen(uint32_t layerCount, const struct OverlayLayerDesc* layers, IFileSystem* out)
+{
+    memset(out, 0, sizeof *out);
+
+    uint64_t maxFileCount = 0;
+    size_t   stringsSize = 0;
+
+    for (uint32_t li = 0; li < layerCount; ++li)
+    {
+        const struct OverlayLayerDesc* desc = layers + li;
+        if (desc->pArchive)
+        {
+            struct BunyArDescription info;
+            fsArchiveGetDescription(desc->pArchive, &info);
+            maxFileCount += info.nodeCount;
+            continue;
+        }
+
+        stringsSize += strlen(desc->directory ? desc->directory : "") + 1;
+        for (uint64_t fi = 0; fi < desc->fileCount; ++fi)
+            stringsSize += strlen(desc->fileNames[fi]) + 1;
+        maxFileCount += desc->fileCount;
+    }
+
+    uint64_t slotCount = 16;
+    while (slotCount < maxFileCount * 2)
+        slotCount *= 2;
+
+    struct OverlayMetadata* overlay = (struct OverlayMetadata*)tf_calloc(1, sizeof *overlay);
+    if (!overlay)
+        return false;
+
+    // fsOverlayClose frees whatever was allocated on failure
+    out->pUser = overlay;
+
+    overlay->layerCount = layerCount;
+    overlay->layers = (struct OverlayLayer*)tf_calloc(layerCount ? layerCount : 1, sizeof *overlay->layers);
+    overlay->files = (struct OverlayFile*)tf_malloc(sizeof *overlay->files * (maxFileCount ? maxFileCount : 1));
+    overlay->slotMask = slotCount - 1;
+    overlay->slots = (uint64_t*)tf_calloc(slotCount, sizeof *overlay->slots);
+    overlay->strings = (char*)tf_malloc(stringsSize ? stringsSize : 1);
+    if (!overlay->layers || !overlay->files || !overlay->slots || !overlay->strings)
+    {
+        LOGF(eERROR, "Failed to open overlay: out of memory for %llu files", (unsigned long long)maxFileCount);
+        fsOverlayClose(out);
+        return false;
+    }
+
+    char* strings = overlay->strings;
+
+    for (uint32_t li = 0; li < layerCount; ++li)
+    {
+        const struct OverlayLayerDesc* desc = layers + li;
+        struct OverlayLayer*           layer = overlay->layers + li;
+
+        layer->pArchive = desc->pArchive;
+        layer->rd = desc->rd;
+
+        if (desc->pArchive)
+        {
+            struct BunyArDescription info;
+            fsArchiveGetDescription(desc->pArchive, &info);
+
+            for (uint64_t ni = 0; ni < info.nodeCount; ++ni)
+            {
+                struct BunyArNodeDescription node;
+                fsArchiveGetNodeDescription(desc->pArchive, ni, &node);
+                overlayAddFile(overlay, node.name, li, ni);
+            }
+            continue;
+        }
+
+        size_t length = strlen(desc->directory ? desc->directory : "");
+        memcpy(strings, desc->directory ? desc->directory : "", length + 1);
+        // separator is added when path is built
+        if (length && (strings[length - 1] == '/' || strings[length - 1] == '\\'))
+            strings[length - 1] = 0;
+        layer->directory = strings;
+        strings += length + 1;
+
+        for (uint64_t fi = 0; fi < desc->fileCount; ++fi)
+        {
+            length = strlen(desc->fileNames[fi]);
+            memcpy(strings, desc->fileNames[fi], length + 1);
+            overlayAddFile(overlay, strings, li, fi);
+            strings += length + 1;
+        }
+    }
+
+    out->Open = ioOverlayOpen;
+    out->GetFileUid = ioOverlayGetFileUid;
+    out->OpenByUid = ioOverlayOpenByUid;
+    return true;
+}
+
+bool fsOverlayClose(IFileSystem* fs)
+{
+    if (!fs || !fs->pUser)
+        return true;
+
+    struct OverlayMetadata* overlay = getFsOverlay(fs);
+    tf_free(overlay->strings);
+    tf_free(overlay->slots);
+    tf_free(overlay->files);
+    tf_free(overlay->layers);
+    tf_free(overlay);
+
+    memset(fs, 0, sizeof *fs);
+    return true;
+}
+
+bool fsOverlayGetFileLayer(IFileSystem* fs, uint64_t uid, uint32_t* outLayer)
+{
+    struct OverlayMetadata* overlay = getFsOverlay(fs);
+    if (uid >= overlay->fileCount)
+        return false;
+
+    *outLayer = overlay->files[uid].layer;
+    return true;
+}
+
 /************************************************************************/
 /************************************************************************/
@@ -28,20 +28,69 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <sys/uio.h>
+
+#if defined(__linux__) && !defined(ANDROID) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#if defined(__NR_io_uring_setup) && defined(__NR_io_uring_enter)
+#define UNIX_FS_IO_URING
+#endif
+#endif
+#endif
+
 #include "../../Utilities/Interfaces/IFileSystem.h"
 #include "../../Utilities/Interfaces/ILog.h"
+#include "../../Utilities/Interfaces/IThread.h"
+#include "../../Utilities/Interfaces/ITime.h"
+#include "../Threading/Atomics.h"
+#include "../Threading/ThreadSystem.h"
+
+#include "../../Utilities/Interfaces/IMemory.h"
 
 extern ResourceDirectoryInfo gResourceDirectories[RD_COUNT];
 
+#if defined(ENABLE_FS_IO_STATS)
+extern struct FsIoStats gResourceDirectoryIoStats[RD_COUNT];
+
+void fsIoStatsAddOpen(struct FsIoStats* stats);
+void fsIoStatsAddRead(struct FsIoStats* stats, uint64_t size, int64_t usec);
+#endif
+
 #if defined(__APPLE__)
 #include <sys/param.h>
 #endif
 
+// Size of user-space buffer used by system streams opened without FM_UNBUFFERED.
+// Reads and writes of this size or bigger bypass the buffer.
+#ifndef UNIX_FS_STREAM_BUFFER_SIZE
+#define UNIX_FS_STREAM_BUFFER_SIZE (32 * 1024)
+#endif
+
+// Buffer is allocated on first small read/write.
+// It either holds data read ahead of the file position or data waiting to be written, never both.
+struct UnixStreamBuffer
+{
+    uint32_t capacity;
+    // read: offset of next byte to return, write: number of pending bytes
+    uint32_t cursor;
+    // read: number of valid bytes, always 0 while writing
+    uint32_t fill;
+    bool     dirty;
+    uint8_t  data[];
+};
+
 struct UnixFileStream
 {
-    ssize_t size;
-    void*   mapping;
-    int     descriptor;
+    ssize_t                  size;
+    void*                    mapping;
+    struct UnixStreamBuffer* buffer;
+    int                      descriptor;
+#if defined(ENABLE_FS_IO_STATS)
+    // stats of resource directory the stream is opened from
+    struct FsIoStats* stats;
+#endif
 };
 
 #define USD(name, fs) struct UnixFileStream* name = (struct UnixFileStream*)(fs)->mUser.data
@@ -73,6 +122,72 @@ static const char* getFileName(const struct UnixFileStream* stream, char* buffer
     return "unknown file name";
 }
 
+static bool unixFsWriteAll(struct UnixFileStream* stream, const uint8_t* src, size_t size)
+{
+    while (size)
+    {
+        ssize_t res = write(stream->descriptor, src, size);
+        if (res < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        src += res;
+        size -= (size_t)res;
+    }
+    return true;
+}
+
+// Makes the descriptor position match the logical stream position.
+// Pending writes are written out, read-ahead data is dropped.
+static bool unixFsSyncBuffer(struct UnixFileStream* stream)
+{
+    struct UnixStreamBuffer* buffer = stream->buffer;
+    if (!buffer)
+        return true;
+
+    bool success = true;
+    if (buffer->dirty)
+    {
+        success = unixFsWriteAll(stream, buffer->data, buffer->cursor);
+        if (!success)
+        {
+            char name[1024];
+            LOGF(eERROR, "Error writing %s to file '%s': %s", humanReadableSize(buffer->cursor).str,
+                 getFileName(stream, name, sizeof name), strerror(errno));
+        }
+    }
+    else if (buffer->cursor != buffer->fill)
+    {
+        success = lseek(stream->descriptor, (off_t)buffer->cursor - (off_t)buffer->fill, SEEK_CUR) >= 0;
+        if (!success)
+        {
+            char name[1024];
+            LOGF(eERROR, "Error seeking file '%s': %s", getFileName(stream, name, sizeof name), strerror(errno));
+        }
+    }
+
+    buffer->cursor = 0;
+    buffer->fill = 0;
+    buffer->dirty = false;
+    return success;
+}
+
+static struct UnixStreamBuffer* unixFsGetBuffer(FileStream* fs, struct UnixFileStream* stream)
+{
+    if (!stream->buffer && !(fs->mMode & FM_UNBUFFERED))
+    {
+        stream->buffer = (struct UnixStreamBuffer*)tf_malloc(sizeof(struct UnixStreamBuffer) + UNIX_FS_STREAM_BUFFER_SIZE);
+        if (stream->buffer)
+        {
+            memset(stream->buffer, 0, sizeof(struct UnixStreamBuffer));
+            stream->buffer->capacity = UNIX_FS_STREAM_BUFFER_SIZE;
+        }
+    }
+    return stream->buffer;
+}
+
 static bool ioUnixFsOpen(IFileSystem* io, const ResourceDirectory rd, const char* fileName, FileMode mode, FileStream* fs)
 {
     memset(fs, 0, sizeof *fs);
@@ -130,6 +245,11 @@ static bool ioUnixFsOpen(IFileSystem* io, const ResourceDirectory rd, const char
     stream->size = -1;
     stream->descriptor = fd;
 
+#if defined(ENABLE_FS_IO_STATS)
+    stream->stats = &gResourceDirectoryIoStats[rd];
+    fsIoStatsAddOpen(stream->stats);
+#endif
+
     struct stat finfo;
     if (fstat(stream->descriptor, &finfo) == 0)
     {
@@ -194,6 +314,15 @@ static bool ioUnixFsClose(FileStream* fs)
 {
     USD(stream, fs);
 
+    bool success = true;
+    if (stream->buffer)
+    {
+        if (stream->buffer->dirty)
+            success = unixFsSyncBuffer(stream);
+        tf_free(stream->buffer);
+        stream->buffer = NULL;
+    }
+
     if (stream->mapping)
     {
         if (munmap(stream->mapping, (size_t)stream->size))
@@ -212,9 +341,9 @@ static bool ioUnixFsClose(FileStream* fs)
     getFileName(stream, buffer, sizeof buffer);
 #endif
 
-    bool success = stream->descriptor < 0 || close(stream->descriptor) == 0;
-    if (!success)
+    if (stream->descriptor >= 0 && close(stream->descriptor) != 0)
     {
+        success = false;
 #if defined(FORGE_DEBUG)
         LOGF(eERROR, "Error after closing file '%s': '%s'", buffer, strerror(errno));
 #else
@@ -225,17 +354,110 @@ static bool ioUnixFsClose(FileStream* fs)
     return success;
 }
 
+static size_t unixFsRead(FileStream* fs, void* dst, size_t size)
+{
+    USD(stream, fs);
+
+    struct UnixStreamBuffer* buffer = size < UNIX_FS_STREAM_BUFFER_SIZE ? unixFsGetBuffer(fs, stream) : stream->buffer;
+    if (buffer && buffer->dirty && !unixFsSyncBuffer(stream))
+        return 0;
+
+    size_t   readBytes = 0;
+    uint8_t* out = (uint8_t*)dst;
+    if (buffer)
+    {
+        size_t available = buffer->fill - buffer->cursor;
+        size_t copySize = available < size ? available : size;
+        memcpy(out, buffer->data + buffer->cursor, copySize);
+        buffer->cursor += (uint32_t)copySize;
+        readBytes = copySize;
+    }
+
+    size_t remaining = size - readBytes;
+    if (!remaining)
+        return readBytes;
+
+    ssize_t res;
+    if (!buffer || remaining >= buffer->capacity)
+    {
+        // Big reads go directly to the destination, buffer is fully consumed at this point
+        if (buffer)
+        {
+            buffer->fill = 0;
+            buffer->cursor = 0;
+        }
+        res = read(stream->descriptor, out + readBytes, remaining);
+        if (res >= 0)
+            return readBytes + (size_t)res;
+    }
+    else
+    {
+        res = read(stream->descriptor, buffer->data, buffer->capacity);
+        if (res >= 0)
+        {
+            size_t copySize = (size_t)res < remaining ? (size_t)res : remaining;
+            memcpy(out + readBytes, buffer->data, copySize);
+            buffer->fill = (uint32_t)res;
+            buffer->cursor = (uint32_t)copySize;
+            return readBytes + copySize;
+        }
+        buffer->fill = 0;
+        buffer->cursor = 0;
+    }
+
+    char name[1024];
+    LOGF(eERROR, "Error reading %s from file '%s': %s", humanReadableSize(size).str, getFileName(stream, name, sizeof name), strerror(errno));
+    return readBytes;
+}
+
 static size_t ioUnixFsRead(FileStream* fs, void* dst, size_t size)
 {
+#if defined(ENABLE_FS_IO_STATS)
     USD(stream, fs);
-    ssize_t res = read(stream->descriptor, dst, size);
-    if (res >= 0)
-        return (size_t)res;
 
-    char buffer[1024];
-    LOGF(eERROR, "Error reading %s from file '%s': %s", humanReadableSize(size).str, getFileName(stream, buffer, sizeof buffer),
-         strerror(errno));
-    return 0;
+    int64_t beg = getUSec(true);
+    size_t  readSize = unixFsRead(fs, dst, size);
+    fsIoStatsAddRead(stream->stats, readSize, getUSec(true) - beg);
+    return readSize;
+#else
+    return unixFsRead(fs, dst, size);
+#endif
+}
+
+static size_t ioUnixFsReadAt(FileStream* fs, void* dst, size_t size, uint64_t offset)
+{
+    USD(stream, fs);
+
+    // Buffered writes have to reach the file first
+    if (stream->buffer && stream->buffer->dirty && !unixFsSyncBuffer(stream))
+        return 0;
+
+#if defined(ENABLE_FS_IO_STATS)
+    int64_t beg = getUSec(true);
+#endif
+
+    size_t readBytes = 0;
+    while (readBytes < size)
+    {
+        ssize_t res = pread(stream->descriptor, (uint8_t*)dst + readBytes, size - readBytes, (off_t)(offset + readBytes));
+        if (res < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            char name[1024];
+            LOGF(eERROR, "Error reading %s at offset %llu from file '%s': %s", humanReadableSize(size).str, (unsigned long long)offset,
+                 getFileName(stream, name, sizeof name), strerror(errno));
+            break;
+        }
+        if (res == 0)
+            break;
+        readBytes += (size_t)res;
+    }
+
+#if defined(ENABLE_FS_IO_STATS)
+    fsIoStatsAddRead(stream->stats, readBytes, getUSec(true) - beg);
+#endif
+    return readBytes;
 }
 
 static ssize_t ioUnixFsGetPosition(FileStream* fs)
@@ -244,7 +466,12 @@ static ssize_t ioUnixFsGetPosition(FileStream* fs)
 
     off_t res = lseek(stream->descriptor, 0, SEEK_CUR);
     if (res >= 0)
+    {
+        const struct UnixStreamBuffer* buffer = stream->buffer;
+        if (buffer)
+            res = buffer->dirty ? res + buffer->cursor : res - (buffer->fill - buffer->cursor);
         return res;
+    }
 
     char buffer[1024];
     LOGF(eERROR, "Error getting file position '%s': %s", getFileName(stream, buffer, sizeof buffer), strerror(errno));
@@ -254,12 +481,31 @@ static ssize_t ioUnixFsGetPosition(FileStream* fs)
 static size_t ioUnixFsWrite(FileStream* fs, const void* src, size_t size)
 {
     USD(stream, fs);
+
+    struct UnixStreamBuffer* buffer = size < UNIX_FS_STREAM_BUFFER_SIZE ? unixFsGetBuffer(fs, stream) : stream->buffer;
+    if (buffer)
+    {
+        if (!buffer->dirty || buffer->cursor + size > buffer->capacity)
+        {
+            if (!unixFsSyncBuffer(stream))
+                return 0;
+        }
+
+        if (size < buffer->capacity)
+        {
+            memcpy(buffer->data + buffer->cursor, src, size);
+            buffer->cursor += (uint32_t)size;
+            buffer->dirty = true;
+            return size;
+        }
+    }
+
     ssize_t res = write(stream->descriptor, src, size);
     if (res >= 0)
         return (size_t)res;
 
-    char buffer[1024];
-    LOGF(eERROR, "Error writing %s from file '%s': %s", humanReadableSize(size).str, getFileName(stream, buffer, sizeof buffer),
+    char name[1024];
+    LOGF(eERROR, "Error writing %s from file '%s': %s", humanReadableSize(size).str, getFileName(stream, name, sizeof name),
          strerror(errno));
     return 0;
 }
@@ -282,12 +528,44 @@ static bool ioUnixFsSeek(FileStream* fs, SeekBaseOffset baseOffset, ssize_t offs
         break;
     }
 
+    struct UnixStreamBuffer* buffer = stream->buffer;
+    if (buffer && !buffer->dirty && buffer->fill)
+    {
+        // Stay inside of read-ahead data if possible
+        ssize_t target = -1;
+        if (whence == SEEK_CUR)
+        {
+            target = (ssize_t)buffer->cursor + offset;
+        }
+        else if (whence == SEEK_SET)
+        {
+            off_t end = lseek(stream->descriptor, 0, SEEK_CUR);
+            if (end >= 0)
+                target = offset - ((ssize_t)end - (ssize_t)buffer->fill);
+        }
+
+        if (target >= 0 && target <= (ssize_t)buffer->fill)
+        {
+            buffer->cursor = (uint32_t)target;
+            return true;
+        }
+
+        if (whence == SEEK_CUR)
+            offset -= (ssize_t)(buffer->fill - buffer->cursor);
+        buffer->cursor = 0;
+        buffer->fill = 0;
+    }
+    else if (buffer && buffer->dirty && !unixFsSyncBuffer(stream))
+    {
+        return false;
+    }
+
     off_t res = lseek(stream->descriptor, offset, whence);
     if (res >= 0)
         return true;
 
-    char buffer[1024];
-    LOGF(eERROR, "Error seeking file '%s': %s", getFileName(stream, buffer, sizeof buffer), strerror(errno));
+    char name[1024];
+    LOGF(eERROR, "Error seeking file '%s': %s", getFileName(stream, name, sizeof name), strerror(errno));
     return false;
 }
 
@@ -298,6 +576,9 @@ static bool ioUnixFsFlush(FileStream* fs)
 
     USD(stream, fs);
 
+    if (!unixFsSyncBuffer(stream))
+        return false;
+
 #if defined(_POSIX_SYNCHRONIZED_IO) && _POSIX_SYNCHRONIZED_IO > 0
     // datasync is a bit faster, because it can skip flush of modified metadata,
     // e.g. file access time
@@ -343,6 +624,8 @@ static bool unixFsUpdateSize(struct UnixFileStream* stream)
 static ssize_t ioUnixFsGetSize(FileStream* fs)
 {
     USD(stream, fs);
+    if (stream->buffer && stream->buffer->dirty && !unixFsSyncBuffer(stream))
+        return -1;
     if ((fs->mMode & FM_WRITE) && !unixFsUpdateSize(stream))
         return -1;
     return stream->size;
@@ -351,15 +634,535 @@ static ssize_t ioUnixFsGetSize(FileStream* fs)
 static void* ioUnixGetSystemHandle(FileStream* fs)
 {
     USD(stream, fs);
+    // Caller may use the descriptor directly, so its position has to be the real one
+    unixFsSyncBuffer(stream);
     return (void*)(ssize_t)stream->descriptor;
 }
 
 static bool ioUnixFsIsAtEnd(FileStream* fs) { return ioUnixFsGetPosition(fs) >= ioUnixFsGetSize(fs); }
 
-IFileSystem gUnixSystemFileIO = { ioUnixFsOpen,          ioUnixFsClose, ioUnixFsRead,    ioUnixFsWrite, ioUnixFsSeek, ioUnixFsGetPosition,
-                                  ioUnixFsGetSize,       ioUnixFsFlush, ioUnixFsIsAtEnd, NULL,          NULL,         ioUnixFsMemoryMap,
-                                  ioUnixGetSystemHandle, NULL };
+IFileSystem gUnixSystemFileIO = { ioUnixFsOpen,          ioUnixFsClose,  ioUnixFsRead,    ioUnixFsWrite, ioUnixFsSeek, ioUnixFsGetPosition,
+                                  ioUnixFsGetSize,       ioUnixFsFlush,  ioUnixFsIsAtEnd, NULL,          NULL,         ioUnixFsMemoryMap,
+                                  ioUnixGetSystemHandle, ioUnixFsReadAt, NULL };
 
 #if !defined(ANDROID)
 IFileSystem* pSystemFileIO = &gUnixSystemFileIO;
 #endif
+
+/************************************************************************/
+// MARK: - Asynchronous reads
+/************************************************************************/
+
+// Worker threads used for positional reads when io_uring is not available
+#ifndef UNIX_FS_ASYNC_READ_THREADS
+#define UNIX_FS_ASYNC_READ_THREADS 4
+#endif
+
+// Max number of reads in flight in io_uring, the rest waits in batches
+#ifndef UNIX_FS_IO_URING_ENTRIES
+#define UNIX_FS_IO_URING_ENTRIES 256
+#endif
+
+typedef struct UnixAsyncRead
+{
+    FileAsyncRead*             pRead;
+    struct FileAsyncReadBatch* pBatch;
+    int                        descriptor;
+#if defined(UNIX_FS_IO_URING)
+    struct iovec iov;
+#endif
+} UnixAsyncRead;
+
+struct FileAsyncReadBatch
+{
+    UnixAsyncRead*             pReads;
+    // Reads handled by backend, some requests might be completed synchronously
+    uint32_t                   readCount;
+    // Total number of requests
+    uint32_t                   count;
+    // Requests completed synchronously which failed or were short
+    uint32_t                   syncFailedCount;
+    tfrg_atomic32_t            completed;
+    // io_uring: next read waiting for space in submission queue
+    uint32_t                   nextSubmit;
+    struct FileAsyncReadBatch* pNextPending;
+};
+
+static Mutex             gAsyncReadMutex;
+static ConditionVariable gAsyncReadCompleted;
+static bool              gAsyncReadInitialized = false;
+static bool              gAsyncReadBackendCreated = false;
+static ThreadSystem      gAsyncReadThreads = NULL;
+
+static void unixFsCompleteAsyncRead(UnixAsyncRead* read)
+{
+    struct FileAsyncReadBatch* batch = read->pBatch;
+    uint32_t                   completed = tfrg_atomic32_add_relaxed(&batch->completed, 1) + 1;
+    if (completed == batch->count && gAsyncReadThreads)
+    {
+        // Waiters check batch state under the same mutex, so wake up can't be missed
+        acquireMutex(&gAsyncReadMutex);
+        wakeAllConditionVariable(&gAsyncReadCompleted);
+        releaseMutex(&gAsyncReadMutex);
+    }
+}
+
+// Used for streams without descriptor, keeps seek position intact
+static void unixFsReadStreamAt(FileAsyncRead* pRead)
+{
+    pRead->mBytesRead = fsReadFromStreamAt(pRead->pStream, pRead->pDst, (size_t)pRead->mSize, pRead->mOffset);
+    if (pRead->mBytesRead != pRead->mSize)
+        pRead->mError = EIO;
+}
+
+static void unixFsAsyncReadTask(void* user, uint64_t threadId)
+{
+    UNREF_PARAM(threadId);
+    UnixAsyncRead* read = (UnixAsyncRead*)user;
+    FileAsyncRead* pRead = read->pRead;
+    uint8_t*       dst = (uint8_t*)pRead->pDst;
+
+    uint64_t done = 0;
+    while (done < pRead->mSize)
+    {
+        ssize_t res = pread(read->descriptor, dst + done, (size_t)(pRead->mSize - done), (off_t)(pRead->mOffset + done));
+        if (res < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            pRead->mError = errno;
+            break;
+        }
+        if (res == 0)
+            break;
+        done += (uint64_t)res;
+    }
+    pRead->mBytesRead = done;
+    unixFsCompleteAsyncRead(read);
+}
+
+#if defined(UNIX_FS_IO_URING)
+typedef struct UnixIoRing
+{
+    int                  descriptor;
+    uint32_t             inFlight;
+    uint32_t             toSubmit;
+    uint32_t             capacity;
+    void*                sqMapping;
+    size_t               sqMappingSize;
+    void*                cqMapping;
+    size_t               cqMappingSize;
+    struct io_uring_sqe* sqes;
+    size_t               sqesSize;
+    uint32_t*            sqTail;
+    uint32_t*            sqMask;
+    uint32_t*            sqArray;
+    uint32_t*            cqHead;
+    uint32_t*            cqTail;
+    uint32_t*            cqMask;
+    struct io_uring_cqe* cqes;
+    // Some thread waits for completions in io_uring_enter without holding gAsyncReadMutex.
+    // Others don't reap completions meanwhile, so the waiting thread always has one to wake up for
+    bool                 waiting;
+} UnixIoRing;
+
+static UnixIoRing                 gIoRing = { .descriptor = -1 };
+static struct FileAsyncReadBatch* pIoRingPendingHead = NULL;
+static struct FileAsyncReadBatch* pIoRingPendingTail = NULL;
+
+static void unixIoRingDestroy(void)
+{
+    if (gIoRing.sqes)
+        munmap(gIoRing.sqes, gIoRing.sqesSize);
+    if (gIoRing.cqMapping && gIoRing.cqMapping != gIoRing.sqMapping)
+        munmap(gIoRing.cqMapping, gIoRing.cqMappingSize);
+    if (gIoRing.sqMapping)
+        munmap(gIoRing.sqMapping, gIoRing.sqMappingSize);
+    if (gIoRing.descriptor >= 0)
+        close(gIoRing.descriptor);
+    memset(&gIoRing, 0, sizeof gIoRing);
+    gIoRing.descriptor = -1;
+}
+
+static bool unixIoRingCreate(void)
+{
+    struct io_uring_params params;
+    memset(&params, 0, sizeof params);
+    int fd = (int)syscall(__NR_io_uring_setup, UNIX_FS_IO_URING_ENTRIES, &params);
+    if (fd < 0)
+    {
+        // Old kernel or blocked by seccomp
+        LOGF(eINFO, "io_uring is not available (%s), using read threads for async reads", strerror(errno));
+        return false;
+    }
+    gIoRing.descriptor = fd;
+
+    gIoRing.sqMappingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+    gIoRing.cqMappingSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if (gIoRing.cqMappingSize > gIoRing.sqMappingSize)
+            gIoRing.sqMappingSize = gIoRing.cqMappingSize;
+        gIoRing.cqMappingSize = gIoRing.sqMappingSize;
+    }
+
+    void* sq = mmap(NULL, gIoRing.sqMappingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sq == MAP_FAILED)
+    {
+        LOGF(eERROR, "Failed to map io_uring submission queue: %s", strerror(errno));
+        unixIoRingDestroy();
+        return false;
+    }
+    gIoRing.sqMapping = sq;
+
+    void* cq = sq;
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP))
+    {
+        cq = mmap(NULL, gIoRing.cqMappingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cq == MAP_FAILED)
+        {
+            LOGF(eERROR, "Failed to map io_uring completion queue: %s", strerror(errno));
+            unixIoRingDestroy();
+            return false;
+        }
+    }
+    gIoRing.cqMapping = cq;
+
+    gIoRing.sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    void* sqes = mmap(NULL, gIoRing.sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (sqes == MAP_FAILED)
+    {
+        LOGF(eERROR, "Failed to map io_uring submission entries: %s", strerror(errno));
+        unixIoRingDestroy();
+        return false;
+    }
+    gIoRing.sqes = (struct io_uring_sqe*)sqes;
+
+    gIoRing.sqTail = (uint32_t*)((uint8_t*)sq + params.sq_off.tail);
+    gIoRing.sqMask = (uint32_t*)((uint8_t*)sq + params.sq_off.ring_mask);
+    gIoRing.sqArray = (uint32_t*)((uint8_t*)sq + params.sq_off.array);
+    gIoRing.cqHead = (uint32_t*)((uint8_t*)cq + params.cq_off.head);
+    gIoRing.cqTail = (uint32_t*)((uint8_t*)cq + params.cq_off.tail);
+    gIoRing.cqMask = (uint32_t*)((uint8_t*)cq + params.cq_off.ring_mask);
+    gIoRing.cqes = (struct io_uring_cqe*)((uint8_t*)cq + params.cq_off.cqes);
+    // Completion queue is at least as big as submission queue, so it can't overflow
+    gIoRing.capacity = params.sq_entries;
+    return true;
+}
+
+// Pushes remaining part of the read into submission queue. Caller guarantees free space
+static void unixIoRingPush(UnixAsyncRead* read)
+{
+    FileAsyncRead* pRead = read->pRead;
+    uint64_t       remaining = pRead->mSize - pRead->mBytesRead;
+    // Linux never transfers more than this in one call
+    const uint64_t maxReadSize = 0x7FFFF000;
+
+    read->iov.iov_base = (uint8_t*)pRead->pDst + pRead->mBytesRead;
+    read->iov.iov_len = (size_t)(remaining < maxReadSize ? remaining : maxReadSize);
+
+    const uint32_t       tail = *gIoRing.sqTail;
+    const uint32_t       index = tail & *gIoRing.sqMask;
+    struct io_uring_sqe* sqe = &gIoRing.sqes[index];
+    memset(sqe, 0, sizeof *sqe);
+    // READV is supported by every io_uring kernel, unlike READ
+    sqe->opcode = IORING_OP_READV;
+    sqe->fd = read->descriptor;
+    sqe->addr = (uint64_t)(uintptr_t)&read->iov;
+    sqe->len = 1;
+    sqe->off = pRead->mOffset + pRead->mBytesRead;
+    sqe->user_data = (uint64_t)(uintptr_t)read;
+    gIoRing.sqArray[index] = index;
+    __atomic_store_n(gIoRing.sqTail, tail + 1, __ATOMIC_RELEASE);
+
+    ++gIoRing.inFlight;
+    ++gIoRing.toSubmit;
+}
+
+// Called with gAsyncReadMutex locked
+static void unixIoRingReap(void)
+{
+    uint32_t       head = *gIoRing.cqHead;
+    const uint32_t tail = __atomic_load_n(gIoRing.cqTail, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head)
+    {
+        const struct io_uring_cqe* cqe = &gIoRing.cqes[head & *gIoRing.cqMask];
+        UnixAsyncRead*             read = (UnixAsyncRead*)(uintptr_t)cqe->user_data;
+        FileAsyncRead*             pRead = read->pRead;
+        --gIoRing.inFlight;
+
+        if (cqe->res == -EINTR || cqe->res == -EAGAIN)
+        {
+            unixIoRingPush(read);
+            continue;
+        }
+
+        if (cqe->res < 0)
+        {
+            pRead->mError = -cqe->res;
+        }
+        else if (cqe->res > 0)
+        {
+            pRead->mBytesRead += (uint64_t)cqe->res;
+            if (pRead->mBytesRead < pRead->mSize)
+            {
+                // Short read, continue from where it stopped
+                unixIoRingPush(read);
+                continue;
+            }
+        }
+        unixFsCompleteAsyncRead(read);
+    }
+    __atomic_store_n(gIoRing.cqHead, head, __ATOMIC_RELEASE);
+}
+
+// Reaps completions, moves pending reads into submission queue and submits them. Called with gAsyncReadMutex locked
+static void unixIoRingPump(void)
+{
+    if (!gIoRing.waiting)
+        unixIoRingReap();
+
+    while (pIoRingPendingHead && gIoRing.inFlight < gIoRing.capacity)
+    {
+        struct FileAsyncReadBatch* batch = pIoRingPendingHead;
+        while (batch->nextSubmit < batch->readCount && gIoRing.inFlight < gIoRing.capacity)
+        {
+            unixIoRingPush(&batch->pReads[batch->nextSubmit++]);
+        }
+        if (batch->nextSubmit == batch->readCount)
+        {
+            pIoRingPendingHead = batch->pNextPending;
+            if (!pIoRingPendingHead)
+                pIoRingPendingTail = NULL;
+            batch->pNextPending = NULL;
+        }
+    }
+
+    if (!gIoRing.toSubmit)
+        return;
+
+    int res = (int)syscall(__NR_io_uring_enter, gIoRing.descriptor, gIoRing.toSubmit, 0, 0, NULL, 0);
+    if (res >= 0)
+    {
+        gIoRing.toSubmit -= (uint32_t)res < gIoRing.toSubmit ? (uint32_t)res : gIoRing.toSubmit;
+    }
+    else if (errno != EINTR && errno != EAGAIN && errno != EBUSY)
+    {
+        LOGF(eERROR, "io_uring_enter failed: %s", strerror(errno));
+    }
+}
+
+// Blocks until io_uring has a completion. Called with gAsyncReadMutex locked, releases it while waiting
+static void unixIoRingWait(void)
+{
+    // Nothing to wait for, or submission has to be retried first
+    if (!gIoRing.inFlight || gIoRing.toSubmit)
+        return;
+    if (gIoRing.waiting)
+    {
+        waitConditionVariable(&gAsyncReadCompleted, &gAsyncReadMutex, TIMEOUT_INFINITE);
+        return;
+    }
+
+    gIoRing.waiting = true;
+    releaseMutex(&gAsyncReadMutex);
+    int res = (int)syscall(__NR_io_uring_enter, gIoRing.descriptor, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0);
+    if (res < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+    {
+        LOGF(eERROR, "io_uring_enter failed: %s", strerror(errno));
+    }
+    acquireMutex(&gAsyncReadMutex);
+    gIoRing.waiting = false;
+
+    unixIoRingReap();
+    wakeAllConditionVariable(&gAsyncReadCompleted);
+}
+#endif
+
+bool unixFsInitAsyncReads(void)
+{
+    if (gAsyncReadInitialized)
+        return true;
+    if (!initMutex(&gAsyncReadMutex))
+        return false;
+    if (!initConditionVariable(&gAsyncReadCompleted))
+    {
+        exitMutex(&gAsyncReadMutex);
+        return false;
+    }
+    gAsyncReadInitialized = true;
+    return true;
+}
+
+void unixFsExitAsyncReads(void)
+{
+    if (!gAsyncReadInitialized)
+        return;
+
+#if defined(UNIX_FS_IO_URING)
+    ASSERT(!gIoRing.inFlight && !pIoRingPendingHead && "All async read batches have to be waited before exitFileSystem");
+    unixIoRingDestroy();
+#endif
+    if (gAsyncReadThreads)
+        threadSystemExit(&gAsyncReadThreads, &gThreadSystemExitDescDefault);
+    gAsyncReadThreads = NULL;
+
+    exitConditionVariable(&gAsyncReadCompleted);
+    exitMutex(&gAsyncReadMutex);
+    gAsyncReadBackendCreated = false;
+    gAsyncReadInitialized = false;
+}
+
+// Called with gAsyncReadMutex locked
+static void unixFsCreateAsyncReadBackend(void)
+{
+    if (gAsyncReadBackendCreated)
+        return;
+    gAsyncReadBackendCreated = true;
+
+#if defined(UNIX_FS_IO_URING)
+    if (unixIoRingCreate())
+        return;
+#endif
+
+    struct ThreadSystemInitDesc desc = gThreadSystemInitDescDefault;
+    desc.threadCount = UNIX_FS_ASYNC_READ_THREADS;
+    desc.threadName = "AsyncRead";
+    if (!threadSystemInit(&gAsyncReadThreads, &desc))
+    {
+        LOGF(eERROR, "Failed to create async read threads, reads are going to be synchronous");
+        gAsyncReadThreads = NULL;
+    }
+}
+
+bool fsReadAsync(uint32_t count, FileAsyncRead* pReads, FileAsyncReadBatch** ppOutBatch)
+{
+    ASSERT(ppOutBatch);
+    ASSERT(pReads || !count);
+    *ppOutBatch = NULL;
+
+    if (!gAsyncReadInitialized)
+    {
+        LOGF(eERROR, "fsReadAsync is called before initFileSystem");
+        return false;
+    }
+
+    struct FileAsyncReadBatch* batch =
+        (struct FileAsyncReadBatch*)tf_calloc(1, sizeof(struct FileAsyncReadBatch) + count * sizeof(UnixAsyncRead));
+    if (!batch)
+        return false;
+    batch->pReads = (UnixAsyncRead*)(batch + 1);
+    batch->count = count;
+
+    uint32_t syncCount = 0;
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        FileAsyncRead* pRead = &pReads[i];
+        pRead->mBytesRead = 0;
+        pRead->mError = 0;
+
+        FileStream* fs = pRead->pStream;
+        if (!pRead->mSize)
+        {
+            ++syncCount;
+            continue;
+        }
+        if (fs->pIO != &gUnixSystemFileIO)
+        {
+            unixFsReadStreamAt(pRead);
+            if (pRead->mError || pRead->mBytesRead != pRead->mSize)
+                ++batch->syncFailedCount;
+            ++syncCount;
+            continue;
+        }
+
+        USD(stream, fs);
+        // Make buffered writes visible to positional reads
+        if (stream->buffer && stream->buffer->dirty)
+            unixFsSyncBuffer(stream);
+
+        UnixAsyncRead* read = &batch->pReads[batch->readCount++];
+        read->pRead = pRead;
+        read->pBatch = batch;
+        read->descriptor = stream->descriptor;
+    }
+    tfrg_atomic32_store_release(&batch->completed, syncCount);
+
+    acquireMutex(&gAsyncReadMutex);
+    unixFsCreateAsyncReadBackend();
+#if defined(UNIX_FS_IO_URING)
+    if (gIoRing.descriptor >= 0)
+    {
+        if (batch->readCount)
+        {
+            if (pIoRingPendingTail)
+                pIoRingPendingTail->pNextPending = batch;
+            else
+                pIoRingPendingHead = batch;
+            pIoRingPendingTail = batch;
+            unixIoRingPump();
+        }
+        releaseMutex(&gAsyncReadMutex);
+        *ppOutBatch = batch;
+        return true;
+    }
+#endif
+    releaseMutex(&gAsyncReadMutex);
+
+    if (gAsyncReadThreads)
+    {
+        threadSystemAddTasks(gAsyncReadThreads, unixFsAsyncReadTask, batch->readCount, sizeof(UnixAsyncRead), batch->pReads);
+    }
+    else
+    {
+        for (uint32_t i = 0; i < batch->readCount; ++i)
+            unixFsAsyncReadTask(&batch->pReads[i], UINT64_MAX);
+    }
+
+    *ppOutBatch = batch;
+    return true;
+}
+
+uint32_t fsPollAsyncReads(FileAsyncReadBatch* pBatch)
+{
+    ASSERT(pBatch);
+#if defined(UNIX_FS_IO_URING)
+    if (gIoRing.descriptor >= 0 && tfrg_atomic32_load_acquire(&pBatch->completed) < pBatch->count)
+    {
+        acquireMutex(&gAsyncReadMutex);
+        unixIoRingPump();
+        releaseMutex(&gAsyncReadMutex);
+    }
+#endif
+    return tfrg_atomic32_load_acquire(&pBatch->completed);
+}
+
+bool fsWaitAsyncReads(FileAsyncReadBatch* pBatch)
+{
+    ASSERT(pBatch);
+    acquireMutex(&gAsyncReadMutex);
+    while (tfrg_atomic32_load_acquire(&pBatch->completed) < pBatch->count)
+    {
+#if defined(UNIX_FS_IO_URING)
+        if (gIoRing.descriptor >= 0)
+        {
+            unixIoRingPump();
+            if (tfrg_atomic32_load_acquire(&pBatch->completed) < pBatch->count)
+                unixIoRingWait();
+            continue;
+        }
+#endif
+        waitConditionVariable(&gAsyncReadCompleted, &gAsyncReadMutex, TIMEOUT_INFINITE);
+    }
+    releaseMutex(&gAsyncReadMutex);
+
+    bool success = !pBatch->syncFailedCount;
+    for (uint32_t i = 0; i < pBatch->readCount; ++i)
+    {
+        const FileAsyncRead* pRead = pBatch->pReads[i].pRead;
+        success = success && !pRead->mError && pRead->mBytesRead == pRead->mSize;
+    }
+
+    tf_free(pBatch);
+    return success;
+}
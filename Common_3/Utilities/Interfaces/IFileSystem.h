@@ -26,6 +26,7 @@
 #include "../../Application/Config.h"
 
 #include "../../OS/Interfaces/IOperatingSystem.h"
+#include "../Threading/ThreadSystem.h"
 
 // IOS Simulator paths can get a bit longer then 256 bytes
 #ifdef TARGET_IOS_SIMULATOR
@@ -115,6 +116,10 @@ extern "C"
         //       On other platforms read access is always available.
         FM_ALLOW_READ = 1 << 4,
 
+        // Disable user-space buffering of system file streams,
+        // every read and write goes straight to the OS.
+        FM_UNBUFFERED = 1 << 5,
+
         // RW mode
         FM_READ_WRITE = FM_READ | FM_WRITE,
 
@@ -222,6 +227,11 @@ extern "C"
         // getSystemHandle
         void* (*GetSystemHandle)(FileStream* fs);
 
+        // Reads from absolute offset without using seek position of the stream.
+        // Can be called from several threads at once, as long as the stream isn't written.
+        // Optional, use fsReadFromStreamAt to fall back to Seek+Read.
+        size_t (*ReadAt)(FileStream* pFile, void* outputBuffer, size_t bufferSizeInBytes, uint64_t offset);
+
         void* pUser;
     };
 
@@ -266,13 +276,16 @@ extern "C"
         // It allows to read several files from archive asynchronously.
         // Not used for fsArchiveOpenFromMemory
         //
+        // Not needed if archive stream supports IFileSystem::ReadAt (system file streams do),
+        // archive reads are positional and lock-free in that case.
+        //
         // Allows: (if this flag is set)
-        // Thread1: reads file "A"
-        // Thread2: reads file "B"
+        // Thread1: reads file "A" using stream 1
+        // Thread2: reads file "A" or "B" using stream 2
         //
         // Does not allow: (do not do this)
-        // Thread1: reads file "A"
-        // Thread2: reads file "A"
+        // Thread1: reads file "A" using stream 1
+        // Thread2: reads file "A" using stream 1
         bool protectStreamCriticalSection;
 
         // Do not log errors if archive header is wrong
@@ -282,6 +295,33 @@ extern "C"
 
         // Try to memory map stream using fsStreamMemoryMap
         bool mmap;
+
+        // Thread system used to decompress big reads of LZ4/ZSTD block files in parallel.
+        // Whole blocks are decompressed directly into the read destination,
+        // calling thread takes part in decompression too.
+        // NULL disables parallel decompression.
+        // Owned by user, must be valid until fsArchiveClose.
+        ThreadSystem decompressionThreads;
+
+        // Minimal number of whole blocks covered by a read to decompress it in parallel.
+        // 0 means default value BUNYAR_PARALLEL_READ_MIN_BLOCKS
+        uint32_t parallelReadMinBlocks;
+
+        // Number of blocks decompressed ahead of a stream that is read sequentially, 0 disables read-ahead.
+        // Blocks are decompressed by 'decompressionThreads', read-ahead is disabled without it.
+        // Limited to 64 blocks, each stream uses up to (2 * readAheadBlocks * blockSize) of memory.
+        uint32_t readAheadBlocks;
+
+        // Budget in bytes for archive-wide cache of decompressed blocks. 0 disables the cache.
+        // Cache is shared by all streams of the archive, so re-opened files and
+        // interleaved reads of several files don't decompress the same blocks again.
+        // Reads decompressed in parallel bypass the cache.
+        uint64_t blockCacheSize;
+
+        // Record the order in which nodes are read for the first time.
+        // Trace is retrieved with fsArchiveGetAccessTrace/fsArchiveSaveAccessTrace
+        // and used to repack archive, so files are laid out in the order they are loaded.
+        bool recordAccessTrace;
     };
 
     /// 'desc' can be NULL
@@ -309,6 +349,75 @@ extern "C"
 
     FORGE_API bool fsArchiveClose(IFileSystem* pArchive);
 
+    /************************************************************************/
+    // MARK: - IO statistics
+    /************************************************************************/
+
+// Bucket 0 counts reads faster than 1us, bucket i counts reads in [2^(i-1), 2^i) us,
+// last bucket counts everything slower.
+#define FS_IO_LATENCY_BUCKET_COUNT 20
+
+    /// Counters are cumulative since start, take differences of two snapshots to measure an interval.
+    /// Requires ENABLE_FS_IO_STATS, getters return false without it.
+    struct FsIoStats
+    {
+        uint64_t openCount;
+        uint64_t readCount;
+        uint64_t bytesRead;
+        // Wall time spent in Read/ReadAt calls
+        uint64_t readTimeUsec;
+        uint64_t readLatencyHistogram[FS_IO_LATENCY_BUCKET_COUNT];
+
+        // Archives only
+        uint64_t decompressedBytes;
+        // Sum over all threads, can exceed readTimeUsec with parallel decompression
+        uint64_t decompressionTimeUsec;
+        uint64_t blockCacheHits;
+        uint64_t blockCacheMisses;
+    };
+
+    /// Streams opened by the system file IO through 'rd'.
+    /// Reads of archives mounted to 'rd' are reported by fsArchiveGetIoStats.
+    FORGE_API bool fsGetIoStats(ResourceDirectory rd, struct FsIoStats* outStats);
+
+    /// All streams of the archive.
+    FORGE_API bool fsArchiveGetIoStats(IFileSystem* pArchive, struct FsIoStats* outStats);
+
+    /// All memory streams, see fsOpenStreamFromMemory.
+    FORGE_API bool fsGetMemoryStreamIoStats(struct FsIoStats* outStats);
+
+    /************************************************************************/
+    // MARK: - Overlay file system
+    /************************************************************************/
+
+    /// One layer of an overlay, either an archive or a directory.
+    struct OverlayLayerDesc
+    {
+        // Opened archive, see fsArchiveOpen. NULL for directory layer.
+        // Owned by user, must be valid until fsOverlayClose.
+        IFileSystem* pArchive;
+
+        // Directory layer, files are opened with fsOpenStreamFromPath(rd, directory/name).
+        // Runtime file system can't list directories, so files of the layer are given explicitly,
+        // e.g. from a manifest shipped with a patch. Names are copied.
+        ResourceDirectory  rd;
+        const char*        directory;
+        uint64_t           fileCount;
+        const char* const* fileNames;
+    };
+
+    /// Mounts layers as one read-only file system.
+    /// Index of all file names is built once, so Open/GetFileUid/OpenByUid do a single lookup
+    /// instead of probing every layer. If several layers contain a file, the last one wins.
+    /// Streams are opened by the layer file system, FileStream::pIO is the archive or directory IO.
+    /// Bind to a resource directory with fsSetPathForResourceDir(overlay, rd, "").
+    FORGE_API bool fsOverlayOpen(uint32_t layerCount, const struct OverlayLayerDesc* layers, IFileSystem* out);
+
+    FORGE_API bool fsOverlayClose(IFileSystem* pOverlay);
+
+    /// Returns index of the layer which provides file, 'uid' is from GetFileUid
+    FORGE_API bool fsOverlayGetFileLayer(IFileSystem* pOverlay, uint64_t uid, uint32_t* outLayer);
+
     /************************************************************************/
     // MARK: - File IO
     /************************************************************************/
@@ -362,6 +471,11 @@ extern "C"
         return fs->pIO->Read(fs, pOutputBuffer, bufferSizeInBytes);
     }
 
+    /// Reads at most `bufferSizeInBytes` bytes starting at `offset`, seek position is not used.
+    /// Thread-safe for streams with IFileSystem::ReadAt, other streams are read with Seek+Read
+    /// restoring the seek position.
+    FORGE_API size_t fsReadFromStreamAt(FileStream* fs, void* pOutputBuffer, size_t bufferSizeInBytes, uint64_t offset);
+
     /// Reads at most `bufferSizeInBytes` bytes from sourceBuffer and writes them into the file.
     /// Returns the number of bytes written.
     static inline size_t fsWriteToStream(FileStream* fs, const void* pSourceBuffer, size_t byteCount)
@@ -415,6 +529,43 @@ extern "C"
         return fs->pIO->MemoryMap(fs, outSize, outData);
     }
 
+    /************************************************************************/
+    // MARK: - Asynchronous reads
+    /************************************************************************/
+
+    typedef struct FileAsyncRead
+    {
+        // Streams opened with fsOpenStreamFromPath are read asynchronously.
+        // Other streams (memory, archive, bundled) are read synchronously during fsReadAsync.
+        FileStream* pStream;
+        void*       pDst;
+        uint64_t    mOffset;
+        uint64_t    mSize;
+
+        // Output, valid after completion.
+        // mBytesRead is less than mSize if end of file is reached or read failed.
+        uint64_t mBytesRead;
+        // 0 on success, errno value otherwise
+        int32_t  mError;
+    } FileAsyncRead;
+
+    typedef struct FileAsyncReadBatch FileAsyncReadBatch;
+
+    /// Submits 'count' reads at once. Linux uses io_uring when kernel allows it,
+    /// other platforms (and Linux fallback) use positional reads on worker threads.
+    ///
+    /// Reads don't use or change stream seek positions, several reads of the same stream are allowed.
+    /// 'pReads' and destination buffers must be valid until fsWaitAsyncReads returns.
+    /// Streams must not be closed or written to until then.
+    FORGE_API bool fsReadAsync(uint32_t count, FileAsyncRead* pReads, FileAsyncReadBatch** ppOutBatch);
+
+    /// Returns number of completed reads in batch. Doesn't block.
+    FORGE_API uint32_t fsPollAsyncReads(FileAsyncReadBatch* pBatch);
+
+    /// Blocks until all reads in batch are completed, then releases the batch.
+    /// Returns false if any read failed or was short.
+    FORGE_API bool fsWaitAsyncReads(FileAsyncReadBatch* pBatch);
+
     /************************************************************************/
     // MARK: - Directory queries
     /************************************************************************/
@@ -436,6 +587,7 @@ extern "C"
     //    archive nodes (file entries)
     //    block of utf8 strings, referenced by nodes
     //    precomputed hash table (optional)
+    //    zstd dictionaries shared by small files (optional)
     //
     // Archive node contains file location within archive and other details
     //
@@ -454,6 +606,21 @@ extern "C"
         BUNYAR_FILE_FORMAT_ZSTD_BLOCKS = 5,
     };
 
+// BunyArNode::format keeps BunyArFileFormat in the low 32 bits.
+// For BUNYAR_FILE_FORMAT_ZSTD_BLOCKS the high 32 bits hold index + 1
+// of the dictionary all blocks of the file are compressed with, 0 if none.
+#define BUNYAR_NODE_FORMAT(format)                     ((enum BunyArFileFormat)((format) & 0xFFFFFFFFu))
+#define BUNYAR_NODE_DICTIONARY(format)                 ((uint32_t)((uint64_t)(format) >> 32))
+#define BUNYAR_NODE_FORMAT_MAKE(fileFormat, dictionary) ((uint64_t)(fileFormat) | ((uint64_t)(dictionary) << 32))
+
+    enum BunyArHeaderFlags
+    {
+        // BunyArHeader::dictionariesPointer is valid
+        BUNYAR_HEADER_FLAG_DICTIONARIES = 1 << 0,
+        // BunyArHeader::contentHashesPointer is valid
+        BUNYAR_HEADER_FLAG_CONTENT_HASHES = 1 << 1,
+    };
+
     static const uint8_t BUNYAR_MAGIC[16] = {
         'B', 'u', 'n', 'y', 'A', 'r', 'c', 'h', // BunyArch
         'T', 'h', 'e', 'F', 'o', 'r', 'g', 'e', // TheForge
@@ -494,7 +661,7 @@ extern "C"
 
         struct BunyArVersion version;
 
-        // 0, reserved
+        // BunyArHeaderFlags
         uint64_t flags;
 
         // nodeCount = nodesPointer.size / sizeof(BunyArNode)
@@ -508,9 +675,37 @@ extern "C"
         // Hash table present, if size >= sizeof(BunyArHashTable)
         struct BunyArPointer64 hashTablePointer;
 
+        // Fields below are optional. Nodes follow the header, so nodesPointer.offset is the stored header size,
+        // fields beyond it are absent and read as zero. Each field is valid only if the corresponding flag is set,
+        // see bunyArHeaderRequiredSize.
+
+        // BUNYAR_HEADER_FLAG_DICTIONARIES
+        // Table of BunyArPointer64, each points to raw content zstd dictionary.
+        // dictionaryCount = dictionariesPointer.size / sizeof(BunyArPointer64)
+        struct BunyArPointer64 dictionariesPointer;
+
+        // BUNYAR_HEADER_FLAG_CONTENT_HASHES
+        // Table of uint64_t XXH64 hashes (seed 0) of original file content, one per node.
+        // Used to update archives without compressing unchanged files again.
+        struct BunyArPointer64 contentHashesPointer;
+
         // header can be extended in the future by new variables or pointers
     };
 
+// Size of BunyArHeader written by archives without flags
+#define BUNYAR_HEADER_BASE_SIZE offsetof(struct BunyArHeader, dictionariesPointer)
+
+    // Smallest stored header size which contains the fields of all flags set,
+    // archives whose nodesPointer.offset is smaller are invalid
+    static inline uint64_t bunyArHeaderRequiredSize(uint64_t flags)
+    {
+        if (flags & BUNYAR_HEADER_FLAG_CONTENT_HASHES)
+            return offsetof(struct BunyArHeader, contentHashesPointer) + sizeof(struct BunyArPointer64);
+        if (flags & BUNYAR_HEADER_FLAG_DICTIONARIES)
+            return offsetof(struct BunyArHeader, dictionariesPointer) + sizeof(struct BunyArPointer64);
+        return BUNYAR_HEADER_BASE_SIZE;
+    }
+
     struct BunyArNode
     {
         // BunyArFileFormat
@@ -614,6 +809,7 @@ extern "C"
     {
         uint64_t                      nodeCount;
         const struct BunyArHashTable* hashTable;
+        uint64_t                      dictionaryCount;
     };
 
     struct BunyArNodeDescription
@@ -622,6 +818,19 @@ extern "C"
         uint64_t              fileSize;
         uint64_t              compressedSize;
         enum BunyArFileFormat format;
+        // index + 1 of zstd dictionary, 0 if none
+        uint32_t              dictionary;
+    };
+
+    struct BunyArBlockCacheStats
+    {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        // bytes of decompressed data currently in cache
+        uint64_t usedSize;
+        // ArchiveOpenDesc::blockCacheSize
+        uint64_t budget;
     };
 
     FORGE_API const char* bunyArFormatName(enum BunyArFileFormat format);
@@ -630,6 +839,17 @@ extern "C"
 
     FORGE_API bool fsArchiveGetNodeDescription(IFileSystem* pArchive, uint64_t nodeId, struct BunyArNodeDescription* outInfo);
 
+    // Returns false if block cache is disabled
+    FORGE_API bool fsArchiveGetBlockCacheStats(IFileSystem* pArchive, struct BunyArBlockCacheStats* outStats);
+
+    // Requires ArchiveOpenDesc::recordAccessTrace.
+    // Returns number of traced nodes, writes up to 'capacity' node ids in the order of their first read.
+    FORGE_API uint64_t fsArchiveGetAccessTrace(IFileSystem* pArchive, uint64_t* outNodeIds, uint64_t capacity);
+
+    // Writes names of traced nodes to a text file, one name per line.
+    // File is accepted by "buny repack --trace".
+    FORGE_API bool fsArchiveSaveAccessTrace(IFileSystem* pArchive, ResourceDirectory rd, const char* fileName);
+
     // Same as GetFileUid(), but without fileName postprocessing.
     // Uses fileName directly without resolving through ResourceDirectory
     // to search for file node.
@@ -0,0 +1,675 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "Quantization.h"
+
+#include <math.h>
+#include <string.h>
+
+#if defined(ARCH_X86_FAMILY)
+#define QUANTIZE_SSE2
+#define QUANTIZE_F16C
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define QUANTIZE_TARGET_F16C
+#else
+#include <cpuid.h>
+#define QUANTIZE_TARGET_F16C __attribute__((target("f16c")))
+#endif
+#elif defined(ARCH_ARM64)
+#define QUANTIZE_NEON
+#include <arm_neon.h>
+#endif
+
+#include "../../Utilities/Interfaces/ILog.h"
+
+#include "../../Utilities/Interfaces/IMemory.h"
+
+typedef union QuantizeFloatBits
+{
+    float    f;
+    uint32_t u;
+} QuantizeFloatBits;
+
+/************************************************************************/
+// Scalar
+/************************************************************************/
+
+// Round to nearest even, keeps denormals, NaN maps to a quiet NaN
+uint16_t quantizeFloatToHalfScalar(float value)
+{
+    const uint32_t    f32Infinity = 255u << 23;
+    const uint32_t    f16Max = (127u + 16u) << 23;
+    QuantizeFloatBits denormMagic = { 0 };
+    denormMagic.u = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+
+    QuantizeFloatBits bits;
+    bits.f = value;
+    const uint32_t sign = bits.u & 0x80000000u;
+    bits.u ^= sign;
+
+    uint16_t result;
+    if (bits.u >= f16Max)
+    {
+        // Infinity or NaN
+        result = bits.u > f32Infinity ? 0x7E00 : 0x7C00;
+    }
+    else if (bits.u < (113u << 23))
+    {
+        // Resulting half is a denormal or zero, let the FPU do the rounding
+        bits.f += denormMagic.f;
+        result = (uint16_t)(bits.u - denormMagic.u);
+    }
+    else
+    {
+        const uint32_t mantissaOdd = (bits.u >> 13) & 1u;
+        // Rebias exponent and round
+        bits.u += ((uint32_t)(15 - 127) << 23) + 0xFFFu;
+        bits.u += mantissaOdd;
+        result = (uint16_t)(bits.u >> 13);
+    }
+
+    return (uint16_t)(result | (sign >> 16));
+}
+
+float quantizeHalfToFloatScalar(uint16_t value)
+{
+    const uint32_t    shiftedExp = 0x7C00u << 13;
+    QuantizeFloatBits magic = { 0 };
+    magic.u = 113u << 23;
+
+    QuantizeFloatBits result;
+    result.u = (uint32_t)(value & 0x7FFFu) << 13;
+    const uint32_t exp = shiftedExp & result.u;
+    result.u += (uint32_t)(127 - 15) << 23;
+
+    if (exp == shiftedExp)
+    {
+        // Infinity or NaN, NaNs come out quiet like with the hardware conversion
+        result.u += (uint32_t)(128 - 16) << 23;
+        if (value & 0x03FFu)
+        {
+            result.u |= 0x00400000u;
+        }
+    }
+    else if (exp == 0)
+    {
+        // Zero or denormal
+        result.u += 1u << 23;
+        result.f -= magic.f;
+    }
+
+    result.u |= (uint32_t)(value & 0x8000u) << 16;
+    return result.f;
+}
+
+// Clamp written with compares so NaN ends up at 'lo' on every path
+static inline float clampScalar(float v, float lo, float hi)
+{
+    v = v >= lo ? v : lo;
+    return hi >= v ? v : hi;
+}
+
+// Round half away from zero, same as the SIMD version below. Only valid for |v| < 2^31
+static inline float roundScalar(float v)
+{
+    const float a = v >= 0.0f ? v : -v;
+    const float t = (float)(int32_t)a;
+    const float r = t + (a - t >= 0.5f ? 1.0f : 0.0f);
+    return v >= 0.0f ? r : -r;
+}
+
+static inline float octWrapScalar(float v, float w) { return (1.0f - (w >= 0.0f ? w : -w)) * (v >= 0.0f ? 1.0f : -1.0f); }
+
+static inline uint32_t encodeOctScalar(const float* pDir)
+{
+    const float x = pDir[0];
+    const float y = pDir[1];
+    const float z = pDir[2];
+    const float absLength = (x >= 0.0f ? x : -x) + (y >= 0.0f ? y : -y) + (z >= 0.0f ? z : -z);
+    if (absLength == 0.0f)
+    {
+        return 0;
+    }
+
+    float ex = x / absLength;
+    float ey = y / absLength;
+    if (z / absLength < 0.0f)
+    {
+        const float oldX = ex;
+        ex = octWrapScalar(ex, ey);
+        ey = octWrapScalar(ey, oldX);
+    }
+    ex = ex * 0.5f + 0.5f;
+    ey = ey * 0.5f + 0.5f;
+
+    const uint32_t ux = (uint32_t)roundScalar(clampScalar(ex, 0.0f, 1.0f) * 65535.0f);
+    const uint32_t uy = (uint32_t)roundScalar(clampScalar(ey, 0.0f, 1.0f) * 65535.0f);
+    return (ux & 0xFFFFu) | (uy << 16);
+}
+
+static inline void decodeOctScalar(uint32_t packed, float* pDir)
+{
+    float ex = (float)(packed & 0xFFFFu) / 65535.0f * 2.0f - 1.0f;
+    float ey = (float)(packed >> 16) / 65535.0f * 2.0f - 1.0f;
+    const float z = 1.0f - (ex >= 0.0f ? ex : -ex) - (ey >= 0.0f ? ey : -ey);
+    if (z < 0.0f)
+    {
+        const float oldX = ex;
+        ex = octWrapScalar(ex, ey);
+        ey = octWrapScalar(ey, oldX);
+    }
+    const float length = sqrtf(ex * ex + ey * ey + z * z);
+    pDir[0] = ex / length;
+    pDir[1] = ey / length;
+    pDir[2] = z / length;
+}
+
+/************************************************************************/
+// 4-wide vector helpers shared by SSE2 and NEON paths
+/************************************************************************/
+#if defined(QUANTIZE_SSE2)
+typedef __m128  QVec;
+typedef __m128i QVecI;
+#define QV_LOAD(p)              _mm_loadu_ps(p)
+#define QV_STORE(p, v)          _mm_storeu_ps(p, v)
+#define QV_STOREI(p, v)         _mm_storeu_si128((__m128i*)(p), v)
+#define QV_SET1(f)              _mm_set1_ps(f)
+#define QV_SET(x, y, z, w)      _mm_setr_ps(x, y, z, w)
+#define QV_ADD(a, b)            _mm_add_ps(a, b)
+#define QV_SUB(a, b)            _mm_sub_ps(a, b)
+#define QV_MUL(a, b)            _mm_mul_ps(a, b)
+#define QV_DIV(a, b)            _mm_div_ps(a, b)
+#define QV_SQRT(a)              _mm_sqrt_ps(a)
+#define QV_ABS(a)               _mm_and_ps(a, _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF)))
+#define QV_TRUNC_TO_INT(a)      _mm_cvttps_epi32(a)
+#define QV_INT_TO_FLOAT(a)      _mm_cvtepi32_ps(a)
+// a >= b ? x : y
+#define QV_SELECT_GE(a, b, x, y) qvSelect(_mm_cmpge_ps(a, b), x, y)
+static inline QVec qvSelect(QVec mask, QVec x, QVec y) { return _mm_or_ps(_mm_and_ps(mask, x), _mm_andnot_ps(mask, y)); }
+#define QUANTIZE_SIMD
+#elif defined(QUANTIZE_NEON)
+typedef float32x4_t QVec;
+typedef int32x4_t   QVecI;
+#define QV_LOAD(p)               vld1q_f32(p)
+#define QV_STORE(p, v)           vst1q_f32(p, v)
+#define QV_STOREI(p, v)          vst1q_s32(p, v)
+#define QV_SET1(f)               vdupq_n_f32(f)
+#define QV_SET(x, y, z, w)       qvSet(x, y, z, w)
+#define QV_ADD(a, b)             vaddq_f32(a, b)
+#define QV_SUB(a, b)             vsubq_f32(a, b)
+#define QV_MUL(a, b)             vmulq_f32(a, b)
+#define QV_DIV(a, b)             vdivq_f32(a, b)
+#define QV_SQRT(a)               vsqrtq_f32(a)
+#define QV_ABS(a)                vabsq_f32(a)
+#define QV_TRUNC_TO_INT(a)       vcvtq_s32_f32(a)
+#define QV_INT_TO_FLOAT(a)       vcvtq_f32_s32(a)
+#define QV_SELECT_GE(a, b, x, y) vbslq_f32(vcgeq_f32(a, b), x, y)
+static inline QVec qvSet(float x, float y, float z, float w)
+{
+    const float values[4] = { x, y, z, w };
+    return vld1q_f32(values);
+}
+#define QUANTIZE_SIMD
+#endif
+
+#if defined(QUANTIZE_SIMD)
+static inline QVec qvClamp(QVec v, QVec lo, QVec hi)
+{
+    v = QV_SELECT_GE(v, lo, v, lo);
+    return QV_SELECT_GE(hi, v, v, hi);
+}
+
+static inline QVec qvRound(QVec v)
+{
+    const QVec zero = QV_SET1(0.0f);
+    const QVec a = QV_ABS(v);
+    const QVec t = QV_INT_TO_FLOAT(QV_TRUNC_TO_INT(a));
+    const QVec r = QV_ADD(t, QV_SELECT_GE(QV_SUB(a, t), QV_SET1(0.5f), QV_SET1(1.0f), zero));
+    return QV_SELECT_GE(v, zero, r, QV_SUB(zero, r));
+}
+
+static inline QVec qvOctWrap(QVec v, QVec w)
+{
+    const QVec one = QV_SET1(1.0f);
+    return QV_MUL(QV_SUB(one, QV_ABS(w)), QV_SELECT_GE(v, QV_SET1(0.0f), one, QV_SET1(-1.0f)));
+}
+
+// Clamps, scales and rounds 4 floats to int32
+static inline void qvQuantize4(const float* pSrc, float lo, float scale, int32_t* pOut)
+{
+    const QVec v = qvClamp(QV_LOAD(pSrc), QV_SET1(lo), QV_SET1(1.0f));
+    QV_STOREI(pOut, QV_TRUNC_TO_INT(qvRound(QV_MUL(v, QV_SET1(scale)))));
+}
+#endif
+
+/************************************************************************/
+// Float16
+/************************************************************************/
+#if defined(QUANTIZE_F16C)
+static bool cpuSupportsF16C(void)
+{
+    uint32_t ecx = 0;
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4] = { 0 };
+    __cpuid(info, 1);
+    ecx = (uint32_t)info[2];
+#else
+    uint32_t eax = 0, ebx = 0, edx = 0;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    {
+        return false;
+    }
+#endif
+    const uint32_t osxsave = 1u << 27;
+    const uint32_t avx = 1u << 28;
+    const uint32_t f16c = 1u << 29;
+    if ((ecx & (osxsave | avx | f16c)) != (osxsave | avx | f16c))
+    {
+        return false;
+    }
+
+    // F16C instructions are VEX encoded, OS needs to save YMM state
+#if defined(_MSC_VER) && !defined(__clang__)
+    const uint64_t xcr0 = _xgetbv(0);
+#else
+    uint32_t xcr0Lo = 0, xcr0Hi = 0;
+    __asm__ __volatile__("xgetbv" : "=a"(xcr0Lo), "=d"(xcr0Hi) : "c"(0));
+    const uint64_t xcr0 = ((uint64_t)xcr0Hi << 32) | xcr0Lo;
+#endif
+    return (xcr0 & 0x6) == 0x6;
+}
+
+static bool hasF16C(void)
+{
+    // Racing threads all compute the same answer
+    static volatile int32_t gF16CSupport = -1;
+    if (gF16CSupport < 0)
+    {
+        gF16CSupport = cpuSupportsF16C() ? 1 : 0;
+    }
+    return gF16CSupport == 1;
+}
+
+QUANTIZE_TARGET_F16C static size_t floatToHalfF16C(const float* pSrc, uint16_t* pDst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        const __m128  v = _mm_loadu_ps(pSrc + i);
+        const __m128i h = _mm_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT);
+        // Hardware keeps NaN payloads, scalar path returns the canonical quiet NaN
+        const __m128i nanMask = _mm_packs_epi32(_mm_castps_si128(_mm_cmpunord_ps(v, v)), _mm_setzero_si128());
+        const __m128i nan = _mm_or_si128(_mm_and_si128(h, _mm_set1_epi16((short)0x8000)), _mm_set1_epi16(0x7E00));
+        _mm_storel_epi64((__m128i*)(pDst + i), _mm_or_si128(_mm_andnot_si128(nanMask, h), _mm_and_si128(nanMask, nan)));
+    }
+    return i;
+}
+
+QUANTIZE_TARGET_F16C static size_t halfToFloatF16C(const uint16_t* pSrc, float* pDst, size_t count)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        _mm_storeu_ps(pDst + i, _mm_cvtph_ps(_mm_loadl_epi64((const __m128i*)(pSrc + i))));
+    }
+    return i;
+}
+#endif
+
+void quantizeFloatToHalf(const float* pSrc, uint16_t* pDst, size_t count)
+{
+    size_t i = 0;
+#if defined(QUANTIZE_F16C)
+    if (hasF16C())
+    {
+        i = floatToHalfF16C(pSrc, pDst, count);
+    }
+#elif defined(QUANTIZE_NEON)
+    for (; i + 4 <= count; i += 4)
+    {
+        const float32x4_t v = vld1q_f32(pSrc + i);
+        const uint16x4_t  h = vreinterpret_u16_f16(vcvt_f16_f32(v));
+        // Same NaN canonicalization as the scalar path
+        const uint16x4_t  nanMask = vmovn_u32(vmvnq_u32(vceqq_f32(v, v)));
+        const uint16x4_t  nan = vorr_u16(vand_u16(h, vdup_n_u16(0x8000)), vdup_n_u16(0x7E00));
+        vst1_u16(pDst + i, vbsl_u16(nanMask, nan, h));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        pDst[i] = quantizeFloatToHalfScalar(pSrc[i]);
+    }
+}
+
+void quantizeHalfToFloat(const uint16_t* pSrc, float* pDst, size_t count)
+{
+    size_t i = 0;
+#if defined(QUANTIZE_F16C)
+    if (hasF16C())
+    {
+        i = halfToFloatF16C(pSrc, pDst, count);
+    }
+#elif defined(QUANTIZE_NEON)
+    for (; i + 4 <= count; i += 4)
+    {
+        vst1q_f32(pDst + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(pSrc + i))));
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        pDst[i] = quantizeHalfToFloatScalar(pSrc[i]);
+    }
+}
+
+/************************************************************************/
+// Normalized integers
+/************************************************************************/
+#if defined(QUANTIZE_SIMD)
+#define QUANTIZE_FLOAT_TO_NORM_SIMD(type, lo, scale)   \
+    for (; i + 4 <= count; i += 4)                     \
+    {                                                  \
+        int32_t q[4];                                  \
+        qvQuantize4(pSrc + i, lo, scale, q);           \
+        pDst[i + 0] = (type)q[0];                      \
+        pDst[i + 1] = (type)q[1];                      \
+        pDst[i + 2] = (type)q[2];                      \
+        pDst[i + 3] = (type)q[3];                      \
+    }
+#define QUANTIZE_NORM_TO_FLOAT_SIMD(lo, scale)                                                                   \
+    for (; i + 4 <= count; i += 4)                                                                               \
+    {                                                                                                            \
+        const QVec v = QV_SET((float)pSrc[i + 0], (float)pSrc[i + 1], (float)pSrc[i + 2], (float)pSrc[i + 3]);   \
+        const QVec r = QV_DIV(v, QV_SET1(scale));                                                                \
+        QV_STORE(pDst + i, QV_SELECT_GE(r, QV_SET1(lo), r, QV_SET1(lo)));                                        \
+    }
+#else
+#define QUANTIZE_FLOAT_TO_NORM_SIMD(type, lo, scale)
+#define QUANTIZE_NORM_TO_FLOAT_SIMD(lo, scale)
+#endif
+
+#define QUANTIZE_FLOAT_TO_NORM(type, lo, scale)                                 \
+    size_t i = 0;                                                               \
+    QUANTIZE_FLOAT_TO_NORM_SIMD(type, lo, scale)                                \
+    for (; i < count; ++i)                                                      \
+    {                                                                           \
+        pDst[i] = (type)(int32_t)roundScalar(clampScalar(pSrc[i], lo, 1.0f) * scale); \
+    }
+
+#define QUANTIZE_NORM_TO_FLOAT(lo, scale)                 \
+    size_t i = 0;                                         \
+    QUANTIZE_NORM_TO_FLOAT_SIMD(lo, scale)                \
+    for (; i < count; ++i)                                \
+    {                                                     \
+        const float r = (float)pSrc[i] / scale;           \
+        pDst[i] = r >= lo ? r : lo;                       \
+    }
+
+void quantizeFloatToUnorm8(const float* pSrc, uint8_t* pDst, size_t count) { QUANTIZE_FLOAT_TO_NORM(uint8_t, 0.0f, 255.0f) }
+void quantizeFloatToSnorm8(const float* pSrc, int8_t* pDst, size_t count) { QUANTIZE_FLOAT_TO_NORM(int8_t, -1.0f, 127.0f) }
+void quantizeFloatToUnorm16(const float* pSrc, uint16_t* pDst, size_t count) { QUANTIZE_FLOAT_TO_NORM(uint16_t, 0.0f, 65535.0f) }
+void quantizeFloatToSnorm16(const float* pSrc, int16_t* pDst, size_t count) { QUANTIZE_FLOAT_TO_NORM(int16_t, -1.0f, 32767.0f) }
+
+// Snorm decode clamps to -1 since both -MAX and -MAX - 1 map to -1
+void quantizeUnorm8ToFloat(const uint8_t* pSrc, float* pDst, size_t count) { QUANTIZE_NORM_TO_FLOAT(0.0f, 255.0f) }
+void quantizeSnorm8ToFloat(const int8_t* pSrc, float* pDst, size_t count) { QUANTIZE_NORM_TO_FLOAT(-1.0f, 127.0f) }
+void quantizeUnorm16ToFloat(const uint16_t* pSrc, float* pDst, size_t count) { QUANTIZE_NORM_TO_FLOAT(0.0f, 65535.0f) }
+void quantizeSnorm16ToFloat(const int16_t* pSrc, float* pDst, size_t count) { QUANTIZE_NORM_TO_FLOAT(-1.0f, 32767.0f) }
+
+/************************************************************************/
+// Octahedral directions
+/************************************************************************/
+void quantizeDirectionToOctUnorm16x2(const float* pSrc, uint32_t* pDst, size_t count)
+{
+    size_t i = 0;
+#if defined(QUANTIZE_SIMD)
+    const QVec zero = QV_SET1(0.0f);
+    const QVec half = QV_SET1(0.5f);
+    for (; i + 4 <= count; i += 4)
+    {
+        const float* d = pSrc + i * 3;
+        const QVec   x = QV_SET(d[0], d[3], d[6], d[9]);
+        const QVec   y = QV_SET(d[1], d[4], d[7], d[10]);
+        const QVec   z = QV_SET(d[2], d[5], d[8], d[11]);
+        const QVec   absLength = QV_ADD(QV_ADD(QV_ABS(x), QV_ABS(y)), QV_ABS(z));
+
+        QVec       ex = QV_DIV(x, absLength);
+        QVec       ey = QV_DIV(y, absLength);
+        const QVec ez = QV_DIV(z, absLength);
+        const QVec wx = qvOctWrap(ex, ey);
+        const QVec wy = qvOctWrap(ey, ex);
+        ex = QV_SELECT_GE(ez, zero, ex, wx);
+        ey = QV_SELECT_GE(ez, zero, ey, wy);
+        ex = QV_ADD(QV_MUL(ex, half), half);
+        ey = QV_ADD(QV_MUL(ey, half), half);
+
+        int32_t ux[4];
+        int32_t uy[4];
+        QV_STOREI(ux, QV_TRUNC_TO_INT(qvRound(QV_MUL(qvClamp(ex, zero, QV_SET1(1.0f)), QV_SET1(65535.0f)))));
+        QV_STOREI(uy, QV_TRUNC_TO_INT(qvRound(QV_MUL(qvClamp(ey, zero, QV_SET1(1.0f)), QV_SET1(65535.0f)))));
+
+        // Zero length produces NaN above, patch those up with the scalar rule
+        float lengths[4];
+        QV_STORE(lengths, absLength);
+        for (uint32_t l = 0; l < 4; ++l)
+        {
+            pDst[i + l] = lengths[l] == 0.0f ? 0 : (((uint32_t)ux[l] & 0xFFFFu) | ((uint32_t)uy[l] << 16));
+        }
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        pDst[i] = encodeOctScalar(pSrc + i * 3);
+    }
+}
+
+void quantizeOctUnorm16x2ToDirection(const uint32_t* pSrc, float* pDst, size_t count)
+{
+    size_t i = 0;
+#if defined(QUANTIZE_SIMD)
+    const QVec one = QV_SET1(1.0f);
+    const QVec two = QV_SET1(2.0f);
+    const QVec maxValue = QV_SET1(65535.0f);
+    for (; i + 4 <= count; i += 4)
+    {
+        const uint32_t* s = pSrc + i;
+        QVec ex = QV_SET((float)(s[0] & 0xFFFFu), (float)(s[1] & 0xFFFFu), (float)(s[2] & 0xFFFFu), (float)(s[3] & 0xFFFFu));
+        QVec ey = QV_SET((float)(s[0] >> 16), (float)(s[1] >> 16), (float)(s[2] >> 16), (float)(s[3] >> 16));
+        ex = QV_SUB(QV_MUL(QV_DIV(ex, maxValue), two), one);
+        ey = QV_SUB(QV_MUL(QV_DIV(ey, maxValue), two), one);
+
+        const QVec z = QV_SUB(QV_SUB(one, QV_ABS(ex)), QV_ABS(ey));
+        const QVec wx = qvOctWrap(ex, ey);
+        const QVec wy = qvOctWrap(ey, ex);
+        ex = QV_SELECT_GE(z, QV_SET1(0.0f), ex, wx);
+        ey = QV_SELECT_GE(z, QV_SET1(0.0f), ey, wy);
+
+        const QVec length = QV_SQRT(QV_ADD(QV_ADD(QV_MUL(ex, ex), QV_MUL(ey, ey)), QV_MUL(z, z)));
+        float      x[4], y[4], zz[4];
+        QV_STORE(x, QV_DIV(ex, length));
+        QV_STORE(y, QV_DIV(ey, length));
+        QV_STORE(zz, QV_DIV(z, length));
+        for (uint32_t l = 0; l < 4; ++l)
+        {
+            float* d = pDst + (i + l) * 3;
+            d[0] = x[l];
+            d[1] = y[l];
+            d[2] = zz[l];
+        }
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        decodeOctScalar(pSrc[i], pDst + i * 3);
+    }
+}
+
+/************************************************************************/
+// Strided streams
+/************************************************************************/
+typedef struct QuantizeOpInfo
+{
+    // Size of a single source / destination scalar
+    uint32_t mSrcSize;
+    uint32_t mDstSize;
+    // Scalars per element for octahedral ops, 0 means use componentCount
+    uint32_t mSrcComponents;
+    uint32_t mDstComponents;
+} QuantizeOpInfo;
+
+static const QuantizeOpInfo gQuantizeOpInfo[QUANTIZE_OP_COUNT] = {
+    { 4, 2, 0, 0 }, // QUANTIZE_FLOAT_TO_HALF
+    { 2, 4, 0, 0 }, // QUANTIZE_HALF_TO_FLOAT
+    { 4, 1, 0, 0 }, // QUANTIZE_FLOAT_TO_UNORM8
+    { 4, 1, 0, 0 }, // QUANTIZE_FLOAT_TO_SNORM8
+    { 4, 2, 0, 0 }, // QUANTIZE_FLOAT_TO_UNORM16
+    { 4, 2, 0, 0 }, // QUANTIZE_FLOAT_TO_SNORM16
+    { 1, 4, 0, 0 }, // QUANTIZE_UNORM8_TO_FLOAT
+    { 1, 4, 0, 0 }, // QUANTIZE_SNORM8_TO_FLOAT
+    { 2, 4, 0, 0 }, // QUANTIZE_UNORM16_TO_FLOAT
+    { 2, 4, 0, 0 }, // QUANTIZE_SNORM16_TO_FLOAT
+    { 1, 2, 0, 0 }, // QUANTIZE_UINT8_TO_UINT16
+    { 4, 4, 3, 1 }, // QUANTIZE_DIRECTION_TO_OCT_UNORM16X2
+    { 4, 4, 1, 3 }, // QUANTIZE_OCT_UNORM16X2_TO_DIRECTION
+};
+
+// 'count' is in elements for octahedral ops and in scalars otherwise
+static void quantizeContiguous(QuantizeOp op, const void* pSrc, void* pDst, size_t count)
+{
+    switch (op)
+    {
+    case QUANTIZE_FLOAT_TO_HALF:
+        quantizeFloatToHalf((const float*)pSrc, (uint16_t*)pDst, count);
+        break;
+    case QUANTIZE_HALF_TO_FLOAT:
+        quantizeHalfToFloat((const uint16_t*)pSrc, (float*)pDst, count);
+        break;
+    case QUANTIZE_FLOAT_TO_UNORM8:
+        quantizeFloatToUnorm8((const float*)pSrc, (uint8_t*)pDst, count);
+        break;
+    case QUANTIZE_FLOAT_TO_SNORM8:
+        quantizeFloatToSnorm8((const float*)pSrc, (int8_t*)pDst, count);
+        break;
+    case QUANTIZE_FLOAT_TO_UNORM16:
+        quantizeFloatToUnorm16((const float*)pSrc, (uint16_t*)pDst, count);
+        break;
+    case QUANTIZE_FLOAT_TO_SNORM16:
+        quantizeFloatToSnorm16((const float*)pSrc, (int16_t*)pDst, count);
+        break;
+    case QUANTIZE_UNORM8_TO_FLOAT:
+        quantizeUnorm8ToFloat((const uint8_t*)pSrc, (float*)pDst, count);
+        break;
+    case QUANTIZE_SNORM8_TO_FLOAT:
+        quantizeSnorm8ToFloat((const int8_t*)pSrc, (float*)pDst, count);
+        break;
+    case QUANTIZE_UNORM16_TO_FLOAT:
+        quantizeUnorm16ToFloat((const uint16_t*)pSrc, (float*)pDst, count);
+        break;
+    case QUANTIZE_SNORM16_TO_FLOAT:
+        quantizeSnorm16ToFloat((const int16_t*)pSrc, (float*)pDst, count);
+        break;
+    case QUANTIZE_UINT8_TO_UINT16:
+    {
+        const uint8_t* src = (const uint8_t*)pSrc;
+        uint16_t*      dst = (uint16_t*)pDst;
+        for (size_t i = 0; i < count; ++i)
+        {
+            dst[i] = src[i];
+        }
+        break;
+    }
+    case QUANTIZE_DIRECTION_TO_OCT_UNORM16X2:
+        quantizeDirectionToOctUnorm16x2((const float*)pSrc, (uint32_t*)pDst, count);
+        break;
+    case QUANTIZE_OCT_UNORM16X2_TO_DIRECTION:
+        quantizeOctUnorm16x2ToDirection((const uint32_t*)pSrc, (float*)pDst, count);
+        break;
+    default:
+        ASSERT(false && "Invalid QuantizeOp");
+        break;
+    }
+}
+
+void quantizeStream(QuantizeOp op, uint32_t count, uint32_t componentCount, const void* pSrc, uint32_t srcStride, void* pDst,
+                    uint32_t dstStride)
+{
+    ASSERT(op < QUANTIZE_OP_COUNT);
+    ASSERT(pSrc && pDst);
+
+    const QuantizeOpInfo* info = &gQuantizeOpInfo[op];
+    const bool            octahedral = info->mSrcComponents != 0;
+    const uint32_t        srcComponents = octahedral ? info->mSrcComponents : componentCount;
+    const uint32_t        dstComponents = octahedral ? info->mDstComponents : componentCount;
+    // Number of scalars passed to the contiguous functions per element
+    const uint32_t        unitsPerElement = octahedral ? 1 : componentCount;
+    const uint32_t        srcElementSize = info->mSrcSize * srcComponents;
+    const uint32_t        dstElementSize = info->mDstSize * dstComponents;
+    ASSERT(srcElementSize && dstElementSize);
+    ASSERT(srcStride >= srcElementSize && dstStride >= dstElementSize);
+
+    const bool srcPacked = srcStride == srcElementSize;
+    const bool dstPacked = dstStride == dstElementSize;
+    if (srcPacked && dstPacked)
+    {
+        quantizeContiguous(op, pSrc, pDst, (size_t)count * unitsPerElement);
+        return;
+    }
+
+    // Gather / scatter through stack buffers so the inner loops stay contiguous
+    uint8_t        srcChunk[2048];
+    uint8_t        dstChunk[2048];
+    const uint32_t largestElement = srcElementSize > dstElementSize ? srcElementSize : dstElementSize;
+    ASSERT(largestElement <= sizeof(srcChunk));
+    const uint32_t elementsPerChunk = (uint32_t)sizeof(srcChunk) / largestElement;
+
+    const uint8_t* src = (const uint8_t*)pSrc;
+    uint8_t*       dst = (uint8_t*)pDst;
+    for (uint32_t first = 0; first < count; first += elementsPerChunk)
+    {
+        const uint32_t chunkCount = count - first < elementsPerChunk ? count - first : elementsPerChunk;
+        const uint8_t* chunkSrc = src + (size_t)first * srcStride;
+        uint8_t*       chunkDst = dst + (size_t)first * dstStride;
+
+        const void* convertSrc = chunkSrc;
+        if (!srcPacked)
+        {
+            for (uint32_t e = 0; e < chunkCount; ++e)
+            {
+                memcpy(srcChunk + e * srcElementSize, chunkSrc + (size_t)e * srcStride, srcElementSize);
+            }
+            convertSrc = srcChunk;
+        }
+
+        quantizeContiguous(op, convertSrc, dstPacked ? (void*)chunkDst : (void*)dstChunk, (size_t)chunkCount * unitsPerElement);
+
+        if (!dstPacked)
+        {
+            for (uint32_t e = 0; e < chunkCount; ++e)
+            {
+                memcpy(chunkDst + (size_t)e * dstStride, dstChunk + e * dstElementSize, dstElementSize);
+            }
+        }
+    }
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2017-2024 The Forge Interactive Inc.
+ *
+ * This file is part of The-Forge
+ * (see https://github.com/ConfettiFX/The-Forge).
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+#pragma once
+#include "../../Application/Config.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif // __cplusplus
+
+    /*
+     * Bulk conversion and quantization of vertex data.
+     *
+     * All functions process whole arrays. Float16 conversions use F16C on x86 (detected at runtime) and NEON on ARM64,
+     * the other conversions use SSE2/NEON, with a scalar fallback everywhere else.
+     * Results of SIMD and scalar paths are bit-identical, so baked assets do not depend on the machine that produced them.
+     *
+     * Rounding rules:
+     *   float -> half      round to nearest even, denormals preserved, overflow goes to infinity
+     *                      NaN becomes the quiet NaN 0x7E00 with its sign, payload is dropped
+     *   float -> unorm     round(saturate(v) * MAX)
+     *   float -> snorm     round(clamp(v, -1, 1) * MAX), rounding half away from zero
+     *   direction -> oct   same encoding as packFloat3DirectionToHalf2 from ShaderUtilities.h
+     */
+
+    /*
+     * Contiguous arrays. 'count' is the number of scalars (or directions for octahedral functions).
+     */
+
+    FORGE_API void quantizeFloatToHalf(const float* pSrc, uint16_t* pDst, size_t count);
+    FORGE_API void quantizeHalfToFloat(const uint16_t* pSrc, float* pDst, size_t count);
+
+    FORGE_API void quantizeFloatToUnorm8(const float* pSrc, uint8_t* pDst, size_t count);
+    FORGE_API void quantizeFloatToSnorm8(const float* pSrc, int8_t* pDst, size_t count);
+    FORGE_API void quantizeFloatToUnorm16(const float* pSrc, uint16_t* pDst, size_t count);
+    FORGE_API void quantizeFloatToSnorm16(const float* pSrc, int16_t* pDst, size_t count);
+
+    FORGE_API void quantizeUnorm8ToFloat(const uint8_t* pSrc, float* pDst, size_t count);
+    FORGE_API void quantizeSnorm8ToFloat(const int8_t* pSrc, float* pDst, size_t count);
+    FORGE_API void quantizeUnorm16ToFloat(const uint16_t* pSrc, float* pDst, size_t count);
+    FORGE_API void quantizeSnorm16ToFloat(const int16_t* pSrc, float* pDst, size_t count);
+
+    // pSrc is an array of float3, each direction is packed to two unorm16 values (x in low bits).
+    // Directions don't need to be normalized. Zero vector is encoded as 0.
+    FORGE_API void quantizeDirectionToOctUnorm16x2(const float* pSrc, uint32_t* pDst, size_t count);
+    // Output directions are normalized.
+    FORGE_API void quantizeOctUnorm16x2ToDirection(const uint32_t* pSrc, float* pDst, size_t count);
+
+    /*
+     * Interleaved vertex streams.
+     *
+     * Each element is read from 'pSrc + i * srcStride' and written to 'pDst + i * dstStride'.
+     * 'componentCount' is the number of scalars per element (ignored for octahedral operations, which always map float3 to uint32).
+     * When both streams are tightly packed this is identical to calling the contiguous functions directly,
+     * otherwise elements are gathered into a small stack buffer, converted and scattered back.
+     */
+
+    typedef enum QuantizeOp
+    {
+        QUANTIZE_FLOAT_TO_HALF = 0,
+        QUANTIZE_HALF_TO_FLOAT,
+        QUANTIZE_FLOAT_TO_UNORM8,
+        QUANTIZE_FLOAT_TO_SNORM8,
+        QUANTIZE_FLOAT_TO_UNORM16,
+        QUANTIZE_FLOAT_TO_SNORM16,
+        QUANTIZE_UNORM8_TO_FLOAT,
+        QUANTIZE_SNORM8_TO_FLOAT,
+        QUANTIZE_UNORM16_TO_FLOAT,
+        QUANTIZE_SNORM16_TO_FLOAT,
+        // Plain integer widening, e.g. uint8 joint indices to uint16
+        QUANTIZE_UINT8_TO_UINT16,
+        QUANTIZE_DIRECTION_TO_OCT_UNORM16X2,
+        QUANTIZE_OCT_UNORM16X2_TO_DIRECTION,
+        QUANTIZE_OP_COUNT,
+    } QuantizeOp;
+
+    FORGE_API void quantizeStream(QuantizeOp op, uint32_t count, uint32_t componentCount, const void* pSrc, uint32_t srcStride, void* pDst,
+                                  uint32_t dstStride);
+
+    /*
+     * Scalar helpers, same results as the array functions.
+     */
+
+    FORGE_API uint16_t quantizeFloatToHalfScalar(float value);
+    FORGE_API float    quantizeHalfToFloatScalar(uint16_t value);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
@@ -38,6 +38,7 @@
 #include "../../../../Common_3/Resources/ResourceLoader/Interfaces/IResourceLoader.h"
 #include "../../../../Common_3/Utilities/Interfaces/IFileSystem.h"
 #include "../../../../Common_3/Utilities/Interfaces/ILog.h"
+#include "../../../../Common_3/Utilities/Interfaces/IThread.h"
 #include "../../../../Common_3/Utilities/Interfaces/ITime.h"
 
 #include "../../../../Common_3/Utilities/RingBuffer.h"
@@ -138,6 +139,7 @@ const char* pCubeTextureName[] = { "TheForge.tex" };
 const char* pTextFileName[] = { "TestDoc.txt" };
 
 const ResourceDirectory RD_ARCHIVE_TEST = RD_MIDDLEWARE_1;
+const ResourceDirectory RD_OVERLAY_TEST = RD_MIDDLEWARE_2;
 
 const char* pModelFileName[] = { "matBall.bin" };
 
@@ -157,6 +159,7 @@ Geometry*    pMesh;
 VertexLayout gVertexLayoutDefault = {};
 
 IFileSystem gArchiveFileSystem = { 0 };
+IFileSystem gOverlayFileSystem = { 0 };
 
 // numbers stored in a file they way each 8 byte value is an index (0,1,2,3,4,5,...).
 // This way we can easily test seek feature for various compression formats.
@@ -569,6 +572,145 @@ static bool runArchiveSeekTests()
     return testSuccess;
 }
 
+static bool readSmallPieces(const char* pFileName, FileMode mode, uint32_t readSize, uint32_t passes, uint64_t* pOutHash,
+                            int64_t* pOutTime)
+{
+    int64_t  startTime = getUSec(true);
+    uint64_t hash = 14695981039346656037ull;
+    for (uint32_t pass = 0; pass < passes; ++pass)
+    {
+        FileStream fs;
+        if (!fsOpenStreamFromPath(RD_DEBUG, pFileName, mode, &fs))
+            return false;
+
+        uint8_t data[64];
+        size_t  rs;
+        while ((rs = fsReadFromStream(&fs, data, readSize)) > 0)
+        {
+            for (size_t i = 0; i < rs; ++i)
+                hash = (hash ^ data[i]) * 1099511628211ull;
+        }
+        fsCloseStream(&fs);
+    }
+
+    *pOutTime = getUSec(true) - startTime;
+    *pOutHash = hash;
+    return true;
+}
+
+// Loaders often read headers field by field. This benchmark compares such reads through
+// a buffered system file stream and an FM_UNBUFFERED one, run under "strace -c" to count syscalls.
+static bool runSmallReadBenchmark()
+{
+    const char*    pFileName = "SmallReads.bin";
+    const uint64_t fileSize = 4 * 1024 * 1024;
+    const uint32_t readSize = 4;
+    const uint32_t passes = 4;
+
+    FileStream fs;
+    if (!fsOpenStreamFromPath(RD_DEBUG, pFileName, FM_WRITE, &fs))
+        return false;
+
+    bool     success = true;
+    uint32_t value = 0x9E3779B9u;
+    for (uint64_t i = 0; success && i < fileSize; i += sizeof(value))
+    {
+        value = value * 1664525u + 1013904223u;
+        success = fsWriteToStream(&fs, &value, sizeof(value)) == sizeof(value);
+    }
+    success = fsCloseStream(&fs) && success;
+
+    uint64_t bufferedHash = 0;
+    uint64_t unbufferedHash = 0;
+    int64_t  bufferedTime = 0;
+    int64_t  unbufferedTime = 0;
+    success = success && readSmallPieces(pFileName, FM_READ, readSize, passes, &bufferedHash, &bufferedTime) &&
+              readSmallPieces(pFileName, (FileMode)(FM_READ | FM_UNBUFFERED), readSize, passes, &unbufferedHash, &unbufferedTime);
+    if (!success)
+    {
+        LOGF(eERROR, "Small read benchmark failed to write or read %s", pFileName);
+        return false;
+    }
+
+    const double readCount = (double)passes * (double)(fileSize / readSize);
+    LOGF(eINFO, "Small read benchmark, %.0f reads of %u bytes: buffered %.1f ns per read, unbuffered %.1f ns per read", readCount,
+         readSize, (double)bufferedTime * 1000.0 / readCount, (double)unbufferedTime * 1000.0 / readCount);
+
+    if (bufferedHash != unbufferedHash)
+    {
+        LOGF(eERROR, "Buffered and unbuffered streams read different data from %s", pFileName);
+        return false;
+    }
+
+    return true;
+}
+
+// Directory layer on top of the archive replaces one of its files, other files still come from the archive
+static bool runOverlayTest()
+{
+    const char*  pPatchContent = "Patched text document";
+    const size_t patchSize = strlen(pPatchContent);
+
+    FileStream fs;
+    if (!fsOpenStreamFromPath(RD_DEBUG, pTextFileName[0], FM_WRITE, &fs))
+        return false;
+    bool success = fsWriteToStream(&fs, pPatchContent, patchSize) == patchSize;
+    success = fsCloseStream(&fs) && success;
+    if (!success)
+    {
+        LOGF(eERROR, "Overlay test: failed to write %s", pTextFileName[0]);
+        return false;
+    }
+
+    OverlayLayerDesc layers[2] = {};
+    layers[0].pArchive = &gArchiveFileSystem;
+    layers[1].rd = RD_DEBUG;
+    layers[1].directory = "";
+    layers[1].fileCount = SIZEOF_ARR(pTextFileName);
+    layers[1].fileNames = pTextFileName;
+    if (!fsOverlayOpen((uint32_t)SIZEOF_ARR(layers), layers, &gOverlayFileSystem))
+    {
+        LOGF(eERROR, "Overlay test: failed to open overlay");
+        return false;
+    }
+    fsSetPathForResourceDir(&gOverlayFileSystem, RD_OVERLAY_TEST, "");
+
+    // Last layer wins
+    uint64_t uid = 0;
+    uint32_t layer = ~0u;
+    char     content[64] = {};
+    success = gOverlayFileSystem.GetFileUid(&gOverlayFileSystem, RD_OVERLAY_TEST, pTextFileName[0], &uid) &&
+              fsOverlayGetFileLayer(&gOverlayFileSystem, uid, &layer) && layer == 1 &&
+              fsOpenStreamFromPath(RD_OVERLAY_TEST, pTextFileName[0], FM_READ, &fs);
+    if (success)
+    {
+        success = fsReadFromStream(&fs, content, sizeof(content)) == patchSize && memcmp(content, pPatchContent, patchSize) == 0;
+        fsCloseStream(&fs);
+    }
+    if (!success)
+        LOGF(eERROR, "Overlay test: %s is not read from the patch layer, layer %u", pTextFileName[0], layer);
+
+    // numbers files store 0, 1, 2, ...
+    uint64_t numbers[2] = { ~0ull, ~0ull };
+    layer = ~0u;
+    bool archiveFileRead = gOverlayFileSystem.GetFileUid(&gOverlayFileSystem, RD_OVERLAY_TEST, gNumbersFileNames[0], &uid) &&
+                           fsOverlayGetFileLayer(&gOverlayFileSystem, uid, &layer) && layer == 0 &&
+                           fsOpenStreamFromPath(RD_OVERLAY_TEST, gNumbersFileNames[0], FM_READ, &fs);
+    if (archiveFileRead)
+    {
+        archiveFileRead = fsReadFromStream(&fs, numbers, sizeof(numbers)) == sizeof(numbers) && numbers[0] == 0 && numbers[1] == 1;
+        fsCloseStream(&fs);
+    }
+    if (!archiveFileRead)
+    {
+        LOGF(eERROR, "Overlay test: %s is not read from the archive layer, layer %u", gNumbersFileNames[0], layer);
+        success = false;
+    }
+
+    fsOverlayClose(&gOverlayFileSystem);
+    return success;
+}
+
 static bool runTests()
 {
     if (!testFindStream("forward", fsFindStream))
@@ -587,6 +729,268 @@ static bool runTests()
 
     LOGF(eINFO, "Archive tests succeded.");
 
+    if (!runSmallReadBenchmark())
+        return false;
+
+    if (!runOverlayTest())
+        return false;
+    LOGF(eINFO, "Overlay test succeded.");
+
+    return true;
+}
+
+// Random allocations and releases of mesh sized parts of a geometry buffer, keeping it about half full.
+// Checks that parts are aligned and don't overlap, and that all memory merges back into one chunk.
+static bool runGeometryBufferPartTest()
+{
+    const uint32_t bufferSize = 16 * 1024 * 1024;
+    const uint32_t operationCount = 100000;
+
+    GeometryBuffer*        pGeometryBuffer = NULL;
+    GeometryBufferLoadDesc geometryBufferDesc = {};
+    geometryBufferDesc.mStartState = RESOURCE_STATE_INDEX_BUFFER;
+    geometryBufferDesc.pNameIndexBuffer = "GeometryBufferPartTest";
+    geometryBufferDesc.mIndicesSize = bufferSize;
+    geometryBufferDesc.pOutGeometryBuffer = &pGeometryBuffer;
+    addGeometryBuffer(&geometryBufferDesc);
+    if (!pGeometryBuffer)
+        return false;
+
+    BufferChunkAllocator* pAllocator = &pGeometryBuffer->mIndex;
+
+    // Vertex strides and index sizes used as alignments
+    const uint32_t alignments[] = { 2, 4, 12, 16, 20, 32 };
+    static BufferChunk parts[4096];
+    uint32_t           partCount = 0;
+    uint32_t           skippedCount = 0;
+    uint32_t           state = 0x2545F491u;
+    bool               success = true;
+
+    int64_t startTime = getUSec(true);
+    for (uint32_t op = 0; success && op < operationCount; ++op)
+    {
+        // xorshift
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+
+        // Allocations are more likely while the buffer is less than half full
+        const bool allocate =
+            !partCount || (partCount < SIZEOF_ARR(parts) && (state % 100) < (pAllocator->mFreeSize > bufferSize / 2 ? 70u : 30u));
+        if (!allocate)
+        {
+            const uint32_t index = (state >> 4) % partCount;
+            removeGeometryBufferPart(pAllocator, &parts[index]);
+            parts[index] = parts[--partCount];
+            continue;
+        }
+
+        // Mostly small meshes, a few large ones
+        const uint32_t maxSize = (state >> 8) % 16 ? bufferSize / 4096 : bufferSize / 64;
+        const uint32_t size = 1 + (state >> 4) % maxSize;
+        const uint32_t alignment = alignments[(state >> 24) % SIZEOF_ARR(alignments)];
+
+        // Allocation asserts if nothing fits, the largest free chunk fits any alignment of this size
+        BufferChunkAllocatorStats stats = {};
+        getGeometryBufferPartStats(pAllocator, &stats);
+        if (stats.mLargestFreeChunkSize < size + alignment - 1)
+        {
+            ++skippedCount;
+            continue;
+        }
+
+        BufferChunk part = {};
+        addGeometryBufferPart(pAllocator, size, alignment, &part);
+        success = part.mSize == size && part.mOffset % alignment == 0 && part.mOffset + part.mSize <= bufferSize;
+        parts[partCount++] = part;
+    }
+    int64_t endTime = getUSec(true);
+
+    BufferChunkAllocatorStats stats = {};
+    getGeometryBufferPartStats(pAllocator, &stats);
+    LOGF(eINFO, "Geometry buffer part test: %u operations in %.3f ms, %u skipped allocations, %u parts, fragmentation %.3f",
+         operationCount, (double)(endTime - startTime) / 1000.0, skippedCount, partCount, (double)stats.mFragmentation);
+
+    qsort(parts, partCount, sizeof(*parts),
+          [](const void* pLhs, const void* pRhs)
+          {
+              const uint32_t lhs = ((const BufferChunk*)pLhs)->mOffset;
+              const uint32_t rhs = ((const BufferChunk*)pRhs)->mOffset;
+              return lhs < rhs ? -1 : (lhs > rhs ? 1 : 0);
+          });
+    uint32_t usedSize = 0;
+    for (uint32_t i = 0; i < partCount; ++i)
+    {
+        usedSize += parts[i].mSize;
+        if (i + 1 < partCount && parts[i].mOffset + parts[i].mSize > parts[i + 1].mOffset)
+            success = false;
+    }
+    if (!success || stats.mUsedChunkCount != partCount || stats.mUsedSize != usedSize)
+    {
+        LOGF(eERROR, "Geometry buffer part test: parts are misaligned, overlap or are not accounted for");
+        success = false;
+    }
+
+    for (uint32_t i = 0; i < partCount; ++i)
+        removeGeometryBufferPart(pAllocator, &parts[i]);
+
+    getGeometryBufferPartStats(pAllocator, &stats);
+    if (stats.mUsedChunkCount != 0 || stats.mFreeChunkCount != 1 || stats.mFreeSize != bufferSize)
+    {
+        LOGF(eERROR, "Geometry buffer part test: %u free chunks with %u bytes left after releasing all parts", stats.mFreeChunkCount,
+             stats.mFreeSize);
+        success = false;
+    }
+
+    removeGeometryBuffer(pGeometryBuffer);
+    return success;
+}
+
+typedef struct LoadCallbackResult
+{
+    SyncToken          mToken;
+    ResourceLoadStatus mStatus;
+    uint32_t           mCallCount;
+    uint32_t           mOrder;
+} LoadCallbackResult;
+
+static uint32_t gLoadCallbackCount = 0;
+
+static void onTestLoadCompleted(void* pUserData, SyncToken token, ResourceLoadStatus status)
+{
+    LoadCallbackResult* pResult = (LoadCallbackResult*)pUserData;
+    pResult->mToken = token;
+    pResult->mStatus = status;
+    pResult->mOrder = gLoadCallbackCount++;
+    ++pResult->mCallCount;
+}
+
+// Cancels loads held in the queue by the upload budget. Buffer loads have no file to read and are always cancelled.
+// Texture loads are cancelled while their file waits for an io thread or is read already, and refused while it is being read.
+static bool runCancelLoadTest()
+{
+    const uint32_t bufferCount = 4;
+    const uint32_t cancelledBuffer = 2;
+    const uint32_t textureFileCount = SIZEOF_ARR(pSkyboxImageFileNames) + 1;
+    const uint32_t textureCount = textureFileCount * 2;
+    const uint32_t loadCount = bufferCount + textureCount;
+
+    // Must stay valid until the loads complete
+    static uint32_t bufferData[1024];
+
+    Buffer*            pBuffers[bufferCount] = {};
+    Texture*           pTextures[textureCount] = {};
+    SyncToken          tokens[loadCount] = {};
+    bool               cancelled[loadCount] = {};
+    LoadCallbackResult results[loadCount] = {};
+    gLoadCallbackCount = 0;
+
+    // Frames are not advanced during the test, so at most the first load executes before waitForToken
+    setResourceLoaderUploadBudget(0, 1);
+    advanceResourceLoaderFrame();
+
+    for (uint32_t i = 0; i < bufferCount; ++i)
+    {
+        BufferLoadDesc desc = {};
+        desc.mDesc.mDescriptors = DESCRIPTOR_TYPE_VERTEX_BUFFER;
+        desc.mDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_GPU_ONLY;
+        desc.mDesc.mSize = sizeof(bufferData);
+        desc.pData = bufferData;
+        desc.ppBuffer = &pBuffers[i];
+        desc.pCallback = onTestLoadCompleted;
+        desc.pCallbackUserData = &results[i];
+        addResource(&desc, &tokens[i]);
+    }
+
+    bool success = true;
+    cancelled[cancelledBuffer] = cancelResourceLoad(tokens[cancelledBuffer]);
+    if (!cancelled[cancelledBuffer])
+    {
+        LOGF(eERROR, "Cancel load test: queued buffer load was not cancelled");
+        success = false;
+    }
+
+    // Every other texture load is cancelled right after it is queued, while io threads pick it up, the rest once all are queued
+    for (uint32_t i = 0; i < textureCount; ++i)
+    {
+        const uint32_t  fileIndex = i % textureFileCount;
+        const uint32_t  loadIndex = bufferCount + i;
+        TextureLoadDesc desc = {};
+        desc.pFileName = fileIndex ? pSkyboxImageFileNames[fileIndex - 1] : pCubeTextureName[0];
+        desc.ppTexture = &pTextures[i];
+        desc.mCreationFlag = TEXTURE_CREATION_FLAG_SRGB;
+        desc.pCallback = onTestLoadCompleted;
+        desc.pCallbackUserData = &results[loadIndex];
+        addResource(&desc, &tokens[loadIndex]);
+        if (i % 2 == 0)
+            cancelled[loadIndex] = cancelResourceLoad(tokens[loadIndex]);
+    }
+    for (uint32_t i = 1; i < textureCount; i += 2)
+        cancelled[bufferCount + i] = cancelResourceLoad(tokens[bufferCount + i]);
+
+    setResourceLoaderUploadBudget(0, 0);
+    SyncToken lastToken = tokens[loadCount - 1];
+    waitForToken(&lastToken);
+
+    if (cancelResourceLoad(tokens[0]))
+    {
+        LOGF(eERROR, "Cancel load test: completed load was cancelled");
+        success = false;
+    }
+
+    // Callbacks are queued by the loader thread right after it publishes the completed token
+    const int64_t startTime = getUSec(true);
+    while (gLoadCallbackCount < loadCount && getUSec(true) - startTime < 5000000)
+    {
+        if (!drainCompletedResourceLoads(0))
+            threadSleep(1);
+    }
+
+    uint32_t cancelledTextureCount = 0;
+    for (uint32_t i = 0; i < loadCount; ++i)
+    {
+        const LoadCallbackResult* pResult = &results[i];
+        const ResourceLoadStatus  expectedStatus = cancelled[i] ? RESOURCE_LOAD_STATUS_CANCELLED : RESOURCE_LOAD_STATUS_COMPLETED;
+        // Buffers are created by addResource, textures only when loaded
+        const bool                created = i < bufferCount ? pBuffers[i] != NULL : pTextures[i - bufferCount] != NULL;
+        // Loads are queued in order, so are their tokens and callbacks
+        const bool                ordered = !i || (tokens[i] > tokens[i - 1] && pResult->mOrder > results[i - 1].mOrder);
+        if (pResult->mCallCount != 1 || pResult->mToken != tokens[i] || pResult->mStatus != expectedStatus || !ordered ||
+            created != (i < bufferCount || !cancelled[i]))
+        {
+            LOGF(eERROR, "Cancel load test: load %u called back %u times with token %llu and status %d, expected token %llu and status %d",
+                 i, pResult->mCallCount, (unsigned long long)pResult->mToken, (int)pResult->mStatus, (unsigned long long)tokens[i],
+                 (int)expectedStatus);
+            success = false;
+        }
+        if (i >= bufferCount && cancelled[i])
+            ++cancelledTextureCount;
+    }
+    LOGF(eINFO, "Cancel load test: %u of %u texture loads cancelled, the rest was being read", cancelledTextureCount, textureCount);
+
+    for (uint32_t i = 0; i < bufferCount; ++i)
+    {
+        if (pBuffers[i])
+            removeResource(pBuffers[i]);
+    }
+    for (uint32_t i = 0; i < textureCount; ++i)
+    {
+        if (pTextures[i])
+            removeResource(pTextures[i]);
+    }
+
+    return success;
+}
+
+static bool runResourceLoaderTests()
+{
+    if (!runGeometryBufferPartTest())
+        return false;
+    if (!runCancelLoadTest())
+        return false;
+
+    LOGF(eINFO, "Resource loader tests succeded.");
+
     return true;
 }
 
@@ -699,6 +1103,9 @@ public:
 
         initResourceLoaderInterface(pRenderer);
 
+        if (!runResourceLoaderTests())
+            LOGF(eERROR, "Couldn't run resource loader tests successfully.");
+
         // Load fonts
         FontDesc font = {};
         font.pFontPath = "TitilliumText/TitilliumText-Bold.otf";